@@ -0,0 +1,174 @@
+/**
+ * @file async_log.cpp
+ * @brief Implementation of the log written by a background thread.
+ *
+ * @author Vicky Chen (chen-vv)
+ * @author Eric Omielan (eomielan)
+ * @bug No known bugs.
+ */
+
+/* -- Includes -- */
+
+/* Standard library includes. */
+#include <chrono>
+#include <cstring>
+#include <ostream>
+
+/* Custom includes */
+#include "include/async_log.h"
+
+/**
+ * @brief Append a string to a line.
+ *
+ * @param text The string.
+ * @param buffer The end of the line so far.
+ * @return char* The new end of the line.
+ */
+static char* append_text(const char* text, char* buffer) {
+    size_t length = std::strlen(text);
+    std::memcpy(buffer, text, length);
+    return buffer + length;
+}
+
+/**
+ * @brief Append the decimal digits of an integer to a line, as operator<< prints them.
+ *
+ * @param value The integer.
+ * @param buffer The end of the line so far.
+ * @return char* The new end of the line.
+ */
+static char* append_number(long long value, char* buffer) {
+    // Negating the magnitude as unsigned also covers LLONG_MIN
+    unsigned long long magnitude = static_cast<unsigned long long>(value);
+    if (value < 0) {
+        *buffer++ = '-';
+        magnitude = 0 - magnitude;
+    }
+
+    char digits[20];
+    int num_digits = 0;
+    do {
+        digits[num_digits++] = static_cast<char>('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude > 0);
+
+    while (num_digits > 0) {
+        *buffer++ = digits[--num_digits];
+    }
+    return buffer;
+}
+
+size_t format_log_record(const LogRecord& record, char* buffer) {
+    char* end = buffer;
+
+    switch (record.kind) {
+        case LOG_RECORD_TICK:
+            end = append_number(record.first, append_text("Tick: ", end));
+            break;
+
+        case LOG_RECORD_BACKOFF:
+            end = append_number(record.first, append_text("Node ", end));
+            end = append_number(record.second, append_text(" backoff: ", end));
+            break;
+
+        case LOG_RECORD_OCCUPIED:
+            end = append_number(record.first, append_text("Channel is occupied by node ", end));
+            break;
+
+        case LOG_RECORD_IDLE:
+            end = append_text("Channel is idle.\n", end);
+            break;
+
+        case LOG_RECORD_FINISHED:
+            end = append_number(record.first, append_text("Node ", end));
+            end = append_number(record.second, append_text(" finished transmitting. new backoff ", end));
+            break;
+
+        case LOG_RECORD_COLLISION:
+            end = append_text("Collision detected b/w:", end);
+            break;
+
+        case LOG_RECORD_COLLIDED:
+            end = append_number(record.first, append_text("Node ", end));
+            break;
+
+        case LOG_RECORD_CYCLE:
+        default:
+            end = append_number(record.first, append_text("Cycle of ", end));
+            end = append_number(record.second, append_text(" ticks detected, skipping to tick ", end));
+            break;
+    }
+
+    *end++ = '\n';
+    return static_cast<size_t>(end - buffer);
+}
+
+bool parse_log_backpressure(const std::string& name, LogBackpressure& backpressure) {
+    if (name == "block") {
+        backpressure = LOG_BACKPRESSURE_BLOCK;
+    } else if (name == "drop") {
+        backpressure = LOG_BACKPRESSURE_DROP;
+    } else {
+        return false;
+    }
+
+    return true;
+}
+
+AsyncLog::AsyncLog()
+    : stream_(nullptr),
+      backpressure_(LOG_BACKPRESSURE_BLOCK),
+      num_dropped_(0),
+      ring_(ASYNC_LOG_RING_CAPACITY),
+      closing_(false) {}
+
+void AsyncLog::open(std::ostream& stream, LogBackpressure backpressure) {
+    stream_ = &stream;
+    backpressure_ = backpressure;
+
+    // A block is written once it is full, so it has room for one more line past its size
+    block_.resize(ASYNC_LOG_BLOCK_SIZE + LOG_RECORD_MAX_LENGTH);
+    thread_ = std::thread(&AsyncLog::write_records, this);
+}
+
+AsyncLog::~AsyncLog() {
+    close();
+}
+
+void AsyncLog::close() {
+    if (!thread_.joinable()) {
+        return;
+    }
+
+    closing_.store(true, std::memory_order_release);
+    thread_.join();
+}
+
+void AsyncLog::write_records() {
+    LogRecord record;
+    size_t length = 0;
+
+    for (;;) {
+        // Every record is in the ring before closing_ is set, so one more pass drains them all
+        bool closing = closing_.load(std::memory_order_acquire);
+
+        while (ring_.try_pop(record)) {
+            length += format_log_record(record, block_.data() + length);
+
+            if (length >= ASYNC_LOG_BLOCK_SIZE) {
+                stream_->write(block_.data(), static_cast<std::streamsize>(length));
+                length = 0;
+            }
+        }
+
+        if (closing) {
+            break;
+        }
+
+        // A simulation that waits on a full ring is woken up within a fraction of the time it took to fill it
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+
+    stream_->write(block_.data(), static_cast<std::streamsize>(length));
+    stream_->flush();
+}
@@ -0,0 +1,342 @@
+/**
+ * @file batch.cpp
+ * @brief Implementation of the lockstep batch engine.
+ *
+ * The lane loops are plain loops over arrays of BATCH_LANES elements, which the
+ * compiler turns into vector instructions. The whole engine is also compiled a
+ * second time with a function target attribute for AVX2, which is picked when
+ * the processor supports it, so the program does not need to be built for a
+ * specific processor.
+ *
+ * @author Vicky Chen (chen-vv)
+ * @author Eric Omielan (eomielan)
+ * @bug No known bugs.
+ */
+
+/* -- Includes -- */
+
+/* Standard library includes. */
+#include <algorithm>
+#include <climits>
+
+/* Custom includes */
+#include "include/batch.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define BATCH_X86 1
+#endif
+
+/**
+ * @brief The state of BATCH_LANES simulations, stored lane by lane.
+ *
+ * @tparam MaxNodes The number of nodes of every lane, at least the number of nodes of its simulation.
+*/
+template <int MaxNodes>
+struct BatchLanes {
+    alignas(32) int backoff[MaxNodes][BATCH_LANES];             /**< The backoffs, INT_MAX past the nodes of a lane. */
+    alignas(32) int node_mask[MaxNodes][BATCH_LANES];           /**< -1 for the nodes of a lane, 0 past them. */
+    alignas(32) int collision_count[MaxNodes][BATCH_LANES];     /**< The collision counts. */
+    alignas(32) long long ticks[BATCH_LANES];                   /**< The current tick of every lane. */
+    alignas(32) long long total_simulation_time[BATCH_LANES];   /**< The tick every lane stops at, 0 if it is empty. */
+    alignas(32) long long successful_ticks[BATCH_LANES];        /**< The successful ticks of every lane. */
+    alignas(32) long long packet_length[BATCH_LANES];           /**< The packet length of every lane. */
+    int max_retransmission_attempt[BATCH_LANES];                /**< The M value of every lane. */
+    int last_window[BATCH_LANES];                               /**< The index of the last window of every lane. */
+    int windows[BATCH_LANES][BATCH_MAX_WINDOWS];                /**< The window after each collision count. */
+    size_t point[BATCH_LANES];                                  /**< The configuration in every lane. */
+    bool busy[BATCH_LANES];                                     /**< Whether a lane holds a configuration. */
+};
+
+/**
+ * @brief Put a configuration into a lane, at tick 0.
+ *
+ * @param lanes The lanes.
+ * @param lane The index of the lane.
+ * @param config The configuration.
+ * @param point The index of the configuration in the sweep.
+ * @param backoff_policy The backoff policy.
+ * @param window_policy The window policy.
+ */
+template <typename Backoff, typename Window, int MaxNodes>
+static void fill_lane(BatchLanes<MaxNodes>& lanes, int lane, const SimulationConfig& config, size_t point,
+                      const Backoff& backoff_policy, const Window& window_policy) {
+    std::vector<int> windows = window_policy.windows(config.R);
+
+    for (int i = 0; i < static_cast<int>(windows.size()); i++) {
+        lanes.windows[lane][i] = windows[i];
+    }
+    lanes.last_window[lane] = static_cast<int>(windows.size()) - 1;
+
+    for (int node_id = 0; node_id < MaxNodes; node_id++) {
+        bool is_node = node_id < config.num_nodes;
+        lanes.backoff[node_id][lane] = is_node ? backoff_policy(node_id, 0, windows[0]) : INT_MAX;
+        lanes.node_mask[node_id][lane] = is_node ? -1 : 0;
+        lanes.collision_count[node_id][lane] = 0;
+    }
+
+    lanes.ticks[lane] = 0;
+    lanes.total_simulation_time[lane] = config.total_simulation_time;
+    lanes.successful_ticks[lane] = 0;
+    lanes.packet_length[lane] = config.packet_length;
+    lanes.max_retransmission_attempt[lane] = config.max_retransmission_attempt;
+    lanes.point[lane] = point;
+    lanes.busy[lane] = true;
+}
+
+/**
+ * @brief Leave a lane empty, so that every step leaves it alone.
+ *
+ * @param lanes The lanes.
+ * @param lane The index of the lane.
+ */
+template <int MaxNodes>
+static void empty_lane(BatchLanes<MaxNodes>& lanes, int lane) {
+    for (int node_id = 0; node_id < MaxNodes; node_id++) {
+        lanes.backoff[node_id][lane] = INT_MAX;
+        lanes.node_mask[node_id][lane] = 0;
+        lanes.collision_count[node_id][lane] = 0;
+    }
+
+    lanes.ticks[lane] = 0;
+    lanes.total_simulation_time[lane] = 0;
+    lanes.successful_ticks[lane] = 0;
+    lanes.packet_length[lane] = 1;
+    lanes.max_retransmission_attempt[lane] = 0;
+    lanes.last_window[lane] = 0;
+    lanes.windows[lane][0] = 1;
+    lanes.busy[lane] = false;
+}
+
+/**
+ * @brief Run a batch of configurations until every one of them is done.
+ *
+ * This is always inlined into run_lanes_generic() and run_lanes_avx2(), so it is
+ * compiled once for each instruction set.
+ *
+ * @tparam Backoff The backoff policy.
+ * @tparam Window The window policy.
+ * @tparam MaxNodes The number of nodes of every lane.
+ */
+template <typename Backoff, typename Window, int MaxNodes>
+__attribute__((always_inline))
+inline void run_lanes(const std::vector<SimulationConfig>& configs, const size_t* points, size_t num_points,
+                      const SimulationOptions& options, std::vector<SimulationResults>& results) {
+    Backoff backoff_policy(options.seed, options.persistence);
+    Window window_policy;
+    BatchLanes<MaxNodes> lanes;
+    size_t next_point = 0;
+    int num_busy_lanes = 0;
+
+    for (int lane = 0; lane < BATCH_LANES; lane++) {
+        if (next_point < num_points) {
+            fill_lane(lanes, lane, configs[points[next_point]], points[next_point], backoff_policy, window_policy);
+            next_point++;
+            num_busy_lanes++;
+        } else {
+            empty_lane(lanes, lane);
+        }
+    }
+
+    while (num_busy_lanes > 0) {
+        // The smallest backoff of every lane, and the nodes that have it. The nodes
+        // past the end of a lane have the largest backoff, so they are never ready.
+        alignas(32) int min_backoff[BATCH_LANES];
+        alignas(32) unsigned ready_mask[BATCH_LANES];
+
+        for (int lane = 0; lane < BATCH_LANES; lane++) {
+            min_backoff[lane] = lanes.backoff[0][lane];
+            ready_mask[lane] = 0;
+        }
+        for (int node_id = 1; node_id < MaxNodes; node_id++) {
+            for (int lane = 0; lane < BATCH_LANES; lane++) {
+                min_backoff[lane] = std::min(min_backoff[lane], lanes.backoff[node_id][lane]);
+            }
+        }
+        for (int node_id = 0; node_id < MaxNodes; node_id++) {
+            for (int lane = 0; lane < BATCH_LANES; lane++) {
+                ready_mask[lane] |= static_cast<unsigned>(lanes.backoff[node_id][lane] == min_backoff[lane]) << node_id;
+            }
+        }
+
+        // Case 2: the channel is idle until the first node of each lane is ready, or the lane ends
+        alignas(32) int idle_ticks[BATCH_LANES];
+
+        for (int lane = 0; lane < BATCH_LANES; lane++) {
+            long long ticks_left = lanes.total_simulation_time[lane] - lanes.ticks[lane];
+            idle_ticks[lane] = static_cast<int>(std::min<long long>(min_backoff[lane], ticks_left));
+            lanes.ticks[lane] += idle_ticks[lane];
+        }
+        for (int node_id = 0; node_id < MaxNodes; node_id++) {
+            for (int lane = 0; lane < BATCH_LANES; lane++) {
+                lanes.backoff[node_id][lane] -= idle_ticks[lane] & lanes.node_mask[node_id][lane];
+            }
+        }
+
+        // Cases 1 and 3: a single ready node transmits its whole packet, or as much of it as fits.
+        // Case 4: several ready nodes collide, which takes one tick.
+        alignas(32) int transmitted[BATCH_LANES];
+        alignas(32) int collided[BATCH_LANES];
+
+        for (int lane = 0; lane < BATCH_LANES; lane++) {
+            long long ticks_left = lanes.total_simulation_time[lane] - lanes.ticks[lane];
+            bool has_event = ticks_left > 0;
+            bool single_ready = (ready_mask[lane] & (ready_mask[lane] - 1)) == 0;
+            long long packet_ticks = std::min(lanes.packet_length[lane], ticks_left);
+
+            packet_ticks = has_event && single_ready ? packet_ticks : 0;
+            lanes.successful_ticks[lane] += packet_ticks;
+            lanes.ticks[lane] += packet_ticks;
+            transmitted[lane] = packet_ticks == lanes.packet_length[lane];
+            collided[lane] = has_event && !single_ready;
+            lanes.ticks[lane] += collided[lane];
+        }
+
+        // The new backoffs are drawn one lane at a time, at the tick after the event
+        for (int lane = 0; lane < BATCH_LANES; lane++) {
+            unsigned mask = ready_mask[lane];
+            long long ticks = lanes.ticks[lane];
+
+            if (transmitted[lane]) {
+                int node_id = __builtin_ctz(mask);
+                lanes.collision_count[node_id][lane] = 0;
+                lanes.backoff[node_id][lane] = backoff_policy(node_id, ticks, lanes.windows[lane][0]);
+            } else if (collided[lane]) {
+                for (; mask != 0; mask &= mask - 1) {
+                    int node_id = __builtin_ctz(mask);
+                    int collision_count = lanes.collision_count[node_id][lane] + 1;
+
+                    if (collision_count > lanes.max_retransmission_attempt[lane]) {
+                        // Drop the packet and start over with a new one
+                        collision_count = 0;
+                    }
+
+                    lanes.collision_count[node_id][lane] = collision_count;
+                    lanes.backoff[node_id][lane] = backoff_policy(
+                        node_id, ticks, lanes.windows[lane][std::min(collision_count, lanes.last_window[lane])]);
+                }
+            }
+        }
+
+        // A lane that is done takes the next configuration, or is left empty
+        for (int lane = 0; lane < BATCH_LANES; lane++) {
+            if (lanes.busy[lane] && lanes.ticks[lane] >= lanes.total_simulation_time[lane]) {
+                SimulationResults& point_results = results[lanes.point[lane]];
+                point_results.total_simulation_time = lanes.ticks[lane];
+                point_results.num_successful_transmission_ticks = lanes.successful_ticks[lane];
+
+                if (next_point < num_points) {
+                    fill_lane(lanes, lane, configs[points[next_point]], points[next_point], backoff_policy,
+                              window_policy);
+                    next_point++;
+                } else {
+                    empty_lane(lanes, lane);
+                    num_busy_lanes--;
+                }
+            }
+        }
+    }
+}
+
+template <typename Backoff, typename Window, int MaxNodes>
+static void run_lanes_generic(const std::vector<SimulationConfig>& configs, const size_t* points, size_t num_points,
+                              const SimulationOptions& options, std::vector<SimulationResults>& results) {
+    run_lanes<Backoff, Window, MaxNodes>(configs, points, num_points, options, results);
+}
+
+#ifdef BATCH_X86
+
+template <typename Backoff, typename Window, int MaxNodes>
+__attribute__((target("avx2")))
+static void run_lanes_avx2(const std::vector<SimulationConfig>& configs, const size_t* points, size_t num_points,
+                           const SimulationOptions& options, std::vector<SimulationResults>& results) {
+    run_lanes<Backoff, Window, MaxNodes>(configs, points, num_points, options, results);
+}
+
+#endif // BATCH_X86
+
+/**
+ * @brief Run a batch with the given policies and lanes, with AVX2 if the processor supports it.
+ *
+ * @tparam Backoff The backoff policy.
+ * @tparam Window The window policy.
+ * @tparam MaxNodes The number of nodes of every lane.
+ */
+template <typename Backoff, typename Window, int MaxNodes>
+static void run_batch_in(const std::vector<SimulationConfig>& configs, const size_t* points, size_t num_points,
+                         const SimulationOptions& options, std::vector<SimulationResults>& results) {
+#ifdef BATCH_X86
+    static const bool has_avx2 = (__builtin_cpu_init(), __builtin_cpu_supports("avx2"));
+
+    if (has_avx2) {
+        run_lanes_avx2<Backoff, Window, MaxNodes>(configs, points, num_points, options, results);
+        return;
+    }
+#endif
+    run_lanes_generic<Backoff, Window, MaxNodes>(configs, points, num_points, options, results);
+}
+
+/**
+ * @brief Run a batch with the given policies, in the smallest lanes that hold every configuration.
+ *
+ * @tparam Backoff The backoff policy.
+ * @tparam Window The window policy.
+ */
+template <typename Backoff, typename Window>
+static void run_batch_as(const std::vector<SimulationConfig>& configs, const size_t* points, size_t num_points,
+                         const SimulationOptions& options, std::vector<SimulationResults>& results) {
+    int max_num_nodes = 0;
+    for (size_t i = 0; i < num_points; i++) {
+        max_num_nodes = std::max(max_num_nodes, configs[points[i]].num_nodes);
+    }
+
+    // Every step visits every node of the lanes, so lanes of half the size halve the work
+    if (max_num_nodes <= BATCH_MAX_NODES / 2) {
+        run_batch_in<Backoff, Window, BATCH_MAX_NODES / 2>(configs, points, num_points, options, results);
+    } else {
+        run_batch_in<Backoff, Window, BATCH_MAX_NODES>(configs, points, num_points, options, results);
+    }
+}
+
+/**
+ * @brief Run a batch with the given backoff policy and the window policy of the options.
+ *
+ * @tparam Backoff The backoff policy.
+ */
+template <typename Backoff>
+static void run_batch_with(const std::vector<SimulationConfig>& configs, const size_t* points, size_t num_points,
+                           const SimulationOptions& options, std::vector<SimulationResults>& results) {
+    if (options.window_policy == WINDOW_BINARY_EXPONENTIAL) {
+        run_batch_as<Backoff, BinaryExponentialWindow>(configs, points, num_points, options, results);
+    } else {
+        run_batch_as<Backoff, TableWindow>(configs, points, num_points, options, results);
+    }
+}
+
+bool batchable(const SimulationConfig& config, const SimulationOptions& options) {
+    if (config.num_nodes < 1 || config.num_nodes > BATCH_MAX_NODES) {
+        return false;
+    }
+
+    size_t num_windows = options.window_policy == WINDOW_BINARY_EXPONENTIAL
+                             ? BinaryExponentialWindow().windows(config.R).size()
+                             : TableWindow().windows(config.R).size();
+    return num_windows <= BATCH_MAX_WINDOWS;
+}
+
+void run_batch(const std::vector<SimulationConfig>& configs, const size_t* points, size_t num_points,
+               const SimulationOptions& options, std::vector<SimulationResults>& results) {
+    switch (options.backoff_policy) {
+        case BACKOFF_UNIFORM:
+            run_batch_with<UniformBackoff>(configs, points, num_points, options, results);
+            break;
+
+        case BACKOFF_P_PERSISTENT:
+            run_batch_with<PPersistentBackoff>(configs, points, num_points, options, results);
+            break;
+
+        case BACKOFF_DETERMINISTIC:
+        default:
+            run_batch_with<DeterministicBackoff>(configs, points, num_points, options, results);
+            break;
+    }
+}
@@ -0,0 +1,314 @@
+/** 
+ * @file bench.cpp
+ * @brief A benchmark of the simulation engines on a set of curated scenarios.
+ *
+ * Every scenario is run with every engine in a child process of its own, so
+ * the peak resident set size of each run can be measured and no run warms up
+ * the caches or the heap of the next one. The results are printed as JSON,
+ * one object per run, so that runs of the benchmark can be diffed over time.
+ *
+ * @author Vicky Chen (chen-vv)
+ * @author Eric Omielan (eomielan)
+ * @bug No known bugs.
+ */
+
+/* -- Includes -- */
+
+/* Standard library includes. */
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+/* System includes */
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+/* Custom includes */
+#include "include/csma.h"
+#include "include/node_kernels.h"
+#include "include/node_stats.h"
+
+/**
+ * @brief A simulation configuration the engines are measured on.
+*/
+struct BenchScenario {
+    const char* name;               /**< The name of the scenario in the results. */
+    const char* description;        /**< What the scenario stresses. */
+    SimulationConfig config;        /**< The parameters of the simulation, at scale 1. */
+};
+
+/**
+ * @brief An engine the scenarios are run with.
+*/
+struct BenchEngine {
+    const char* name;               /**< The name of the engine in the results. */
+    Engine engine;                  /**< The engine. */
+    bool detect_cycles;             /**< Whether cycle detection is turned on. */
+};
+
+/**
+ * @brief The measurements of one run, sent from the child process to the parent.
+*/
+struct BenchMeasurement {
+    double seconds;                 /**< The wall-clock time of the simulation. */
+    long long successful_ticks;     /**< The successful ticks of the simulation. */
+    long long peak_rss_kb;          /**< The peak resident set size of the child process. */
+};
+
+/**
+ * @brief Build a configuration.
+ * 
+ * @param num_nodes N.
+ * @param packet_length L.
+ * @param max_retransmission_attempt M.
+ * @param R The R values.
+ * @param total_simulation_time T.
+ * @return SimulationConfig The configuration.
+ */
+static SimulationConfig make_config(int num_nodes, int packet_length, int max_retransmission_attempt,
+                                    std::vector<int> R, long long total_simulation_time) {
+    SimulationConfig config;
+    config.num_nodes = num_nodes;
+    config.packet_length = packet_length;
+    config.max_retransmission_attempt = max_retransmission_attempt;
+    config.R = R;
+    config.total_simulation_time = total_simulation_time;
+    return config;
+}
+
+/**
+ * @brief Get a list of doubling R values.
+ * 
+ * @param first The first R value.
+ * @param count The number of R values.
+ * @return std::vector<int> The R values first, 2 * first, 4 * first, ...
+ */
+static std::vector<int> doubling_R(int first, int count) {
+    std::vector<int> R;
+    for (int i = 0; i < count; i++) {
+        R.push_back(first << i);
+    }
+    return R;
+}
+
+/**
+ * @brief Get the curated scenarios. The simulation times are chosen so that the slowest
+ * engine takes about a second on each.
+ * 
+ * @return std::vector<BenchScenario> The scenarios.
+ */
+static std::vector<BenchScenario> bench_scenarios() {
+    return {
+        {"two_nodes", "N=2, short packets, the original test inputs scaled up",
+         make_config(2, 1, 6, doubling_R(4, 6), 100000000)},
+        {"low_contention", "few nodes with wide windows, the channel is mostly idle",
+         make_config(8, 4, 10, doubling_R(256, 4), 100000000)},
+        {"high_contention", "many nodes with narrow windows, most ticks collide",
+         make_config(64, 1, 3, {2, 4}, 10000000)},
+        {"deep_R", "a long list of doubling R values",
+         make_config(16, 4, 15, doubling_R(2, 15), 100000000)},
+        {"long_packets", "long packets, the channel is mostly busy",
+         make_config(32, 1000, 6, doubling_R(16, 3), 200000000)},
+        {"large_N", "10^5 nodes with windows larger than the node count",
+         make_config(100000, 5, 8, doubling_R(1 << 17, 3), 20000)},
+        {"huge_N", "10^6 nodes with windows larger than the node count",
+         make_config(1000000, 10, 5, doubling_R(1 << 20, 2), 2000)},
+    };
+}
+
+/**
+ * @brief Get the engines the scenarios are run with.
+ * 
+ * @return std::vector<BenchEngine> The engines.
+ */
+static std::vector<BenchEngine> bench_engines() {
+    return {
+        {"reference", ENGINE_REFERENCE, false},
+        {"tick", ENGINE_TICK, false},
+        {"simd", ENGINE_SIMD, false},
+        {"event", ENGINE_NEXT_EVENT, false},
+        {"event+cycle-detect", ENGINE_NEXT_EVENT, true},
+        {"group", ENGINE_GROUP, false},
+        {"small", ENGINE_SMALL, false},
+    };
+}
+
+/**
+ * @brief Run one simulation in a child process and measure it.
+ * 
+ * @param config The parameters of the simulation.
+ * @param options How the simulation is run.
+ * @param measurement Set to the measurements of the run.
+ * @return bool True if the child process reported its measurements, false otherwise.
+ */
+static bool measure_in_child(const SimulationConfig& config, const SimulationOptions& options,
+                             BenchMeasurement& measurement) {
+    int pipe_fds[2];
+    if (pipe(pipe_fds) != 0) {
+        return false;
+    }
+
+    pid_t pid = fork();
+
+    if (pid == 0) {
+        close(pipe_fds[0]);
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        SimulationResults results = run_simulation(config, options);
+        std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+
+        BenchMeasurement child_measurement;
+        child_measurement.seconds = std::chrono::duration<double>(end - start).count();
+        child_measurement.successful_ticks = results.num_successful_transmission_ticks;
+        child_measurement.peak_rss_kb = usage.ru_maxrss;
+
+        ssize_t written = write(pipe_fds[1], &child_measurement, sizeof(child_measurement));
+        _exit(written == static_cast<ssize_t>(sizeof(child_measurement)) ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+
+    close(pipe_fds[1]);
+
+    bool received = pid > 0 && read(pipe_fds[0], &measurement, sizeof(measurement)) == static_cast<ssize_t>(sizeof(measurement));
+    close(pipe_fds[0]);
+
+    int status = 0;
+    if (pid > 0) {
+        waitpid(pid, &status, 0);
+    }
+
+    return received && WIFEXITED(status) && WEXITSTATUS(status) == EXIT_SUCCESS;
+}
+
+/**
+ * @brief Count the events of a simulation: the packets sent and the backoffs drawn after
+ * collisions, which are the same for every engine.
+ * 
+ * @param config The parameters of the simulation.
+ * @return long long The number of events.
+ */
+static long long count_events(const SimulationConfig& config) {
+    NodeStatistics statistics;
+    statistics.reset(config.num_nodes);
+
+    SimulationOptions options;
+    options.engine = ENGINE_NEXT_EVENT;
+    options.node_statistics = &statistics;
+    run_simulation(config, options);
+
+    long long events = 0;
+    for (const NodeStats& node : statistics.nodes()) {
+        events += node.transmissions + node.collisions;
+    }
+
+    return events;
+}
+
+/**
+ * @brief Check whether a name is in a comma-separated list.
+ * 
+ * @param list The list, or empty to match every name.
+ * @param name The name to look for.
+ * @return bool True if the list is empty or contains the name.
+ */
+static bool in_list(const std::string& list, const char* name) {
+    return list.empty() || ("," + list + ",").find("," + std::string(name) + ",") != std::string::npos;
+}
+
+/** 
+ * @brief The benchmark entrypoint.
+ *
+ * Usage: csma-bench [--scale <factor>] [--scenarios <names>] [--engines <names>]
+ * 
+ * --scale multiplies the simulation time of every scenario, and --scenarios and
+ * --engines select comma-separated subsets of them.
+ *
+ * @param argc The number of command-line arguments.
+ * @param argv An array of strings containing the command-line arguments.
+ * @return Returns EXIT_SUCCESS on success, EXIT_FAILURE on failure.
+ */
+int main(int argc, char* argv[]) {
+    double scale = 1.0;
+    std::string scenario_names;
+    std::string engine_names;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+
+        if (arg == "--scale" && i + 1 < argc) {
+            scale = std::strtod(argv[++i], nullptr);
+        } else if (arg == "--scenarios" && i + 1 < argc) {
+            scenario_names = argv[++i];
+        } else if (arg == "--engines" && i + 1 < argc) {
+            engine_names = argv[++i];
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--scale <factor>] [--scenarios <names>] [--engines <names>]" << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (!(scale > 0)) {
+        std::cerr << "Error: The scale must be positive" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::cout << "{\n";
+    std::cout << "  \"instruction_set\": \"" << node_kernels_instruction_set() << "\",\n";
+    std::cout << "  \"scale\": " << scale << ",\n";
+    std::cout << "  \"results\": [";
+
+    bool first_result = true;
+
+    for (BenchScenario& scenario : bench_scenarios()) {
+        if (!in_list(scenario_names, scenario.name)) {
+            continue;
+        }
+
+        SimulationConfig& config = scenario.config;
+        config.total_simulation_time = std::max(1LL, std::llround(config.total_simulation_time * scale));
+        long long events = count_events(config);
+
+        for (const BenchEngine& engine : bench_engines()) {
+            if (!in_list(engine_names, engine.name)) {
+                continue;
+            }
+
+            SimulationOptions options;
+            options.engine = engine.engine;
+            options.detect_cycles = engine.detect_cycles;
+
+            BenchMeasurement measurement;
+            if (!measure_in_child(config, options, measurement)) {
+                std::cerr << "Error: The " << engine.name << " engine failed on scenario " << scenario.name << std::endl;
+                return EXIT_FAILURE;
+            }
+
+            double seconds = std::max(measurement.seconds, 1e-9);
+
+            std::cout << (first_result ? "\n" : ",\n");
+            std::cout << "    {\"scenario\": \"" << scenario.name << "\", \"engine\": \"" << engine.name << "\", "
+                      << "\"N\": " << config.num_nodes << ", \"L\": " << config.packet_length << ", "
+                      << "\"M\": " << config.max_retransmission_attempt << ", \"R_count\": " << config.R.size() << ", "
+                      << "\"T\": " << config.total_simulation_time << ",\n"
+                      << "     \"seconds\": " << measurement.seconds << ", "
+                      << "\"ns_per_tick\": " << seconds * 1e9 / config.total_simulation_time << ", "
+                      << "\"ticks_per_sec\": " << config.total_simulation_time / seconds << ", "
+                      << "\"events_per_sec\": " << events / seconds << ", "
+                      << "\"peak_rss_kb\": " << measurement.peak_rss_kb << ", "
+                      << "\"utilization\": " << format_ratio(measurement.successful_ticks, config.total_simulation_time, 6) << "}";
+            std::cout.flush();
+            first_result = false;
+        }
+    }
+
+    std::cout << "\n  ]\n}" << std::endl;
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,340 @@
+/**
+ * @file checkpoint.cpp
+ * @brief Implementation of the checkpoint writer and reader.
+ *
+ * @author Vicky Chen (chen-vv)
+ * @author Eric Omielan (eomielan)
+ * @bug No known bugs.
+ */
+
+/* -- Includes -- */
+
+/* Standard library includes. */
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/* Custom includes */
+#include "include/checkpoint.h"
+
+/**
+ * @brief The magic bytes at the start of every checkpoint file.
+*/
+static const char CHECKPOINT_MAGIC[8] = {'C', 'S', 'M', 'A', 'C', 'K', 'P', '2'};
+
+/**
+ * @brief The byte order mark of the checkpoint files.
+*/
+static const uint32_t CHECKPOINT_BYTE_ORDER = 0x01020304;
+
+/**
+ * @brief Mix a range of bytes into a 64-bit FNV-1a hash.
+ *
+ * @param hash The hash so far.
+ * @param data The bytes.
+ * @param size The number of bytes.
+ * @return uint64_t The updated hash.
+ */
+static uint64_t fnv1a(uint64_t hash, const void* data, size_t size) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ bytes[i]) * 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+/**
+ * @brief The initial value of a 64-bit FNV-1a hash.
+*/
+static const uint64_t FNV1A_BASIS = 0xcbf29ce484222325ULL;
+
+/**
+ * @brief The columns of a checkpoint, in the order of the file.
+*/
+struct CheckpointColumns {
+    const int32_t* backoff;                     /**< The backoff of every node. */
+    const int32_t* collision_count_overflows;   /**< The (node ID, count) pairs of the large collision counts. */
+    const uint8_t* collision_count;             /**< The collision count byte of every node. */
+};
+
+/**
+ * @brief Mix a column of the node table into a checksum.
+ *
+ * The column is mixed eight bytes at a time into four independent hashes, so the
+ * checksum of a large table is not held back by the latency of the multiplications.
+ *
+ * @param checksum The checksum so far.
+ * @param data The bytes of the column.
+ * @param size The number of bytes.
+ * @return uint64_t The updated checksum.
+ */
+static uint64_t checksum_column(uint64_t checksum, const void* data, size_t size) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    uint64_t lanes[4] = {checksum, checksum ^ 1, checksum ^ 2, checksum ^ 3};
+    size_t i = 0;
+
+    for (; i + 32 <= size; i += 32) {
+        for (int lane = 0; lane < 4; lane++) {
+            uint64_t word;
+            std::memcpy(&word, bytes + i + 8 * lane, sizeof(word));
+            lanes[lane] = (lanes[lane] ^ word) * 0x100000001b3ULL;
+        }
+    }
+
+    lanes[0] = fnv1a(lanes[0], bytes + i, size - i);
+    return fnv1a(checksum, lanes, sizeof(lanes));
+}
+
+/**
+ * @brief Compute the checksum of a checkpoint.
+ *
+ * @param header The header of the checkpoint, whose checksum field is ignored.
+ * @param columns The columns of the node table.
+ * @return uint64_t The checksum.
+ */
+static uint64_t checkpoint_checksum(const CheckpointHeader& header, const CheckpointColumns& columns) {
+    CheckpointHeader unchecked = header;
+    unchecked.checksum = 0;
+    uint64_t checksum = fnv1a(FNV1A_BASIS, &unchecked, sizeof(unchecked));
+
+    size_t num_nodes = static_cast<size_t>(header.num_nodes);
+    size_t num_overflows = static_cast<size_t>(header.num_collision_count_overflows);
+    checksum = checksum_column(checksum, columns.backoff, num_nodes * sizeof(int32_t));
+    checksum = checksum_column(checksum, columns.collision_count_overflows, 2 * num_overflows * sizeof(int32_t));
+    checksum = checksum_column(checksum, columns.collision_count, num_nodes);
+    return checksum;
+}
+
+uint64_t checkpoint_fingerprint(const SimulationConfig& config, const SimulationOptions& options) {
+    int32_t parameters[4] = {config.num_nodes, config.packet_length, config.max_retransmission_attempt,
+                             static_cast<int32_t>(config.R.size())};
+    uint64_t fingerprint = fnv1a(FNV1A_BASIS, parameters, sizeof(parameters));
+
+    for (int R : config.R) {
+        int32_t value = R;
+        fingerprint = fnv1a(fingerprint, &value, sizeof(value));
+    }
+
+    int32_t policies[2] = {options.backoff_policy, options.window_policy};
+    fingerprint = fnv1a(fingerprint, policies, sizeof(policies));
+
+    // The seed and the probability only change the backoffs of the random policies
+    if (options.backoff_policy != BACKOFF_DETERMINISTIC) {
+        fingerprint = fnv1a(fingerprint, &options.seed, sizeof(options.seed));
+    }
+    if (options.backoff_policy == BACKOFF_P_PERSISTENT) {
+        fingerprint = fnv1a(fingerprint, &options.persistence, sizeof(options.persistence));
+    }
+
+    return fingerprint;
+}
+
+bool write_checkpoint(const std::string& filename, const SimulationSnapshot& snapshot, uint64_t fingerprint) {
+    const NodeTable& nodes = snapshot.nodes;
+    std::vector<int32_t> overflows;
+    for (const std::pair<const int, int>& overflow : nodes.collision_count_overflows) {
+        overflows.push_back(overflow.first);
+        overflows.push_back(overflow.second);
+    }
+
+    CheckpointColumns columns = {nodes.backoff.data(), overflows.data(), nodes.collision_count.data()};
+
+    CheckpointHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, CHECKPOINT_MAGIC, sizeof(header.magic));
+    header.byte_order = CHECKPOINT_BYTE_ORDER;
+    header.flags = snapshot.channel_occupied ? 1 : 0;
+    header.fingerprint = fingerprint;
+    header.current_tick = snapshot.current_tick;
+    header.num_successful_transmission_ticks = snapshot.num_successful_transmission_ticks;
+    header.num_nodes = static_cast<int32_t>(nodes.size());
+    header.active_node_id = snapshot.active_node_id;
+    header.packet_ticks_remaining = snapshot.packet_ticks_remaining;
+    header.num_collision_count_overflows = static_cast<int32_t>(nodes.collision_count_overflows.size());
+    header.checksum = checkpoint_checksum(header, columns);
+
+    // Write the whole checkpoint next to the previous one, then replace it in one step. Every
+    // writer has a temporary file of its own, so processes sharing a cache never write into each other's
+    std::vector<char> temporary_name(filename.begin(), filename.end());
+    const char suffix[] = ".XXXXXX";
+    temporary_name.insert(temporary_name.end(), suffix, suffix + sizeof(suffix));
+
+    int fd = mkstemp(temporary_name.data());
+    if (fd < 0) {
+        return false;
+    }
+    std::string temporary_filename = temporary_name.data();
+
+    // mkstemp() only lets the owner read the file, where a checkpoint is readable by everyone
+    std::FILE* file = fchmod(fd, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH) == 0 ? fdopen(fd, "wb") : nullptr;
+    if (!file) {
+        close(fd);
+        std::remove(temporary_filename.c_str());
+        return false;
+    }
+
+    size_t num_nodes = static_cast<size_t>(nodes.size());
+    bool written = std::fwrite(&header, sizeof(header), 1, file) == 1 &&
+                   std::fwrite(columns.backoff, sizeof(int32_t), num_nodes, file) == num_nodes &&
+                   std::fwrite(columns.collision_count_overflows, sizeof(int32_t), overflows.size(), file) ==
+                       overflows.size() &&
+                   std::fwrite(columns.collision_count, sizeof(uint8_t), num_nodes, file) == num_nodes;
+
+    written = std::fflush(file) == 0 && written;
+    written = fsync(fileno(file)) == 0 && written;
+    written = std::fclose(file) == 0 && written;
+
+    if (!written || std::rename(temporary_filename.c_str(), filename.c_str()) != 0) {
+        std::remove(temporary_filename.c_str());
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Check that the state of the nodes in a checkpoint is one a simulation can reach.
+ *
+ * @param header The header of the checkpoint.
+ * @param columns The columns of the node table.
+ * @return bool True if every value is within its range, false otherwise.
+ */
+static bool valid_checkpoint_state(const CheckpointHeader& header, const CheckpointColumns& columns) {
+    if (header.current_tick < 0 || header.num_successful_transmission_ticks < 0 ||
+        header.num_successful_transmission_ticks > header.current_tick || header.flags > 1 ||
+        (header.flags && (header.active_node_id < 0 || header.active_node_id >= header.num_nodes ||
+                          header.packet_ticks_remaining < 1))) {
+        return false;
+    }
+
+    int32_t num_overflowing_nodes = 0;
+    for (int32_t i = 0; i < header.num_nodes; i++) {
+        if (columns.backoff[i] < 0) {
+            return false;
+        }
+        num_overflowing_nodes += columns.collision_count[i] == COLLISION_COUNT_OVERFLOW;
+    }
+
+    // Every overflowing byte has exactly one large count, in increasing order of node ID
+    if (num_overflowing_nodes != header.num_collision_count_overflows) {
+        return false;
+    }
+    for (int32_t i = 0; i < header.num_collision_count_overflows; i++) {
+        int32_t node_id = columns.collision_count_overflows[2 * i];
+        if (node_id < 0 || node_id >= header.num_nodes || columns.collision_count[node_id] != COLLISION_COUNT_OVERFLOW ||
+            (i > 0 && node_id <= columns.collision_count_overflows[2 * i - 2]) ||
+            columns.collision_count_overflows[2 * i + 1] < COLLISION_COUNT_OVERFLOW) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool read_checkpoint(const std::string& filename, uint64_t fingerprint, int num_nodes,
+                     SimulationSnapshot& snapshot, std::string& error) {
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        error = "could not open checkpoint " + filename;
+        return false;
+    }
+
+    struct stat status;
+    if (fstat(fd, &status) != 0 || status.st_size < static_cast<off_t>(sizeof(CheckpointHeader))) {
+        close(fd);
+        error = filename + " is not a checkpoint";
+        return false;
+    }
+
+    size_t size = static_cast<size_t>(status.st_size);
+    void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        error = "could not map checkpoint " + filename;
+        return false;
+    }
+
+    CheckpointHeader header;
+    std::memcpy(&header, mapping, sizeof(header));
+    size_t column_size = header.num_nodes > 0 ? static_cast<size_t>(header.num_nodes) : 0;
+    size_t num_overflows = header.num_collision_count_overflows > 0
+                               ? static_cast<size_t>(header.num_collision_count_overflows)
+                               : 0;
+    const int32_t* data = reinterpret_cast<const int32_t*>(static_cast<const char*>(mapping) + sizeof(header));
+    CheckpointColumns columns = {data, data + column_size,
+                                 reinterpret_cast<const uint8_t*>(data + column_size + 2 * num_overflows)};
+
+    bool valid = false;
+    if (std::memcmp(header.magic, CHECKPOINT_MAGIC, sizeof(header.magic)) != 0) {
+        error = filename + " is not a checkpoint";
+    } else if (header.byte_order != CHECKPOINT_BYTE_ORDER) {
+        error = "checkpoint " + filename + " was written on a machine with another byte order";
+    } else if (header.num_nodes < 0 || header.num_collision_count_overflows < 0 ||
+               size != sizeof(header) + (column_size + 2 * num_overflows) * sizeof(int32_t) + column_size) {
+        error = "checkpoint " + filename + " is truncated";
+    } else if (header.checksum != checkpoint_checksum(header, columns)) {
+        error = "checkpoint " + filename + " is corrupted";
+    } else if (header.fingerprint != fingerprint || header.num_nodes != num_nodes) {
+        error = "checkpoint " + filename + " was written by a run with other parameters or policies";
+    } else if (!valid_checkpoint_state(header, columns)) {
+        error = "checkpoint " + filename + " holds an invalid state";
+    } else {
+        valid = true;
+    }
+
+    if (valid) {
+        NodeTable& nodes = snapshot.nodes;
+        nodes.backoff.assign(columns.backoff, columns.backoff + column_size);
+        nodes.collision_count.assign(columns.collision_count, columns.collision_count + column_size);
+        nodes.collision_count_overflows.clear();
+        for (size_t i = 0; i < num_overflows; i++) {
+            nodes.collision_count_overflows[columns.collision_count_overflows[2 * i]] =
+                columns.collision_count_overflows[2 * i + 1];
+        }
+        snapshot.channel_occupied = header.flags != 0;
+        snapshot.active_node_id = header.active_node_id;
+        snapshot.packet_ticks_remaining = header.packet_ticks_remaining;
+        snapshot.current_tick = header.current_tick;
+        snapshot.num_successful_transmission_ticks = header.num_successful_transmission_ticks;
+    }
+
+    munmap(mapping, size);
+    return valid;
+}
+
+CheckpointWriter::CheckpointWriter(const std::string& filename, long long interval, uint64_t fingerprint)
+    : filename_(filename),
+      interval_(interval),
+      fingerprint_(fingerprint),
+      next_(0),
+      failed_(false) {}
+
+CheckpointWriter::~CheckpointWriter() {
+    close();
+}
+
+void CheckpointWriter::commit() {
+    // The other snapshot is free again once its write is done
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+
+    const SimulationSnapshot* snapshot = &snapshots_[next_];
+    thread_ = std::thread([this, snapshot] {
+        if (!write_checkpoint(filename_, *snapshot, fingerprint_)) {
+            failed_ = true;
+        }
+    });
+    next_ ^= 1;
+}
+
+bool CheckpointWriter::close() {
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    return !failed_;
+}
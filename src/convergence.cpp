@@ -0,0 +1,192 @@
+/**
+ * @file convergence.cpp
+ * @brief Implementation of the early termination of converged simulations.
+ *
+ * @author Vicky Chen (chen-vv)
+ * @author Eric Omielan (eomielan)
+ * @bug No known bugs.
+ */
+
+/* -- Includes -- */
+
+/* Standard library includes. */
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <vector>
+
+/* Custom includes */
+#include "include/convergence.h"
+#include "include/replication.h"
+
+long long default_batch_ticks(const SimulationConfig& config) {
+    // Every node transmits or backs off with its largest window several times in a batch
+    long long cycle = static_cast<long long>(config.num_nodes) * (config.packet_length + 1LL) + config.R.back();
+    return std::max(1000LL, 10 * std::min(cycle, LLONG_MAX / 10));
+}
+
+/**
+ * @brief Estimate the steady-state utilization from the utilization of every batch so far.
+ *
+ * @param batches The successful ticks of every batch, in order.
+ * @param batch_ticks The number of ticks of every batch.
+ * @param result Set to the warm-up, the number of batches after it and the estimate.
+ */
+static void estimate(const std::vector<long long>& batches, long long batch_ticks, ConvergenceResult& result) {
+    size_t num_batches = batches.size();
+    size_t best_warmup = 0;
+    long double best_statistic = 0;
+    long double best_sum = 0;
+    long double best_sum_of_squares = 0;
+
+    // Sums over the batches after the warm-up, from the end, so every warm-up length costs one step
+    long double sum = 0;
+    long double sum_of_squares = 0;
+
+    for (size_t i = num_batches; i-- > 0;) {
+        long double value = static_cast<long double>(batches[i]);
+        sum += value;
+        sum_of_squares += value * value;
+
+        if (i > num_batches / 2) {
+            continue;
+        }
+
+        long double remaining = static_cast<long double>(num_batches - i);
+        long double statistic = (sum_of_squares - sum * sum / remaining) / (remaining * remaining);
+
+        // Ties go to the shortest warm-up, which keeps the most batches
+        if (i == num_batches / 2 || statistic <= best_statistic) {
+            best_warmup = i;
+            best_statistic = statistic;
+            best_sum = sum;
+            best_sum_of_squares = sum_of_squares;
+        }
+    }
+
+    long long remaining = static_cast<long long>(num_batches - best_warmup);
+    long double ticks = static_cast<long double>(batch_ticks);
+    long double variance = std::max(0.0L, (best_sum_of_squares - best_sum * best_sum / remaining) / (remaining - 1));
+
+    result.warmup_ticks = static_cast<long long>(best_warmup) * batch_ticks;
+    result.num_batches = remaining;
+    result.steady_successful_ticks = 0;
+    for (size_t i = best_warmup; i < num_batches; i++) {
+        result.steady_successful_ticks += batches[i];
+    }
+    result.steady_ticks = remaining * batch_ticks;
+    result.ci_half_width = student_t_975(remaining - 1) * static_cast<double>(std::sqrt(variance / remaining) / ticks);
+}
+
+/**
+ * @brief Run a simulation with the given policies in batches until its utilization converges.
+ *
+ * @tparam SimulationType The instantiation of BasicSimulation with the selected policies.
+ * @param config The parameters of the simulation.
+ * @param options How the simulation is run.
+ * @param convergence When the simulation may stop.
+ * @return ConvergenceResult The results of the ticks that were simulated, and the estimate.
+ */
+template <typename SimulationType>
+static ConvergenceResult converge_as(const SimulationConfig& config, const SimulationOptions& options,
+                                     const ConvergenceOptions& convergence) {
+    ConvergenceResult result;
+    result.estimated = true;
+    result.converged = false;
+    result.batch_ticks = convergence.batch_ticks > 0 ? convergence.batch_ticks : default_batch_ticks(config);
+    result.warmup_ticks = 0;
+    result.num_batches = 0;
+    result.steady_successful_ticks = 0;
+    result.steady_ticks = 0;
+    result.ci_half_width = 0;
+
+    SimulationType simulation(config, options);
+    std::vector<long long> batches;
+    size_t next_check = 2 * CONVERGENCE_MIN_BATCHES;
+    long long tick = 0;
+
+    result.results = simulation.run(0);
+
+    while (tick < config.total_simulation_time) {
+        long long previous_successful_ticks = result.results.num_successful_transmission_ticks;
+        long long end_tick = result.batch_ticks > config.total_simulation_time - tick ? config.total_simulation_time
+                                                                                      : tick + result.batch_ticks;
+        result.results = simulation.run(end_tick);
+
+        if (end_tick - tick < result.batch_ticks) {
+            // A batch cut short by T is not part of the estimate
+            break;
+        }
+
+        tick = end_tick;
+        batches.push_back(result.results.num_successful_transmission_ticks - previous_successful_ticks);
+
+        // The estimate is checked on a geometric schedule, so the checks cost a fraction of the batches
+        if (batches.size() >= next_check) {
+            estimate(batches, result.batch_ticks, result);
+
+            if (result.ci_half_width <= convergence.tolerance && tick < config.total_simulation_time) {
+                result.converged = true;
+                return result;
+            }
+            next_check = std::max(batches.size() + 1, batches.size() * 21 / 20);
+        }
+    }
+
+    if (batches.size() >= 2 * CONVERGENCE_MIN_BATCHES) {
+        estimate(batches, result.batch_ticks, result);
+    } else {
+        // Too short to tell the warm-up apart, so the whole run is the estimate
+        result.steady_successful_ticks = result.results.num_successful_transmission_ticks;
+        result.steady_ticks = result.results.total_simulation_time;
+        result.num_batches = static_cast<long long>(batches.size());
+    }
+
+    return result;
+}
+
+/**
+ * @brief Run a simulation until it converges, with the given backoff policy and the window policy of the options.
+ *
+ * @tparam Backoff The backoff policy.
+ */
+template <typename Backoff>
+static ConvergenceResult converge_with(const SimulationConfig& config, const SimulationOptions& options,
+                                       const ConvergenceOptions& convergence) {
+    if (options.window_policy == WINDOW_BINARY_EXPONENTIAL) {
+        return converge_as<BasicSimulation<Backoff, BinaryExponentialWindow>>(config, options, convergence);
+    }
+
+    return converge_as<BasicSimulation<Backoff, TableWindow>>(config, options, convergence);
+}
+
+ConvergenceResult run_until_converged(const SimulationConfig& config, SimulationOptions options,
+                                      const ConvergenceOptions& convergence) {
+    switch (options.backoff_policy) {
+        case BACKOFF_UNIFORM:
+            return converge_with<UniformBackoff>(config, options, convergence);
+
+        case BACKOFF_P_PERSISTENT:
+            return converge_with<PPersistentBackoff>(config, options, convergence);
+
+        case BACKOFF_DETERMINISTIC:
+        default:
+            break;
+    }
+
+    // A deterministic run becomes periodic, so cycle detection gives its exact result at T
+    options.detect_cycles = true;
+    options.engine = ENGINE_NEXT_EVENT;
+
+    ConvergenceResult result;
+    result.results = run_simulation(config, options);
+    result.estimated = false;
+    result.converged = false;
+    result.batch_ticks = 0;
+    result.warmup_ticks = 0;
+    result.num_batches = 0;
+    result.steady_successful_ticks = result.results.num_successful_transmission_ticks;
+    result.steady_ticks = result.results.total_simulation_time;
+    result.ci_half_width = 0;
+    return result;
+}
@@ -2,8 +2,9 @@
  * @file csma.cpp
  * @brief A toy simulation of the Carrier Sense Multiple Access (CSMA) protocol.
  *
- * This file contains the function implementations and main() function
- * of the CSMA simulation. 
+ * This file contains the command line handling and the main() function
+ * of the CSMA simulation. The simulation itself
+ * is implemented by the Simulation class in simulation.cpp.
  *
  * @author Vicky Chen (chen-vv)
  * @author Eric Omielan (eomielan)
@@ -15,104 +16,616 @@
 /* Standard library includes. */
 #include <iostream>
 #include <fstream>
-#include <sstream>
 #include <string>
+#include <cstdio>
 #include <cstdlib>
-#include <iomanip>
+#include <cstring>
+#include <memory>
 
 /* Custom includes */
 #include "include/csma.h"
+#include "include/async_log.h"
+#include "include/checkpoint.h"
+#include "include/convergence.h"
+#include "include/distributed.h"
+#include "include/input_file.h"
+#include "include/node_stats.h"
+#include "include/profile.h"
+#include "include/replication.h"
+#include "include/report.h"
+#include "include/result_cache.h"
+#include "include/server.h"
+#include "include/sweep.h"
+#include "include/trace.h"
+#include "include/traffic.h"
+#include "include/verify.h"
 
-void assign_values(std::ifstream& input_file) {
-    std::string line;
+/**
+ * @brief Match a command line option that takes a value, given either as
+ * "--name value" or as "--name=value".
+ * 
+ * @param argc The number of command-line arguments.
+ * @param argv An array of strings containing the command-line arguments.
+ * @param i The index of the argument to match, advanced past the value if it is
+ * given as a separate argument.
+ * @param name The name of the option, including the leading dashes.
+ * @param value Set to the value of the option if the argument matches.
+ * @return bool True if the argument is the given option, false otherwise.
+ */
+static bool match_option(int argc, char* argv[], int& i, const char* name, std::string& value) {
+    size_t name_length = std::strlen(name);
 
-    while (std::getline(input_file, line)) {
-        std::stringstream ss(line);
-        char parameter;
-        ss >> parameter;
+    if (std::strncmp(argv[i], name, name_length) != 0) {
+        return false;
+    }
 
-        switch (parameter) {
-            case 'N': {
-                int N;
-                ss >> N;
-                nodes.resize(N);
-                break;
-            }
+    if (argv[i][name_length] == '=') {
+        value = argv[i] + name_length + 1;
+        return true;
+    }
 
-            case 'L':
-                ss >> packet_length;
-                break;
+    if (argv[i][name_length] != '\0') {
+        return false;
+    }
 
-            case 'M':
-                ss >> max_retransmission_attempt;
-                break;
+    value = i + 1 < argc ? argv[++i] : "";
+    return true;
+}
 
-            case 'R': {
-                int r_value;
-                while (ss >> r_value) {
-                    R.push_back(r_value);
-                }
-                break;
-            }
+/**
+ * @brief The command line options that cannot be given with every other option, one bit each.
+*/
+enum CommandOption {
+    OPTION_SWEEP = 1 << 0,              /**< --sweep */
+    OPTION_COORDINATOR = 1 << 1,        /**< --coordinator */
+    OPTION_WORKER = 1 << 2,             /**< --worker */
+    OPTION_DOMAINS = 1 << 3,            /**< --domains */
+    OPTION_TRAFFIC = 1 << 4,            /**< --traffic */
+    OPTION_SERVE = 1 << 5,              /**< --serve */
+    OPTION_VERIFY = 1 << 6,             /**< --verify */
+    OPTION_STRESS = 1 << 7,             /**< --stress */
+    OPTION_REPLICATIONS = 1 << 8,       /**< --replications */
+    OPTION_TRACE = 1 << 9,              /**< --trace */
+    OPTION_NODE_STATS = 1 << 10,        /**< --node-stats */
+    OPTION_PROFILE = 1 << 11,           /**< --profile */
+    OPTION_CHECKPOINT_EVERY = 1 << 12,  /**< --checkpoint-every */
+    OPTION_RESUME = 1 << 13,            /**< --resume */
+    OPTION_REPORT_INTERVAL = 1 << 14,   /**< --report-interval */
+    OPTION_CONVERGE = 1 << 15,          /**< --converge */
+    OPTION_CACHE = 1 << 16,             /**< --cache */
+    OPTION_ASYNC_LOG = 1 << 17,         /**< --async-log */
+    OPTION_CYCLE_DETECT = 1 << 18,      /**< --cycle-detect */
+    OPTION_SOCKET = 1 << 19,            /**< --socket */
+    OPTION_SHARD_POINTS = 1 << 20,      /**< --shard-points */
+    OPTION_SHARD_TIMEOUT = 1 << 21,     /**< --shard-timeout */
+    OPTION_CI_WIDTH = 1 << 22,          /**< --ci-width */
+    OPTION_REPORT_FILE = 1 << 23,       /**< --report-file */
+    OPTION_CONVERGE_BATCH = 1 << 24     /**< --converge-batch */
+};
+
+/** @brief The options that choose what the program runs, of which at most one may be given. */
+#define MODE_OPTIONS (OPTION_SWEEP | OPTION_WORKER | OPTION_DOMAINS | OPTION_TRAFFIC | OPTION_SERVE | \
+                      OPTION_VERIFY | OPTION_STRESS | OPTION_REPLICATIONS)
+
+/** @brief The options of a single run, which need an input file with a single scenario. */
+#define SINGLE_RUN_OPTIONS (OPTION_TRACE | OPTION_NODE_STATS | OPTION_PROFILE | OPTION_CHECKPOINT_EVERY | \
+                            OPTION_RESUME | OPTION_REPORT_INTERVAL | OPTION_CONVERGE)
+
+/**
+ * @brief What a command line option needs, and what it cannot be combined with.
+*/
+struct OptionRule {
+    unsigned option;            /**< The CommandOption. */
+    const char* name;           /**< The name of the option, including the leading dashes. */
+    unsigned needs;             /**< The options that must be given with it. */
+    unsigned conflicts;         /**< The options that cannot be given with it. */
+};
+
+/**
+ * @brief Every option of CommandOption, in the order they are checked.
+ *
+ * A conflict only needs to be listed on one of its two options. The modes exclude
+ * each other and the options of a single run. What a mode accepts is everything
+ * it does not list, so for instance --domains and --serve both run through --cache.
+ */
+static const OptionRule option_rules[] = {
+    {OPTION_SWEEP, "--sweep", 0, (MODE_OPTIONS & ~OPTION_SWEEP) | SINGLE_RUN_OPTIONS | OPTION_ASYNC_LOG},
+    {OPTION_COORDINATOR, "--coordinator", OPTION_SWEEP, OPTION_CACHE},
+    {OPTION_WORKER, "--worker", 0, (MODE_OPTIONS & ~OPTION_WORKER) | SINGLE_RUN_OPTIONS | OPTION_CACHE | OPTION_ASYNC_LOG},
+    {OPTION_DOMAINS, "--domains", 0, (MODE_OPTIONS & ~OPTION_DOMAINS) | SINGLE_RUN_OPTIONS | OPTION_ASYNC_LOG},
+    {OPTION_TRAFFIC, "--traffic", 0,
+     (MODE_OPTIONS & ~OPTION_TRAFFIC) | SINGLE_RUN_OPTIONS | OPTION_CACHE | OPTION_ASYNC_LOG | OPTION_CYCLE_DETECT},
+    {OPTION_SERVE, "--serve", 0, (MODE_OPTIONS & ~OPTION_SERVE) | SINGLE_RUN_OPTIONS | OPTION_ASYNC_LOG},
+    {OPTION_VERIFY, "--verify", 0, (MODE_OPTIONS & ~OPTION_VERIFY) | SINGLE_RUN_OPTIONS | OPTION_CACHE | OPTION_ASYNC_LOG},
+    {OPTION_STRESS, "--stress", 0, (MODE_OPTIONS & ~OPTION_STRESS) | SINGLE_RUN_OPTIONS | OPTION_CACHE | OPTION_ASYNC_LOG},
+    {OPTION_REPLICATIONS, "--replications", 0,
+     (MODE_OPTIONS & ~OPTION_REPLICATIONS) | SINGLE_RUN_OPTIONS | OPTION_CACHE | OPTION_ASYNC_LOG},
+    {OPTION_TRACE, "--trace", 0, OPTION_CHECKPOINT_EVERY | OPTION_RESUME | OPTION_CACHE},
+    {OPTION_NODE_STATS, "--node-stats", 0, OPTION_CHECKPOINT_EVERY | OPTION_RESUME | OPTION_CACHE},
+    {OPTION_PROFILE, "--profile", 0, OPTION_CACHE},
+    {OPTION_CHECKPOINT_EVERY, "--checkpoint-every", 0, OPTION_CONVERGE | OPTION_CACHE},
+    {OPTION_RESUME, "--resume", 0, OPTION_REPORT_INTERVAL | OPTION_CONVERGE | OPTION_CACHE},
+    {OPTION_REPORT_INTERVAL, "--report-interval", 0, OPTION_CACHE | OPTION_CYCLE_DETECT},
+    {OPTION_CONVERGE, "--converge", 0, OPTION_CACHE},
+    {OPTION_CACHE, "--cache", 0, 0},
+    {OPTION_ASYNC_LOG, "--async-log", 0, 0},
+    {OPTION_CYCLE_DETECT, "--cycle-detect", 0, 0},
+    {OPTION_SOCKET, "--socket", OPTION_SERVE, 0},
+    {OPTION_SHARD_POINTS, "--shard-points", OPTION_COORDINATOR, 0},
+    {OPTION_SHARD_TIMEOUT, "--shard-timeout", OPTION_COORDINATOR, 0},
+    {OPTION_CI_WIDTH, "--ci-width", OPTION_REPLICATIONS, 0},
+    {OPTION_REPORT_FILE, "--report-file", OPTION_REPORT_INTERVAL, 0},
+    {OPTION_CONVERGE_BATCH, "--converge-batch", OPTION_CONVERGE, 0}
+};
+
+/**
+ * @brief List the names of a set of options, as "--a", "--a or --b" or "--a, --b or --c".
+ * 
+ * @param options The CommandOption bits of the options, at least one.
+ * @param conjunction The word before the last name, such as "or" or "and".
+ * @return std::string The names, in the order of option_rules.
+ */
+static std::string option_names(unsigned options, const char* conjunction) {
+    std::string names;
+
+    for (const OptionRule& rule : option_rules) {
+        if (!(options & rule.option)) {
+            continue;
+        }
+        options &= ~rule.option;
+
+        if (!names.empty()) {
+            names += options ? ", " : std::string(" ") + conjunction + " ";
+        }
+        names += rule.name;
+    }
+
+    return names;
+}
+
+/**
+ * @brief Check that every option given has the options it needs, and none it cannot be combined with.
+ * 
+ * @param given The CommandOption bits of the options given.
+ * @return bool True if the options can be combined, false otherwise, after printing the problem.
+ */
+static bool check_option_rules(unsigned given) {
+    for (const OptionRule& rule : option_rules) {
+        if (!(given & rule.option)) {
+            continue;
+        }
+
+        if ((given & rule.needs) != rule.needs) {
+            std::cerr << "Error: " << rule.name << " needs " << option_names(rule.needs & ~given, "and") << std::endl;
+            return false;
+        }
+
+        if (given & rule.conflicts) {
+            std::cerr << "Error: " << rule.name << " cannot be combined with " << option_names(given & rule.conflicts, "or")
+                      << std::endl;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief The synopsis of one mode of the program, as printed by the usage.
+*/
+struct ModeUsage {
+    unsigned mode;              /**< The CommandOption bits that select the mode, or 0 for a run of an input file. */
+    const char* synopsis;       /**< The arguments of the mode, after the name of the program. */
+};
 
-            case 'T':
-                ss >> total_simulation_time;
-                break;
+/** @brief The synopsis of every mode, in the order they are printed, with a newline where it continues. */
+static const ModeUsage mode_usages[] = {
+    {0, "[run options] [engine options] [policy options] <inputfilename> [outputfilename]"},
+    {OPTION_DOMAINS, "--domains [--threads <count>] [--cache <directory>] [engine options] [policy options]\n"
+                     "<inputfilename> [outputfilename]"},
+    {OPTION_TRAFFIC, "--traffic [--threads <count>] [policy options] <inputfilename> [outputfilename]"},
+    {OPTION_SWEEP, "--sweep [--threads <count>] [--cache <directory>] [engine options] [policy options]\n"
+                   "<gridfilename> [outputfilename]"},
+    {OPTION_SWEEP | OPTION_COORDINATOR, "--sweep --coordinator <port> [--shard-points <count>] [--shard-timeout <seconds>]\n"
+                                        "[engine options] [policy options] <gridfilename> [outputfilename]"},
+    {OPTION_WORKER, "--worker <host>:<port> [--threads <count>]"},
+    {OPTION_SERVE, "--serve [--socket <socketpath>] [--threads <count>] [--cache <directory>]\n"
+                   "[engine options] [policy options]"},
+    {OPTION_VERIFY, "--verify [policy options] <inputfilename>"},
+    {OPTION_STRESS, "--stress <count> [--seed <seed>]"}
+};
 
-            default:
-                std::cerr << "Unknown parameter: " << parameter << std::endl;
+/**
+ * @brief Print the usage of the mode selected by the options given, or of every mode if none is.
+ * 
+ * @param program The name of the program.
+ * @param given The CommandOption bits of the options given.
+ */
+static void print_usage(const char* program, unsigned given) {
+    unsigned mode_options = 0;
+    for (const ModeUsage& usage : mode_usages) {
+        mode_options |= usage.mode;
+    }
+    unsigned mode = given & mode_options;
+    bool any_mode = false;
+    for (const ModeUsage& usage : mode_usages) {
+        any_mode = any_mode || (mode != 0 && usage.mode == mode);
+    }
+
+    const char* prefix = "Usage: ";
+    std::string indent(std::strlen(prefix) + std::strlen(program) + 3, ' ');
+
+    for (const ModeUsage& usage : mode_usages) {
+        if (any_mode && usage.mode != mode) {
+            continue;
+        }
+
+        std::string synopsis = usage.synopsis;
+        for (size_t newline = synopsis.find('\n'); newline != std::string::npos; newline = synopsis.find('\n', newline + 1)) {
+            synopsis.insert(newline + 1, indent);
         }
+        std::cerr << prefix << program << " " << synopsis << std::endl;
+        prefix = "       ";
+    }
+
+    if (!any_mode) {
+        std::cerr << "Run options: [--replications <count> [--ci-width <width>]] [--threads <count>] [--trace <tracefilename>]\n"
+                     "             [--node-stats] [--profile] [--checkpoint-every <ticks>] [--resume <checkpointfilename>]\n"
+                     "             [--report-interval <ticks> [--report-file <reportfilename>]]\n"
+                     "             [--converge <tolerance> [--converge-batch <ticks>]] [--cache <directory>] [--async-log block|drop]"
+                  << std::endl;
+    }
+    std::cerr << "Engine options: [--engine small|tick|reference|event|simd|group|batch] [--cycle-detect]" << std::endl;
+    std::cerr << "Policy options: [--backoff deterministic|uniform|p-persistent] [--window table|beb]\n"
+                 "                [--seed <seed>] [--persistence <p>]" << std::endl;
+    std::cerr << "Every mode takes [--log-level off|summary|events|full-trace]." << std::endl;
+}
+
+/**
+ * @brief Log how many runs the result cache of the options answered, at the summary level.
+ * 
+ * @param options The options the runs used.
+ */
+static void log_cache_summary(const SimulationOptions& options) {
+    if (options.result_cache && options.log_level >= LOG_SUMMARY) {
+        std::cout << "Result cache: " << options.result_cache->num_reused() << " reused, "
+                  << options.result_cache->num_extended() << " extended, "
+                  << options.result_cache->num_simulated() << " simulated" << std::endl;
+    }
+}
+
+/**
+ * @brief Run a list of simulations on a thread pool and write the results table.
+ * 
+ * @param configs The configurations to run, which must all be valid.
+ * @param output_filename The name of the file to write the results table to.
+ * @param options The engine options used for every point.
+ * @param num_threads The number of worker threads, or 0 for one per hardware thread.
+ * @param mode The name of the mode, for the summary.
+ * @return int EXIT_SUCCESS on success, EXIT_FAILURE on failure.
+ */
+static int run_points(const std::vector<SimulationConfig>& configs, const char* output_filename,
+                      const SimulationOptions& options, int num_threads, const char* mode) {
+    std::vector<SimulationResults> results = run_sweep(configs, options, num_threads);
+
+    std::ofstream output_file(output_filename);
+
+    if (!output_file.is_open()) {
+        std::cerr << "Error: Unable to open file " << output_filename << std::endl;
+        return EXIT_FAILURE;
     }
+
+    write_sweep_results(output_file, configs, results);
+
+    if (options.log_level >= LOG_SUMMARY) {
+        std::cout << mode << " of " << configs.size() << " points written to " << output_filename << std::endl;
+    }
+    log_cache_summary(options);
+
+    return EXIT_SUCCESS;
 }
 
-int generate_backoff(int node_id, int ticks, int R) {
-    int backoff = (node_id + ticks) % R;
-    return backoff;
+/**
+ * @brief Run every scenario of an input file as an independent collision domain and
+ * write the per-domain and total results.
+ * 
+ * @param configs The configurations of the domains, which must all be valid.
+ * @param names The names of the domains.
+ * @param output_filename The name of the file to write the results table to.
+ * @param options The engine options used for every domain.
+ * @param num_threads The number of worker threads, or 0 for one per hardware thread.
+ * @return int EXIT_SUCCESS on success, EXIT_FAILURE on failure.
+ */
+static int run_domain_mode(const std::vector<SimulationConfig>& configs, const std::vector<std::string>& names,
+                           const char* output_filename, const SimulationOptions& options, int num_threads) {
+    // The domains share nothing, so every worker is pinned to a core of its own
+    std::vector<SimulationResults> results = run_sweep(configs, options, num_threads, true);
+
+    std::ofstream output_file(output_filename);
+
+    if (!output_file.is_open()) {
+        std::cerr << "Error: Unable to open file " << output_filename << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    write_domain_results(output_file, names, configs, results);
+
+    if (options.log_level >= LOG_SUMMARY) {
+        std::cout << "Results of " << configs.size() << " domains written to " << output_filename << std::endl;
+    }
+    log_cache_summary(options);
+
+    return EXIT_SUCCESS;
 }
 
-void set_channel_occupied(bool is_occupied) {
-    channel_occupied = is_occupied;
+/**
+ * @brief Run every scenario of an input file with non-saturated traffic and write the results table.
+ * 
+ * @param configs The configurations of the scenarios, which must all be valid.
+ * @param traffic The traffic of the scenarios, which must all be valid.
+ * @param names The names of the scenarios.
+ * @param output_filename The name of the file to write the results table to.
+ * @param options The policy options used for every scenario.
+ * @param num_threads The number of worker threads, or 0 for one per hardware thread.
+ * @return int EXIT_SUCCESS on success, EXIT_FAILURE on failure.
+ */
+static int run_traffic_mode(const std::vector<SimulationConfig>& configs, const std::vector<TrafficConfig>& traffic,
+                            const std::vector<std::string>& names, const char* output_filename,
+                            const SimulationOptions& options, int num_threads) {
+    std::vector<TrafficResults> results;
+    std::string error;
+
+    if (!run_traffic_scenarios(configs, traffic, options, num_threads, results, error)) {
+        std::cerr << "Error: " << error << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::ofstream output_file(output_filename);
+
+    if (!output_file.is_open()) {
+        std::cerr << "Error: Unable to open file " << output_filename << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    write_traffic_results(output_file, names, configs, results);
+
+    if (options.log_level >= LOG_SUMMARY) {
+        std::cout << "Traffic results of " << configs.size() << " scenarios written to " << output_filename << std::endl;
+    }
+
+    return EXIT_SUCCESS;
 }
 
-std::vector<int> get_ready_node_ids() {
-    std::vector<int> ready_nodes;
+/**
+ * @brief Read a sweep grid file and list the configurations of its points.
+ * 
+ * @param input_filename The name of the sweep grid file.
+ * @param contents Set to the contents of the file.
+ * @param configs Set to the configurations of every point of every grid of the file.
+ * @return bool True if the file was read and every point is valid, false otherwise.
+ */
+static bool read_sweep_points(const char* input_filename, std::string& contents, std::vector<SimulationConfig>& configs) {
+    if (!read_input_file(input_filename, contents)) {
+        std::cerr << "Error: Unable to open file " << input_filename << std::endl;
+        return false;
+    }
+
+    std::vector<SweepGrid> grids;
+    std::string error;
+
+    if (!parse_sweep_grids(contents, grids, error)) {
+        std::cerr << "Error: Invalid sweep file " << input_filename << ": " << error << std::endl;
+        return false;
+    }
+
+    for (const SweepGrid& grid : grids) {
+        std::vector<SimulationConfig> grid_configs = expand_sweep_grid(grid);
+        configs.insert(configs.end(), grid_configs.begin(), grid_configs.end());
+    }
 
-    for (const auto& node : nodes) {
-        if (node.backoff == READY_TO_TRANSMIT) {
-            ready_nodes.push_back(node.id);
+    for (size_t i = 0; i < configs.size(); i++) {
+        if (!validate_config(configs[i], error)) {
+            std::cerr << "Error: Invalid sweep file " << input_filename << ": point " << i + 1 << ": " << error << std::endl;
+            return false;
         }
     }
 
-    return ready_nodes;
+    return true;
 }
 
-void initialize_nodes() {
-    int curr_id = 0;
-    
-    for (auto& node : nodes) {
-        node.id = curr_id++;
-        node.collision_count = 0;
-        node.R = R[0];
-        node.backoff = generate_backoff(node.id, 0, node.R);
+/**
+ * @brief Run every point of a sweep grid file and write the results table.
+ * 
+ * @param input_filename The name of the sweep grid file.
+ * @param output_filename The name of the file to write the results table to.
+ * @param options The engine options used for every point.
+ * @param num_threads The number of worker threads, or 0 for one per hardware thread.
+ * @return int EXIT_SUCCESS on success, EXIT_FAILURE on failure.
+ */
+static int run_sweep_mode(const char* input_filename, const char* output_filename,
+                          const SimulationOptions& options, int num_threads) {
+    std::string contents;
+    std::vector<SimulationConfig> configs;
+
+    if (!read_sweep_points(input_filename, contents, configs)) {
+        return EXIT_FAILURE;
+    }
+
+    return run_points(configs, output_filename, options, num_threads, "Sweep");
+}
+
+/**
+ * @brief Share out the points of a sweep grid file to workers over TCP, and write the results table.
+ * 
+ * @param input_filename The name of the sweep grid file.
+ * @param output_filename The name of the file to write the results table to.
+ * @param options The engine and policy options the workers use for every point.
+ * @param coordinator The port and the shards.
+ * @return int EXIT_SUCCESS on success, EXIT_FAILURE on failure.
+ */
+static int run_coordinator_mode(const char* input_filename, const char* output_filename,
+                                const SimulationOptions& options, const CoordinatorOptions& coordinator) {
+    std::string contents;
+    std::vector<SimulationConfig> configs;
+
+    if (!read_sweep_points(input_filename, contents, configs)) {
+        return EXIT_FAILURE;
+    }
+
+    std::ofstream output_file(output_filename);
+
+    if (!output_file.is_open()) {
+        std::cerr << "Error: Unable to open file " << output_filename << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::vector<SimulationResults> results;
+    CoordinatorSummary summary;
+    std::string error;
+
+    if (!run_coordinator(contents, configs, options, coordinator, results, summary, error)) {
+        std::cerr << "Error: " << error << std::endl;
+        return EXIT_FAILURE;
     }
+
+    write_sweep_results(output_file, configs, results);
+
+    if (options.log_level >= LOG_SUMMARY) {
+        std::cout << "Sweep of " << configs.size() << " points written to " << output_filename << ", " << summary.num_shards
+                  << " shards run by " << summary.num_workers << " workers, " << summary.num_reassigned << " reassigned"
+                  << std::endl;
+    }
+
+    return EXIT_SUCCESS;
 }
 
-void transmit_packet(int active_node_id, int ticks) {
-    std::cout << "Channel is occupied by node " << active_node_id << std::endl;
+/**
+ * @brief Run the shards of a coordinator until it has none left.
+ * 
+ * @param address The host and the port of the coordinator, as <host>:<port>.
+ * @param options The options whose log level is used.
+ * @param num_threads The number of worker threads, or 0 for one per hardware thread.
+ * @return int EXIT_SUCCESS once the coordinator is done, EXIT_FAILURE on failure.
+ */
+static int run_worker_mode(const std::string& address, const SimulationOptions& options, int num_threads) {
+    long long num_shards = 0;
+    std::string error;
+
+    if (!run_worker(address, num_threads, num_shards, error)) {
+        std::cerr << "Error: " << error << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    if (options.log_level >= LOG_SUMMARY) {
+        std::cout << "Worker ran " << num_shards << " shards of " << address << std::endl;
+    }
 
-    Node& active_node = nodes[active_node_id];
-    active_node.packet_ticks_remaining--;
+    return EXIT_SUCCESS;
+}
 
-    if (active_node.packet_ticks_remaining == TRANSMIT_COMPLETE) {
-        active_node.R = R[0];
-        active_node.collision_count = 0;
-        active_node.backoff = generate_backoff(active_node.id, ticks + 1, active_node.R);
-        set_channel_occupied(false);
+/**
+ * @brief Answer simulation requests on standard input, or on a Unix domain socket, until
+ * the input ends or the server fails.
+ * 
+ * @param socket_path The path of the socket, or empty to serve standard input and output.
+ * @param options The engine and policy options used for every request.
+ * @param num_threads The number of worker threads, or 0 for one per hardware thread.
+ * @return int EXIT_SUCCESS once standard input has been served, EXIT_FAILURE on failure.
+ */
+static int run_server_mode(const std::string& socket_path, const SimulationOptions& options, int num_threads) {
+    std::string error;
 
-        std::cout << "Node " << active_node_id << " finished transmitting. new backoff " << nodes[active_node_id].backoff  << std::endl;
+    if (socket_path.empty() ? !serve_standard_streams(options, num_threads, error)
+                            : !serve_socket(socket_path, options, num_threads, error)) {
+        std::cerr << "Error: " << error << std::endl;
+        return EXIT_FAILURE;
     }
 
-    num_successful_transmission_ticks++;
+    log_cache_summary(options);
+    return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Run replicas of the simulation of an input file and write their summary.
+ * 
+ * @param config The parameters of the simulation, which must be valid.
+ * @param output_filename The name of the file to write the summary to.
+ * @param options How every replica is run.
+ * @param num_replications The number of replicas, or the most to run with a CI width.
+ * @param max_ci_width The confidence interval width to stop at, or 0 to run every replica.
+ * @param num_threads The number of worker threads, or 0 for one per hardware thread.
+ * @return int EXIT_SUCCESS on success, EXIT_FAILURE on failure.
+ */
+static int run_replication_mode(const SimulationConfig& config, const char* output_filename,
+                                const SimulationOptions& options, long long num_replications,
+                                double max_ci_width, int num_threads) {
+    ReplicationSummary summary = run_replications(config, options, num_replications, max_ci_width, num_threads);
+
+    std::ofstream output_file(output_filename);
+
+    if (!output_file.is_open()) {
+        std::cerr << "Error: Unable to open file " << output_filename << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    write_replication_summary(output_file, summary);
+
+    if (options.log_level >= LOG_SUMMARY) {
+        std::cout << "Replications: " << summary.num_replications << ", mean utilization = " << summary.mean
+                  << ", 95% CI = [" << summary.mean - summary.ci_half_width << ", "
+                  << summary.mean + summary.ci_half_width << "]" << std::endl;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Check every engine against the reference engine on every scenario of an input file.
+ * 
+ * @param configs The configurations of the scenarios, which must all be valid.
+ * @param names The name of each scenario, or an empty name to number it instead.
+ * @param options The backoff and window policies, the seed and the persistence.
+ * @return int EXIT_SUCCESS if every engine matches on every scenario, EXIT_FAILURE otherwise.
+ */
+static int run_verify_mode(const std::vector<SimulationConfig>& configs, const std::vector<std::string>& names,
+                           const SimulationOptions& options) {
+    size_t num_mismatches = 0;
+    std::string mismatch;
+
+    for (size_t i = 0; i < configs.size(); i++) {
+        if (verify_engines(configs[i], options, mismatch)) {
+            continue;
+        }
+        num_mismatches++;
+
+        std::cout << "Mismatch in scenario " << (names[i].empty() ? std::to_string(i + 1) : names[i]) << ": "
+                  << mismatch << std::endl;
+    }
+
+    if (options.log_level >= LOG_SUMMARY) {
+        std::cout << "Verify: " << configs.size() << " scenarios checked against the reference engine, "
+                  << num_mismatches << " mismatches" << std::endl;
+    }
+
+    return num_mismatches == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/**
+ * @brief Check every engine against the reference engine on random configurations.
+ * 
+ * @param num_cases The number of configurations to check.
+ * @param options The options whose seed seeds the random configurations.
+ * @return int EXIT_SUCCESS if every engine matches on every configuration, EXIT_FAILURE otherwise.
+ */
+static int run_stress_mode(long long num_cases, const SimulationOptions& options) {
+    long long num_mismatches = run_stress(options.seed, num_cases, std::cout);
+
+    if (options.log_level >= LOG_SUMMARY) {
+        std::cout << "Stress: " << num_cases << " random scenarios checked against the reference engine, "
+                  << num_mismatches << " mismatches" << std::endl;
+    }
+
+    return num_mismatches == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
 }
 
 /** 
@@ -144,101 +657,514 @@ void transmit_packet(int active_node_id, int ticks) {
  * @return Returns EXIT_SUCCESS on success, EXIT_FAILURE on failure.
  */
 int main(int argc, char* argv[]) {
+    SimulationOptions options;
+    options.log_level = LOG_FULL_TRACE;
+    bool async_log = false;
+    LogBackpressure log_backpressure = LOG_BACKPRESSURE_BLOCK;
+    const char* input_filename = nullptr;
+    const char* output_filename = "output.txt";
+    int num_positional_args = 0;
+    bool sweep = false;
+    bool domains = false;
+    bool traffic = false;
+    int num_threads = 0;
+    long long num_replications = 0;
+    double max_ci_width = 0;
+    std::string trace_filename;
+    bool write_node_stats = false;
+    bool profile = false;
+    long long checkpoint_interval = 0;
+    std::string resume_filename;
+    long long report_interval = 0;
+    std::string report_filename;
+    bool converge = false;
+    ConvergenceOptions convergence = {0, 0};
+    std::string cache_directory;
+    bool serve = false;
+    std::string socket_path;
+    bool verify = false;
+    long long num_stress_cases = 0;
+    bool coordinate = false;
+    CoordinatorOptions coordinator = {0, DISTRIBUTED_DEFAULT_SHARD_POINTS, 0};
+    bool shard_points = false;
+    bool shard_timeout = false;
+    std::string worker_address;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        std::string value;
+
+        if (match_option(argc, argv, i, "--log-level", value)) {
+            if (!parse_log_level(value, options.log_level)) {
+                std::cerr << "Error: Unknown log level '" << value << "' (expected off, summary, events or full-trace)" << std::endl;
+                return EXIT_FAILURE;
+            }
+        } else if (match_option(argc, argv, i, "--async-log", value)) {
+            if (!parse_log_backpressure(value, log_backpressure)) {
+                std::cerr << "Error: Unknown backpressure policy '" << value << "' (expected block or drop)" << std::endl;
+                return EXIT_FAILURE;
+            }
+            async_log = true;
+        } else if (match_option(argc, argv, i, "--engine", value)) {
+            if (!parse_engine(value, options.engine)) {
+                std::cerr << "Error: Unknown engine '" << value << "' (expected small, tick, reference, event, simd, group or batch)" << std::endl;
+                return EXIT_FAILURE;
+            }
+        } else if (arg == "--cycle-detect") {
+            options.detect_cycles = true;
+        } else if (match_option(argc, argv, i, "--backoff", value)) {
+            if (!parse_backoff_policy(value, options.backoff_policy)) {
+                std::cerr << "Error: Unknown backoff policy '" << value << "' (expected deterministic, uniform or p-persistent)" << std::endl;
+                return EXIT_FAILURE;
+            }
+        } else if (match_option(argc, argv, i, "--window", value)) {
+            if (!parse_window_policy(value, options.window_policy)) {
+                std::cerr << "Error: Unknown window policy '" << value << "' (expected table or beb)" << std::endl;
+                return EXIT_FAILURE;
+            }
+        } else if (match_option(argc, argv, i, "--seed", value)) {
+            char* end = nullptr;
+            options.seed = std::strtoull(value.c_str(), &end, 10);
+
+            if (value.empty() || *end != '\0' || value[0] == '-') {
+                std::cerr << "Error: Invalid seed '" << value << "'" << std::endl;
+                return EXIT_FAILURE;
+            }
+        } else if (match_option(argc, argv, i, "--persistence", value)) {
+            char* end = nullptr;
+            options.persistence = std::strtod(value.c_str(), &end);
+
+            if (value.empty() || *end != '\0' || !(options.persistence > 0.0 && options.persistence <= 1.0)) {
+                std::cerr << "Error: Invalid persistence '" << value << "' (expected a probability in (0, 1])" << std::endl;
+                return EXIT_FAILURE;
+            }
+        } else if (match_option(argc, argv, i, "--replications", value)) {
+            char* end = nullptr;
+            num_replications = std::strtoll(value.c_str(), &end, 10);
+
+            if (value.empty() || *end != '\0' || num_replications < 1) {
+                std::cerr << "Error: Invalid replication count '" << value << "'" << std::endl;
+                return EXIT_FAILURE;
+            }
+        } else if (match_option(argc, argv, i, "--ci-width", value)) {
+            char* end = nullptr;
+            max_ci_width = std::strtod(value.c_str(), &end);
+
+            if (value.empty() || *end != '\0' || !(max_ci_width > 0)) {
+                std::cerr << "Error: Invalid confidence interval width '" << value << "'" << std::endl;
+                return EXIT_FAILURE;
+            }
+        } else if (match_option(argc, argv, i, "--trace", value)) {
+            trace_filename = value;
+        } else if (arg == "--node-stats") {
+            write_node_stats = true;
+        } else if (arg == "--profile") {
+            profile = true;
+        } else if (match_option(argc, argv, i, "--checkpoint-every", value)) {
+            char* end = nullptr;
+            checkpoint_interval = std::strtoll(value.c_str(), &end, 10);
+
+            if (value.empty() || *end != '\0' || checkpoint_interval < 1) {
+                std::cerr << "Error: Invalid checkpoint interval '" << value << "'" << std::endl;
+                return EXIT_FAILURE;
+            }
+        } else if (match_option(argc, argv, i, "--resume", value)) {
+            resume_filename = value;
+        } else if (match_option(argc, argv, i, "--report-interval", value)) {
+            char* end = nullptr;
+            report_interval = std::strtoll(value.c_str(), &end, 10);
+
+            if (value.empty() || *end != '\0' || report_interval < 1) {
+                std::cerr << "Error: Invalid report interval '" << value << "'" << std::endl;
+                return EXIT_FAILURE;
+            }
+        } else if (match_option(argc, argv, i, "--report-file", value)) {
+            report_filename = value;
+        } else if (match_option(argc, argv, i, "--converge", value)) {
+            char* end = nullptr;
+            convergence.tolerance = std::strtod(value.c_str(), &end);
+
+            if (value.empty() || *end != '\0' || !(convergence.tolerance > 0)) {
+                std::cerr << "Error: Invalid convergence tolerance '" << value << "'" << std::endl;
+                return EXIT_FAILURE;
+            }
+            converge = true;
+        } else if (match_option(argc, argv, i, "--converge-batch", value)) {
+            char* end = nullptr;
+            convergence.batch_ticks = std::strtoll(value.c_str(), &end, 10);
+
+            if (value.empty() || *end != '\0' || convergence.batch_ticks < 1) {
+                std::cerr << "Error: Invalid batch length '" << value << "'" << std::endl;
+                return EXIT_FAILURE;
+            }
+        } else if (match_option(argc, argv, i, "--cache", value)) {
+            cache_directory = value;
+        } else if (arg == "--serve") {
+            serve = true;
+        } else if (match_option(argc, argv, i, "--socket", value)) {
+            socket_path = value;
+        } else if (arg == "--verify") {
+            verify = true;
+        } else if (match_option(argc, argv, i, "--stress", value)) {
+            char* end = nullptr;
+            num_stress_cases = std::strtoll(value.c_str(), &end, 10);
+
+            if (value.empty() || *end != '\0' || num_stress_cases < 1) {
+                std::cerr << "Error: Invalid stress case count '" << value << "'" << std::endl;
+                return EXIT_FAILURE;
+            }
+        } else if (match_option(argc, argv, i, "--coordinator", value)) {
+            char* end = nullptr;
+            long parsed = std::strtol(value.c_str(), &end, 10);
+
+            if (value.empty() || *end != '\0' || parsed < 0 || parsed > 65535) {
+                std::cerr << "Error: Invalid port '" << value << "'" << std::endl;
+                return EXIT_FAILURE;
+            }
+            coordinator.port = static_cast<int>(parsed);
+            coordinate = true;
+        } else if (match_option(argc, argv, i, "--shard-points", value)) {
+            char* end = nullptr;
+            coordinator.shard_points = std::strtoll(value.c_str(), &end, 10);
+
+            if (value.empty() || *end != '\0' || coordinator.shard_points < 1) {
+                std::cerr << "Error: Invalid shard size '" << value << "'" << std::endl;
+                return EXIT_FAILURE;
+            }
+            shard_points = true;
+        } else if (match_option(argc, argv, i, "--shard-timeout", value)) {
+            char* end = nullptr;
+            coordinator.shard_timeout = std::strtod(value.c_str(), &end);
+
+            if (value.empty() || *end != '\0' || !(coordinator.shard_timeout > 0)) {
+                std::cerr << "Error: Invalid shard timeout '" << value << "'" << std::endl;
+                return EXIT_FAILURE;
+            }
+            shard_timeout = true;
+        } else if (match_option(argc, argv, i, "--worker", value)) {
+            if (value.empty()) {
+                std::cerr << "Error: --worker needs the <host>:<port> of a coordinator" << std::endl;
+                return EXIT_FAILURE;
+            }
+            worker_address = value;
+        } else if (arg == "--sweep") {
+            sweep = true;
+        } else if (arg == "--traffic") {
+            traffic = true;
+        } else if (arg == "--domains") {
+            domains = true;
+        } else if (match_option(argc, argv, i, "--threads", value)) {
+            char* end = nullptr;
+            long parsed = std::strtol(value.c_str(), &end, 10);
+
+            if (value.empty() || *end != '\0' || parsed < 0 || parsed > 4096) {
+                std::cerr << "Error: Invalid thread count '" << value << "'" << std::endl;
+                return EXIT_FAILURE;
+            }
+            num_threads = static_cast<int>(parsed);
+        } else if (num_positional_args == 0) {
+            input_filename = argv[i];
+            num_positional_args++;
+        } else if (num_positional_args == 1) {
+            output_filename = argv[i];
+            num_positional_args++;
+        } else {
+            num_positional_args++;
+        }
+    }
+
+    bool stress = num_stress_cases > 0;
+    bool worker = !worker_address.empty();
+    unsigned given = (sweep ? OPTION_SWEEP : 0) | (coordinate ? OPTION_COORDINATOR : 0) | (worker ? OPTION_WORKER : 0) |
+                     (domains ? OPTION_DOMAINS : 0) | (traffic ? OPTION_TRAFFIC : 0) | (serve ? OPTION_SERVE : 0) |
+                     (verify ? OPTION_VERIFY : 0) | (stress ? OPTION_STRESS : 0) |
+                     (num_replications > 0 ? OPTION_REPLICATIONS : 0) | (!trace_filename.empty() ? OPTION_TRACE : 0) |
+                     (write_node_stats ? OPTION_NODE_STATS : 0) | (profile ? OPTION_PROFILE : 0) |
+                     (checkpoint_interval > 0 ? OPTION_CHECKPOINT_EVERY : 0) | (!resume_filename.empty() ? OPTION_RESUME : 0) |
+                     (report_interval > 0 ? OPTION_REPORT_INTERVAL : 0) | (converge ? OPTION_CONVERGE : 0) |
+                     (!cache_directory.empty() ? OPTION_CACHE : 0) | (async_log ? OPTION_ASYNC_LOG : 0) |
+                     (options.detect_cycles ? OPTION_CYCLE_DETECT : 0) | (!socket_path.empty() ? OPTION_SOCKET : 0) |
+                     (shard_points ? OPTION_SHARD_POINTS : 0) | (shard_timeout ? OPTION_SHARD_TIMEOUT : 0) |
+                     (max_ci_width > 0 ? OPTION_CI_WIDTH : 0) | (!report_filename.empty() ? OPTION_REPORT_FILE : 0) |
+                     (convergence.batch_ticks > 0 ? OPTION_CONVERGE_BATCH : 0);
+
+    if (!check_option_rules(given)) {
+        return EXIT_FAILURE;
+    }
+
     // Check for the correct number of arguments
-    if (argc != 2 && argc != 3) {
-        std::cerr << "Usage: " << argv[0] << " <inputfilename> [outputfilename]" << std::endl;
+    if (serve || stress || worker ? num_positional_args != 0 : num_positional_args != 1 && num_positional_args != 2) {
+        print_usage(argv[0], given);
         return EXIT_FAILURE;
     }
 
-    // Open the input file
-    std::ifstream input_file(argv[1]);
+    if (worker) {
+        return run_worker_mode(worker_address, options, num_threads);
+    }
 
-    if (!input_file.is_open()) {
-        std::cerr << "Error: Unable to open file " << argv[1] << std::endl;
+    if (stress) {
+        return run_stress_mode(num_stress_cases, options);
+    }
+
+    if (converge && options.backoff_policy == BACKOFF_DETERMINISTIC) {
+        if (report_interval > 0) {
+            std::cerr << "Error: --converge runs the deterministic backoff policy with cycle detection, which cannot be combined with --report-interval" << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        // A deterministic run becomes periodic, so it is run to T with cycle detection instead
+        options.detect_cycles = true;
+    }
+
+    if (options.detect_cycles) {
+        // Cycles are detected on the idle channel between events
+        options.engine = ENGINE_NEXT_EVENT;
+    }
+
+    if ((options.engine == ENGINE_NEXT_EVENT || options.engine == ENGINE_GROUP) && options.log_level == LOG_FULL_TRACE) {
+        // The next-event and group engines skip the ticks that the full trace would print
+        options.log_level = LOG_EVENTS;
+    }
+
+    if (profile && !profiling_available()) {
+        std::cerr << "Error: --profile needs a simulator built with profiling, run make clean && make PROFILE=1" << std::endl;
         return EXIT_FAILURE;
     }
 
-    assign_values(input_file);
+    ResultCache result_cache;
 
-    input_file.close();
+    if (!cache_directory.empty()) {
+        if (!result_cache.open(cache_directory)) {
+            std::cerr << "Error: Unable to open cache directory " << cache_directory << std::endl;
+            return EXIT_FAILURE;
+        }
+        options.result_cache = &result_cache;
+    }
 
-    // For each node, initialize its status and other properties
-    initialize_nodes();
+    if (serve) {
+        return run_server_mode(socket_path, options, num_threads);
+    }
+
+    if (sweep && coordinate) {
+        return run_coordinator_mode(input_filename, output_filename, options, coordinator);
+    }
+
+    if (sweep) {
+        return run_sweep_mode(input_filename, output_filename, options, num_threads);
+    }
+
+    // Read and parse the input file
+    std::string contents;
+
+    if (!read_input_file(input_filename, contents)) {
+        std::cerr << "Error: Unable to open file " << input_filename << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::vector<SimulationConfig> configs;
+    std::string error;
+
+    std::vector<std::string> names;
+    std::vector<TrafficConfig> scenario_traffic;
+
+    if (!parse_scenarios(contents, configs, error, &names, traffic ? &scenario_traffic : nullptr)) {
+        std::cerr << "Error: Invalid input file " << input_filename << ": " << error << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    if (verify) {
+        return run_verify_mode(configs, names, options);
+    }
+
+    if (traffic) {
+        return run_traffic_mode(configs, scenario_traffic, names, output_filename, options, num_threads);
+    }
+
+    if (domains) {
+        return run_domain_mode(configs, names, output_filename, options, num_threads);
+    }
 
-    channel_occupied = false;
-    num_successful_transmission_ticks = 0;
+    if (configs.size() > 1) {
+        // Several scenarios are run as a batch, like the points of a sweep
+        unsigned single_run = given & (OPTION_REPLICATIONS | SINGLE_RUN_OPTIONS);
 
-    for (int ticks = 0; ticks < total_simulation_time; ticks++) {
-        std::cout << "Tick: " << ticks << std::endl;
-        for (auto& node : nodes) {
-            std::cout << "Node " << node.id << " backoff: " << node.backoff << std::endl;
+        if (single_run) {
+            std::cerr << "Error: " << option_names(single_run, "and") << (single_run & (single_run - 1) ? " need" : " needs")
+                      << " an input file with a single scenario" << std::endl;
+            return EXIT_FAILURE;
         }
 
-        if (channel_occupied) {
-            transmit_packet(active_node_id, ticks);
-        } else {
-            std::vector<int> ready_nodes = get_ready_node_ids();
+        return run_points(configs, output_filename, options, num_threads, "Batch");
+    }
 
-            if (ready_nodes.empty()) {
-                // No nodes are ready to transmit
-                std::cout << "Channel is idle.\n" << std::endl;
+    const SimulationConfig& config = configs[0];
+
+    if (num_replications > 0) {
+        return run_replication_mode(config, output_filename, options, num_replications, max_ci_width, num_threads);
+    }
 
-                for (auto& node : nodes) {
-                    node.backoff--;
-                }
-            } else if (ready_nodes.size() == 1) {
-                // Only one node is ready to transmit
-                set_channel_occupied(true);
+    TraceWriter trace_writer;
 
-                active_node_id = ready_nodes[0];
-                nodes[active_node_id].packet_ticks_remaining = packet_length;
+    if (!trace_filename.empty()) {
+        if (!trace_writer.open(trace_filename, config)) {
+            std::cerr << "Error: Unable to open file " << trace_filename << std::endl;
+            return EXIT_FAILURE;
+        }
+        options.trace_writer = &trace_writer;
+    }
 
-                transmit_packet(active_node_id, ticks);
-            } else {
-                // Multiple nodes are ready to transmit, so a collision occurs
-                std::cout << "Collision detected b/w:" << std::endl;
+    NodeStatistics node_statistics;
 
-                for (int node_id : ready_nodes) {
-                    Node& node = nodes[node_id];
+    if (write_node_stats) {
+        node_statistics.reset(config.num_nodes);
+        options.node_statistics = &node_statistics;
+    }
 
-                    std::cout << "Node " << node.id << std::endl;
+    SimulationProfile simulation_profile;
 
-                    node.collision_count++;
+    if (profile) {
+        options.profile = &simulation_profile;
+    }
 
-                    if (node.collision_count > max_retransmission_attempt) {
-                        // Drop packet and reset node
-                        node.R = R[0];
-                        node.collision_count = 0;
-                        node.backoff = generate_backoff(node.id, ticks + 1, node.R);
-                        continue;
-                    }
+    SimulationSnapshot resume_snapshot;
 
-                    node.R = R[node.collision_count];
-                    node.backoff = generate_backoff(node.id, ticks + 1, node.R);
-                }
-            }
+    if (!resume_filename.empty()) {
+        if (!read_checkpoint(resume_filename, checkpoint_fingerprint(config, options), config.num_nodes,
+                             resume_snapshot, error)) {
+            std::cerr << "Error: " << error << std::endl;
+            return EXIT_FAILURE;
         }
+
+        if (resume_snapshot.current_tick > config.total_simulation_time) {
+            std::cerr << "Error: checkpoint " << resume_filename << " is at tick " << resume_snapshot.current_tick
+                      << ", after the end of the simulation" << std::endl;
+            return EXIT_FAILURE;
+        }
+        options.resume_snapshot = &resume_snapshot;
     }
 
-    // Write the link utilization rate to the output file
-    std::ofstream output_file;
-    if (argc == 3) {
-        output_file.open(argv[2]);
+    // The checkpoints are written next to the output file
+    std::string checkpoint_filename = std::string(output_filename) + ".checkpoint";
+    std::unique_ptr<CheckpointWriter> checkpoint_writer;
+
+    if (checkpoint_interval > 0) {
+        checkpoint_writer.reset(new CheckpointWriter(checkpoint_filename, checkpoint_interval,
+                                                     checkpoint_fingerprint(config, options)));
+        options.checkpoint_writer = checkpoint_writer.get();
+    }
+
+    // Unless it is given a file, the report is written next to the output file
+    if (report_filename.empty()) {
+        report_filename = std::string(output_filename) + ".report.csv";
+    }
+
+    UtilizationReport report;
+
+    if (report_interval > 0) {
+        if (!report.open(report_filename, report_interval)) {
+            std::cerr << "Error: Unable to open file " << report_filename << std::endl;
+            return EXIT_FAILURE;
+        }
+        options.report = &report;
+    }
+
+    AsyncLog log_writer;
+
+    if (async_log && options.log_level >= LOG_EVENTS) {
+        log_writer.open(*options.log_stream, log_backpressure);
+        options.async_log = &log_writer;
+    }
+
+    ConvergenceResult convergence_result = ConvergenceResult();
+    SimulationResults results;
+
+    if (converge) {
+        // The run may stop before T, and the results are those of the ticks it simulated
+        convergence_result = run_until_converged(config, options, convergence);
+        results = convergence_result.results;
     } else {
-        output_file.open("output.txt");
+        results = run_simulation(config, options);
     }
 
+    if (options.async_log) {
+        // The rest of the output comes after the whole log
+        log_writer.close();
+    }
+
+    if (options.report && !report.close(results.total_simulation_time)) {
+        std::cerr << "Error: Unable to write file " << report_filename << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    if (checkpoint_writer && !checkpoint_writer->close()) {
+        std::cerr << "Error: Unable to write file " << checkpoint_filename << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    if (profile) {
+        // The report goes to standard error, so it does not mix with the log
+        write_profile(std::cerr, simulation_profile);
+    }
+
+    if (options.trace_writer && !trace_writer.close(results)) {
+        std::cerr << "Error: Unable to write file " << trace_filename << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // Write the link utilization rate to the output file
+    std::ofstream output_file(output_filename);
+
     if (!output_file.is_open()) {
-        std::cerr << "Error: Unable to open file output.txt" << std::endl;
+        std::cerr << "Error: Unable to open file " << output_filename << std::endl;
         return EXIT_FAILURE;
     }
 
-    output_file << std::fixed << std::setprecision(2);
-    output_file << static_cast<double>(num_successful_transmission_ticks) / total_simulation_time << std::endl;
+    if (converge) {
+        // The estimate leaves out the warm-up transient
+        output_file << format_ratio(convergence_result.steady_successful_ticks, convergence_result.steady_ticks, 2) << std::endl;
+    } else {
+        output_file << format_ratio(results.num_successful_transmission_ticks, results.total_simulation_time, 2) << std::endl;
+    }
+
+    if (options.log_level >= LOG_SUMMARY) {
+        std::cout << "Slots with succcessful transmissions: " << results.num_successful_transmission_ticks << ", T = " << results.total_simulation_time << std::endl;
+    }
+
+    if (log_writer.num_dropped() > 0) {
+        std::cout << "Log records dropped: " << log_writer.num_dropped() << std::endl;
+    }
+
+    if (converge && options.log_level >= LOG_SUMMARY) {
+        if (convergence_result.estimated) {
+            char half_width[32];
+            std::snprintf(half_width, sizeof(half_width), "%.6f", convergence_result.ci_half_width);
 
-    std::cout << "Slots with succcessful transmissions: " << num_successful_transmission_ticks << ", T = " << total_simulation_time << std::endl;
+            std::cout << (convergence_result.converged ? "Converged at tick " : "Not converged by tick ")
+                      << results.total_simulation_time << ": utilization "
+                      << format_ratio(convergence_result.steady_successful_ticks, convergence_result.steady_ticks, 6)
+                      << " +/- " << half_width << " after a warm-up of " << convergence_result.warmup_ticks
+                      << " ticks, over " << convergence_result.num_batches << " batches of "
+                      << convergence_result.batch_ticks << " ticks" << std::endl;
+        } else {
+            std::cout << "Deterministic backoff: run to T with cycle detection" << std::endl;
+        }
+    }
+    log_cache_summary(options);
 
     output_file.close();
 
+    if (write_node_stats) {
+        // The statistics are written next to the output file
+        std::string node_stats_filename = std::string(output_filename) + ".nodes.csv";
+        std::ofstream node_stats_file(node_stats_filename);
+
+        if (!node_stats_file.is_open()) {
+            std::cerr << "Error: Unable to open file " << node_stats_filename << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        write_node_statistics(node_stats_file, node_statistics);
+    }
+
     return EXIT_SUCCESS;
 }
@@ -0,0 +1,668 @@
+/**
+ * @file csma_python.cpp
+ * @brief A Python extension module that runs the simulation in process, built with make python.
+ *
+ * The module wraps the same simulation as the csma program:
+ *
+ *     import csma_sim
+ *     result = csma_sim.run({"N": 4, "L": 2, "M": 6, "R": [4, 8, 16, 32, 64, 128], "T": 10},
+ *                           node_stats=True, report_interval=5)
+ *     result.successful_ticks, result.total_simulation_time, result.utilization
+ *     numpy.asarray(result.node_stats["transmissions"])
+ *     numpy.asarray(result.windows["successful_ticks"])
+ *
+ *     sweep = csma_sim.run_sweep([{"N": n, "T": 1000} for n in range(1, 65)], threads=8)
+ *     numpy.asarray(sweep["successful_ticks"])
+ *
+ * A configuration is a dict with the parameter letters of an input file, where R
+ * may be any iterable of integers, or the text of an input file. The options take
+ * the names and values of the command line options.
+ *
+ * The per-node statistics, the utilization windows and the results of a sweep are
+ * returned as arrays that export the buffers the simulation filled: numpy.asarray()
+ * and memoryview() wrap them without copying, and keep the result they belong to
+ * alive. The statistics of a node are stored together in one structure, so the array
+ * of one statistic has a stride of a whole structure. The module has no build or run
+ * time dependency on NumPy.
+ *
+ * The GIL is released while the simulations run, so other Python threads keep running.
+ *
+ * @author Vicky Chen (chen-vv)
+ * @author Eric Omielan (eomielan)
+ * @bug No known bugs.
+ */
+
+/* -- Includes -- */
+
+/* Python includes, which must come first. */
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+/* Standard library includes. */
+#include <climits>
+#include <cstddef>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+
+/* Custom includes */
+#include "include/csma.h"
+#include "include/input_file.h"
+#include "include/node_stats.h"
+#include "include/report.h"
+#include "include/sweep.h"
+
+/**
+ * @brief The outcome of run(): the results of the simulation and what was recorded while it ran.
+*/
+struct RunData {
+    SimulationResults results;          /**< The results of the simulation. */
+    bool has_node_statistics;           /**< Whether the per-node statistics were recorded. */
+    NodeStatistics node_statistics;     /**< The per-node statistics, if they were recorded. */
+    bool has_windows;                   /**< Whether the utilization windows were recorded. */
+    UtilizationReport report;           /**< The report that collected the utilization windows. */
+};
+
+/**
+ * @brief A read-only array of one or two dimensions over memory owned by another object.
+*/
+struct ArrayObject {
+    PyObject_HEAD
+    PyObject* owner;            /**< The object that owns the memory, kept alive by the array. */
+    char* data;                 /**< The first element. */
+    int ndim;                   /**< The number of dimensions, 1 or 2. */
+    Py_ssize_t shape[2];        /**< The number of elements along each dimension. */
+    Py_ssize_t strides[2];      /**< The number of bytes between elements along each dimension. */
+    const char* format;         /**< The struct module format of an element. */
+    Py_ssize_t itemsize;        /**< The size of an element in bytes. */
+};
+
+/**
+ * @brief The Python object returned by run().
+*/
+struct ResultObject {
+    PyObject_HEAD
+    RunData* data;              /**< The results, owned by the object. */
+};
+
+/** @brief Stands in for the data of empty arrays, which the buffer protocol wants to be non-null. */
+static long long empty_array_data;
+
+static void array_dealloc(PyObject* self) {
+    Py_XDECREF(reinterpret_cast<ArrayObject*>(self)->owner);
+    Py_TYPE(self)->tp_free(self);
+}
+
+static Py_ssize_t array_length(PyObject* self) {
+    return reinterpret_cast<ArrayObject*>(self)->shape[0];
+}
+
+static int array_get_buffer(PyObject* self, Py_buffer* view, int flags) {
+    ArrayObject* array = reinterpret_cast<ArrayObject*>(self);
+
+    if (flags & PyBUF_WRITABLE) {
+        PyErr_SetString(PyExc_BufferError, "the array is read-only");
+        return -1;
+    }
+
+    if ((flags & PyBUF_STRIDES) != PyBUF_STRIDES) {
+        PyErr_SetString(PyExc_BufferError, "the array is strided");
+        return -1;
+    }
+
+    view->obj = self;
+    Py_INCREF(self);
+    view->buf = array->data;
+    view->len = array->itemsize * array->shape[0] * (array->ndim == 2 ? array->shape[1] : 1);
+    view->readonly = 1;
+    view->itemsize = array->itemsize;
+    view->format = (flags & PyBUF_FORMAT) ? const_cast<char*>(array->format) : nullptr;
+    view->ndim = array->ndim;
+    view->shape = array->shape;
+    view->strides = array->strides;
+    view->suboffsets = nullptr;
+    view->internal = nullptr;
+    return 0;
+}
+
+static PySequenceMethods array_sequence_methods = {};
+static PyBufferProcs array_buffer_procs = {};
+static PyTypeObject array_type = {PyVarObject_HEAD_INIT(nullptr, 0)};
+
+/**
+ * @brief Create an array of 64-bit or 32-bit counters over memory owned by another object.
+ *
+ * @param owner The object that owns the memory.
+ * @param data The first element, or null if the array is empty.
+ * @param length The number of elements, or of rows of a two-dimensional array.
+ * @param stride The number of bytes between elements, or between rows.
+ * @param format "q" for long long elements, "I" for unsigned int elements.
+ * @param columns The number of columns of a two-dimensional array, each one element
+ * after the other, or 0 for a one-dimensional array.
+ * @return PyObject* The new array, or null with an exception set.
+ */
+static PyObject* new_array(PyObject* owner, const void* data, size_t length, size_t stride, const char* format,
+                           int columns = 0) {
+    ArrayObject* array = PyObject_New(ArrayObject, &array_type);
+
+    if (!array) {
+        return nullptr;
+    }
+
+    Py_INCREF(owner);
+    array->owner = owner;
+    array->data = const_cast<char*>(static_cast<const char*>(length > 0 ? data : &empty_array_data));
+    array->format = format;
+    array->itemsize = format[0] == 'q' ? sizeof(long long) : sizeof(unsigned int);
+    array->ndim = columns > 0 ? 2 : 1;
+    array->shape[0] = static_cast<Py_ssize_t>(length);
+    array->strides[0] = static_cast<Py_ssize_t>(stride);
+    array->shape[1] = columns;
+    array->strides[1] = array->itemsize;
+    return reinterpret_cast<PyObject*>(array);
+}
+
+/**
+ * @brief Add an array to a dict, and release it.
+ *
+ * @param dict The dict.
+ * @param key The key of the array.
+ * @param array The array, or null after an error.
+ * @return bool True if the array was added, false with an exception set.
+ */
+static bool set_array(PyObject* dict, const char* key, PyObject* array) {
+    if (!array) {
+        return false;
+    }
+
+    int status = PyDict_SetItemString(dict, key, array);
+    Py_DECREF(array);
+    return status == 0;
+}
+
+static void result_dealloc(PyObject* self) {
+    RunData* data = reinterpret_cast<ResultObject*>(self)->data;
+
+    if (data) {
+        data->~RunData();
+        std::free(data);
+    }
+    Py_TYPE(self)->tp_free(self);
+}
+
+static PyObject* result_successful_ticks(PyObject* self, void*) {
+    return PyLong_FromLongLong(reinterpret_cast<ResultObject*>(self)->data->results.num_successful_transmission_ticks);
+}
+
+static PyObject* result_total_simulation_time(PyObject* self, void*) {
+    return PyLong_FromLongLong(reinterpret_cast<ResultObject*>(self)->data->results.total_simulation_time);
+}
+
+static PyObject* result_utilization(PyObject* self, void*) {
+    const SimulationResults& results = reinterpret_cast<ResultObject*>(self)->data->results;
+    return PyFloat_FromDouble(results.total_simulation_time > 0 ? results.utilization() : 0.0);
+}
+
+static PyObject* result_node_stats(PyObject* self, void*) {
+    const RunData& data = *reinterpret_cast<ResultObject*>(self)->data;
+
+    if (!data.has_node_statistics) {
+        Py_RETURN_NONE;
+    }
+
+    const std::vector<NodeStats>& nodes = data.node_statistics.nodes();
+    const char* base = reinterpret_cast<const char*>(nodes.data());
+    size_t stride = sizeof(NodeStats);
+    PyObject* dict = PyDict_New();
+
+    if (!dict ||
+        !set_array(dict, "transmissions", new_array(self, base + offsetof(NodeStats, transmissions), nodes.size(), stride, "q")) ||
+        !set_array(dict, "collisions", new_array(self, base + offsetof(NodeStats, collisions), nodes.size(), stride, "q")) ||
+        !set_array(dict, "drops", new_array(self, base + offsetof(NodeStats, drops), nodes.size(), stride, "q")) ||
+        !set_array(dict, "total_delay", new_array(self, base + offsetof(NodeStats, total_delay), nodes.size(), stride, "q")) ||
+        !set_array(dict, "delay_bins", new_array(self, base + offsetof(NodeStats, delay_bins), nodes.size(), stride, "I",
+                                                 NODE_STATS_DELAY_BINS))) {
+        Py_XDECREF(dict);
+        return nullptr;
+    }
+
+    return dict;
+}
+
+static PyObject* result_windows(PyObject* self, void*) {
+    const RunData& data = *reinterpret_cast<ResultObject*>(self)->data;
+
+    if (!data.has_windows) {
+        Py_RETURN_NONE;
+    }
+
+    const std::vector<UtilizationWindow>& windows = data.report.windows();
+    const char* base = reinterpret_cast<const char*>(windows.data());
+    size_t stride = sizeof(UtilizationWindow);
+    PyObject* dict = PyDict_New();
+
+    if (!dict ||
+        !set_array(dict, "start_tick", new_array(self, base + offsetof(UtilizationWindow, start_tick), windows.size(), stride, "q")) ||
+        !set_array(dict, "end_tick", new_array(self, base + offsetof(UtilizationWindow, end_tick), windows.size(), stride, "q")) ||
+        !set_array(dict, "successful_ticks", new_array(self, base + offsetof(UtilizationWindow, successful_ticks), windows.size(), stride, "q")) ||
+        !set_array(dict, "collisions", new_array(self, base + offsetof(UtilizationWindow, collisions), windows.size(), stride, "q")) ||
+        !set_array(dict, "drops", new_array(self, base + offsetof(UtilizationWindow, drops), windows.size(), stride, "q"))) {
+        Py_XDECREF(dict);
+        return nullptr;
+    }
+
+    return dict;
+}
+
+static PyGetSetDef result_getset[] = {
+    {const_cast<char*>("successful_ticks"), result_successful_ticks, nullptr,
+     const_cast<char*>("The number of ticks with a successful transmission."), nullptr},
+    {const_cast<char*>("total_simulation_time"), result_total_simulation_time, nullptr,
+     const_cast<char*>("The number of ticks simulated."), nullptr},
+    {const_cast<char*>("utilization"), result_utilization, nullptr,
+     const_cast<char*>("The fraction of the ticks with a successful transmission."), nullptr},
+    {const_cast<char*>("node_stats"), result_node_stats, nullptr,
+     const_cast<char*>("The per-node statistics as a dict of arrays, or None without node_stats."), nullptr},
+    {const_cast<char*>("windows"), result_windows, nullptr,
+     const_cast<char*>("The utilization windows as a dict of arrays, or None without report_interval."), nullptr},
+    {nullptr, nullptr, nullptr, nullptr, nullptr},
+};
+
+static PyTypeObject result_type = {PyVarObject_HEAD_INIT(nullptr, 0)};
+
+/**
+ * @brief Convert a Python integer to a C++ integer in a range.
+ *
+ * @param object The Python integer.
+ * @param minimum The smallest value allowed.
+ * @param maximum The largest value allowed.
+ * @param name The name of the value, for the exception.
+ * @param value Set to the integer.
+ * @return bool True on success, false with an exception set.
+ */
+static bool to_integer(PyObject* object, long long minimum, long long maximum, const char* name, long long& value) {
+    value = PyLong_AsLongLong(object);
+
+    if (value == -1 && PyErr_Occurred()) {
+        if (PyErr_ExceptionMatches(PyExc_OverflowError)) {
+            PyErr_Clear();
+            PyErr_Format(PyExc_ValueError, "%s is out of range", name);
+        }
+        return false;
+    }
+
+    if (value < minimum || value > maximum) {
+        PyErr_Format(PyExc_ValueError, "%s is out of range", name);
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Add the configurations of a Python configuration: a dict of parameters, or the text of an input file.
+ *
+ * @param object The configuration.
+ * @param configs The list the configurations are added to, every one of them valid.
+ * @return bool True on success, false with an exception set.
+ */
+static bool add_configs(PyObject* object, std::vector<SimulationConfig>& configs) {
+    std::string error;
+
+    if (PyUnicode_Check(object)) {
+        const char* text = PyUnicode_AsUTF8(object);
+
+        if (!text) {
+            return false;
+        }
+
+        std::vector<SimulationConfig> file_configs;
+        if (!parse_scenarios(text, file_configs, error)) {
+            PyErr_SetString(PyExc_ValueError, error.c_str());
+            return false;
+        }
+
+        configs.insert(configs.end(), file_configs.begin(), file_configs.end());
+        return true;
+    }
+
+    if (!PyDict_Check(object)) {
+        PyErr_SetString(PyExc_TypeError, "a configuration must be a dict or the text of an input file");
+        return false;
+    }
+
+    SimulationConfig config;
+    PyObject* key;
+    PyObject* value;
+    Py_ssize_t position = 0;
+
+    while (PyDict_Next(object, &position, &key, &value)) {
+        const char* name = PyUnicode_Check(key) ? PyUnicode_AsUTF8(key) : nullptr;
+        std::string parameter = name ? name : "";
+        long long number;
+
+        if (parameter == "N" || parameter == "L" || parameter == "M") {
+            if (!to_integer(value, INT_MIN, INT_MAX, name, number)) {
+                return false;
+            }
+
+            int& field = parameter == "N" ? config.num_nodes
+                       : parameter == "L" ? config.packet_length
+                                          : config.max_retransmission_attempt;
+            field = static_cast<int>(number);
+        } else if (parameter == "T") {
+            if (!to_integer(value, LLONG_MIN, LLONG_MAX, name, config.total_simulation_time)) {
+                return false;
+            }
+        } else if (parameter == "R") {
+            config.R.clear();
+
+            if (PyLong_Check(value)) {
+                if (!to_integer(value, INT_MIN, INT_MAX, name, number)) {
+                    return false;
+                }
+                config.R.push_back(static_cast<int>(number));
+            } else {
+                // Any iterable will do, such as a list or a NumPy array
+                PyObject* iterator = PyObject_GetIter(value);
+                if (!iterator) {
+                    return false;
+                }
+
+                while (PyObject* item = PyIter_Next(iterator)) {
+                    bool converted = to_integer(item, INT_MIN, INT_MAX, name, number);
+                    Py_DECREF(item);
+
+                    if (!converted) {
+                        Py_DECREF(iterator);
+                        return false;
+                    }
+                    config.R.push_back(static_cast<int>(number));
+                }
+
+                Py_DECREF(iterator);
+                if (PyErr_Occurred()) {
+                    return false;
+                }
+            }
+        } else {
+            PyErr_Format(PyExc_ValueError, "unknown parameter %R (expected N, L, M, R or T)", key);
+            return false;
+        }
+    }
+
+    if (!validate_config(config, error)) {
+        PyErr_SetString(PyExc_ValueError, error.c_str());
+        return false;
+    }
+
+    configs.push_back(config);
+    return true;
+}
+
+/**
+ * @brief Set the engine and policy options from the keyword arguments of run() and run_sweep().
+ *
+ * @param engine The name of the engine, or null for the default.
+ * @param backoff The name of the backoff policy, or null for the default.
+ * @param window The name of the window policy, or null for the default.
+ * @param seed The seed of the random backoff policies.
+ * @param persistence The transmit probability of the p-persistent policy.
+ * @param cycle_detect Whether to detect cycles.
+ * @param options Set to the options.
+ * @return bool True on success, false with an exception set.
+ */
+static bool set_options(const char* engine, const char* backoff, const char* window, unsigned long long seed,
+                        double persistence, int cycle_detect, SimulationOptions& options) {
+    if (engine && !parse_engine(engine, options.engine)) {
+        PyErr_Format(PyExc_ValueError, "unknown engine '%s' (expected small, tick, reference, event, simd, group or batch)", engine);
+        return false;
+    }
+
+    if (backoff && !parse_backoff_policy(backoff, options.backoff_policy)) {
+        PyErr_Format(PyExc_ValueError, "unknown backoff policy '%s' (expected deterministic, uniform or p-persistent)", backoff);
+        return false;
+    }
+
+    if (window && !parse_window_policy(window, options.window_policy)) {
+        PyErr_Format(PyExc_ValueError, "unknown window policy '%s' (expected table or beb)", window);
+        return false;
+    }
+
+    if (!(persistence > 0.0 && persistence <= 1.0)) {
+        PyErr_SetString(PyExc_ValueError, "the persistence must be a probability in (0, 1]");
+        return false;
+    }
+
+    options.log_level = LOG_OFF;
+    options.seed = seed;
+    options.persistence = persistence;
+    options.detect_cycles = cycle_detect != 0;
+
+    if (options.detect_cycles) {
+        // Cycles are detected on the idle channel between events
+        options.engine = ENGINE_NEXT_EVENT;
+    }
+
+    return true;
+}
+
+static PyObject* csma_run(PyObject*, PyObject* args, PyObject* kwargs) {
+    static const char* keywords[] = {"config", "engine", "backoff", "window", "seed", "persistence", "cycle_detect",
+                                     "node_stats", "report_interval", nullptr};
+    PyObject* config_object;
+    const char* engine = nullptr;
+    const char* backoff = nullptr;
+    const char* window = nullptr;
+    unsigned long long seed = 0;
+    double persistence = 0.5;
+    int cycle_detect = 0;
+    int node_stats = 0;
+    long long report_interval = 0;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O|$zzzKdppL", const_cast<char**>(keywords), &config_object,
+                                     &engine, &backoff, &window, &seed, &persistence, &cycle_detect, &node_stats,
+                                     &report_interval)) {
+        return nullptr;
+    }
+
+    std::vector<SimulationConfig> configs;
+    SimulationOptions options;
+
+    if (!add_configs(config_object, configs) ||
+        !set_options(engine, backoff, window, seed, persistence, cycle_detect, options)) {
+        return nullptr;
+    }
+
+    if (configs.size() != 1) {
+        PyErr_SetString(PyExc_ValueError, "run() takes a single scenario, use run_sweep() for several");
+        return nullptr;
+    }
+
+    if (report_interval < 0 || (report_interval > 0 && cycle_detect)) {
+        PyErr_SetString(PyExc_ValueError, "report_interval must be positive, and cannot be combined with cycle_detect");
+        return nullptr;
+    }
+
+    // The ring buffer of the report is aligned to cache lines, which new only honours from C++17 on
+    void* memory = nullptr;
+
+    if (posix_memalign(&memory, alignof(RunData), sizeof(RunData)) != 0) {
+        return PyErr_NoMemory();
+    }
+
+    ResultObject* result = PyObject_New(ResultObject, &result_type);
+
+    if (!result) {
+        std::free(memory);
+        return nullptr;
+    }
+
+    result->data = new (memory) RunData();
+    RunData& data = *result->data;
+    data.has_node_statistics = node_stats != 0;
+    data.has_windows = report_interval > 0;
+
+    if (data.has_node_statistics) {
+        data.node_statistics.reset(configs[0].num_nodes);
+        options.node_statistics = &data.node_statistics;
+    }
+
+    if (data.has_windows) {
+        data.report.collect(report_interval);
+        options.report = &data.report;
+    }
+
+    Py_BEGIN_ALLOW_THREADS
+    data.results = run_simulation(configs[0], options);
+
+    if (data.has_windows) {
+        data.report.close(data.results.total_simulation_time);
+    }
+    Py_END_ALLOW_THREADS
+
+    return reinterpret_cast<PyObject*>(result);
+}
+
+/**
+ * @brief Free the results of a sweep held by a capsule.
+ *
+ * @param capsule The capsule.
+ */
+static void free_sweep_results(PyObject* capsule) {
+    delete static_cast<std::vector<SimulationResults>*>(PyCapsule_GetPointer(capsule, "csma_sim.sweep_results"));
+}
+
+static PyObject* csma_run_sweep(PyObject*, PyObject* args, PyObject* kwargs) {
+    static const char* keywords[] = {"configs", "engine", "backoff", "window", "seed", "persistence", "cycle_detect",
+                                     "threads", nullptr};
+    PyObject* configs_object;
+    const char* engine = nullptr;
+    const char* backoff = nullptr;
+    const char* window = nullptr;
+    unsigned long long seed = 0;
+    double persistence = 0.5;
+    int cycle_detect = 0;
+    int num_threads = 0;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O|$zzzKdpi", const_cast<char**>(keywords), &configs_object,
+                                     &engine, &backoff, &window, &seed, &persistence, &cycle_detect, &num_threads)) {
+        return nullptr;
+    }
+
+    std::vector<SimulationConfig> configs;
+    SimulationOptions options;
+
+    if (PyUnicode_Check(configs_object) || PyDict_Check(configs_object)) {
+        if (!add_configs(configs_object, configs)) {
+            return nullptr;
+        }
+    } else {
+        PyObject* iterator = PyObject_GetIter(configs_object);
+        if (!iterator) {
+            return nullptr;
+        }
+
+        while (PyObject* item = PyIter_Next(iterator)) {
+            bool added = add_configs(item, configs);
+            Py_DECREF(item);
+
+            if (!added) {
+                Py_DECREF(iterator);
+                return nullptr;
+            }
+        }
+
+        Py_DECREF(iterator);
+        if (PyErr_Occurred()) {
+            return nullptr;
+        }
+    }
+
+    if (!set_options(engine, backoff, window, seed, persistence, cycle_detect, options)) {
+        return nullptr;
+    }
+
+    if (num_threads < 0 || num_threads > 4096) {
+        PyErr_SetString(PyExc_ValueError, "threads must be between 0 and 4096");
+        return nullptr;
+    }
+
+    std::unique_ptr<std::vector<SimulationResults>> results(new std::vector<SimulationResults>());
+
+    Py_BEGIN_ALLOW_THREADS
+    *results = run_sweep(configs, options, num_threads);
+    Py_END_ALLOW_THREADS
+
+    // The arrays keep the capsule, and with it the results, alive
+    const std::vector<SimulationResults>& sweep_results = *results;
+    PyObject* owner = PyCapsule_New(results.get(), "csma_sim.sweep_results", free_sweep_results);
+
+    if (!owner) {
+        return nullptr;
+    }
+    results.release();
+
+    const char* base = reinterpret_cast<const char*>(sweep_results.data());
+    size_t stride = sizeof(SimulationResults);
+    PyObject* dict = PyDict_New();
+
+    if (!dict ||
+        !set_array(dict, "successful_ticks", new_array(owner, base + offsetof(SimulationResults, num_successful_transmission_ticks),
+                                                       sweep_results.size(), stride, "q")) ||
+        !set_array(dict, "total_simulation_time", new_array(owner, base + offsetof(SimulationResults, total_simulation_time),
+                                                            sweep_results.size(), stride, "q"))) {
+        Py_XDECREF(dict);
+        Py_DECREF(owner);
+        return nullptr;
+    }
+
+    Py_DECREF(owner);
+    return dict;
+}
+
+static PyMethodDef csma_methods[] = {
+    {"run", reinterpret_cast<PyCFunction>(reinterpret_cast<void (*)(void)>(csma_run)), METH_VARARGS | METH_KEYWORDS,
+     "run(config, *, engine='small', backoff='deterministic', window='table', seed=0, persistence=0.5,\n"
+     "    cycle_detect=False, node_stats=False, report_interval=0)\n\n"
+     "Run the simulation of a configuration and return its Result."},
+    {"run_sweep", reinterpret_cast<PyCFunction>(reinterpret_cast<void (*)(void)>(csma_run_sweep)), METH_VARARGS | METH_KEYWORDS,
+     "run_sweep(configs, *, engine='small', backoff='deterministic', window='table', seed=0, persistence=0.5,\n"
+     "          cycle_detect=False, threads=0)\n\n"
+     "Run the simulations of a list of configurations on a thread pool, and return the arrays\n"
+     "successful_ticks and total_simulation_time in a dict."},
+    {nullptr, nullptr, 0, nullptr},
+};
+
+static PyModuleDef csma_module = {
+    PyModuleDef_HEAD_INIT, "csma_sim", "A simulation of the CSMA protocol.", -1, csma_methods,
+    nullptr, nullptr, nullptr, nullptr,
+};
+
+PyMODINIT_FUNC PyInit_csma_sim() {
+    array_sequence_methods.sq_length = array_length;
+    array_buffer_procs.bf_getbuffer = array_get_buffer;
+
+    array_type.tp_name = "csma_sim.Array";
+    array_type.tp_basicsize = sizeof(ArrayObject);
+    array_type.tp_dealloc = array_dealloc;
+    array_type.tp_as_sequence = &array_sequence_methods;
+    array_type.tp_as_buffer = &array_buffer_procs;
+    array_type.tp_flags = Py_TPFLAGS_DEFAULT;
+    array_type.tp_doc = "A read-only array over the buffers of a simulation, for numpy.asarray() or memoryview().";
+
+    result_type.tp_name = "csma_sim.Result";
+    result_type.tp_basicsize = sizeof(ResultObject);
+    result_type.tp_dealloc = result_dealloc;
+    result_type.tp_flags = Py_TPFLAGS_DEFAULT;
+    result_type.tp_doc = "The results of a simulation, and the statistics recorded while it ran.";
+    result_type.tp_getset = result_getset;
+
+    if (PyType_Ready(&array_type) < 0 || PyType_Ready(&result_type) < 0) {
+        return nullptr;
+    }
+
+    return PyModule_Create(&csma_module);
+}
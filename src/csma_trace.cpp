@@ -0,0 +1,211 @@
+/** 
+ * @file csma_trace.cpp
+ * @brief A reader of the binary traces written with csma --trace.
+ *
+ * The reader rebuilds the timeline of a traced simulation, printed in the
+ * same format as the events log level of the simulator, and statistics of
+ * the whole run and of every node.
+ *
+ * @author Vicky Chen (chen-vv)
+ * @author Eric Omielan (eomielan)
+ * @bug No known bugs.
+ */
+
+/* -- Includes -- */
+
+/* Standard library includes. */
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+/* Custom includes */
+#include "include/trace.h"
+
+/**
+ * @brief The counts of one node over a traced run.
+*/
+struct NodeTraceStats {
+    long long transmissions;        /**< The number of packets sent without collision. */
+    long long collisions;           /**< The number of collisions the node took part in. */
+    long long drops;                /**< The number of packets dropped after too many collisions. */
+};
+
+/**
+ * @brief Print one record in the format of the events log level.
+ * 
+ * @param record The record to print.
+ * @param config The configuration of the traced simulation.
+ */
+static void print_timeline_record(const TraceRecord& record, const SimulationConfig& config) {
+    switch (record.type) {
+        case TRACE_START:
+            std::cout << "Tick: " << record.ticks << '\n';
+            std::cout << "Channel is occupied by node " << record.node_ids[0] << '\n';
+            break;
+
+        case TRACE_END:
+            // A one-tick packet finishes on the tick it started, which already printed the tick
+            if (config.packet_length > 1) {
+                std::cout << "Tick: " << record.ticks << '\n';
+            }
+            std::cout << "Node " << record.node_ids[0] << " finished transmitting. new backoff " << record.value << '\n';
+            break;
+
+        case TRACE_COLLISION:
+            std::cout << "Tick: " << record.ticks << '\n';
+            std::cout << "Collision detected b/w:" << '\n';
+            for (int node_id : record.node_ids) {
+                std::cout << "Node " << node_id << '\n';
+            }
+            break;
+
+        case TRACE_CYCLE:
+            std::cout << "Cycle of " << record.value << " ticks detected, skipping to tick "
+                      << record.ticks + record.skipped_ticks << '\n';
+            break;
+
+        case TRACE_END_OF_RUN:
+            std::cout << "Slots with succcessful transmissions: " << record.value << ", T = " << record.ticks << '\n';
+            break;
+
+        default:
+            break;
+    }
+}
+
+/** 
+ * @brief The trace reader entrypoint.
+ *
+ * Usage: csma-trace [--timeline] [--nodes] <tracefilename>
+ * 
+ * Without options, the statistics of the whole run are printed. --timeline prints
+ * every event instead, and --nodes adds the statistics of every node.
+ *
+ * @param argc The number of command-line arguments.
+ * @param argv An array of strings containing the command-line arguments.
+ * @return Returns EXIT_SUCCESS on success, EXIT_FAILURE on failure.
+ */
+int main(int argc, char* argv[]) {
+    bool timeline = false;
+    bool per_node = false;
+    const char* trace_filename = nullptr;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+
+        if (arg == "--timeline") {
+            timeline = true;
+        } else if (arg == "--nodes") {
+            per_node = true;
+        } else if (!trace_filename) {
+            trace_filename = argv[i];
+        } else {
+            trace_filename = nullptr;
+            break;
+        }
+    }
+
+    if (!trace_filename) {
+        std::cerr << "Usage: " << argv[0] << " [--timeline] [--nodes] <tracefilename>" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    TraceReader reader;
+    std::string error;
+
+    if (!reader.open(trace_filename, error)) {
+        std::cerr << "Error: Invalid trace file " << trace_filename << ": " << error << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    const SimulationConfig& config = reader.config();
+    std::vector<NodeTraceStats> nodes(config.num_nodes, NodeTraceStats{0, 0, 0});
+    long long num_idle_stretches = 0;
+    long long num_idle_ticks = 0;
+    long long longest_idle_stretch = 0;
+    long long num_collisions = 0;
+    long long num_skipped_ticks = 0;
+    TraceRecord record;
+
+    while (reader.next(record, error)) {
+        if (timeline) {
+            print_timeline_record(record, config);
+        }
+
+        for (int node_id : record.node_ids) {
+            if (node_id < 0 || node_id >= config.num_nodes) {
+                std::cerr << "Error: Invalid trace file " << trace_filename << ": node ID " << node_id << " out of range" << std::endl;
+                return EXIT_FAILURE;
+            }
+        }
+
+        switch (record.type) {
+            case TRACE_IDLE:
+                num_idle_stretches++;
+                num_idle_ticks += record.value;
+                longest_idle_stretch = std::max(longest_idle_stretch, record.value);
+                break;
+
+            case TRACE_END:
+                nodes[record.node_ids[0]].transmissions++;
+                break;
+
+            case TRACE_COLLISION:
+                num_collisions++;
+                for (int node_id : record.node_ids) {
+                    nodes[node_id].collisions++;
+                }
+                break;
+
+            case TRACE_DROP:
+                nodes[record.node_ids[0]].drops++;
+                break;
+
+            case TRACE_CYCLE:
+                num_skipped_ticks += record.skipped_ticks;
+                break;
+
+            default:
+                break;
+        }
+
+        if (record.type == TRACE_END_OF_RUN && !timeline) {
+            long long num_transmissions = 0;
+            long long num_drops = 0;
+            for (const NodeTraceStats& node : nodes) {
+                num_transmissions += node.transmissions;
+                num_drops += node.drops;
+            }
+
+            std::cout << "Ticks: " << record.ticks << '\n';
+            std::cout << "Successful ticks: " << record.value << '\n';
+            std::cout << "Utilization: " << format_ratio(record.value, record.ticks, 2) << '\n';
+            std::cout << "Transmissions: " << num_transmissions << '\n';
+            std::cout << "Collisions: " << num_collisions << '\n';
+            std::cout << "Drops: " << num_drops << '\n';
+            std::cout << "Idle ticks: " << num_idle_ticks << " in " << num_idle_stretches
+                      << " stretches, longest " << longest_idle_stretch << '\n';
+
+            if (num_skipped_ticks > 0) {
+                std::cout << "Ticks skipped by cycle detection: " << num_skipped_ticks << '\n';
+            }
+
+            if (per_node) {
+                for (int node_id = 0; node_id < config.num_nodes; node_id++) {
+                    std::cout << "Node " << node_id << ": transmissions " << nodes[node_id].transmissions
+                              << ", collisions " << nodes[node_id].collisions
+                              << ", drops " << nodes[node_id].drops << '\n';
+                }
+            }
+        }
+    }
+
+    if (!error.empty()) {
+        std::cerr << "Error: Invalid trace file " << trace_filename << ": " << error << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
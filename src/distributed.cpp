@@ -0,0 +1,728 @@
+/**
+ * @file distributed.cpp
+ * @brief Implementation of the coordinator and the workers of a distributed sweep.
+ *
+ * @author Vicky Chen (chen-vv)
+ * @author Eric Omielan (eomielan)
+ * @bug No known bugs.
+ */
+
+/* -- Includes -- */
+
+/* Standard library includes. */
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+/* Custom includes */
+#include "include/distributed.h"
+#include "include/stream_connection.h"
+#include "include/sweep.h"
+
+/** @brief The shard of a worker that is not running one. */
+#define NO_SHARD static_cast<size_t>(-1)
+
+/**
+ * @brief The progress of one shard.
+*/
+struct ShardState {
+    size_t first;               /**< The first point of the shard. */
+    size_t count;               /**< The number of points of the shard. */
+    bool done;                  /**< Whether its results are in. */
+    bool pending;               /**< Whether it waits in the queue for a worker. */
+    int in_flight;              /**< The number of workers running it. */
+    std::chrono::steady_clock::time_point assigned; /**< When it last went to a worker. */
+};
+
+/**
+ * @brief One worker connected to the coordinator.
+*/
+struct WorkerSlot {
+    std::shared_ptr<StreamConnection> connection;   /**< The connection, or null once it is gone. */
+    std::string name;           /**< The address of the worker, for the log. */
+    size_t shard;               /**< The shard it runs, or NO_SHARD. */
+    long long num_shards;       /**< The number of shards whose results it sent first. */
+};
+
+/**
+ * @brief The shards of a sweep and the workers running them, shared by the threads of the connections.
+*/
+class SweepCoordinator {
+public:
+    /**
+     * @brief Cut a sweep into shards, all waiting for a worker.
+     *
+     * @param configs The configurations of the points.
+     * @param coordinator The shard size and timeout.
+     * @param log_level The level the workers are logged at.
+     * @param results The results of the points, set as the shards are done.
+     */
+    SweepCoordinator(const std::vector<SimulationConfig>& configs, const CoordinatorOptions& coordinator,
+                     LogLevel log_level, std::vector<SimulationResults>& results)
+        : configs_(configs),
+          timeout_(std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+              std::chrono::duration<double>(coordinator.shard_timeout))),
+          log_level_(log_level),
+          results_(results),
+          num_done_(0),
+          num_reassigned_(0) {
+        results_.resize(configs.size());
+
+        for (size_t first = 0; first < configs.size(); first += coordinator.shard_points) {
+            ShardState shard;
+            shard.first = first;
+            shard.count = std::min(configs.size() - first, static_cast<size_t>(coordinator.shard_points));
+            shard.done = false;
+            shard.pending = true;
+            shard.in_flight = 0;
+            pending_.push_back(shards_.size());
+            shards_.push_back(shard);
+        }
+    }
+
+    /**
+     * @brief Register a worker that connected.
+     *
+     * @param connection The connection to the worker.
+     * @param name The address of the worker.
+     * @return size_t The index of the worker.
+     */
+    size_t add_worker(const std::shared_ptr<StreamConnection>& connection, const std::string& name) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        WorkerSlot worker;
+        worker.connection = connection;
+        worker.name = name;
+        worker.shard = NO_SHARD;
+        worker.num_shards = 0;
+        workers_.push_back(worker);
+        log("Worker " + name + " connected");
+        return workers_.size() - 1;
+    }
+
+    /**
+     * @brief Wait for a shard to give a worker.
+     *
+     * @param worker The index of the worker.
+     * @param shard Set to the index of the shard.
+     * @param first Set to the first point of the shard.
+     * @param count Set to the number of points of the shard.
+     * @return bool True if the worker got a shard, false once every shard is done.
+     */
+    bool take_shard(size_t worker, size_t& shard, size_t& first, size_t& count) {
+        std::unique_lock<std::mutex> lock(mutex_);
+
+        for (;;) {
+            if (num_done_ == shards_.size()) {
+                return false;
+            }
+
+            if (pending_.empty()) {
+                requeue_timed_out_shards();
+            }
+
+            if (!pending_.empty()) {
+                shard = pending_.front();
+                pending_.pop_front();
+
+                ShardState& state = shards_[shard];
+                state.pending = false;
+                if (state.done) {
+                    continue;
+                }
+
+                state.in_flight++;
+                state.assigned = std::chrono::steady_clock::now();
+                workers_[worker].shard = shard;
+                first = state.first;
+                count = state.count;
+                return true;
+            }
+
+            // The shards of the other workers may still time out, or come back when a worker is lost
+            if (timeout_.count() > 0) {
+                changed_.wait_for(lock, std::chrono::milliseconds(100));
+            } else {
+                changed_.wait(lock);
+            }
+        }
+    }
+
+    /**
+     * @brief Take in the results of the shard of a worker.
+     *
+     * @param worker The index of the worker.
+     * @param shard The index of the shard the results are of.
+     * @param successful_ticks The successful ticks of every point of the shard.
+     * @return bool True if the worker was running that shard and sent a value per point, false otherwise.
+     */
+    bool complete(size_t worker, size_t shard, const std::vector<long long>& successful_ticks) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        WorkerSlot& slot = workers_[worker];
+
+        if (shard != slot.shard || successful_ticks.size() != shards_[shard].count) {
+            return false;
+        }
+
+        ShardState& state = shards_[shard];
+        state.in_flight--;
+        slot.shard = NO_SHARD;
+
+        // A shard that timed out may come back twice, and the first results are kept
+        if (!state.done) {
+            for (size_t i = 0; i < state.count; i++) {
+                results_[state.first + i].total_simulation_time = configs_[state.first + i].total_simulation_time;
+                results_[state.first + i].num_successful_transmission_ticks = successful_ticks[i];
+            }
+            state.done = true;
+            slot.num_shards++;
+            num_done_++;
+
+            if (num_done_ == shards_.size()) {
+                changed_.notify_all();
+            }
+        }
+
+        return true;
+    }
+
+    /**
+     * @brief Forget a worker whose connection ended, and queue its shard for another worker.
+     *
+     * @param worker The index of the worker.
+     * @param reason Why the worker is gone, for the log.
+     */
+    void remove_worker(size_t worker, const std::string& reason) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        WorkerSlot& slot = workers_[worker];
+        slot.connection.reset();
+
+        if (slot.shard == NO_SHARD) {
+            return;
+        }
+
+        ShardState& state = shards_[slot.shard];
+        state.in_flight--;
+
+        if (!state.done && state.in_flight == 0 && !state.pending) {
+            state.pending = true;
+            pending_.push_back(slot.shard);
+            num_reassigned_++;
+            changed_.notify_one();
+            log("Worker " + slot.name + " " + reason + ", shard " + std::to_string(slot.shard) + " reassigned");
+        }
+        slot.shard = NO_SHARD;
+    }
+
+    /**
+     * @brief Check whether every shard is done.
+     *
+     * @return bool True if the results of every point are in, false otherwise.
+     */
+    bool finished() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return num_done_ == shards_.size();
+    }
+
+    /**
+     * @brief Shut down the connections of every worker still connected, once every shard is done,
+     * so that their threads stop waiting for results or requests that are no longer needed.
+     *
+     * A worker without a shard, which may be about to ask for one or may never send
+     * anything, is told that the sweep is done first.
+     */
+    void shut_down_workers() {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        for (WorkerSlot& slot : workers_) {
+            if (!slot.connection) {
+                continue;
+            }
+
+            if (slot.shard == NO_SHARD) {
+                slot.connection->write_line("done");
+            }
+            slot.connection->shut_down();
+        }
+    }
+
+    /**
+     * @brief Sum up the shards and the workers of the sweep.
+     *
+     * @param summary Set to the shards, the workers that sent results and the reassigned shards.
+     */
+    void summarize(CoordinatorSummary& summary) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        summary.num_shards = static_cast<long long>(shards_.size());
+        summary.num_workers = 0;
+        for (const WorkerSlot& slot : workers_) {
+            summary.num_workers += slot.num_shards > 0 ? 1 : 0;
+        }
+        summary.num_reassigned = num_reassigned_;
+    }
+
+    /**
+     * @brief Log a line about the workers, at the events level.
+     *
+     * @param line The line.
+     */
+    void log(const std::string& line) {
+        if (log_level_ >= LOG_EVENTS) {
+            std::cout << line << std::endl;
+        }
+    }
+
+private:
+    /**
+     * @brief Queue the shards that have been out for longer than the timeout for another worker as well.
+     */
+    void requeue_timed_out_shards() {
+        if (timeout_.count() <= 0) {
+            return;
+        }
+
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+        for (size_t shard = 0; shard < shards_.size(); shard++) {
+            ShardState& state = shards_[shard];
+
+            if (!state.done && !state.pending && state.in_flight > 0 && now - state.assigned >= timeout_) {
+                state.pending = true;
+                pending_.push_back(shard);
+                num_reassigned_++;
+                log("Shard " + std::to_string(shard) + " timed out, reassigned");
+            }
+        }
+    }
+
+    const std::vector<SimulationConfig>& configs_;  /**< The configurations of the points. */
+    std::chrono::steady_clock::duration timeout_;   /**< The time after which a shard goes to another worker too. */
+    LogLevel log_level_;                            /**< The level the workers are logged at. */
+    std::vector<SimulationResults>& results_;       /**< The results of the points. */
+    std::mutex mutex_;                              /**< Guards everything below. */
+    std::condition_variable changed_;               /**< Signalled when a shard is queued or the last one is done. */
+    std::vector<ShardState> shards_;                /**< The shards, in the order of their points. */
+    std::deque<size_t> pending_;                    /**< The shards waiting for a worker. */
+    std::vector<WorkerSlot> workers_;               /**< Every worker that connected. */
+    size_t num_done_;                               /**< The number of shards whose results are in. */
+    long long num_reassigned_;                      /**< The number of times a shard was queued again. */
+};
+
+/**
+ * @brief Parse an integer of a message, followed by a space or by the end of the message.
+ *
+ * @param position The position of the integer, advanced past it.
+ * @param value Set to the integer.
+ * @return bool True if an integer was there, false otherwise.
+ */
+static bool read_integer(const char*& position, long long& value) {
+    char* end = nullptr;
+    errno = 0;
+    value = std::strtoll(position, &end, 10);
+
+    if (end == position || errno != 0 || (*end != '\0' && *end != ' ')) {
+        return false;
+    }
+
+    position = end;
+    return true;
+}
+
+/**
+ * @brief Build the message a coordinator greets its workers with.
+ *
+ * @param grid_contents The contents of the grid file.
+ * @param num_points The number of points of the grid file.
+ * @param options The engine and policy options of the sweep.
+ * @return std::string The header line, a newline and the grid file.
+ */
+static std::string greeting(const std::string& grid_contents, size_t num_points, const SimulationOptions& options) {
+    // The persistence is written with every digit, so the workers draw the same backoffs
+    char persistence[32];
+    std::snprintf(persistence, sizeof(persistence), "%.17g", options.persistence);
+
+    std::ostringstream message;
+    message << DISTRIBUTED_PROTOCOL << " " << num_points << " " << options.engine << " " << options.backoff_policy
+            << " " << options.window_policy << " " << (options.detect_cycles ? 1 : 0) << " " << options.seed << " "
+            << persistence << " " << grid_contents.size() << "\n" << grid_contents;
+    return message.str();
+}
+
+/**
+ * @brief Hand shards to one worker and take in their results, until every shard is done
+ * or the worker is gone.
+ *
+ * @param coordinator The shards of the sweep.
+ * @param worker The index of the worker.
+ * @param connection The connection to the worker.
+ * @param message The greeting of the worker.
+ */
+static void serve_worker(SweepCoordinator& coordinator, size_t worker,
+                         const std::shared_ptr<StreamConnection>& connection, const std::string& message) {
+    connection->write_line(message);
+
+    std::string line;
+    std::vector<long long> successful_ticks;
+
+    for (;;) {
+        if (!connection->read_line(line)) {
+            coordinator.remove_worker(worker, "lost");
+            return;
+        }
+
+        if (line == "next") {
+            size_t shard = 0;
+            size_t first = 0;
+            size_t count = 0;
+
+            if (!coordinator.take_shard(worker, shard, first, count)) {
+                connection->write_line("done");
+                coordinator.remove_worker(worker, "done");
+                return;
+            }
+
+            connection->write_line("shard " + std::to_string(shard) + " " + std::to_string(first) + " " +
+                                   std::to_string(count));
+        } else if (line.compare(0, 7, "result ") == 0) {
+            const char* position = line.c_str() + 6;
+            long long shard = 0;
+            long long value = 0;
+            bool valid = read_integer(position, shard) && shard >= 0;
+
+            successful_ticks.clear();
+            while (valid && *position != '\0') {
+                valid = read_integer(position, value) && value >= 0;
+                successful_ticks.push_back(value);
+            }
+
+            if (!valid || !coordinator.complete(worker, static_cast<size_t>(shard), successful_ticks)) {
+                coordinator.remove_worker(worker, "sent malformed results");
+                return;
+            }
+        } else {
+            coordinator.remove_worker(worker, line.compare(0, 6, "error ") == 0 ? "failed: " + line.substr(6)
+                                                                               : "sent a malformed message");
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Open a TCP socket listening on a port of every address of the machine.
+ *
+ * @param port The port, or 0 for any free port.
+ * @param bound_port Set to the port the socket listens on.
+ * @param error Set to a description of the problem if the socket cannot listen.
+ * @return int The socket, or -1 if it cannot listen.
+ */
+static int listen_on_port(int port, int& bound_port, std::string& error) {
+    struct sockaddr_in address;
+    std::memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons(static_cast<uint16_t>(port));
+
+    int listener = socket(AF_INET, SOCK_STREAM, 0);
+    int reuse = 1;
+    socklen_t length = sizeof(address);
+
+    if (listener < 0 || setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse)) != 0 ||
+        bind(listener, reinterpret_cast<struct sockaddr*>(&address), sizeof(address)) != 0 ||
+        listen(listener, SOMAXCONN) != 0 ||
+        getsockname(listener, reinterpret_cast<struct sockaddr*>(&address), &length) != 0) {
+        error = "unable to listen on port " + std::to_string(port) + ": " + std::strerror(errno);
+        if (listener >= 0) {
+            close(listener);
+        }
+        return -1;
+    }
+
+    bound_port = ntohs(address.sin_port);
+    return listener;
+}
+
+/**
+ * @brief Set the options every connection between a coordinator and a worker uses.
+ *
+ * The messages are short and answered one at a time, so they are sent at once, and
+ * keepalives let a coordinator notice a worker whose machine went away.
+ *
+ * @param fd The socket of the connection.
+ */
+static void set_connection_options(int fd) {
+    int enable = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+    setsockopt(fd, SOL_SOCKET, SO_KEEPALIVE, &enable, sizeof(enable));
+}
+
+bool run_coordinator(const std::string& grid_contents, const std::vector<SimulationConfig>& configs,
+                     const SimulationOptions& options, const CoordinatorOptions& coordinator,
+                     std::vector<SimulationResults>& results, CoordinatorSummary& summary, std::string& error) {
+    int port = 0;
+    int listener = listen_on_port(coordinator.port, port, error);
+
+    if (listener < 0) {
+        return false;
+    }
+
+    // A worker that goes away fails the writes to it, rather than stopping the coordinator
+    std::signal(SIGPIPE, SIG_IGN);
+
+    if (options.log_level >= LOG_SUMMARY) {
+        std::cout << "Coordinator listening on port " << port << std::endl;
+    }
+
+    SweepCoordinator sweep(configs, coordinator, options.log_level, results);
+    std::string message = greeting(grid_contents, configs.size(), options);
+    std::vector<std::thread> threads;
+
+    // The listener is polled, so the coordinator stops accepting workers once every shard is done
+    while (!sweep.finished()) {
+        struct pollfd descriptor = {listener, POLLIN, 0};
+
+        if (poll(&descriptor, 1, 100) <= 0) {
+            continue;
+        }
+
+        struct sockaddr_in address;
+        socklen_t length = sizeof(address);
+        int client = accept(listener, reinterpret_cast<struct sockaddr*>(&address), &length);
+
+        if (client < 0) {
+            continue;
+        }
+        set_connection_options(client);
+
+        char host[INET_ADDRSTRLEN] = "";
+        inet_ntop(AF_INET, &address.sin_addr, host, sizeof(host));
+        std::string name = std::string(host) + ":" + std::to_string(ntohs(address.sin_port));
+
+        std::shared_ptr<StreamConnection> connection(new StreamConnection(client, client, true));
+        size_t worker = sweep.add_worker(connection, name);
+        threads.emplace_back([&sweep, worker, connection, &message] {
+            serve_worker(sweep, worker, connection, message);
+        });
+    }
+
+    close(listener);
+    sweep.shut_down_workers();
+
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    sweep.summarize(summary);
+    return true;
+}
+
+/**
+ * @brief Connect to a coordinator, retrying while it is not listening yet.
+ *
+ * @param address The host and the port of the coordinator, as <host>:<port>.
+ * @param error Set to a description of the problem if no connection could be made.
+ * @return int The socket of the connection, or -1 on failure.
+ */
+static int connect_to_coordinator(const std::string& address, std::string& error) {
+    size_t colon = address.rfind(':');
+
+    if (colon == std::string::npos || colon == 0 || colon + 1 == address.size()) {
+        error = "invalid coordinator address '" + address + "' (expected <host>:<port>)";
+        return -1;
+    }
+
+    std::string host = address.substr(0, colon);
+    std::string port = address.substr(colon + 1);
+
+    struct addrinfo hints;
+    std::memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+
+    std::chrono::steady_clock::time_point deadline =
+        std::chrono::steady_clock::now() + std::chrono::seconds(DISTRIBUTED_CONNECT_SECONDS);
+
+    for (;;) {
+        struct addrinfo* addresses = nullptr;
+        int status = getaddrinfo(host.c_str(), port.c_str(), &hints, &addresses);
+
+        if (status != 0) {
+            error = "unable to resolve " + address + ": " + gai_strerror(status);
+            return -1;
+        }
+
+        for (struct addrinfo* candidate = addresses; candidate; candidate = candidate->ai_next) {
+            int fd = socket(candidate->ai_family, candidate->ai_socktype, candidate->ai_protocol);
+
+            if (fd >= 0 && connect(fd, candidate->ai_addr, candidate->ai_addrlen) == 0) {
+                freeaddrinfo(addresses);
+                set_connection_options(fd);
+                return fd;
+            }
+
+            error = "unable to connect to " + address + ": " + std::strerror(errno);
+            if (fd >= 0) {
+                close(fd);
+            }
+        }
+        freeaddrinfo(addresses);
+
+        if (std::chrono::steady_clock::now() >= deadline) {
+            return -1;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+}
+
+/**
+ * @brief Read the greeting of a coordinator, and the points and options of its sweep.
+ *
+ * @param connection The connection to the coordinator.
+ * @param configs Set to the configurations of the points of the sweep.
+ * @param options Set to the engine and policy options of the sweep.
+ * @param error Set to a description of the problem if the sweep cannot be run.
+ * @return bool True if the sweep can be run, false otherwise.
+ */
+static bool read_greeting(StreamConnection& connection, std::vector<SimulationConfig>& configs,
+                          SimulationOptions& options, std::string& error) {
+    std::string line;
+
+    if (!connection.read_line(line)) {
+        error = "the coordinator closed the connection";
+        return false;
+    }
+
+    std::istringstream header(line);
+    std::string protocol;
+    int version = 0;
+    size_t num_points = 0;
+    int engine = 0;
+    int backoff_policy = 0;
+    int window_policy = 0;
+    int detect_cycles = 0;
+    size_t num_bytes = 0;
+
+    header >> protocol >> version >> num_points >> engine >> backoff_policy >> window_policy >> detect_cycles >>
+        options.seed >> options.persistence >> num_bytes;
+
+    if (!header || protocol + " " + std::to_string(version) != DISTRIBUTED_PROTOCOL || engine < ENGINE_TICK ||
+        engine > ENGINE_BATCH || backoff_policy < BACKOFF_DETERMINISTIC || backoff_policy > BACKOFF_P_PERSISTENT ||
+        window_policy < WINDOW_TABLE || window_policy > WINDOW_BINARY_EXPONENTIAL) {
+        error = "the coordinator speaks another protocol than " DISTRIBUTED_PROTOCOL;
+        return false;
+    }
+
+    options.engine = static_cast<Engine>(engine);
+    options.backoff_policy = static_cast<BackoffPolicy>(backoff_policy);
+    options.window_policy = static_cast<WindowPolicy>(window_policy);
+    options.detect_cycles = detect_cycles != 0;
+
+    // The grid file is followed by the newline that ends the message
+    std::string contents;
+    if (!connection.read_bytes(num_bytes, contents) || !connection.read_line(line) || !line.empty()) {
+        error = "the coordinator closed the connection";
+        return false;
+    }
+
+    std::vector<SweepGrid> grids;
+    if (!parse_sweep_grids(contents, grids, error)) {
+        error = "invalid sweep file: " + error;
+        return false;
+    }
+
+    configs.clear();
+    for (const SweepGrid& grid : grids) {
+        std::vector<SimulationConfig> grid_configs = expand_sweep_grid(grid);
+        configs.insert(configs.end(), grid_configs.begin(), grid_configs.end());
+    }
+
+    for (size_t i = 0; i < configs.size(); i++) {
+        if (!validate_config(configs[i], error)) {
+            error = "invalid sweep file: point " + std::to_string(i + 1) + ": " + error;
+            return false;
+        }
+    }
+
+    if (configs.size() != num_points) {
+        error = "the sweep file has " + std::to_string(configs.size()) + " points here and " +
+                std::to_string(num_points) + " on the coordinator";
+        return false;
+    }
+
+    return true;
+}
+
+bool run_worker(const std::string& address, int num_threads, long long& num_shards, std::string& error) {
+    num_shards = 0;
+    int fd = connect_to_coordinator(address, error);
+
+    if (fd < 0) {
+        return false;
+    }
+
+    // A coordinator that goes away fails the writes to it, rather than stopping the worker
+    std::signal(SIGPIPE, SIG_IGN);
+
+    StreamConnection connection(fd, fd, true);
+    std::vector<SimulationConfig> configs;
+    SimulationOptions options;
+
+    if (!read_greeting(connection, configs, options, error)) {
+        connection.write_line("error " + error);
+        return false;
+    }
+
+    std::string line;
+    std::vector<SimulationConfig> shard_configs;
+
+    for (;;) {
+        connection.write_line("next");
+
+        if (!connection.read_line(line)) {
+            error = "lost the connection to the coordinator";
+            return false;
+        }
+
+        if (line == "done") {
+            return true;
+        }
+
+        std::istringstream message(line);
+        std::string kind;
+        size_t shard = 0;
+        size_t first = 0;
+        size_t count = 0;
+        message >> kind >> shard >> first >> count;
+
+        if (!message || kind != "shard" || first > configs.size() || count > configs.size() - first) {
+            error = "malformed message from the coordinator: " + line;
+            return false;
+        }
+
+        shard_configs.assign(configs.begin() + first, configs.begin() + first + count);
+        std::vector<SimulationResults> results = run_sweep(shard_configs, options, num_threads);
+
+        std::string answer = "result " + std::to_string(shard);
+        for (const SimulationResults& point : results) {
+            answer += " " + std::to_string(point.num_successful_transmission_ticks);
+        }
+        connection.write_line(answer);
+        num_shards++;
+    }
+}
@@ -0,0 +1,162 @@
+/**
+ * @file async_log.h
+ * @brief A log written by a background thread, for --async-log.
+ *
+ * The events and full-trace logs print a line for every event, and the full
+ * trace one for every node on every tick, so formatting and writing them on the
+ * simulating thread makes the simulation as slow as the output. With an
+ * asynchronous log, every line is a compact record that the simulation pushes
+ * into a preallocated ring buffer. A background thread formats the records into
+ * exactly the text the simulation would have printed, and writes it to the log
+ * stream in large blocks.
+ *
+ * When the thread falls behind and the ring is full, the backpressure policy
+ * decides: the simulation either waits for a free slot, so the log is complete,
+ * or drops the record and counts it, so the simulation never waits.
+ *
+ * @author Vicky Chen (chen-vv)
+ * @author Eric Omielan (eomielan)
+ * @bug No known bugs.
+ */
+
+#ifndef ASYNC_LOG_H
+#define ASYNC_LOG_H
+
+#include <atomic>
+#include <cstddef>
+#include <iosfwd>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ring_buffer.h"
+
+/** @brief The number of records the ring buffer of an asynchronous log holds. */
+#define ASYNC_LOG_RING_CAPACITY (1 << 16)
+
+/** @brief The number of bytes of text the writing thread collects before it writes them. */
+#define ASYNC_LOG_BLOCK_SIZE (1 << 16)
+
+/** @brief The longest line a single record formats to, in bytes. */
+#define LOG_RECORD_MAX_LENGTH 96
+
+/**
+ * @brief The lines of the log.
+*/
+enum LogRecordKind {
+    LOG_RECORD_TICK,            /**< "Tick: <first>" */
+    LOG_RECORD_BACKOFF,         /**< "Node <first> backoff: <second>" */
+    LOG_RECORD_OCCUPIED,        /**< "Channel is occupied by node <first>" */
+    LOG_RECORD_IDLE,            /**< "Channel is idle." and an empty line */
+    LOG_RECORD_FINISHED,        /**< "Node <first> finished transmitting. new backoff <second>" */
+    LOG_RECORD_COLLISION,       /**< "Collision detected b/w:" */
+    LOG_RECORD_COLLIDED,        /**< "Node <first>" */
+    LOG_RECORD_CYCLE            /**< "Cycle of <first> ticks detected, skipping to tick <second>" */
+};
+
+/**
+ * @brief What the simulation does when the ring buffer of an asynchronous log is full.
+*/
+enum LogBackpressure {
+    LOG_BACKPRESSURE_BLOCK,     /**< Wait until the writing thread frees a slot, so no line is lost. */
+    LOG_BACKPRESSURE_DROP       /**< Drop the record and count it, so the simulation never waits. */
+};
+
+/**
+ * @brief One line of the log, before it is formatted.
+*/
+struct LogRecord {
+    long long first;            /**< The tick, node or cycle length the line starts with. */
+    long long second;           /**< The backoff or tick the line ends with, if it has one. */
+    int kind;                   /**< The LogRecordKind of the line. */
+};
+
+/**
+ * @brief Format a record into exactly the line the simulation prints for it.
+ *
+ * @param record The record.
+ * @param buffer Set to the text of the line, which holds at least LOG_RECORD_MAX_LENGTH bytes.
+ * @return size_t The number of bytes of the line, including its newlines.
+ */
+size_t format_log_record(const LogRecord& record, char* buffer);
+
+/**
+ * @brief Parse the name of a backpressure policy, as given to --async-log.
+ *
+ * @param name "block" or "drop".
+ * @param backpressure Set to the policy.
+ * @return bool True if the name is a policy, false otherwise.
+ */
+bool parse_log_backpressure(const std::string& name, LogBackpressure& backpressure);
+
+/**
+ * @brief A log formatted and written by a background thread, passed to a simulation in its options.
+ *
+ * Records are pushed by a single simulating thread at a time.
+*/
+class AsyncLog {
+public:
+    AsyncLog();
+    ~AsyncLog();
+
+    AsyncLog(const AsyncLog&) = delete;
+    AsyncLog& operator=(const AsyncLog&) = delete;
+
+    /**
+     * @brief Start the thread that writes the log.
+     *
+     * @param stream The stream the log is written to, which nothing else writes to until close().
+     * @param backpressure What push() does when the ring buffer is full.
+     */
+    void open(std::ostream& stream, LogBackpressure backpressure);
+
+    /**
+     * @brief Append a line to the log, from the simulating thread.
+     *
+     * @param record The line.
+     */
+    void push(const LogRecord& record) {
+        if (ring_.try_push(record)) {
+            return;
+        }
+
+        if (backpressure_ == LOG_BACKPRESSURE_DROP) {
+            num_dropped_++;
+            return;
+        }
+
+        while (!ring_.try_push(record)) {
+            std::this_thread::yield();
+        }
+    }
+
+    /**
+     * @brief Wait until every record is written, and stop the writing thread.
+     */
+    void close();
+
+    /**
+     * @brief Get the number of records that were dropped because the ring buffer was full.
+     *
+     * @return long long The number of dropped records, always 0 when push() blocks.
+     */
+    long long num_dropped() const {
+        return num_dropped_;
+    }
+
+private:
+    /**
+     * @brief Format and write the records until the log is closed.
+     */
+    void write_records();
+
+    std::ostream* stream_;                      /**< The stream the log is written to. */
+    LogBackpressure backpressure_;              /**< What push() does when the ring is full. */
+    long long num_dropped_;                     /**< The records push() dropped. */
+    RingBuffer<LogRecord> ring_;                /**< The records not formatted yet. */
+    std::vector<char> block_;                   /**< The text formatted and not written yet. */
+    std::thread thread_;                        /**< The thread writing the log. */
+    std::atomic<bool> closing_;                 /**< Set once the last record is in the ring. */
+};
+
+#endif // ASYNC_LOG_H
@@ -0,0 +1,69 @@
+/**
+ * @file batch.h
+ * @brief A lockstep engine that runs many small simulations at once, one per vector lane.
+ *
+ * A sweep over small configurations runs thousands of simulations of a few nodes
+ * each, and a single one of them leaves most of a core idle: every event is a
+ * short chain of dependent instructions. The batch engine runs BATCH_LANES of them
+ * side by side instead. The state of the simulations is stored lane by lane, so
+ * element i of every array belongs to the simulation in lane i, and every step
+ * advances every lane by one event with the same instructions:
+ *
+ *     find the smallest backoff of each lane and the bitmask of the nodes that have it
+ *     count every backoff of each lane down by its smallest backoff (the idle case)
+ *     transmit the whole packet in the lanes with a single ready node
+ *     spend one tick on a collision in the lanes with several ready nodes
+ *
+ * The four cases of a tick are picked by masks rather than branches, and a lane
+ * that is done, or has no event left before its end, does nothing in a step. Only
+ * the new backoffs are drawn one lane at a time. A lane whose simulation is done
+ * takes the next configuration of the batch, so the lanes stay busy until the
+ * batch runs out.
+ *
+ * The results are exactly those of the other engines.
+ *
+ * @author Vicky Chen (chen-vv)
+ * @author Eric Omielan (eomielan)
+ * @bug No known bugs.
+ */
+
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <cstddef>
+#include <vector>
+
+#include "csma.h"
+
+/** @brief The number of simulations the batch engine runs side by side. */
+#define BATCH_LANES 8
+
+/** @brief The largest number of nodes of a simulation the batch engine runs. */
+#define BATCH_MAX_NODES 8
+
+/** @brief The largest number of different backoff windows of a simulation the batch engine runs. */
+#define BATCH_MAX_WINDOWS 16
+
+/**
+ * @brief Check whether the batch engine can run a configuration.
+ *
+ * @param config The configuration, which must be valid.
+ * @param options The options it is run with.
+ * @return bool True if the configuration has 1 to BATCH_MAX_NODES nodes and at most
+ * BATCH_MAX_WINDOWS windows under the window policy of the options, false otherwise.
+ */
+bool batchable(const SimulationConfig& config, const SimulationOptions& options);
+
+/**
+ * @brief Run a batch of configurations in lockstep, with the policies selected in the options.
+ *
+ * @param configs The configurations of a sweep.
+ * @param points The indices of the configurations to run, which must all be batchable().
+ * @param num_points The number of indices.
+ * @param options The policy options used for every configuration.
+ * @param results Set to the results of the configurations at the given indices.
+ */
+void run_batch(const std::vector<SimulationConfig>& configs, const size_t* points, size_t num_points,
+               const SimulationOptions& options, std::vector<SimulationResults>& results);
+
+#endif // BATCH_H
@@ -0,0 +1,155 @@
+/**
+ * @file checkpoint.h
+ * @brief Snapshots of a running simulation, for --checkpoint-every and --resume.
+ *
+ * A checkpoint file holds a fixed-size header followed by the columns of the
+ * node table, in the byte order of the machine that wrote it:
+ *
+ *     CheckpointHeader
+ *     int32 backoff[num_nodes]
+ *     int32 collision_count_overflows[num_collision_count_overflows][2]
+ *     uint8 collision_count[num_nodes]
+ *
+ * The collision counts that do not fit in a byte are stored as (node ID, count)
+ * pairs, which are only there when M is at least COLLISION_COUNT_OVERFLOW. The
+ * columns are at fixed offsets with no padding, so a checkpoint can be mapped
+ * into memory and copied straight into the node table, however large N is.
+ *
+ * A checkpoint is written to a temporary file of its own, with a unique name, that
+ * is renamed over the previous checkpoint once it is complete, so a run that is
+ * killed while writing still leaves the previous checkpoint intact, and several
+ * processes writing the same checkpoint never write into the same file.
+ *
+ * @author Vicky Chen (chen-vv)
+ * @author Eric Omielan (eomielan)
+ * @bug No known bugs.
+ */
+
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <cstdint>
+#include <string>
+#include <thread>
+
+#include "csma.h"
+
+/**
+ * @brief The header of a checkpoint file.
+*/
+struct CheckpointHeader {
+    char magic[8];                              /**< Always "CSMACKP2". */
+    uint32_t byte_order;                        /**< Always 0x01020304, in the byte order of the writer. */
+    uint32_t flags;                             /**< Bit 0 set if the channel is occupied. */
+    uint64_t fingerprint;                       /**< The checkpoint_fingerprint() of the run. */
+    int64_t current_tick;                       /**< The tick the simulation stopped at. */
+    int64_t num_successful_transmission_ticks;  /**< The successful ticks up to the current tick. */
+    int32_t num_nodes;                          /**< The number of entries of every column. */
+    int32_t active_node_id;                     /**< The ID of the node transmitting a packet. */
+    int32_t packet_ticks_remaining;             /**< The number of ticks left of that packet. */
+    int32_t num_collision_count_overflows;      /**< The number of collision counts that do not fit in a byte. */
+    uint64_t checksum;                          /**< The checksum of the header, with this field zero, and the columns. */
+};
+
+/**
+ * @brief Compute the fingerprint of everything a checkpoint can only be resumed with.
+ *
+ * The fingerprint covers the parameters and the policies of the run, except for the
+ * simulation time, so a resumed run may also run for longer than the original one.
+ *
+ * @param config The parameters of the simulation.
+ * @param options The options of the simulation.
+ * @return uint64_t The fingerprint.
+ */
+uint64_t checkpoint_fingerprint(const SimulationConfig& config, const SimulationOptions& options);
+
+/**
+ * @brief Write a snapshot to a checkpoint file, replacing it atomically.
+ *
+ * @param filename The name of the checkpoint file.
+ * @param snapshot The snapshot to write.
+ * @param fingerprint The checkpoint_fingerprint() of the run.
+ * @return bool True if the checkpoint was written, false otherwise.
+ */
+bool write_checkpoint(const std::string& filename, const SimulationSnapshot& snapshot, uint64_t fingerprint);
+
+/**
+ * @brief Read a checkpoint file, mapping it into memory.
+ *
+ * @param filename The name of the checkpoint file.
+ * @param fingerprint The checkpoint_fingerprint() of the run to resume.
+ * @param num_nodes The number of nodes of the run to resume.
+ * @param snapshot Set to the snapshot in the file.
+ * @param error Set to a description of the problem if the checkpoint cannot be resumed.
+ * @return bool True if the checkpoint was read and belongs to the run, false otherwise.
+ */
+bool read_checkpoint(const std::string& filename, uint64_t fingerprint, int num_nodes,
+                     SimulationSnapshot& snapshot, std::string& error);
+
+/**
+ * @brief Writes the checkpoints of a run in the background.
+ *
+ * The simulation copies its state into one of two snapshots and goes on running
+ * while the other is written, so the loop only waits for a write when it reaches
+ * the next checkpoint before the previous one is on disk.
+*/
+class CheckpointWriter {
+public:
+    /**
+     * @brief Construct a writer of checkpoints.
+     *
+     * @param filename The name of the checkpoint file.
+     * @param interval The number of ticks between two checkpoints, at least 1.
+     * @param fingerprint The checkpoint_fingerprint() of the run.
+     */
+    CheckpointWriter(const std::string& filename, long long interval, uint64_t fingerprint);
+
+    /**
+     * @brief Wait for the checkpoint being written, if any.
+     */
+    ~CheckpointWriter();
+
+    CheckpointWriter(const CheckpointWriter&) = delete;
+    CheckpointWriter& operator=(const CheckpointWriter&) = delete;
+
+    /**
+     * @brief Get the number of ticks between two checkpoints.
+     *
+     * @return long long The interval.
+     */
+    long long interval() const {
+        return interval_;
+    }
+
+    /**
+     * @brief Get the snapshot to save the next checkpoint into.
+     *
+     * @return SimulationSnapshot& A snapshot that is not being written.
+     */
+    SimulationSnapshot& next_snapshot() {
+        return snapshots_[next_];
+    }
+
+    /**
+     * @brief Start writing the snapshot returned by next_snapshot() in the background.
+     */
+    void commit();
+
+    /**
+     * @brief Wait for the checkpoint being written, if any.
+     *
+     * @return bool True if every checkpoint was written, false otherwise.
+     */
+    bool close();
+
+private:
+    std::string filename_;                      /**< The name of the checkpoint file. */
+    long long interval_;                        /**< The number of ticks between two checkpoints. */
+    uint64_t fingerprint_;                      /**< The fingerprint written to every checkpoint. */
+    SimulationSnapshot snapshots_[2];           /**< The snapshot being written and the next one. */
+    int next_;                                  /**< The index of the next snapshot. */
+    std::thread thread_;                        /**< The thread writing a checkpoint, if any. */
+    bool failed_;                               /**< Set by the writing thread if a write failed. */
+};
+
+#endif // CHECKPOINT_H
@@ -0,0 +1,81 @@
+/**
+ * @file convergence.h
+ * @brief Early termination of a simulation once its utilization has converged, for --converge.
+ *
+ * The simulation runs in batches of a fixed number of ticks, and the successful
+ * ticks of every batch give a series of batch utilizations. The end of the warm-up
+ * transient is found with the marginal standard error rule (MSER): the number of
+ * leading batches d that are dropped is the one that minimizes
+ *
+ *     sum over i > d of (u_i - mean of u_(d+1..k))^2 / (k - d)^2
+ *
+ * over d in [0, k/2], which trades the bias of the transient against the variance
+ * of a shorter series. The steady-state utilization is the mean of the remaining
+ * batches, and the batches are long enough to be nearly independent, so the 95%
+ * confidence interval of the mean follows from their variance with Student's t
+ * distribution. The simulation stops as soon as half the width of that interval is
+ * at most the tolerance, with at least CONVERGENCE_MIN_BATCHES batches after the
+ * warm-up, or at T if it never gets there.
+ *
+ * The deterministic backoff policy has no noise to average out: its runs become
+ * periodic. They are handed off to cycle detection instead, which gives the exact
+ * result at T while skipping the repetitions of the cycle.
+ *
+ * @author Vicky Chen (chen-vv)
+ * @author Eric Omielan (eomielan)
+ * @bug No known bugs.
+ */
+
+#ifndef CONVERGENCE_H
+#define CONVERGENCE_H
+
+#include "csma.h"
+
+/** @brief The fewest batches after the warm-up that an estimate may stop on. */
+#define CONVERGENCE_MIN_BATCHES 20
+
+/**
+ * @brief When a run may stop early.
+*/
+struct ConvergenceOptions {
+    double tolerance;               /**< The largest half width of the 95% confidence interval to stop at. */
+    long long batch_ticks;          /**< The number of ticks of every batch, or 0 for default_batch_ticks(). */
+};
+
+/**
+ * @brief The outcome of a run that may stop early.
+*/
+struct ConvergenceResult {
+    SimulationResults results;      /**< The results of the ticks that were simulated. */
+    bool estimated;                 /**< Whether the utilization was estimated from batches, rather than run with cycle detection. */
+    bool converged;                 /**< Whether the estimate stopped the run before T. */
+    long long batch_ticks;          /**< The number of ticks of every batch. */
+    long long warmup_ticks;         /**< The number of ticks of the warm-up transient that were dropped. */
+    long long num_batches;          /**< The number of batches after the warm-up. */
+    long long steady_successful_ticks; /**< The successful ticks the steady-state utilization is estimated from. */
+    long long steady_ticks;         /**< The ticks the steady-state utilization is estimated from. */
+    double ci_half_width;           /**< Half the width of the 95% confidence interval of the estimate. */
+};
+
+/**
+ * @brief Get the default length of a batch, which spans many backoff and transmission cycles.
+ *
+ * @param config The parameters of the simulation.
+ * @return long long The number of ticks of every batch.
+ */
+long long default_batch_ticks(const SimulationConfig& config);
+
+/**
+ * @brief Run a simulation until its utilization converges, or until T.
+ *
+ * With the deterministic backoff policy, the simulation runs to T with cycle detection.
+ *
+ * @param config The parameters of the simulation, which must be valid.
+ * @param options How the simulation is run.
+ * @param convergence When the simulation may stop.
+ * @return ConvergenceResult The results of the ticks that were simulated, and the estimate.
+ */
+ConvergenceResult run_until_converged(const SimulationConfig& config, SimulationOptions options,
+                                      const ConvergenceOptions& convergence);
+
+#endif // CONVERGENCE_H
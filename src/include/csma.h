@@ -2,9 +2,11 @@
  * @file csma.h
  * @brief Function prototypes and data structures for CSMA simulation.
  *
- * This contains the function prototypes and any macros, constants,
- * or global variables you will need for simulating the Carrier Sense
- * Multiple Access (CSMA) protocol.
+ * This contains the function prototypes, macros, constants and the
+ * Simulation class you will need for simulating the Carrier Sense
+ * Multiple Access (CSMA) protocol. Every simulation owns its own
+ * configuration and state, so any number of them can exist in one
+ * process and this header can be included from any translation unit.
  *
  * @author Vicky Chen (chen-vv)
  * @author Eric Omielan (eomielan)
@@ -14,8 +16,21 @@
 #ifndef CSMA_H
 #define CSMA_H
 
+#include <iosfwd>
+#include <map>
+#include <string>
 #include <vector>
 
+#include "policies.h"
+
+class TraceWriter;
+class NodeStatistics;
+class CheckpointWriter;
+class UtilizationReport;
+class ResultCache;
+class AsyncLog;
+struct SimulationProfile;
+
 /**
  * @brief Macro to determine whether a node is ready to transmit.
  * 
@@ -35,165 +50,905 @@
 #define TRANSMIT_COMPLETE 0
 
 /**
- * @brief Structure to represent a node in the CSMA simulation.
+ * @brief Verbosity of the text written to standard output during a simulation.
  * 
- * This structure contains the necessary information to represent a node
- * in the CSMA simulation. It includes the node's ID, the number of
- * collisions the node has experienced, the backoff value, the R value,
- * and the number of ticks remaining for the node to finish transmitting.
+ * Each level includes everything printed by the levels before it. The levels
+ * are selected on the command line with --log-level.
 */
-struct Node {
-    int id;                     /**< The unique identifier of the node. */                     
-    int collision_count;        /**< The number of collisions experienced. */
-    int backoff;                /**< 
-                                  * The backoff value of the node.
-                                  * This value determines the amount of time the node
-                                  * must wait before transmitting its packet. 
-                                  * It will always be within the range of [0, R).
+enum LogLevel {
+    LOG_OFF,                    /**< Nothing is printed; only the output file is written. */
+    LOG_SUMMARY,                /**< Only the final count of successful slots is printed. */
+    LOG_EVENTS,                 /**< 
+                                  * Transmission starts, transmission ends and collisions
+                                  * are printed, each under the tick they happened on.
                                   */
-    int R;                      /**< 
-                                  * The R value of the node.  
-                                  * This value is used to determine the upper 
-                                  * limit of the backoff value.
-                                  */
-    int packet_ticks_remaining;        /**< 
-                                  * The number of ticks remaining for the node
-                                  * to finish transmitting its packet.
+    LOG_FULL_TRACE              /**< 
+                                  * Every tick and every node's backoff is printed. This is
+                                  * the original output of the simulator and the default.
                                   */
 };
 
 /**
- * @brief The list of all the nodes in the simulation.
- * 
- * This vector contains all the nodes in the simulation. Each node is
- * represented by a Node structure, and the node with id i can be accessed
- * by nodes[i].
+ * @brief The algorithm used to advance the simulation clock.
  * 
- * The length of this list is parsed and read from the input file, denoted
- * by N.
+ * All engines produce the same link utilization rate for the same input. The
+ * engine is selected on the command line with --engine.
 */
-std::vector<Node> nodes;
+enum Engine {
+    ENGINE_TICK,                /**< 
+                                  * Every tick is simulated one at a time. The nodes
+                                  * that are ready to transmit are looked up in a
+                                  * ReadyCalendar, so an idle tick does not visit every
+                                  * node.
+                                  */
+    ENGINE_REFERENCE,           /**< 
+                                  * Every tick is simulated one at a time by scanning and
+                                  * counting down every node. This is the original engine,
+                                  * kept as the reference the other engines are checked
+                                  * against.
+                                  */
+    ENGINE_NEXT_EVENT,          /**< 
+                                  * The clock jumps straight to the next tick on which
+                                  * a transmission starts, ends or collides. Idle
+                                  * countdowns and the rest of a transmission are skipped
+                                  * in a single step. The full trace is not available,
+                                  * so it is reduced to the events log level.
+                                  */
+    ENGINE_SIMD,                /**< 
+                                  * Every tick is simulated one at a time like the
+                                  * reference engine, but the ready nodes are counted and
+                                  * the backoffs counted down with vector instructions.
+                                  */
+    ENGINE_GROUP,               /**< 
+                                  * Like the next-event engine, but the nodes are grouped
+                                  * in a ReadyCalendar by the epoch on which they become
+                                  * ready as soon as their backoff is assigned, so an
+                                  * event only visits the nodes of its group instead of
+                                  * every node. The full trace is reduced to the events
+                                  * log level.
+                                  */
+    ENGINE_SMALL,               /**< 
+                                  * For at most SMALL_ENGINE_MAX_NODES nodes, the backoffs
+                                  * are kept in an array of a size fixed at compile time and
+                                  * the ready nodes in a bitmask, and the clock jumps from
+                                  * one event to the next like the next-event engine, except
+                                  * with the full trace. Larger simulations run the tick
+                                  * engine. This is the default.
+                                  */
+    ENGINE_BATCH                /**< 
+                                  * In a sweep, the points of at most BATCH_MAX_NODES nodes
+                                  * run BATCH_LANES at a time in the lanes of vector
+                                  * instructions, see batch.h. A single simulation, and every
+                                  * point the batch engine cannot run, runs the small engine.
+                                  */
+};
+
+/** @brief The largest number of nodes ENGINE_SMALL keeps in fixed-size arrays. */
+#define SMALL_ENGINE_MAX_NODES 64
 
 /**
- * @brief The length of the packet in number of ticks it takes to transmit.
- * 
- * This variable represents the length of the packet in number of simulation
- * ticks. Each packet in the simulation takes this number of ticks to transmit.
- * 
- * This value is parsed and read from the input file, denoted by L.
+ * @brief The backoff policies that can be selected at run time, see policies.h.
+*/
+enum BackoffPolicy {
+    BACKOFF_DETERMINISTIC,      /**< DeterministicBackoff, mod(node_id + ticks, R). This is the default. */
+    BACKOFF_UNIFORM,            /**< UniformBackoff, uniformly random in the window. */
+    BACKOFF_P_PERSISTENT        /**< PPersistentBackoff, p-persistent CSMA truncated to the window. */
+};
+
+/**
+ * @brief The window policies that can be selected at run time, see policies.h.
 */
-int packet_length;
+enum WindowPolicy {
+    WINDOW_TABLE,               /**< TableWindow, the R value at the collision count. This is the default. */
+    WINDOW_BINARY_EXPONENTIAL   /**< BinaryExponentialWindow, doubling from the first to the last R value. */
+};
+
+/**
+ * @brief The collision count a node's byte holds once the count no longer fits in it.
+*/
+#define COLLISION_COUNT_OVERFLOW 255
 
 /**
- * @brief A list of possible upper limits on a node's backoff value.
+ * @brief Table of the state of every node in the CSMA simulation.
  * 
- * This list contains the upper limits on a node's backoff value. By default,
- * each node starts with the first value in this list, and the value is updated
- * based on the number of collisions experienced by the node.
+ * The state of the nodes is stored as one contiguous array per field, and the
+ * node with id i is described by element i of every array, so the ID itself is
+ * implicit. Idle ticks only touch the backoffs, which this layout keeps densely
+ * packed so they can be scanned and counted down with vector instructions.
  * 
- * Note that the length of this list is always equal to M, the maximum 
- * number of retransmission attempts before the packet is dropped. As a result,
- * at collision count i, the node's R value is updated to R[i].
+ * A node only holds its backoff and its collision count, five bytes in all: its
+ * window always follows from the collision count and the shared R values, and only
+ * the node transmitting a packet has ticks of it left, which the simulation keeps
+ * on its own. The collision count is a byte, since it never exceeds M + 1 and M is
+ * small in practice. The exact count of a node that reaches COLLISION_COUNT_OVERFLOW
+ * is kept on the side, so a large M still behaves exactly the same.
+*/
+struct NodeTable {
+    std::vector<unsigned char> collision_count; /**< 
+                                                  * The number of collisions experienced,
+                                                  * or COLLISION_COUNT_OVERFLOW if it is kept
+                                                  * in collision_count_overflows.
+                                                  */
+    std::vector<int> backoff;                   /**< 
+                                                  * The backoff value of the node.
+                                                  * This value determines the amount of time the node
+                                                  * must wait before transmitting its packet. 
+                                                  * It will always be within the range of [0, R).
+                                                  */
+    std::map<int, int> collision_count_overflows; /**< The collision counts that do not fit in a byte, by node ID. */
+
+    /**
+     * @brief Get the number of nodes in the table.
+     * 
+     * @return int The number of nodes.
+     */
+    int size() const {
+        return static_cast<int>(backoff.size());
+    }
+
+    /**
+     * @brief Change the number of nodes in the table.
+     * 
+     * @param num_nodes The new number of nodes.
+     */
+    void resize(int num_nodes) {
+        collision_count.resize(num_nodes);
+        backoff.resize(num_nodes);
+        collision_count_overflows.clear();
+    }
+
+    /**
+     * @brief Get the number of collisions a node experienced.
+     * 
+     * @param node_id The ID of the node.
+     * @return int The collision count of the node.
+     */
+    int collisions(int node_id) const {
+        int count = collision_count[node_id];
+        return count < COLLISION_COUNT_OVERFLOW ? count : collision_count_overflows.at(node_id);
+    }
+
+    /**
+     * @brief Set the number of collisions a node experienced.
+     * 
+     * @param node_id The ID of the node.
+     * @param count The new collision count of the node.
+     */
+    void set_collisions(int node_id, int count) {
+        if (collision_count[node_id] == COLLISION_COUNT_OVERFLOW) {
+            collision_count_overflows.erase(node_id);
+        }
+
+        if (count >= COLLISION_COUNT_OVERFLOW) {
+            collision_count_overflows[node_id] = count;
+            count = COLLISION_COUNT_OVERFLOW;
+        }
+        collision_count[node_id] = static_cast<unsigned char>(count);
+    }
+};
+
+/**
+ * @brief A copy of the complete state of a simulation at one tick, see checkpoint.h.
  * 
- * This list is parsed and read from the input file, denoted by R.
+ * The random backoff policies are counter-based, so the state of the nodes, the
+ * channel and the counters is all it takes to continue a run exactly.
 */
-std::vector<int> R;
+struct SimulationSnapshot {
+    NodeTable nodes;                            /**< The state of every node. */
+    bool channel_occupied;                      /**< Whether a node is transmitting a packet. */
+    int active_node_id;                         /**< The ID of the node transmitting a packet. */
+    int packet_ticks_remaining;                 /**< The number of ticks left of that packet. */
+    long long current_tick;                     /**< The tick the simulation stopped at. */
+    long long num_successful_transmission_ticks; /**< The successful ticks up to the current tick. */
+};
 
 /**
- * @brief The maximum number of attempts that a node makes to transmit a packet.
+ * @brief Index of the nodes by the idle tick on which their backoff reaches zero.
  * 
- * This variable represents the maximum number of retransmission attempts that
- * a node makes to transmit a packet. If the node reaches this number of attempts
- * without successfully transmitting the packet, the packet is dropped and the
- * node moves on to the next packet.
+ * A node's backoff only counts down on idle ticks, so instead of decrementing every
+ * node, the calendar counts the idle ticks that have elapsed (the epoch) and files
+ * each node under the epoch on which it becomes ready, i.e. the epoch at which its
+ * backoff was assigned plus the backoff. The nodes filed under the current epoch
+ * are exactly the nodes that are ready to transmit.
  * 
- * This value is parsed and read from the input file, denoted by M.
+ * Nodes are filed in a circular array of buckets, each holding an intrusive
+ * linked list of node IDs. When there are at least as many buckets as the largest
+ * backoff window, every bucket only holds nodes of a single epoch, so finding the
+ * k ready nodes costs O(k) and an idle tick costs O(1). For very large windows the
+ * number of buckets is capped and a bucket may also hold nodes of later epochs,
+ * which are skipped over. A bitmap of the buckets that hold any node lets the group
+ * engine find the next epoch on which a node may be ready without visiting the
+ * empty buckets one by one.
 */
-int max_retransmission_attempt; 
+struct ReadyCalendar {
+    long long epoch;                      /**< The number of idle ticks elapsed. */
+    int bucket_mask;                      /**< The number of buckets minus one (a power of two). */
+    std::vector<int> bucket_heads;        /**< The first node ID of each bucket, or -1 if empty. */
+    std::vector<int> next_node_ids;       /**< The next node ID in the same bucket, or -1. */
+    std::vector<long long> ready_epochs;  /**< The epoch on which each node becomes ready. */
+    std::vector<unsigned long long> occupied_buckets; /**< One bit per bucket, set if it holds any node. */
+
+    /**
+     * @brief Empty the calendar and size it for the given simulation.
+     * 
+     * @param num_nodes The number of nodes in the simulation.
+     * @param max_backoff_window The largest value of R that a backoff is drawn from.
+     */
+    void reset(int num_nodes, int max_backoff_window);
+
+    /**
+     * @brief File a node under the epoch on which the given backoff reaches zero.
+     * 
+     * The node must not already be filed in the calendar.
+     * 
+     * @param node_id The ID of the node.
+     * @param backoff The backoff just assigned to the node.
+     */
+    void schedule(int node_id, int backoff);
+
+    /**
+     * @brief Remove the nodes that are ready to transmit on the current epoch.
+     * 
+     * @param ready_nodes Cleared, then filled with the removed node IDs in ascending order.
+     */
+    void take_ready(std::vector<int>& ready_nodes);
+
+    /**
+     * @brief Get the number of idle ticks until the next bucket that holds any node.
+     * 
+     * No node becomes ready before then, though a bucket of a capped calendar may only
+     * hold nodes of later epochs.
+     * 
+     * @return int The number of idle ticks, 0 if the bucket of the current epoch holds
+     * a node, or -1 if the calendar is empty.
+     */
+    int idle_ticks_until_next_bucket() const;
+
+    /**
+     * @brief Get the current backoff of a node filed in the calendar.
+     * 
+     * @param node_id The ID of the node.
+     * @return int The number of idle ticks until the node is ready to transmit.
+     */
+    int backoff(int node_id) const {
+        return static_cast<int>(ready_epochs[node_id] - epoch);
+    }
+};
 
 /**
- * @brief The total number of ticks that this simulation should run for.
+ * @brief Detector of repeating simulation states for the next-event engine.
  * 
- * This variable represents the total number of ticks that the simulation should
- * run for. The simulation starts at tick 0 and runs until the current tick is
- * equal to this value.
+ * The simulation is deterministic and its state is finite: the backoff and collision
+ * count of every node, plus the current tick modulo the least common multiple of the
+ * R values (the period of generate_backoff()). Every run therefore eventually becomes
+ * periodic. Once the state on an idle channel is seen again, the number of successful
+ * ticks per period is known, and all remaining full periods can be added arithmetically.
  * 
- * This value is parsed and read from the input file, denoted by T.
+ * The state is fingerprinted incrementally with the polynomial hash
+ * sum(g(id, collision_count) * x^backoff) modulo 2^61 - 1, so counting every backoff
+ * down by k only multiplies the hash by x^-k, and a new backoff only replaces the term
+ * of its node. Repeats are found with Brent's algorithm: the state is saved at
+ * exponentially growing intervals and every later state is compared against it, first
+ * by hash and then node by node, so a detected cycle is always exact.
 */
-int total_simulation_time; 
+struct CycleDetector {
+    bool enabled;                               /**< False once a cycle was used, or if none can be. */
+    long long backoff_period;                   /**< The least common multiple of the R values. */
+    unsigned long long hash;                    /**< The fingerprint of the current state. */
+    std::vector<unsigned long long> powers;     /**< x^k, for small k. */
+    std::vector<unsigned long long> inverse_powers; /**< x^-k, for small k. */
+    const NodeTable* nodes;                     /**< The nodes of the simulation being checked. */
+    std::vector<int> saved_backoffs;            /**< The node backoffs of the saved state. */
+    std::vector<unsigned char> saved_collision_counts; /**< The node collision counts of the saved state. */
+    std::map<int, int> saved_collision_count_overflows; /**< The large collision counts of the saved state. */
+    unsigned long long saved_hash;              /**< The fingerprint of the saved state. */
+    long long saved_ticks;                      /**< The tick of the saved state. */
+    long long saved_successful_ticks;           /**< The successful ticks before the saved state. */
+    long long steps_since_saved;                /**< The number of states checked since saving. */
+    long long steps_until_save;                 /**< The number of states after which to save again. */
+
+    /**
+     * @brief Fingerprint the current nodes and enable detection if a cycle can fit
+     * within the remaining simulation time.
+     * 
+     * @param nodes The nodes of the simulation to check.
+     * @param R The list of backoff windows of the simulation.
+     * @param ticks_left The number of ticks that remain to be simulated.
+     */
+    void reset(const NodeTable& nodes, const std::vector<int>& R, long long ticks_left);
+
+    /**
+     * @brief Add the term of a node to the fingerprint.
+     * 
+     * @param node_id The ID of the node whose backoff or collision count was just assigned.
+     */
+    void add(int node_id);
+
+    /**
+     * @brief Remove the term of a node from the fingerprint.
+     * 
+     * @param node_id The ID of the node whose backoff or collision count is about to change.
+     */
+    void remove(int node_id);
+
+    /**
+     * @brief Update the fingerprint after every backoff was counted down at once.
+     * 
+     * @param idle_ticks The number of idle ticks that were skipped.
+     */
+    void count_down(int idle_ticks);
+
+    /**
+     * @brief Check whether the state on the idle channel at the given tick was seen before.
+     * 
+     * @param ticks The current tick of the simulation.
+     * @param successful_ticks The number of successful ticks before the current tick.
+     * @param period Set to the length of the cycle in ticks if one is found.
+     * @param successful_ticks_per_period Set to the successful ticks of one cycle if one is found.
+     * @return bool True if the current state repeats an earlier one.
+     */
+    bool check(long long ticks, long long successful_ticks, long long& period, long long& successful_ticks_per_period);
+
+    /**
+     * @brief Save the state on the idle channel at the given tick, to be compared against
+     * the later states.
+     * 
+     * @param ticks The current tick of the simulation.
+     * @param successful_ticks The number of successful ticks before the current tick.
+     */
+    void save(long long ticks, long long successful_ticks);
+};
 
 /**
- * @brief The state of the transmission channel.
- * 
- * This variable represents the state of the transmission channel. If the channel
- * is occupied, this value is true. Otherwise, this value is false.
+ * @brief The parameters of a simulation, as read from the input file.
 */
-bool channel_occupied; 
+struct SimulationConfig {
+    int num_nodes;                  /**< 
+                                      * The number of nodes in the simulation.
+                                      * 
+                                      * This value is parsed and read from the input file,
+                                      * denoted by N.
+                                      */
+    int packet_length;              /**< 
+                                      * The length of the packet in number of ticks it takes
+                                      * to transmit. Each packet in the simulation takes this
+                                      * number of ticks to transmit.
+                                      * 
+                                      * This value is parsed and read from the input file,
+                                      * denoted by L.
+                                      */
+    std::vector<int> R;             /**< 
+                                      * A list of possible upper limits on a node's backoff
+                                      * value. By default, each node starts with the first
+                                      * value in this list, and at collision count i, the
+                                      * node's R value is updated to R[i]. The last value is
+                                      * reused if the list is shorter than the collision count.
+                                      * 
+                                      * This list is parsed and read from the input file,
+                                      * denoted by R.
+                                      */
+    int max_retransmission_attempt; /**< 
+                                      * The maximum number of retransmission attempts that
+                                      * a node makes to transmit a packet. If the node reaches
+                                      * this number of attempts without successfully
+                                      * transmitting the packet, the packet is dropped and the
+                                      * node moves on to the next packet.
+                                      * 
+                                      * This value is parsed and read from the input file,
+                                      * denoted by M.
+                                      */
+    long long total_simulation_time; /**< 
+                                      * The total number of ticks that this simulation should
+                                      * run for. The simulation starts at tick 0 and runs until
+                                      * the current tick is equal to this value.
+                                      * 
+                                      * This value is parsed and read from the input file,
+                                      * denoted by T.
+                                      */
+
+    /**
+     * @brief Construct an empty configuration without nodes.
+     */
+    SimulationConfig();
+};
 
 /**
- * @brief The number of simulation ticks during which a packet is transmitted without
- * collision.
+ * @brief How a simulation is run, as opposed to what is simulated.
  * 
- * This variable represents the number of simulation ticks during which a packet is
- * transmitted without collision. This value is incremented for each tick, if that
- * current tick is a successful transmission.
+ * None of these options change the results of the simulation.
 */
-int num_successful_transmission_ticks;
+struct SimulationOptions {
+    Engine engine;                  /**< The algorithm used to advance the simulation clock. */
+    LogLevel log_level;             /**< The verbosity of the text written to the log stream. */
+    bool detect_cycles;             /**< 
+                                      * Whether to skip every full repetition of the
+                                      * simulation state, which uses the next-event engine.
+                                      */
+    std::ostream* log_stream;       /**< The stream the log is written to, standard output by default. */
+    BackoffPolicy backoff_policy;   /**< The backoff policy selected by run_simulation() and run_sweep(). */
+    WindowPolicy window_policy;     /**< The window policy selected by run_simulation() and run_sweep(). */
+    unsigned long long seed;        /**< The seed of the random backoff policies. */
+    double persistence;             /**< The transmit probability p of PPersistentBackoff, in (0, 1]. */
+    TraceWriter* trace_writer;      /**< If not null, the binary trace the events are recorded in (not owned). */
+    NodeStatistics* node_statistics; /**< If not null, the per-node statistics updated on every event (not owned). */
+    SimulationProfile* profile;     /**< 
+                                      * If not null, the profile the loops are counted and timed
+                                      * in, only when built with CSMA_PROFILE (not owned).
+                                      */
+    CheckpointWriter* checkpoint_writer; /**< 
+                                           * If not null, a snapshot is saved to it on every
+                                           * multiple of its interval (not owned).
+                                           */
+    SimulationSnapshot* resume_snapshot; /**< 
+                                           * If not null, run_simulation() continues from this
+                                           * snapshot instead of tick 0, and consumes it (not owned).
+                                           */
+    UtilizationReport* report;      /**< If not null, the report the windowed utilization is streamed to (not owned). */
+    ResultCache* result_cache;      /**< 
+                                      * If not null, the cache run_simulation() and run_sweep()
+                                      * take and store final states in, without any of the
+                                      * observers above, which would miss the cached ticks (not owned).
+                                      */
+    AsyncLog* async_log;            /**< 
+                                      * If not null, the log is formatted and written to the log
+                                      * stream by the thread of this log instead (not owned).
+                                      */
+
+    /**
+     * @brief Construct the default options: the small engine and the original policies,
+     * without any output.
+     */
+    SimulationOptions();
+};
 
 /**
- * @brief The ID of the node currently transmitting the packet.
+ * @brief The outcome of a simulation up to its current tick.
 */
-int active_node_id;
+struct SimulationResults {
+    long long total_simulation_time;            /**< The number of ticks simulated. */
+    long long num_successful_transmission_ticks; /**< 
+                                                  * The number of simulation ticks during which
+                                                  * a packet is transmitted without collision.
+                                                  */
+
+    /**
+     * @brief Get the link utilization rate, i.e. the fraction of successful ticks.
+     * 
+     * @return double The number of successful ticks divided by the number of ticks.
+     */
+    double utilization() const {
+        return static_cast<double>(num_successful_transmission_ticks) / total_simulation_time;
+    }
+};
 
 /**
- * @brief Generate a backoff value for a node, which is the pseudorandom number generator following
- * backoff = mod(node_id + ticks, R)
+ * @brief A simulation of the CSMA protocol on a single channel.
+ * 
+ * The simulation owns its configuration and its state. It starts at tick 0, and
+ * run() advances it to a later tick with the engine selected in its options, so
+ * a run can be continued by calling run() again with a larger total simulation
+ * time. reset() brings the simulation back to tick 0, reusing the memory of its
+ * node table and engine structures, so one Simulation can run many configurations
+ * one after the other without allocating.
  * 
- * @param node_id The ID of the node to which the backoff value is assigned.
- * @param ticks The number of ticks that have elapsed in the simulation.
- * @param R The R value of the node, which is the upper limit of the backoff value since the
- * backoff is in the range of [0, R).
- * @return int The backoff value of the node.
+ * The backoff and window policies (see policies.h) are template parameters, so
+ * they are inlined into every engine. The members are instantiated in
+ * simulation.cpp for the policies listed there; Simulation uses the original ones.
+ * 
+ * @tparam Backoff The backoff policy, which draws a backoff from the window.
+ * @tparam Window The window policy, which chooses the window after a collision.
+*/
+template <typename Backoff = DeterministicBackoff, typename Window = TableWindow>
+class BasicSimulation {
+public:
+    /**
+     * @brief Construct a simulation without nodes.
+     */
+    BasicSimulation();
+
+    /**
+     * @brief Construct a simulation of the given configuration at tick 0.
+     * 
+     * @param config The parameters of the simulation, which must be valid.
+     * @param options How the simulation is run.
+     */
+    explicit BasicSimulation(const SimulationConfig& config, const SimulationOptions& options = SimulationOptions());
+
+    /**
+     * @brief Bring the simulation back to tick 0.
+     */
+    void reset();
+
+    /**
+     * @brief Switch the simulation to another configuration, at tick 0.
+     * 
+     * @param config The parameters of the simulation, which must be valid.
+     */
+    void reset(const SimulationConfig& config);
+
+    /**
+     * @brief Run the simulation until the total simulation time of its configuration.
+     * 
+     * @return SimulationResults The results of the simulation.
+     */
+    SimulationResults run();
+
+    /**
+     * @brief Run the simulation until the given tick.
+     * 
+     * @param total_simulation_time The tick at which the simulation stops. Nothing is
+     * simulated if the simulation is already at or past this tick.
+     * @return SimulationResults The results of the simulation.
+     */
+    SimulationResults run(long long total_simulation_time);
+
+    /**
+     * @brief Get the results of the simulation up to its current tick.
+     * 
+     * @return SimulationResults The results of the simulation.
+     */
+    SimulationResults results() const;
+
+    /**
+     * @brief Copy the state of the simulation into a snapshot.
+     * 
+     * @param snapshot Set to the state of the simulation, reusing its memory.
+     */
+    void save(SimulationSnapshot& snapshot) const;
+
+    /**
+     * @brief Continue the simulation from a snapshot of the same configuration.
+     * 
+     * @param snapshot The snapshot, which must have one entry per node. Its node
+     * state is moved into the simulation.
+     */
+    void restore(SimulationSnapshot& snapshot);
+
+    /**
+     * @brief Get the parameters of the simulation.
+     * 
+     * @return const SimulationConfig& The parameters of the simulation.
+     */
+    const SimulationConfig& config() const {
+        return config_;
+    }
+
+    /**
+     * @brief Get the options of the simulation, which may be changed between runs.
+     * 
+     * @return SimulationOptions& The options of the simulation.
+     */
+    SimulationOptions& options() {
+        return options_;
+    }
+
+    /**
+     * @brief Get the state of the nodes of the simulation.
+     * 
+     * @return const NodeTable& The state of the nodes.
+     */
+    const NodeTable& nodes() const {
+        return nodes_;
+    }
+
+    /**
+     * @brief Get the state of the transmission channel.
+     * 
+     * @return bool True if a node is transmitting a packet, false otherwise.
+     */
+    bool channel_occupied() const {
+        return channel_occupied_;
+    }
+
+    /**
+     * @brief Get the ID of the node currently transmitting a packet.
+     * 
+     * @return int The ID of the node, only meaningful while the channel is occupied.
+     */
+    int active_node_id() const {
+        return active_node_id_;
+    }
+
+    /**
+     * @brief Get the current tick of the simulation.
+     * 
+     * @return long long The number of ticks simulated so far.
+     */
+    long long current_tick() const {
+        return current_tick_;
+    }
+
+private:
+    /**
+     * @brief Initialize the nodes in the simulation and their properties.
+     */
+    void initialize_nodes();
+
+    /**
+     * @brief Get the upper limit of the backoff of a node after a number of collisions.
+     * 
+     * @param collision_count The number of collisions the node experienced.
+     * @return int The R value of the node.
+     */
+    int backoff_window(int collision_count) const {
+        return window_policy_(config_.R, collision_count);
+    }
+
+    /**
+     * @brief Draw the backoff of a node from its window after a number of collisions.
+     * 
+     * @param node_id The ID of the node.
+     * @param ticks The tick on which the backoff starts counting down.
+     * @param collision_count The number of collisions the node experienced.
+     * @return int The new backoff of the node.
+     */
+    int draw_backoff(int node_id, long long ticks, int collision_count) const {
+        return backoff_policy_(node_id, ticks, backoff_window(collision_count));
+    }
+
+    /**
+     * @brief Set the transmission channel to occupied or unoccupied.
+     * 
+     * This function is called by a node that is about to start transmitting a packet in order to block
+     * the channel from other nodes. It is also called by a node that has finished transmitting its
+     * packet in order to unblock the channel.
+     * 
+     * @param is_occupied A boolean value indicating whether to set the channel to occupied or not.
+     */
+    void set_channel_occupied(bool is_occupied);
+
+    /**
+     * @brief Get the nodes that are ready to transmit a packet (i.e. have a backoff of 0).
+     * 
+     * @param ready_nodes Cleared, then filled with the IDs of the ready nodes in ascending order.
+     */
+    void get_ready_node_ids(std::vector<int>& ready_nodes) const;
+
+    /**
+     * @brief Occupy the channel with a node that is ready to transmit a new packet.
+     * 
+     * @tparam level The log level of the simulation.
+     * @param node_id The ID of the node starting the transmission.
+     * @param ticks The current tick of the simulation.
+     */
+    template <LogLevel level>
+    void start_transmission(int node_id, long long ticks);
+
+    /**
+     * @brief Release the channel after the last tick of a transmission and assign the
+     * transmitting node a new backoff for its next packet.
+     * 
+     * @tparam level The log level of the simulation.
+     * @param ticks The tick on which the last part of the packet was transmitted.
+     */
+    template <LogLevel level>
+    void finish_transmission(long long ticks);
+
+    /**
+     * @brief Transmit a packet from the active node.
+     * 
+     * The log level is a template parameter so that the output statements of the
+     * levels that are not selected are removed from the compiled code entirely.
+     * 
+     * @tparam level The log level of the simulation.
+     * @param ticks The current tick of the simulation.
+     */
+    template <LogLevel level>
+    void transmit_packet(long long ticks);
+
+    /**
+     * @brief Log the start of a collision, and report it.
+     * 
+     * @tparam level The log level of the simulation.
+     * @param ticks The current tick of the simulation.
+     */
+    template <LogLevel level>
+    void begin_collision(long long ticks);
+
+    /**
+     * @brief Back off one node that took part in a collision, dropping its packet if it
+     * exceeded the maximum number of retransmission attempts.
+     * 
+     * @tparam level The log level of the simulation.
+     * @param node_id The ID of the colliding node.
+     * @param ticks The current tick of the simulation.
+     */
+    template <LogLevel level>
+    void back_off_node(int node_id, long long ticks);
+
+    /**
+     * @brief Back off every node that took part in a collision, dropping the packets
+     * of the nodes that exceeded the maximum number of retransmission attempts.
+     * 
+     * @tparam level The log level of the simulation.
+     * @param ready_nodes The IDs of the colliding nodes, in ascending order.
+     * @param ticks The current tick of the simulation.
+     */
+    template <LogLevel level>
+    void handle_collision(const std::vector<int>& ready_nodes, long long ticks);
+
+    /**
+     * @brief Run the simulation with the engine selected in the options.
+     * 
+     * @tparam level The log level of the simulation.
+     * @param total_simulation_time The tick at which the simulation stops.
+     */
+    template <LogLevel level>
+    void run_engine(long long total_simulation_time);
+
+    /**
+     * @brief Run the simulation loop until the given tick.
+     * 
+     * The ready nodes are looked up in a ReadyCalendar instead of scanning every node,
+     * and an idle tick only advances the calendar's epoch. The node backoffs are written
+     * back when the loop ends.
+     * 
+     * @tparam level The log level of the simulation.
+     * @param total_simulation_time The tick at which the simulation stops.
+     */
+    template <LogLevel level>
+    void run_tick_loop(long long total_simulation_time);
+
+    /**
+     * @brief Run the original simulation loop until the given tick, scanning every
+     * node on every idle tick.
+     * 
+     * @tparam level The log level of the simulation.
+     * @param total_simulation_time The tick at which the simulation stops.
+     */
+    template <LogLevel level>
+    void run_reference_loop(long long total_simulation_time);
+
+    /**
+     * @brief Run the simulation loop until the given tick, using the vectorized kernels
+     * of node_kernels.h to find the ready nodes and to count down the backoffs on idle
+     * ticks.
+     * 
+     * @tparam level The log level of the simulation.
+     * @param total_simulation_time The tick at which the simulation stops.
+     */
+    template <LogLevel level>
+    void run_simd_loop(long long total_simulation_time);
+
+    /**
+     * @brief Run the simulation until the given tick, jumping from one event to the next
+     * instead of simulating every tick.
+     * 
+     * On an idle channel, every backoff is counted down by the smallest backoff at once.
+     * On an occupied channel, the rest of the transmission is skipped in a single step.
+     * The result is identical to the one of run_tick_loop().
+     * 
+     * @tparam level The log level of the simulation.
+     * @param total_simulation_time The tick at which the simulation stops.
+     * @param cycle_detector If not null, used to skip over every full repetition of
+     * the simulation state once it becomes periodic.
+     */
+    template <LogLevel level>
+    void run_next_event_loop(long long total_simulation_time, CycleDetector* cycle_detector);
+
+    /**
+     * @brief Run the simulation until the given tick, jumping from one group of ready
+     * nodes to the next.
+     * 
+     * The nodes are filed in the ReadyCalendar like in run_tick_loop(), but idle stretches
+     * and transmissions are skipped in a single step like in run_next_event_loop(), so
+     * neither visits the nodes that are not part of the next event. The result is
+     * identical to the one of run_tick_loop().
+     * 
+     * @tparam level The log level of the simulation.
+     * @param total_simulation_time The tick at which the simulation stops.
+     */
+    template <LogLevel level>
+    void run_group_loop(long long total_simulation_time);
+
+    /**
+     * @brief Run the simulation until the given tick for at most MaxNodes nodes.
+     * 
+     * The backoffs are copied into a std::array of MaxNodes entries, so the smallest
+     * backoff and the bitmask of the nodes that have it are found in one unrolled pass,
+     * and the idle, single-ready and collision cases are told apart from the bitmask.
+     * Idle stretches and transmissions are skipped in a single step, except with the
+     * full trace, where every tick is printed. The result is identical to the one of
+     * run_tick_loop().
+     * 
+     * @tparam level The log level of the simulation.
+     * @tparam MaxNodes The size of the arrays, at least the number of nodes and at most 64.
+     * @param total_simulation_time The tick at which the simulation stops.
+     */
+    template <LogLevel level, int MaxNodes>
+    void run_small_loop(long long total_simulation_time);
+
+    SimulationConfig config_;                   /**< The parameters of the simulation. */
+    SimulationOptions options_;                 /**< How the simulation is run. */
+    NodeTable nodes_;                           /**< The state of all the nodes. */
+    bool channel_occupied_;                     /**< Whether a node is transmitting a packet. */
+    int active_node_id_;                        /**< The ID of the node transmitting the packet. */
+    int packet_ticks_remaining_;                /**< The number of ticks left of the packet being transmitted. */
+    long long current_tick_;                    /**< The number of ticks simulated so far. */
+    long long num_successful_transmission_ticks_; /**< The successful ticks so far. */
+    ReadyCalendar calendar_;                    /**< The ready index of the tick engine. */
+    CycleDetector cycle_detector_;              /**< The cycle detector of the next-event engine. */
+    std::vector<int> ready_nodes_;              /**< Scratch list of the nodes ready on a tick. */
+    Backoff backoff_policy_;                    /**< The backoff policy, built from the options on reset. */
+    Window window_policy_;                      /**< The window policy. */
+};
+
+/** @brief The simulation with the original backoff and window policies. */
+typedef BasicSimulation<> Simulation;
+
+/* The policy combinations instantiated in simulation.cpp */
+extern template class BasicSimulation<DeterministicBackoff, TableWindow>;
+extern template class BasicSimulation<DeterministicBackoff, BinaryExponentialWindow>;
+extern template class BasicSimulation<UniformBackoff, TableWindow>;
+extern template class BasicSimulation<UniformBackoff, BinaryExponentialWindow>;
+extern template class BasicSimulation<PPersistentBackoff, TableWindow>;
+extern template class BasicSimulation<PPersistentBackoff, BinaryExponentialWindow>;
+
+/**
+ * @brief Run a simulation with the backoff and window policies selected in the options.
+ * 
+ * @param config The parameters of the simulation, which must be valid.
+ * @param options How the simulation is run.
+ * @return SimulationResults The results of the simulation.
  */
-int generate_backoff(int node_id, int ticks, int R);
+SimulationResults run_simulation(const SimulationConfig& config, const SimulationOptions& options);
 
 /**
- * @brief Set the transmission channel to occupied or unoccupied.
+ * @brief Format a ratio of two tick counts as a decimal number, rounded half up.
  * 
- * This function is called by a node that is about to start transmitting a packet in order to block
- * the channel from other nodes. It is also called by a node that has finished transmitting its
- * packet in order to unblock the channel.
+ * The ratio is computed with integer arithmetic, so it is exact for any 64-bit counts,
+ * where converting the counts to double would lose precision above 2^53 ticks.
  * 
- * @param is_occupied A boolean value indicating whether to set the channel to occupied or not.
+ * @param numerator The number of ticks counted, at least 0.
+ * @param denominator The total number of ticks. A ratio over 0 ticks is formatted as 0.
+ * @param decimals The number of digits after the decimal point, at most 18.
+ * @return std::string The formatted ratio, e.g. "0.40".
  */
-void set_channel_occupied(bool is_occupied);
+std::string format_ratio(long long numerator, long long denominator, int decimals);
 
 /**
- * @brief Get the nodes that are ready to transmit a packet (i.e. have a backoff of 0).
+ * @brief Check that a configuration describes a simulation that can be run.
  * 
- * @return std::vector<int> A list of node IDs that are ready to transmit.
+ * @param config The parameters of the simulation.
+ * @param error Set to a description of the first problem found, if any.
+ * @return bool True if the configuration is valid, false otherwise.
  */
-std::vector<int> get_ready_node_ids();
+bool validate_config(const SimulationConfig& config, std::string& error);
 
 /**
- * @brief Read the input file and assign the values to the variables.
+ * @brief Parse the name of a log level given on the command line.
  * 
- * @param input_file Input file stream.
+ * @param name One of "off", "summary", "events" or "full-trace".
+ * @param level Set to the parsed level on success.
+ * @return bool True if the name is a known log level, false otherwise.
  */
-void assign_values(std::ifstream& input_file);
+bool parse_log_level(const std::string& name, LogLevel& level);
 
 /**
- * @brief Initialize the nodes in the simulation and their properties.
+ * @brief Parse the name of a simulation engine given on the command line.
+ * 
+ * @param name One of "small", "tick", "reference", "event", "simd", "group" or "batch".
+ * @param engine Set to the parsed engine on success.
+ * @return bool True if the name is a known engine, false otherwise.
  */
-void initialize_nodes();
+bool parse_engine(const std::string& name, Engine& engine);
 
 /**
- * @brief Transmit a packet from the active node.
+ * @brief Parse the name of a backoff policy given on the command line.
  * 
- * @param active_node_id The ID of the node transmitting the packet.
- * @param ticks The current tick of the simulation.
+ * @param name One of "deterministic", "uniform" or "p-persistent".
+ * @param policy Set to the parsed policy on success.
+ * @return bool True if the name is a known backoff policy, false otherwise.
  */
-void transmit_packet(int active_node_id, int ticks);
+bool parse_backoff_policy(const std::string& name, BackoffPolicy& policy);
 
+/**
+ * @brief Parse the name of a window policy given on the command line.
+ * 
+ * @param name One of "table" or "beb".
+ * @param policy Set to the parsed policy on success.
+ * @return bool True if the name is a known window policy, false otherwise.
+ */
+bool parse_window_policy(const std::string& name, WindowPolicy& policy);
 
-#endif // CSMA_H
\ No newline at end of file
+#endif // CSMA_H
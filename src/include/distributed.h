@@ -0,0 +1,100 @@
+/**
+ * @file distributed.h
+ * @brief Sweeps shared out over TCP between worker processes on other machines, for
+ * --coordinator and --worker.
+ *
+ * The coordinator reads and expands the sweep grid file, cuts its points into
+ * shards of consecutive points, and listens on a TCP port. Any number of workers
+ * connect to it, at any time, and pull shards one at a time: a worker runs the
+ * points of a shard with run_sweep() on all of its threads, and sends back their
+ * successful ticks. Once every shard is done, the coordinator writes the results
+ * table of the whole sweep, exactly as a sweep on a single machine would.
+ *
+ * A worker gets the grid file and the engine and policy options from the
+ * coordinator, and parses the grid file itself, so every worker runs exactly the
+ * points and the policies of the coordinator. The protocol is a line of text per
+ * message:
+ *
+ *     csma-sweep 1 <points> <engine> <backoff> <window> <cycles> <seed> <persistence> <bytes>
+ *     <bytes of the grid file>              coordinator, once a worker connects
+ *     next                                  worker, asking for a shard
+ *     shard <id> <first point> <points>     coordinator, or "done" once every shard is done
+ *     result <id> <successful ticks>...     worker, one value per point of the shard
+ *     error <description>                   worker, when it cannot run the sweep
+ *
+ * A shard whose worker disconnects, or crashes, before it sends the results is
+ * handed out again to the next worker that asks. With a shard timeout, a shard
+ * also goes to another worker once it has been out for that long, in case its
+ * worker hangs, and the first results sent for it are kept.
+ *
+ * @author Vicky Chen (chen-vv)
+ * @author Eric Omielan (eomielan)
+ * @bug No known bugs.
+ */
+
+#ifndef DISTRIBUTED_H
+#define DISTRIBUTED_H
+
+#include <string>
+#include <vector>
+
+#include "csma.h"
+
+/** @brief The number of points of a shard, unless --shard-points is given. */
+#define DISTRIBUTED_DEFAULT_SHARD_POINTS 256
+
+/** @brief The number of seconds a worker keeps trying to connect to its coordinator. */
+#define DISTRIBUTED_CONNECT_SECONDS 30
+
+/** @brief The first line of the message a coordinator greets a worker with, followed by the protocol version. */
+#define DISTRIBUTED_PROTOCOL "csma-sweep 1"
+
+/**
+ * @brief How a coordinator shares out a sweep.
+*/
+struct CoordinatorOptions {
+    int port;                   /**< The TCP port to listen on, or 0 for any free port. */
+    long long shard_points;     /**< The number of points of every shard but the last. */
+    double shard_timeout;       /**< The seconds after which a shard goes to another worker as well, or 0 for never. */
+};
+
+/**
+ * @brief What a coordinator did to run a sweep.
+*/
+struct CoordinatorSummary {
+    long long num_shards;       /**< The number of shards of the sweep. */
+    long long num_workers;      /**< The number of workers that sent the results of at least one shard. */
+    long long num_reassigned;   /**< The number of times a shard went to another worker. */
+};
+
+/**
+ * @brief Share out the points of a sweep to the workers that connect, until every point is done.
+ *
+ * The port is printed once the coordinator listens, at the summary level, and the
+ * workers that come and go at the events level.
+ *
+ * @param grid_contents The contents of the sweep grid file, which every worker parses.
+ * @param configs The configurations of the points of the grid file, which must all be valid.
+ * @param options The engine and policy options used for every point, and the log level.
+ * @param coordinator The port and the shards.
+ * @param results Set to the results of each configuration, in the same order.
+ * @param summary Set to the shards, the workers and the reassigned shards.
+ * @param error Set to a description of the problem if the coordinator cannot listen.
+ * @return bool True if every point was run, false otherwise.
+ */
+bool run_coordinator(const std::string& grid_contents, const std::vector<SimulationConfig>& configs,
+                     const SimulationOptions& options, const CoordinatorOptions& coordinator,
+                     std::vector<SimulationResults>& results, CoordinatorSummary& summary, std::string& error);
+
+/**
+ * @brief Run the shards of a coordinator until it has none left.
+ *
+ * @param address The host and the port of the coordinator, as <host>:<port>.
+ * @param num_threads The number of worker threads, or 0 for one per hardware thread.
+ * @param num_shards Set to the number of shards this worker ran.
+ * @param error Set to a description of the problem if the worker stopped before the coordinator was done.
+ * @return bool True once the coordinator is done, false otherwise.
+ */
+bool run_worker(const std::string& address, int num_threads, long long& num_shards, std::string& error);
+
+#endif // DISTRIBUTED_H
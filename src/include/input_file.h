@@ -0,0 +1,147 @@
+/**
+ * @file input_file.h
+ * @brief Reading and parsing of simulation input files.
+ *
+ * An input file is read into memory in a single read, and parsed in place:
+ * the lines and their whitespace-separated tokens are pointers into the
+ * file contents, and integers are parsed straight from them, so parsing
+ * does not allocate except for the configurations it produces.
+ *
+ * A file may hold several scenarios, separated by blank lines or by
+ * header lines of the form [name]:
+ *
+ *     [short packets]
+ *     N 4
+ *     L 2
+ *     M 6
+ *     R 4 8 16 32 64 128
+ *     T 10000
+ *
+ *     [long packets]
+ *     ...
+ *
+ * @author Vicky Chen (chen-vv)
+ * @author Eric Omielan (eomielan)
+ * @bug No known bugs.
+ */
+
+#ifndef INPUT_FILE_H
+#define INPUT_FILE_H
+
+#include <string>
+#include <vector>
+
+#include "csma.h"
+
+struct TrafficConfig;
+
+/**
+ * @brief A whitespace-separated token of an input line, pointing into the file contents.
+*/
+struct InputToken {
+    const char* begin;  /**< The first character of the token. */
+    const char* end;    /**< One past the last character of the token. */
+
+    /**
+     * @brief Copy the token, for error messages.
+     *
+     * @return std::string The characters of the token.
+     */
+    std::string str() const {
+        return std::string(begin, end);
+    }
+};
+
+/**
+ * @brief Walks the lines of an input file in memory, and the tokens of each line.
+*/
+class InputScanner {
+public:
+    /**
+     * @brief Construct a scanner before the first line of the contents.
+     *
+     * @param contents The contents of the input file, which must outlive the scanner.
+     */
+    explicit InputScanner(const std::string& contents);
+
+    /**
+     * @brief Move to the next line.
+     *
+     * @return bool True if there was another line, false at the end of the contents.
+     */
+    bool next_line();
+
+    /**
+     * @brief Get the next token of the current line.
+     *
+     * @param token Set to the token.
+     * @return bool True if the line had another token, false otherwise.
+     */
+    bool next_token(InputToken& token);
+
+    /**
+     * @brief Get the number of the current line.
+     *
+     * @return int The number of the current line, starting from 1.
+     */
+    int line_number() const {
+        return line_number_;
+    }
+
+private:
+    const char* position_;      /**< The next character of the current line. */
+    const char* line_end_;      /**< The end of the current line, before its newline. */
+    const char* end_;           /**< The end of the contents. */
+    int line_number_;           /**< The number of the current line. */
+};
+
+/**
+ * @brief Parse a decimal integer, with an optional minus sign, at the start of a range of characters.
+ *
+ * @param position The first character, advanced past the integer on success.
+ * @param end One past the last character that may be parsed.
+ * @param value Set to the integer.
+ * @return bool True if an integer that fits in a long long was parsed, false otherwise.
+ */
+bool parse_integer(const char*& position, const char* end, long long& value);
+
+/**
+ * @brief Check whether a token is a scenario header of the form [name], possibly
+ * followed by more tokens of the name.
+ *
+ * @param scanner The scanner, whose remaining tokens on the line are consumed.
+ * @param token The first token of the line.
+ * @param name Set to the name between the brackets if the line is a header.
+ * @param error Set to a description of the problem if the header is not closed.
+ * @return int 1 if the line is a header, 0 if it is not, -1 if it is a malformed header.
+ */
+int scan_header(InputScanner& scanner, const InputToken& token, InputToken& name, std::string& error);
+
+/**
+ * @brief Read a whole input file into memory.
+ *
+ * @param filename The name of the file.
+ * @param contents Set to the contents of the file.
+ * @return bool True if the file was read, false if it could not be opened or read.
+ */
+bool read_input_file(const std::string& filename, std::string& contents);
+
+/**
+ * @brief Parse the scenarios of an input file.
+ *
+ * Each scenario starts from the default SimulationConfig, and every R line of a
+ * scenario adds to its R values. Every scenario is checked with validate_config().
+ *
+ * @param contents The contents of the input file.
+ * @param configs Set to the configuration of each scenario, in the order of the file.
+ * @param error Set to a description of the problem, with its line number, if the file is malformed.
+ * @param names If not null, set to the header name of each scenario, or an empty
+ * name for a scenario without a header.
+ * @param traffic If not null, set to the traffic of each scenario (see traffic.h). If null,
+ * a file that has traffic lines is malformed.
+ * @return bool True if the file held at least one scenario and all of them are valid, false otherwise.
+ */
+bool parse_scenarios(const std::string& contents, std::vector<SimulationConfig>& configs, std::string& error,
+                     std::vector<std::string>* names = nullptr, std::vector<TrafficConfig>* traffic = nullptr);
+
+#endif // INPUT_FILE_H
@@ -0,0 +1,48 @@
+/** 
+ * @file node_kernels.h
+ * @brief Function prototypes for the vectorized kernels over node backoffs.
+ *
+ * This contains the kernels that the SIMD engine runs over the contiguous
+ * array of node backoffs on every idle tick. Each kernel is implemented
+ * with AVX2 and SSE2 instructions where the processor supports them, and
+ * falls back to a plain loop otherwise. The instruction set is picked once,
+ * at the first call.
+ *
+ * @author Vicky Chen (chen-vv)
+ * @author Eric Omielan (eomielan)
+ * @bug No known bugs.
+ */
+
+#ifndef NODE_KERNELS_H
+#define NODE_KERNELS_H
+
+/**
+ * @brief Count the nodes that are ready to transmit (i.e. have a backoff of 0).
+ * 
+ * The backoffs are compared against zero a whole vector at a time, and the
+ * comparison mask is turned into a count with a popcount, so a single pass
+ * tells apart the idle, single-ready and collision cases.
+ * 
+ * @param backoffs The backoff of every node.
+ * @param num_nodes The number of nodes.
+ * @param first_ready_node_id Set to the lowest ID of a ready node, if there is one.
+ * @return int The number of ready nodes.
+ */
+int count_ready_nodes(const int* backoffs, int num_nodes, int* first_ready_node_id);
+
+/**
+ * @brief Count the backoff of every node down by one.
+ * 
+ * @param backoffs The backoff of every node.
+ * @param num_nodes The number of nodes.
+ */
+void count_down_backoffs(int* backoffs, int num_nodes);
+
+/**
+ * @brief Get the name of the instruction set the kernels run with.
+ * 
+ * @return const char* One of "avx2", "sse2" or "scalar".
+ */
+const char* node_kernels_instruction_set();
+
+#endif // NODE_KERNELS_H
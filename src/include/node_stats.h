@@ -0,0 +1,156 @@
+/** 
+ * @file node_stats.h
+ * @brief Per-node statistics of a simulation, updated on events only.
+ *
+ * For every node, the simulation counts the packets it sent, the collisions
+ * it took part in and the packets it dropped, and keeps a histogram of the
+ * head-of-line access delay: the number of ticks from the moment a packet
+ * reaches the head of the node's queue (after the previous packet was sent or
+ * dropped) until the tick its successful transmission starts.
+ *
+ * @author Vicky Chen (chen-vv)
+ * @author Eric Omielan (eomielan)
+ * @bug No known bugs.
+ */
+
+#ifndef NODE_STATS_H
+#define NODE_STATS_H
+
+#include <climits>
+#include <iosfwd>
+#include <vector>
+
+/**
+ * @brief The number of bins of the access delay histograms.
+ * 
+ * Bin 0 counts a delay of 0 ticks, and bin k > 0 counts the delays in [2^(k-1), 2^k),
+ * except the last bin, which counts every delay from 2^(NODE_STATS_DELAY_BINS - 2) on.
+*/
+#define NODE_STATS_DELAY_BINS 32
+
+/**
+ * @brief The statistics of one node.
+ * 
+ * Everything a node updates on an event is in this one structure, so an event only
+ * touches the cache lines of the node it happens to.
+*/
+struct NodeStats {
+    long long transmissions;        /**< The number of packets sent without collision. */
+    long long collisions;           /**< The number of collisions the node took part in. */
+    long long drops;                /**< The number of packets dropped after too many collisions. */
+    long long total_delay;          /**< The sum of the access delays of the sent packets. */
+    long long head_of_line_tick;    /**< The tick on which the current packet reached the head of the queue. */
+    unsigned int delay_bins[NODE_STATS_DELAY_BINS]; /**< The access delay histogram, saturating at UINT_MAX. */
+};
+
+/**
+ * @brief The statistics of every node of a simulation, passed to it in its options.
+*/
+class NodeStatistics {
+public:
+    /**
+     * @brief Clear the statistics and size them for a simulation.
+     * 
+     * @param num_nodes The number of nodes of the simulation.
+     */
+    void reset(int num_nodes);
+
+    /**
+     * @brief Record that a node sent a packet.
+     * 
+     * The delay is only recorded once the packet is sent, so every delay in the
+     * histogram belongs to a packet counted in transmissions.
+     * 
+     * @param node_id The ID of the node.
+     * @param start_ticks The tick the transmission started on.
+     * @param end_ticks The tick the last part of the packet was sent on.
+     */
+    void end(int node_id, long long start_ticks, long long end_ticks) {
+        NodeStats& node = nodes_[node_id];
+        long long delay = start_ticks - node.head_of_line_tick;
+
+        node.transmissions++;
+        node.total_delay += delay;
+        node.head_of_line_tick = end_ticks + 1;
+
+        unsigned int& bin = node.delay_bins[delay_bin(delay)];
+        if (bin != UINT_MAX) {
+            bin++;
+        }
+    }
+
+    /**
+     * @brief Record that a node took part in a collision.
+     * 
+     * @param node_id The ID of the node.
+     */
+    void collision(int node_id) {
+        nodes_[node_id].collisions++;
+    }
+
+    /**
+     * @brief Record that a node dropped its packet after a collision.
+     * 
+     * @param node_id The ID of the node.
+     * @param ticks The tick of the collision.
+     */
+    void drop(int node_id, long long ticks) {
+        NodeStats& node = nodes_[node_id];
+        node.drops++;
+        node.head_of_line_tick = ticks + 1;
+    }
+
+    /**
+     * @brief Save the current statistics, to be used by skip_cycle().
+     */
+    void save() {
+        saved_nodes_ = nodes_;
+    }
+
+    /**
+     * @brief Add the statistics of repetitions of the cycle that started at the last save().
+     * 
+     * The simulation state at the save and now is identical, so every repetition adds
+     * the difference between the current and the saved statistics. This is only exact
+     * if the simulation was already periodic the whole period before the save, so that
+     * the head-of-line ticks at the save also repeat.
+     * 
+     * @param repetitions The number of repetitions that are skipped.
+     * @param skipped_ticks The number of ticks that are skipped.
+     */
+    void skip_cycle(long long repetitions, long long skipped_ticks);
+
+    /**
+     * @brief Get the statistics of the nodes.
+     * 
+     * @return const std::vector<NodeStats>& The statistics of each node.
+     */
+    const std::vector<NodeStats>& nodes() const {
+        return nodes_;
+    }
+
+    /**
+     * @brief Get the histogram bin of an access delay.
+     * 
+     * @param delay The access delay in ticks, at least 0.
+     * @return int The index of the bin.
+     */
+    static int delay_bin(long long delay) {
+        int bin = delay == 0 ? 0 : 64 - __builtin_clzll(static_cast<unsigned long long>(delay));
+        return bin < NODE_STATS_DELAY_BINS ? bin : NODE_STATS_DELAY_BINS - 1;
+    }
+
+private:
+    std::vector<NodeStats> nodes_;          /**< The statistics of each node. */
+    std::vector<NodeStats> saved_nodes_;    /**< The statistics at the last save(). */
+};
+
+/**
+ * @brief Write the statistics of every node as a CSV table, one row per node.
+ * 
+ * @param output The stream to write the table to.
+ * @param statistics The statistics to write.
+ */
+void write_node_statistics(std::ostream& output, const NodeStatistics& statistics);
+
+#endif // NODE_STATS_H
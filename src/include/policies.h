@@ -0,0 +1,167 @@
+/** 
+ * @file policies.h
+ * @brief The backoff and window policies of the CSMA simulation.
+ *
+ * The simulation engines take both policies as template parameters, so a
+ * policy is inlined into the simulation loops and costs nothing when it is
+ * not used. A backoff policy draws the backoff of a node from its backoff
+ * window, and a window policy chooses the window from the number of
+ * collisions the node experienced.
+ *
+ * A backoff policy is constructed from a seed and a persistence probability,
+ * and is called as backoff(node_id, ticks, window) to get a backoff in
+ * [0, window). Its static member periodic tells whether the backoff only
+ * depends on the tick modulo the window, which cycle detection relies on.
+ *
+ * A window policy is default constructed, and is called as
+ * window(R, collision_count) with the R values of the input file. Its
+ * windows() member lists every window a node can be given.
+ *
+ * The random policies are counter-based: the backoff is a hash of the seed,
+ * the node ID and the tick, so a run gives the same results with every
+ * engine, can be continued at any tick, and is repeatable for a given seed.
+ *
+ * @author Vicky Chen (chen-vv)
+ * @author Eric Omielan (eomielan)
+ * @bug No known bugs.
+ */
+
+#ifndef POLICIES_H
+#define POLICIES_H
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+/**
+ * @brief Generate a backoff value for a node, which is the pseudorandom number generator following
+ * backoff = mod(node_id + ticks, R)
+ * 
+ * @param node_id The ID of the node to which the backoff value is assigned.
+ * @param ticks The number of ticks that have elapsed in the simulation.
+ * @param R The R value of the node, which is the upper limit of the backoff value since the
+ * backoff is in the range of [0, R).
+ * @return int The backoff value of the node.
+ */
+int generate_backoff(int node_id, long long ticks, int R);
+
+/**
+ * @brief Hash a seed, a node ID and a tick into 64 random bits.
+ * 
+ * Two rounds of the SplitMix64 finalizer, which passes the usual statistical test
+ * suites when used on a counter.
+ * 
+ * @param seed The seed of the simulation.
+ * @param node_id The ID of the node.
+ * @param ticks The tick the random bits are drawn on.
+ * @return unsigned long long The random bits.
+ */
+inline unsigned long long random_bits(unsigned long long seed, int node_id, long long ticks) {
+    unsigned long long z = seed ^ (static_cast<unsigned long long>(ticks) * 0xd1b54a32d192ed03ULL);
+    z += static_cast<unsigned long long>(node_id) * 0x9e3779b97f4a7c15ULL;
+
+    for (int round = 0; round < 2; round++) {
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        z = z ^ (z >> 31);
+        z += 0x9e3779b97f4a7c15ULL;
+    }
+
+    return z;
+}
+
+/**
+ * @brief The original backoff, mod(node_id + ticks, R).
+*/
+struct DeterministicBackoff {
+    static const bool periodic = true;  /**< The backoff repeats with the window. */
+
+    DeterministicBackoff(unsigned long long, double) {}
+
+    int operator()(int node_id, long long ticks, int window) const {
+        return generate_backoff(node_id, ticks, window);
+    }
+};
+
+/**
+ * @brief A backoff drawn uniformly at random from the window.
+*/
+struct UniformBackoff {
+    static const bool periodic = false;
+    unsigned long long seed;            /**< The seed of the random draws. */
+
+    UniformBackoff(unsigned long long seed, double) : seed(seed) {}
+
+    int operator()(int node_id, long long ticks, int window) const {
+        // Multiply-shift maps 32 random bits onto [0, window) without a division
+        unsigned long long bits = random_bits(seed, node_id, ticks) >> 32;
+        return static_cast<int>((bits * static_cast<unsigned long long>(window)) >> 32);
+    }
+};
+
+/**
+ * @brief The backoff of p-persistent CSMA, where a ready node transmits on each idle
+ * tick with probability p.
+ * 
+ * The number of idle ticks before the node transmits follows a geometric distribution,
+ * which is truncated to the window so that the window still bounds the backoff.
+*/
+struct PPersistentBackoff {
+    static const bool periodic = false;
+    unsigned long long seed;            /**< The seed of the random draws. */
+    double log_defer_probability;       /**< log(1 - p), or 0 if p is 1. */
+
+    PPersistentBackoff(unsigned long long seed, double persistence)
+        : seed(seed),
+          log_defer_probability(persistence < 1.0 ? std::log1p(-persistence) : 0.0) {}
+
+    int operator()(int node_id, long long ticks, int window) const {
+        if (log_defer_probability == 0.0) {
+            return 0;
+        }
+
+        // Inverse transform sampling of the geometric distribution from a uniform in [0, 1)
+        double uniform = static_cast<double>(random_bits(seed, node_id, ticks) >> 11) / 9007199254740992.0;
+        double deferred_ticks = std::floor(std::log1p(-uniform) / log_defer_probability);
+
+        return deferred_ticks < window - 1 ? static_cast<int>(deferred_ticks) : window - 1;
+    }
+};
+
+/**
+ * @brief The original window, the R value at the collision count, reusing the last
+ * R value once a node collided more often than there are R values.
+*/
+struct TableWindow {
+    int operator()(const std::vector<int>& R, int collision_count) const {
+        int last_index = static_cast<int>(R.size()) - 1;
+        return R[std::min(collision_count, last_index)];
+    }
+
+    std::vector<int> windows(const std::vector<int>& R) const {
+        return R;
+    }
+};
+
+/**
+ * @brief Truncated binary exponential backoff: the window starts at the first R value
+ * and doubles with every collision, up to the last R value.
+*/
+struct BinaryExponentialWindow {
+    int operator()(const std::vector<int>& R, int collision_count) const {
+        long long window = static_cast<long long>(R.front()) << std::min(collision_count, 31);
+        return static_cast<int>(std::min<long long>(window, std::max(R.front(), R.back())));
+    }
+
+    std::vector<int> windows(const std::vector<int>& R) const {
+        std::vector<int> windows(1, (*this)(R, 0));
+
+        for (int collision_count = 1; (*this)(R, collision_count) != windows.back(); collision_count++) {
+            windows.push_back((*this)(R, collision_count));
+        }
+
+        return windows;
+    }
+};
+
+#endif // POLICIES_H
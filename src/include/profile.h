@@ -0,0 +1,153 @@
+/** 
+ * @file profile.h
+ * @brief Counters and phase timers of the simulation loops, for --profile.
+ *
+ * The counters are only compiled in when the simulator is built with
+ * CSMA_PROFILE defined (make PROFILE=1). Otherwise the PROFILE_ macros
+ * expand to nothing, so the simulation loops are exactly the same as
+ * without any profiling code.
+ *
+ * @author Vicky Chen (chen-vv)
+ * @author Eric Omielan (eomielan)
+ * @bug No known bugs.
+ */
+
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <iosfwd>
+
+#if defined(CSMA_PROFILE) && (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h>
+#endif
+
+#include <chrono>
+
+/**
+ * @brief The counters of a profiled simulation.
+ * 
+ * The ticks are split into the four cases of the simulation loop, plus the ticks
+ * skipped by cycle detection. The times are in clock cycles of read_profile_clock().
+*/
+struct SimulationProfile {
+    long long busy_ticks;                       /**< Ticks with a transmission in progress. */
+    long long idle_ticks;                       /**< Ticks on which no node was ready. */
+    long long single_ready_ticks;               /**< Ticks on which one node started to transmit. */
+    long long collision_ticks;                  /**< Ticks on which several nodes collided. */
+    long long skipped_ticks;                    /**< Ticks skipped by cycle detection. */
+    unsigned long long ready_lookup_cycles;     /**< Time spent finding the ready nodes. */
+    unsigned long long idle_countdown_cycles;   /**< Time spent counting the backoffs down. */
+    unsigned long long collision_cycles;        /**< Time spent handling collisions. */
+    unsigned long long output_cycles;           /**< Time spent printing the full trace. */
+    unsigned long long total_cycles;            /**< Time spent in run(). */
+    double total_seconds;                       /**< Time spent in run(), in seconds. */
+
+    /**
+     * @brief Construct a profile with every counter at 0.
+     */
+    SimulationProfile();
+};
+
+/**
+ * @brief Whether the simulator was built with the profiling counters.
+ * 
+ * @return bool True if CSMA_PROFILE was defined at build time.
+ */
+bool profiling_available();
+
+/**
+ * @brief Read the clock the phases are timed with: the time stamp counter on x86,
+ * nanoseconds elsewhere.
+ * 
+ * @return unsigned long long The current time in clock cycles.
+ */
+inline unsigned long long read_profile_clock() {
+#if defined(CSMA_PROFILE) && (defined(__x86_64__) || defined(__i386__))
+    return __rdtsc();
+#else
+    return static_cast<unsigned long long>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+}
+
+/**
+ * @brief Adds the time until the end of its scope to a phase counter.
+*/
+class ProfilePhase {
+public:
+    /**
+     * @brief Start timing a phase.
+     * 
+     * @param cycles The counter of the phase, or null to time nothing.
+     */
+    explicit ProfilePhase(unsigned long long* cycles)
+        : cycles_(cycles),
+          start_(cycles ? read_profile_clock() : 0) {}
+
+    ~ProfilePhase() {
+        if (cycles_) {
+            *cycles_ += read_profile_clock() - start_;
+        }
+    }
+
+private:
+    unsigned long long* cycles_;    /**< The counter of the phase, or null. */
+    unsigned long long start_;      /**< The time the phase started. */
+};
+
+/**
+ * @brief Adds the time until the end of its scope to the total time of a profile,
+ * both in clock cycles and in seconds.
+*/
+class ProfileRun {
+public:
+    /**
+     * @brief Start timing a run.
+     * 
+     * @param profile The profile to add the time to, or null to time nothing.
+     */
+    explicit ProfileRun(SimulationProfile* profile)
+        : profile_(profile),
+          phase_(profile ? &profile->total_cycles : nullptr),
+          start_(std::chrono::steady_clock::now()) {}
+
+    ~ProfileRun() {
+        if (profile_) {
+            profile_->total_seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start_).count();
+        }
+    }
+
+private:
+    SimulationProfile* profile_;                        /**< The profile, or null. */
+    ProfilePhase phase_;                                /**< Times the run in clock cycles. */
+    std::chrono::steady_clock::time_point start_;       /**< The time the run started. */
+};
+
+#ifdef CSMA_PROFILE
+/** @brief Add a number of ticks to a tick counter of the profile in the options, if any. */
+#define PROFILE_TICKS(counter, count) \
+    do { if (options_.profile) options_.profile->counter += (count); } while (0)
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+
+/** @brief Time the rest of the enclosing scope into a phase counter of the profile in the options, if any. */
+#define PROFILE_PHASE(counter) \
+    ProfilePhase PROFILE_CONCAT(profile_phase_, __LINE__)(options_.profile ? &options_.profile->counter : nullptr)
+/** @brief Time the rest of the enclosing scope into the total time of the profile in the options, if any. */
+#define PROFILE_RUN() ProfileRun profile_run_(options_.profile)
+#else
+#define PROFILE_TICKS(counter, count) do {} while (0)
+#define PROFILE_PHASE(counter) do {} while (0)
+#define PROFILE_RUN() do {} while (0)
+#endif
+
+/**
+ * @brief Write a profile as a human-readable report.
+ * 
+ * @param output The stream to write the report to.
+ * @param profile The profile of a simulation.
+ */
+void write_profile(std::ostream& output, const SimulationProfile& profile);
+
+#endif // PROFILE_H
@@ -0,0 +1,80 @@
+/** 
+ * @file replication.h
+ * @brief Monte Carlo replications of a simulation with a random backoff policy.
+ *
+ * Every replica runs the same configuration with its own seed, derived from
+ * the base seed and the index of the replica, so the replicas are independent
+ * and the summary does not depend on how many threads ran them or in which
+ * order they finished.
+ *
+ * @author Vicky Chen (chen-vv)
+ * @author Eric Omielan (eomielan)
+ * @bug No known bugs.
+ */
+
+#ifndef REPLICATION_H
+#define REPLICATION_H
+
+#include <iosfwd>
+
+#include "csma.h"
+
+/** @brief The number of replicas between two checks of the stopping criterion. */
+#define REPLICATION_CHECK_INTERVAL 8
+
+/**
+ * @brief The link utilization rates of a set of replicas, summarized.
+*/
+struct ReplicationSummary {
+    long long num_replications;     /**< The number of replicas summarized. */
+    double mean;                    /**< The mean utilization of the replicas. */
+    double variance;                /**< The sample variance of the utilization, or 0 for one replica. */
+    double ci_half_width;           /**< Half the width of the 95% confidence interval of the mean. */
+};
+
+/**
+ * @brief Get the seed of a replica.
+ * 
+ * @param seed The base seed of the replications.
+ * @param replica The index of the replica.
+ * @return unsigned long long The seed the replica is run with.
+ */
+unsigned long long replica_seed(unsigned long long seed, long long replica);
+
+/**
+ * @brief Get the 97.5% quantile of Student's t distribution, the factor of the
+ * standard error in a 95% confidence interval.
+ * 
+ * @param degrees_of_freedom The degrees of freedom, at least 1.
+ * @return double The quantile.
+ */
+double student_t_975(long long degrees_of_freedom);
+
+/**
+ * @brief Run replicas of a simulation in parallel and summarize their utilization.
+ * 
+ * The replicas are run with the policies and engine of the options, each with the seed
+ * replica_seed(options.seed, index). If a maximum width is given, the replications stop
+ * at the first multiple of REPLICATION_CHECK_INTERVAL replicas whose 95% confidence
+ * interval is narrower than it. Logging, tracing and node
+ * statistics are turned off.
+ * 
+ * @param config The parameters of the simulation, which must be valid.
+ * @param options How every replica is run.
+ * @param max_replications The number of replicas to run, or the most to run if stopping early.
+ * @param max_ci_width The confidence interval width to stop at, or 0 to run every replica.
+ * @param num_threads The number of worker threads, or 0 for one per hardware thread.
+ * @return ReplicationSummary The summary of the replicas that count towards the result.
+ */
+ReplicationSummary run_replications(const SimulationConfig& config, SimulationOptions options,
+                                    long long max_replications, double max_ci_width, int num_threads);
+
+/**
+ * @brief Write the summary of the replications as a CSV table with one row.
+ * 
+ * @param output The stream to write the table to.
+ * @param summary The summary of the replications.
+ */
+void write_replication_summary(std::ostream& output, const ReplicationSummary& summary);
+
+#endif // REPLICATION_H
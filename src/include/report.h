@@ -0,0 +1,173 @@
+/**
+ * @file report.h
+ * @brief A streaming report of the utilization over windows of ticks, for --report-interval.
+ *
+ * The ticks are split into windows of K ticks, and for every window the report
+ * gives the successful ticks, the collisions and the dropped packets in it,
+ * along with the same counts since tick 0:
+ *
+ *     window_start,window_end,successful_ticks,utilization,collisions,drops,total_successful_ticks,total_utilization,total_collisions,total_drops
+ *
+ * The simulation only tells the report about events, so it works the same with
+ * every engine: a window is complete once an event happens on or after its end,
+ * and every window an engine skips over in one step is completed at once. The
+ * successful ticks of a transmission are split exactly between the windows it spans.
+ *
+ * Completed windows are passed through a preallocated ring buffer to a thread
+ * that formats and writes them, so the simulation never waits for the file.
+ * A report can also keep the completed windows in memory instead, for the
+ * Python module.
+ *
+ * @author Vicky Chen (chen-vv)
+ * @author Eric Omielan (eomielan)
+ * @bug No known bugs.
+ */
+
+#ifndef REPORT_H
+#define REPORT_H
+
+#include <atomic>
+#include <climits>
+#include <cstdio>
+#include <deque>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ring_buffer.h"
+
+/** @brief The number of completed windows the ring buffer of a report holds. */
+#define REPORT_RING_CAPACITY 4096
+
+/**
+ * @brief The counts of one window of ticks.
+*/
+struct UtilizationWindow {
+    long long start_tick;                       /**< The first tick of the window. */
+    long long end_tick;                         /**< One past the last tick of the window. */
+    long long successful_ticks;                 /**< The successful ticks in the window. */
+    long long collisions;                       /**< The collisions in the window. */
+    long long drops;                            /**< The packets dropped in the window. */
+};
+
+/**
+ * @brief Writer of a streaming utilization report, passed to a simulation in its options.
+*/
+class UtilizationReport {
+public:
+    UtilizationReport();
+    ~UtilizationReport();
+
+    UtilizationReport(const UtilizationReport&) = delete;
+    UtilizationReport& operator=(const UtilizationReport&) = delete;
+
+    /**
+     * @brief Create the report file and start the thread that writes it.
+     *
+     * @param filename The name of the report file, which may be a named pipe, or "-" for standard output.
+     * @param interval The number of ticks of every window, at least 1.
+     * @return bool True if the file was opened, false otherwise.
+     */
+    bool open(const std::string& filename, long long interval);
+
+    /**
+     * @brief Keep the windows in memory rather than writing them to a file.
+     *
+     * @param interval The number of ticks of every window, at least 1.
+     */
+    void collect(long long interval);
+
+    /**
+     * @brief Get the completed windows of a report that collects them.
+     *
+     * @return const std::vector<UtilizationWindow>& The windows, in order, all of them once it is closed.
+     */
+    const std::vector<UtilizationWindow>& windows() const {
+        return collected_;
+    }
+
+    /**
+     * @brief Complete the last windows of the run, and wait until every window is written.
+     *
+     * @param total_simulation_time The tick the simulation stopped at. The last window
+     * ends on it, even if it is shorter than the interval.
+     * @return bool True if every window was written, false on a write error.
+     */
+    bool close(long long total_simulation_time);
+
+    /**
+     * @brief Record that a node occupied the channel.
+     *
+     * @param ticks The tick the transmission started on.
+     * @param packet_length The number of ticks of the transmission, if it is not cut short.
+     */
+    void start(long long ticks, int packet_length) {
+        complete_windows(ticks);
+        credit_transmission();
+        transmission_start_ = ticks;
+        transmission_end_ = packet_length > LLONG_MAX - ticks ? LLONG_MAX : ticks + packet_length;
+    }
+
+    /**
+     * @brief Record a collision.
+     *
+     * @param ticks The tick of the collision.
+     */
+    void collision(long long ticks) {
+        complete_windows(ticks);
+        window_.collisions++;
+    }
+
+    /**
+     * @brief Record that a node dropped its packet.
+     *
+     * @param ticks The tick of the collision that made the node drop its packet.
+     */
+    void drop(long long ticks) {
+        complete_windows(ticks);
+        window_.drops++;
+    }
+
+private:
+    /**
+     * @brief Complete every window that ends on or before a tick.
+     *
+     * @param ticks The tick of the next event.
+     */
+    void complete_windows(long long ticks) {
+        while (ticks >= window_.end_tick) {
+            complete_window();
+        }
+    }
+
+    /**
+     * @brief Add the ticks of the last transmission that fall in the current window.
+     */
+    void credit_transmission();
+
+    /**
+     * @brief Hand the current window to the writing thread, and move on to the next one.
+     */
+    void complete_window();
+
+    /**
+     * @brief Format and write the completed windows until the report is closed.
+     */
+    void write_windows();
+
+    std::FILE* file_;                           /**< The report file. */
+    bool owns_file_;                            /**< Whether the file is closed with the report. */
+    long long interval_;                        /**< The number of ticks of every window. */
+    UtilizationWindow window_;                  /**< The window the next events fall in. */
+    long long transmission_start_;              /**< The first tick of the last transmission. */
+    long long transmission_end_;                /**< One past the last tick of the last transmission. */
+    RingBuffer<UtilizationWindow> ring_;        /**< The completed windows not written yet. */
+    std::deque<UtilizationWindow> backlog_;     /**< The completed windows that did not fit in the ring. */
+    std::thread thread_;                        /**< The thread writing the windows. */
+    std::atomic<bool> closing_;                 /**< Set once the last window is in the ring. */
+    bool failed_;                               /**< Set by the writing thread on a write error. */
+    bool collecting_;                           /**< Whether the windows are kept in memory. */
+    std::vector<UtilizationWindow> collected_;  /**< The completed windows, if they are kept in memory. */
+};
+
+#endif // REPORT_H
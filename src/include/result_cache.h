@@ -0,0 +1,181 @@
+/**
+ * @file result_cache.h
+ * @brief An on-disk cache of the final state of simulations, for --cache.
+ *
+ * Every simulation run through the cache leaves a checkpoint of its final state
+ * in the cache directory (see checkpoint.h), named after the fingerprint of its
+ * parameters and policies and after the tick it stopped at:
+ *
+ *     <fingerprint in hex>-<T>.checkpoint
+ *
+ * The fingerprint covers everything but T, so a later run of the same parameters
+ * with the same T takes its results straight from the checkpoint, and a run with a
+ * larger T resumes from the checkpoint of the longest shorter run and only
+ * simulates the ticks after it. The checkpoints are checked like any other, so an
+ * entry that is damaged, or written by another version, is simulated again.
+ *
+ * The cache can be shared by the worker threads of a sweep, and by several
+ * processes: the entries are written atomically, so a reader only ever sees
+ * complete ones.
+ *
+ * @author Vicky Chen (chen-vv)
+ * @author Eric Omielan (eomielan)
+ * @bug No known bugs.
+ */
+
+#ifndef RESULT_CACHE_H
+#define RESULT_CACHE_H
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+
+#include "csma.h"
+
+/**
+ * @brief A directory of final simulation states, indexed by fingerprint and tick.
+*/
+class ResultCache {
+public:
+    ResultCache();
+
+    ResultCache(const ResultCache&) = delete;
+    ResultCache& operator=(const ResultCache&) = delete;
+
+    /**
+     * @brief Open a cache directory, creating it if it does not exist, and index its entries.
+     *
+     * @param directory The name of the directory.
+     * @return bool True if the directory could be read, false otherwise.
+     */
+    bool open(const std::string& directory);
+
+    /**
+     * @brief Find the longest run of a simulation that is no longer than it.
+     *
+     * @param config The parameters of the simulation.
+     * @param options The options of the simulation.
+     * @param snapshot Set to the final state of the cached run.
+     * @return bool True if a run up to at most the simulation time of the configuration
+     * was found, false otherwise.
+     */
+    bool lookup(const SimulationConfig& config, const SimulationOptions& options, SimulationSnapshot& snapshot);
+
+    /**
+     * @brief Add the final state of a run to the cache, unless it is already there.
+     *
+     * @param config The parameters of the simulation.
+     * @param options The options of the simulation.
+     * @param snapshot The state of the simulation at its simulation time.
+     */
+    void store(const SimulationConfig& config, const SimulationOptions& options, const SimulationSnapshot& snapshot);
+
+    /**
+     * @brief Count a run whose results were taken from the cache without simulating any tick.
+     */
+    void count_reused() {
+        num_reused_++;
+    }
+
+    /**
+     * @brief Count a run that was resumed from the final state of a shorter run.
+     */
+    void count_extended() {
+        num_extended_++;
+    }
+
+    /**
+     * @brief Count a run that was simulated from tick 0.
+     */
+    void count_simulated() {
+        num_simulated_++;
+    }
+
+    /**
+     * @brief Get the number of runs whose results were taken from the cache.
+     *
+     * @return long long The number of runs.
+     */
+    long long num_reused() const {
+        return num_reused_;
+    }
+
+    /**
+     * @brief Get the number of runs that were resumed from a shorter run.
+     *
+     * @return long long The number of runs.
+     */
+    long long num_extended() const {
+        return num_extended_;
+    }
+
+    /**
+     * @brief Get the number of runs that were simulated from tick 0.
+     *
+     * @return long long The number of runs.
+     */
+    long long num_simulated() const {
+        return num_simulated_;
+    }
+
+private:
+    /**
+     * @brief Get the name of the file of an entry.
+     *
+     * @param fingerprint The checkpoint_fingerprint() of the run.
+     * @param ticks The tick the run stopped at.
+     * @return std::string The name of the file in the cache directory.
+     */
+    std::string entry_filename(uint64_t fingerprint, long long ticks) const;
+
+    std::string directory_;                     /**< The cache directory. */
+    std::mutex mutex_;                          /**< Guards the index. */
+    std::map<uint64_t, std::set<long long>> entries_; /**< The ticks of the entries of every fingerprint. */
+    std::atomic<long long> num_reused_;         /**< The runs answered from an entry of the same T. */
+    std::atomic<long long> num_extended_;       /**< The runs resumed from an entry of a shorter T. */
+    std::atomic<long long> num_simulated_;      /**< The runs without any entry. */
+};
+
+/**
+ * @brief Run a simulation that is at tick 0 through a result cache.
+ *
+ * The results come from the cache if it holds the same run, and otherwise the
+ * simulation resumes from the longest shorter run, if any, and its final state is
+ * added to the cache. A simulation that logs its events or ticks is run from tick
+ * 0 whatever the cache holds, so its log is complete, and only adds its final state.
+ *
+ * @tparam SimulationType The instantiation of BasicSimulation with the selected policies.
+ * @param simulation The simulation, at tick 0.
+ * @param cache The cache.
+ * @return SimulationResults The results of the simulation.
+ */
+template <typename SimulationType>
+SimulationResults run_through_cache(SimulationType& simulation, ResultCache& cache) {
+    const SimulationConfig& config = simulation.config();
+    SimulationSnapshot snapshot;
+
+    if (simulation.options().log_level <= LOG_SUMMARY && cache.lookup(config, simulation.options(), snapshot)) {
+        if (snapshot.current_tick == config.total_simulation_time) {
+            cache.count_reused();
+            SimulationResults results;
+            results.total_simulation_time = snapshot.current_tick;
+            results.num_successful_transmission_ticks = snapshot.num_successful_transmission_ticks;
+            return results;
+        }
+
+        cache.count_extended();
+        simulation.restore(snapshot);
+    } else {
+        cache.count_simulated();
+    }
+
+    SimulationResults results = simulation.run();
+    simulation.save(snapshot);
+    cache.store(config, simulation.options(), snapshot);
+    return results;
+}
+
+#endif // RESULT_CACHE_H
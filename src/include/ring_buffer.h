@@ -0,0 +1,93 @@
+/**
+ * @file ring_buffer.h
+ * @brief A fixed-capacity ring buffer between one producer and one consumer thread.
+ *
+ * The buffer is allocated once, and pushing or popping an item is a copy and
+ * a single atomic store, so the producer never waits for the consumer: when the
+ * buffer is full, try_push() fails and the producer decides what to do.
+ *
+ * @author Vicky Chen (chen-vv)
+ * @author Eric Omielan (eomielan)
+ * @bug No known bugs.
+ */
+
+#ifndef RING_BUFFER_H
+#define RING_BUFFER_H
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+/**
+ * @brief A lock-free ring buffer with a single producer and a single consumer.
+ *
+ * @tparam T The type of the items, which must be copyable.
+*/
+template <typename T>
+class RingBuffer {
+public:
+    /**
+     * @brief Construct an empty ring buffer.
+     *
+     * @param capacity The number of items the buffer holds, rounded up to a power of two.
+     */
+    explicit RingBuffer(size_t capacity)
+        : head_(0),
+          tail_(0) {
+        size_t size = 1;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        items_.resize(size);
+        mask_ = size - 1;
+    }
+
+    RingBuffer(const RingBuffer&) = delete;
+    RingBuffer& operator=(const RingBuffer&) = delete;
+
+    /**
+     * @brief Append an item, from the producer thread.
+     *
+     * @param item The item.
+     * @return bool True if the item was appended, false if the buffer is full.
+     */
+    bool try_push(const T& item) {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+
+        if (tail - head_.load(std::memory_order_acquire) > mask_) {
+            return false;
+        }
+
+        items_[tail & mask_] = item;
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Remove the oldest item, from the consumer thread.
+     *
+     * @param item Set to the oldest item.
+     * @return bool True if an item was removed, false if the buffer is empty.
+     */
+    bool try_pop(T& item) {
+        size_t head = head_.load(std::memory_order_relaxed);
+
+        if (head == tail_.load(std::memory_order_acquire)) {
+            return false;
+        }
+
+        item = items_[head & mask_];
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    std::vector<T> items_;                      /**< The slots of the buffer. */
+    size_t mask_;                               /**< The number of slots minus one. */
+
+    // The two positions are written by different threads, so they are kept on separate cache lines
+    alignas(64) std::atomic<size_t> head_;      /**< The number of items popped, written by the consumer. */
+    alignas(64) std::atomic<size_t> tail_;      /**< The number of items pushed, written by the producer. */
+};
+
+#endif // RING_BUFFER_H
@@ -0,0 +1,80 @@
+/**
+ * @file server.h
+ * @brief A long-lived server that runs simulations requested over a stream, for --serve.
+ *
+ * A request is a request id, any token without whitespace, followed by a scenario
+ * in one of two forms. On a single line, the lines of an input file are joined
+ * with semicolons:
+ *
+ *     7 N 4; L 2; M 6; R 4 8 16 32 64 128; T 10
+ *
+ * or the id is followed by a plus sign and a byte count, and that many bytes of an
+ * input file follow the line:
+ *
+ *     8 +26
+ *     N 4
+ *     L 2
+ *     M 6
+ *     R 4 8 16
+ *     T 10
+ *
+ * Every request is answered with a single line that carries its id, once its
+ * simulation is done:
+ *
+ *     7 ok <successful ticks> <T> <utilization>
+ *     8 error <description of the problem>
+ *
+ * Any number of requests may be in flight at once. They are run on a thread
+ * pool, where every worker keeps a simulation warm between requests, and the
+ * answers are written as soon as they are ready, so they can come back in
+ * another order than the requests. Every connection has a thread that writes its
+ * answers, so a client that does not read them never holds up the pool. Once
+ * SERVER_MAX_PENDING_ANSWERS of its answers are waiting, the server stops reading
+ * its requests until it reads some.
+ *
+ * @author Vicky Chen (chen-vv)
+ * @author Eric Omielan (eomielan)
+ * @bug No known bugs.
+ */
+
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <string>
+
+#include "csma.h"
+
+/** @brief The largest input file, in bytes, a length-prefixed request may carry. */
+#define SERVER_MAX_REQUEST_BYTES (1 << 20)
+
+/** @brief The number of requests of a connection that may be unanswered, or unwritten, before its next request is read. */
+#define SERVER_MAX_PENDING_ANSWERS 1024
+
+/**
+ * @brief Answer the requests of standard input on standard output, until the end of the input.
+ *
+ * @param options The engine and policy options used for every request.
+ * @param num_threads The number of worker threads, or 0 for one per hardware thread.
+ * @param error Set to a description of the problem if the server failed.
+ * @return bool True if every request was answered, false otherwise.
+ */
+bool serve_standard_streams(const SimulationOptions& options, int num_threads, std::string& error);
+
+/**
+ * @brief Answer the requests of every connection to a Unix domain socket, until an error.
+ *
+ * The socket is created at the given path, replacing a stale socket left there
+ * by an earlier server. Every connection is read by a thread of its own, and its
+ * answers are written back to it, while the simulations of all connections share
+ * the thread pool.
+ *
+ * @param socket_path The path of the socket.
+ * @param options The engine and policy options used for every request.
+ * @param num_threads The number of worker threads, or 0 for one per hardware thread.
+ * @param error Set to a description of the problem that stopped the server.
+ * @return bool False, once the socket cannot accept connections any more.
+ */
+bool serve_socket(const std::string& socket_path, const SimulationOptions& options, int num_threads,
+                  std::string& error);
+
+#endif // SERVER_H
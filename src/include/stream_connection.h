@@ -0,0 +1,185 @@
+/**
+ * @file stream_connection.h
+ * @brief A buffered connection over file descriptors, for the server and the distributed sweep.
+ *
+ * @author Vicky Chen (chen-vv)
+ * @author Eric Omielan (eomielan)
+ * @bug No known bugs.
+ */
+
+#ifndef STREAM_CONNECTION_H
+#define STREAM_CONNECTION_H
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <sys/socket.h>
+#include <unistd.h>
+
+/**
+ * @brief A connection over a pair of file descriptors: the stream lines and bytes are
+ * read from, and the stream whole lines are written to.
+ *
+ * The lines written by different threads never interleave, so a connection can be
+ * shared by its reader and by the tasks that answer it, and stays open until the
+ * last of them is done with it.
+*/
+class StreamConnection {
+public:
+    /**
+     * @brief Construct a connection over two file descriptors.
+     *
+     * @param input_fd The descriptor the requests are read from.
+     * @param output_fd The descriptor the answers are written to.
+     * @param owns_fds Whether the descriptors are closed with the connection.
+     */
+    StreamConnection(int input_fd, int output_fd, bool owns_fds)
+        : input_fd_(input_fd),
+          output_fd_(output_fd),
+          owns_fds_(owns_fds),
+          write_failed_(false),
+          buffer_position_(0) {}
+
+    ~StreamConnection() {
+        if (owns_fds_) {
+            close(input_fd_);
+            if (output_fd_ != input_fd_) {
+                close(output_fd_);
+            }
+        }
+    }
+
+    StreamConnection(const StreamConnection&) = delete;
+    StreamConnection& operator=(const StreamConnection&) = delete;
+
+    /**
+     * @brief Read the next line, without its newline.
+     *
+     * @param line Set to the line.
+     * @return bool True if a line was read, false at the end of the stream. A last
+     * line without a newline is still read.
+     */
+    bool read_line(std::string& line) {
+        line.clear();
+
+        for (;;) {
+            const char* begin = buffer_.data() + buffer_position_;
+            const char* newline = static_cast<const char*>(std::memchr(begin, '\n', buffer_.size() - buffer_position_));
+
+            if (newline) {
+                line.append(begin, newline);
+                buffer_position_ = newline - buffer_.data() + 1;
+                return true;
+            }
+
+            line.append(begin, buffer_.data() + buffer_.size());
+            buffer_position_ = buffer_.size();
+
+            if (!fill_buffer()) {
+                return !line.empty();
+            }
+        }
+    }
+
+    /**
+     * @brief Read an exact number of bytes.
+     *
+     * @param num_bytes The number of bytes.
+     * @param bytes Set to the bytes.
+     * @return bool True if all of the bytes were read, false if the stream ended first.
+     */
+    bool read_bytes(size_t num_bytes, std::string& bytes) {
+        bytes.clear();
+
+        while (bytes.size() < num_bytes) {
+            if (buffer_position_ == buffer_.size() && !fill_buffer()) {
+                return false;
+            }
+
+            size_t count = std::min(num_bytes - bytes.size(), buffer_.size() - buffer_position_);
+            bytes.append(buffer_.data() + buffer_position_, count);
+            buffer_position_ += count;
+        }
+
+        return true;
+    }
+
+    /**
+     * @brief Write a line, whole, between the lines written by other threads.
+     *
+     * @param line The line, without its newline.
+     */
+    void write_line(std::string line) {
+        line.push_back('\n');
+        std::lock_guard<std::mutex> lock(write_mutex_);
+
+        // Once the other end has gone, the remaining lines are dropped
+        const char* position = line.data();
+        const char* end = position + line.size();
+
+        while (!write_failed_ && position < end) {
+            ssize_t written = write(output_fd_, position, end - position);
+
+            if (written > 0) {
+                position += written;
+            } else if (written < 0 && errno != EINTR) {
+                write_failed_ = true;
+            }
+        }
+    }
+
+    /**
+     * @brief Check whether a line could not be written.
+     *
+     * @return bool True if the stream of lines written failed, false otherwise.
+     */
+    bool write_failed() {
+        std::lock_guard<std::mutex> lock(write_mutex_);
+        return write_failed_;
+    }
+
+    /**
+     * @brief Shut a socket connection down from another thread, so that a read blocked
+     * on it returns the end of the stream and every later write fails.
+     */
+    void shut_down() {
+        shutdown(input_fd_, SHUT_RDWR);
+    }
+
+private:
+    /**
+     * @brief Replace the consumed buffer with the next bytes of the stream.
+     *
+     * @return bool True if any bytes were read, false at the end of the stream or on an error.
+     */
+    bool fill_buffer() {
+        buffer_.resize(1 << 16);
+        buffer_position_ = 0;
+
+        for (;;) {
+            ssize_t count = read(input_fd_, &buffer_[0], buffer_.size());
+
+            if (count > 0) {
+                buffer_.resize(count);
+                return true;
+            }
+
+            if (count == 0 || errno != EINTR) {
+                buffer_.clear();
+                return false;
+            }
+        }
+    }
+
+    int input_fd_;              /**< The descriptor lines are read from. */
+    int output_fd_;             /**< The descriptor lines are written to. */
+    bool owns_fds_;             /**< Whether the descriptors are closed with the connection. */
+    std::mutex write_mutex_;    /**< Keeps the lines of different threads apart. */
+    bool write_failed_;         /**< Whether writing a line failed. */
+    std::string buffer_;        /**< The bytes read from the stream and not yet consumed. */
+    size_t buffer_position_;    /**< The first byte of the buffer that is not yet consumed. */
+};
+
+#endif // STREAM_CONNECTION_H
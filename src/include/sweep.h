@@ -0,0 +1,126 @@
+/** 
+ * @file sweep.h
+ * @brief Parameter sweeps that run a grid of simulations on a thread pool.
+ *
+ * A sweep grid file uses the parameter letters of the simulation input file,
+ * but every parameter may be given several values:
+ *
+ *     N 2 4 8        a list of values
+ *     L 1:8          an inclusive range with step 1
+ *     T 1000:9000:2000   an inclusive range with step 2000
+ *     M 2:64*2       an inclusive geometric range, doubling each step
+ *     R 4 8 16 32    one R vector per R line, any number of R lines
+ *
+ * The sweep runs the simulation for every combination of the values, so a
+ * plain simulation input file is a sweep of a single point. A file may hold
+ * several grids, separated by blank lines or [name] headers, and the sweep
+ * runs the points of all of them.
+ *
+ * @author Vicky Chen (chen-vv)
+ * @author Eric Omielan (eomielan)
+ * @bug No known bugs.
+ */
+
+#ifndef SWEEP_H
+#define SWEEP_H
+
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+#include "csma.h"
+
+/**
+ * @brief The values a sweep takes for each simulation parameter.
+*/
+struct SweepGrid {
+    std::vector<int> num_nodes;                     /**< The values of N. */
+    std::vector<int> packet_length;                 /**< The values of L. */
+    std::vector<std::vector<int>> R;                /**< The R vectors. */
+    std::vector<int> max_retransmission_attempt;    /**< The values of M. */
+    std::vector<long long> total_simulation_time;   /**< The values of T. */
+};
+
+/**
+ * @brief Parse a sweep grid file, which may hold several grids separated by blank
+ * lines or [name] headers, like the scenarios of an input file.
+ * 
+ * Parameters that are not given in a grid keep the single default value of SimulationConfig.
+ * 
+ * @param contents The contents of the grid file, see read_input_file().
+ * @param grids Set to the parsed grids, in the order of the file.
+ * @param error Set to a description of the problem, with its line number, if the file is malformed.
+ * @return bool True if the file held at least one grid and all of them were parsed, false otherwise.
+ */
+bool parse_sweep_grids(const std::string& contents, std::vector<SweepGrid>& grids, std::string& error);
+
+/**
+ * @brief List the simulation configurations of every point of a grid.
+ * 
+ * @param grid The grid to expand.
+ * @return std::vector<SimulationConfig> One configuration per combination of
+ * parameter values, ordered by R, N, L, M and then T.
+ */
+std::vector<SimulationConfig> expand_sweep_grid(const SweepGrid& grid);
+
+/**
+ * @brief Run the simulation of every configuration on a work-stealing thread pool.
+ * 
+ * Every worker thread reuses one Simulation for all the points it runs. Logging,
+ * tracing and node statistics are turned off, since the points run at the same time.
+ * 
+ * @param configs The configurations to run, which must all be valid.
+ * @param options The engine and policy options used for every point.
+ * @param num_threads The number of worker threads, or 0 for one per hardware thread.
+ * @param pin_threads Whether to pin every worker thread to a core of its own.
+ * @return std::vector<SimulationResults> The results of each configuration, in the same order.
+ */
+std::vector<SimulationResults> run_sweep(const std::vector<SimulationConfig>& configs,
+                                         SimulationOptions options, int num_threads, bool pin_threads = false);
+
+/**
+ * @brief Write the parameters and results of one simulation as CSV fields.
+ * 
+ * @param output The stream to write the fields N,L,M,R,T,successful_ticks,utilization to.
+ * @param config The configuration of the simulation.
+ * @param results The results of the simulation.
+ */
+void write_point_fields(std::ostream& output, const SimulationConfig& config, const SimulationResults& results);
+
+/**
+ * @brief Write the name of a row of a CSV table, quoted if it would break the row.
+ * 
+ * @param output The stream to write the name to.
+ * @param name The name, or an empty name to number the row instead.
+ * @param kind What the rows are, which a numbered row is named after.
+ * @param index The index of the row, numbered from 1 in its name.
+ */
+void write_csv_name(std::ostream& output, const std::string& name, const char* kind, size_t index);
+
+/**
+ * @brief Write the results of a sweep as a CSV table, one row per point.
+ * 
+ * @param output The stream to write the table to.
+ * @param configs The configurations of the points.
+ * @param results The results of the points.
+ */
+void write_sweep_results(std::ostream& output, const std::vector<SimulationConfig>& configs,
+                         const std::vector<SimulationResults>& results);
+
+/**
+ * @brief Write the results of independent collision domains as a CSV table, one row
+ * per domain followed by a total row.
+ * 
+ * The total row adds up the nodes, ticks and successful ticks of every domain, so its
+ * utilization is the fraction of all simulated ticks that were successful.
+ * 
+ * @param output The stream to write the table to.
+ * @param names The name of each domain, or an empty name to number it instead.
+ * @param configs The configurations of the domains.
+ * @param results The results of the domains.
+ */
+void write_domain_results(std::ostream& output, const std::vector<std::string>& names,
+                          const std::vector<SimulationConfig>& configs,
+                          const std::vector<SimulationResults>& results);
+
+#endif // SWEEP_H
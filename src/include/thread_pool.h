@@ -0,0 +1,122 @@
+/** 
+ * @file thread_pool.h
+ * @brief A work-stealing thread pool for running many simulations at once.
+ *
+ * Each worker thread owns a queue of tasks. A worker runs the tasks of its
+ * own queue in the order they were submitted and, once that is empty, steals
+ * the most recently submitted task from the queue of another worker, so
+ * workers that finish their share early keep busy while others are stuck on
+ * long simulations. Workers can be pinned to cores, so that the state of
+ * the simulations they run stays in the caches of one core.
+ *
+ * @author Vicky Chen (chen-vv)
+ * @author Eric Omielan (eomielan)
+ * @bug No known bugs.
+ */
+
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief A fixed set of worker threads that run submitted tasks.
+*/
+class ThreadPool {
+public:
+    /**
+     * @brief Start the worker threads.
+     * 
+     * @param num_threads The number of worker threads, or 0 for one per hardware thread.
+     * @param pin_threads Whether to pin every worker to a core of its own, in turn over
+     * the cores the process may run on. Pinning is only supported on Linux.
+     */
+    explicit ThreadPool(int num_threads = 0, bool pin_threads = false);
+
+    /**
+     * @brief Wait for every submitted task to finish, then stop the worker threads.
+     */
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * @brief Queue a task to be run by one of the worker threads.
+     * 
+     * Tasks submitted from a worker thread are queued on that worker, other tasks
+     * are spread over the workers in turn.
+     * 
+     * @param task The task to run.
+     */
+    void submit(std::function<void()> task);
+
+    /**
+     * @brief Block until every submitted task has finished.
+     */
+    void wait();
+
+    /**
+     * @brief Get the number of worker threads.
+     * 
+     * @return int The number of worker threads.
+     */
+    int size() const {
+        return static_cast<int>(threads_.size());
+    }
+
+    /**
+     * @brief Get the index of the worker thread that calls this function.
+     * 
+     * The index can be used to give every worker its own reusable state.
+     * 
+     * @return int The index in [0, size()) of the calling worker, or -1 if the caller
+     * is not a worker thread of any pool.
+     */
+    static int current_worker_index();
+
+private:
+    /**
+     * @brief The tasks queued on one worker.
+     */
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    /**
+     * @brief Run tasks until the pool is stopped.
+     * 
+     * @param index The index of the worker.
+     * @param cpu The core to pin the worker to, or -1 to leave it unpinned.
+     */
+    void worker_loop(int index, int cpu);
+
+    /**
+     * @brief Take a task from the worker's own queue, or steal one from another worker.
+     * 
+     * @param index The index of the worker.
+     * @param task Set to the task that was taken.
+     * @return bool True if a task was taken, false if every queue is empty.
+     */
+    bool take_task(int index, std::function<void()>& task);
+
+    std::vector<std::unique_ptr<WorkerQueue>> queues_;  /**< The queue of each worker. */
+    std::vector<std::thread> threads_;                  /**< The worker threads. */
+    std::mutex state_mutex_;                            /**< Guards sleeping and waking workers and waiters. */
+    std::condition_variable work_available_;            /**< Signalled when a task is queued or the pool stops. */
+    std::condition_variable work_finished_;             /**< Signalled when the last unfinished task finishes. */
+    std::atomic<long long> queued_tasks_;               /**< The number of tasks waiting in the queues. */
+    std::atomic<long long> unfinished_tasks_;           /**< The number of tasks queued or running. */
+    std::atomic<unsigned> next_queue_;                  /**< The queue that receives the next outside task. */
+    bool stopping_;                                     /**< Whether the workers should exit. */
+};
+
+#endif // THREAD_POOL_H
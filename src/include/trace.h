@@ -0,0 +1,259 @@
+/** 
+ * @file trace.h
+ * @brief A compact binary trace of the events of a simulation, and its reader.
+ *
+ * The trace only records the ticks on which the state of the channel changes:
+ * idle stretches, the start and end of every transmission, collisions and the
+ * packets they drop, and skipped cycles. Every record is a one-byte type
+ * followed by LEB128 varints, and ticks are written as the difference to the
+ * tick of the previous record, so most records take 3 to 5 bytes.
+ *
+ * The file starts with the magic "CSMATRC1" and the configuration of the
+ * simulation, and ends with a TRACE_END_OF_RUN record holding the results.
+ *
+ * @author Vicky Chen (chen-vv)
+ * @author Eric Omielan (eomielan)
+ * @bug No known bugs.
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "csma.h"
+
+/** @brief The first bytes of every trace file. */
+#define TRACE_MAGIC "CSMATRC1"
+
+/** @brief The size of the write buffer of a trace, flushed to the file when full. */
+#define TRACE_BUFFER_SIZE (1 << 20)
+
+/**
+ * @brief The types of the records of a trace.
+*/
+enum TraceRecordType {
+    TRACE_IDLE = 1,             /**< tick delta, number of idle ticks: the channel was idle from the tick on. */
+    TRACE_START,                /**< tick delta, node: the node occupied the channel. */
+    TRACE_END,                  /**< tick delta, node, backoff: the node sent the last tick of its packet. */
+    TRACE_COLLISION,            /**< tick delta, count, node deltas: the nodes collided. */
+    TRACE_DROP,                 /**< tick delta, node: the node dropped its packet after the collision. */
+    TRACE_CYCLE,                /**< tick delta, period, ticks skipped: a cycle was skipped. */
+    TRACE_END_OF_RUN            /**< tick delta, successful ticks: the run stopped at the tick. */
+};
+
+/**
+ * @brief Writer of a binary trace, passed to a simulation in its options.
+ * 
+ * The event functions only append to a memory buffer, so the simulation is only
+ * slowed down when the buffer is flushed to the file.
+*/
+class TraceWriter {
+public:
+    TraceWriter();
+    ~TraceWriter();
+
+    TraceWriter(const TraceWriter&) = delete;
+    TraceWriter& operator=(const TraceWriter&) = delete;
+
+    /**
+     * @brief Create the trace file and write its header.
+     * 
+     * @param filename The name of the trace file.
+     * @param config The parameters of the simulation being traced.
+     * @return bool True if the file was created, false otherwise.
+     */
+    bool open(const std::string& filename, const SimulationConfig& config);
+
+    /**
+     * @brief Write the results of the simulation and close the file.
+     * 
+     * @param results The results of the simulation.
+     * @return bool True if every record was written, false on a write error.
+     */
+    bool close(const SimulationResults& results);
+
+    /**
+     * @brief Record that a node occupied the channel.
+     * 
+     * @param ticks The tick the transmission started on.
+     * @param node_id The ID of the node.
+     */
+    void start(long long ticks, int node_id) {
+        record_idle(ticks);
+        begin_record(TRACE_START, ticks);
+        put_varint(static_cast<unsigned long long>(node_id));
+        channel_occupied_ = true;
+    }
+
+    /**
+     * @brief Record that a node finished its transmission.
+     * 
+     * @param ticks The tick the last part of the packet was sent on.
+     * @param node_id The ID of the node.
+     * @param backoff The backoff of the next packet of the node.
+     */
+    void end(long long ticks, int node_id, int backoff) {
+        begin_record(TRACE_END, ticks);
+        put_varint(static_cast<unsigned long long>(node_id));
+        put_varint(static_cast<unsigned long long>(backoff));
+        channel_occupied_ = false;
+        idle_since_ = ticks + 1;
+    }
+
+    /**
+     * @brief Record a collision.
+     * 
+     * @param ticks The tick of the collision.
+     * @param node_ids The IDs of the colliding nodes, in ascending order.
+     */
+    void collision(long long ticks, const std::vector<int>& node_ids);
+
+    /**
+     * @brief Record that a node dropped its packet after a collision.
+     * 
+     * @param ticks The tick of the collision.
+     * @param node_id The ID of the node.
+     */
+    void drop(long long ticks, int node_id) {
+        begin_record(TRACE_DROP, ticks);
+        put_varint(static_cast<unsigned long long>(node_id));
+    }
+
+    /**
+     * @brief Record that every full repetition of a cycle was skipped.
+     * 
+     * @param ticks The tick on which the cycle was detected.
+     * @param period The length of the cycle in ticks.
+     * @param skipped_to_ticks The tick the simulation continues from.
+     */
+    void cycle(long long ticks, long long period, long long skipped_to_ticks);
+
+private:
+    /**
+     * @brief Record the idle stretch that ends before the given tick, if there is one.
+     * 
+     * @param ticks The tick on which the channel stops being idle.
+     */
+    void record_idle(long long ticks) {
+        if (ticks > idle_since_) {
+            begin_record(TRACE_IDLE, idle_since_);
+            put_varint(static_cast<unsigned long long>(ticks - idle_since_));
+        }
+    }
+
+    /**
+     * @brief Start a record, flushing the buffer first if it is nearly full.
+     * 
+     * @param type The type of the record.
+     * @param ticks The tick of the record.
+     */
+    void begin_record(TraceRecordType type, long long ticks) {
+        if (buffer_used_ > TRACE_BUFFER_SIZE - 64) {
+            flush();
+        }
+
+        buffer_[buffer_used_++] = static_cast<unsigned char>(type);
+        put_varint(static_cast<unsigned long long>(ticks - last_ticks_));
+        last_ticks_ = ticks;
+    }
+
+    /**
+     * @brief Append an unsigned LEB128 varint to the buffer, which must have room for
+     * the 10 bytes of the longest varint.
+     * 
+     * @param value The value to append.
+     */
+    void put_varint(unsigned long long value) {
+        while (value >= 0x80) {
+            buffer_[buffer_used_++] = static_cast<unsigned char>(value | 0x80);
+            value >>= 7;
+        }
+        buffer_[buffer_used_++] = static_cast<unsigned char>(value);
+    }
+
+    /**
+     * @brief Write the buffer to the file and empty it.
+     */
+    void flush();
+
+    std::FILE* file_;                   /**< The trace file, or null if not open. */
+    std::vector<unsigned char> buffer_; /**< The records not yet written to the file. */
+    size_t buffer_used_;                /**< The number of bytes of the buffer in use. */
+    long long last_ticks_;              /**< The tick of the last record. */
+    long long idle_since_;              /**< The first tick of the current idle stretch. */
+    bool channel_occupied_;             /**< Whether a transmission is in progress. */
+    bool failed_;                       /**< Whether a write to the file failed. */
+};
+
+/**
+ * @brief One record of a trace, with its tick decoded.
+*/
+struct TraceRecord {
+    TraceRecordType type;           /**< The type of the record. */
+    long long ticks;                /**< The tick of the record. */
+    long long value;                /**< 
+                                      * The idle ticks of TRACE_IDLE, the backoff of TRACE_END,
+                                      * the period of TRACE_CYCLE or the successful ticks of
+                                      * TRACE_END_OF_RUN.
+                                      */
+    long long skipped_ticks;        /**< The ticks skipped by TRACE_CYCLE. */
+    std::vector<int> node_ids;      /**< The node of TRACE_START, TRACE_END and TRACE_DROP, or the nodes of TRACE_COLLISION. */
+};
+
+/**
+ * @brief Reader of a binary trace.
+*/
+class TraceReader {
+public:
+    TraceReader();
+    ~TraceReader();
+
+    TraceReader(const TraceReader&) = delete;
+    TraceReader& operator=(const TraceReader&) = delete;
+
+    /**
+     * @brief Open a trace file and read its header.
+     * 
+     * @param filename The name of the trace file.
+     * @param error Set to a description of the problem if the file cannot be read.
+     * @return bool True if the file is a trace, false otherwise.
+     */
+    bool open(const std::string& filename, std::string& error);
+
+    /**
+     * @brief Read the next record.
+     * 
+     * @param record Set to the record that was read.
+     * @param error Set to a description of the problem if the trace is corrupt.
+     * @return bool True if a record was read, false at the end of the trace or on an error.
+     */
+    bool next(TraceRecord& record, std::string& error);
+
+    /**
+     * @brief Get the configuration of the traced simulation.
+     * 
+     * @return const SimulationConfig& The configuration in the header of the trace.
+     */
+    const SimulationConfig& config() const {
+        return config_;
+    }
+
+private:
+    /**
+     * @brief Read an unsigned LEB128 varint from the file.
+     * 
+     * @param value Set to the value that was read.
+     * @return bool True if a complete varint was read, false otherwise.
+     */
+    bool get_varint(unsigned long long& value);
+
+    std::FILE* file_;               /**< The trace file, or null if not open. */
+    SimulationConfig config_;       /**< The configuration in the header of the trace. */
+    long long last_ticks_;          /**< The tick of the last record read. */
+    bool finished_;                 /**< Whether the TRACE_END_OF_RUN record was read. */
+};
+
+#endif // TRACE_H
@@ -0,0 +1,169 @@
+/**
+ * @file traffic.h
+ * @brief The non-saturated traffic model, for --traffic.
+ *
+ * The simulation assumes that every node always has a packet to send. With
+ * --traffic, every node instead has a queue of packets that arrive over time,
+ * and only competes for the channel while its queue is not empty. The packets
+ * of a node arrive by one of these processes, given on an A line of the
+ * scenario in the input file:
+ *
+ *     A saturated                      a new packet as soon as the last one leaves, the default
+ *     A poisson 0.002                  a Poisson process of 0.002 packets per tick
+ *     A onoff 0.05 200 5000            bursts of 0.05 packets per tick, on for 200 and
+ *                                      off for 5000 ticks on average
+ *     A trace arrivals.txt             the ticks of a file of "<tick> <node>" lines
+ *
+ * A node line overrides the packet length, the R values or the arrival process
+ * of a node, or of an inclusive range of nodes:
+ *
+ *     node 0 L 8
+ *     node 1-3 R 2 4 8
+ *     node 4 A poisson 0.01
+ *
+ * The simulation is driven by two priority queues: the nodes that compete for
+ * the channel, keyed by the idle tick their backoff runs out on, and the next
+ * arrival of every node. A node with an empty queue is in neither, so it costs
+ * nothing until its next packet arrives, and the simulation jumps from one
+ * event to the next. With saturated traffic on every node, the results are
+ * exactly those of the simulation without --traffic.
+ *
+ * @author Vicky Chen (chen-vv)
+ * @author Eric Omielan (eomielan)
+ * @bug No known bugs.
+ */
+
+#ifndef TRAFFIC_H
+#define TRAFFIC_H
+
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+#include "csma.h"
+
+/**
+ * @brief The processes packets arrive by.
+*/
+enum ArrivalKind {
+    ARRIVAL_SATURATED,          /**< A new packet arrives as soon as the last one leaves the node. */
+    ARRIVAL_POISSON,            /**< Packets arrive at exponentially distributed intervals. */
+    ARRIVAL_ON_OFF,             /**< Poisson arrivals during on periods, none during off periods. */
+    ARRIVAL_TRACE               /**< Packets arrive on the ticks listed for the node in a file. */
+};
+
+/**
+ * @brief How the packets of a node arrive.
+*/
+struct ArrivalProcess {
+    ArrivalKind kind;           /**< The process. */
+    double rate;                /**< The mean number of packets per tick, while on. */
+    double mean_on_ticks;       /**< The mean length of an on period, in ticks. */
+    double mean_off_ticks;      /**< The mean length of an off period, in ticks. */
+    std::string trace_filename; /**< The file the arrival ticks are read from. */
+
+    /**
+     * @brief Construct saturated arrivals.
+     */
+    ArrivalProcess();
+};
+
+/**
+ * @brief An override of the parameters of a range of nodes.
+*/
+struct NodeTraffic {
+    int first_node;             /**< The first node of the range. */
+    int last_node;              /**< The last node of the range, inclusive. */
+    int packet_length;          /**< The packet length of the nodes, or 0 to keep L. */
+    std::vector<int> R;         /**< The R values of the nodes, or empty to keep R. */
+    bool has_arrivals;          /**< Whether the arrival process of the nodes is overridden. */
+    ArrivalProcess arrivals;    /**< The arrival process of the nodes, if it is overridden. */
+
+    /**
+     * @brief Construct an override of a range of nodes that does not change anything.
+     */
+    NodeTraffic();
+};
+
+/**
+ * @brief The traffic of a scenario, on top of its SimulationConfig.
+*/
+struct TrafficConfig {
+    ArrivalProcess arrivals;            /**< The arrival process of every node without an override. */
+    std::vector<NodeTraffic> nodes;     /**< The overrides of the nodes, later ones taking precedence. */
+};
+
+/**
+ * @brief The outcome of a simulation with non-saturated traffic.
+*/
+struct TrafficResults {
+    SimulationResults results;          /**< The successful ticks and the simulated ticks. */
+    long long packets_arrived;          /**< The packets that arrived before T. */
+    long long packets_delivered;        /**< The packets that were transmitted by T. */
+    long long packets_dropped;          /**< The packets dropped after too many collisions. */
+    long long offered_ticks;            /**< The ticks the packets that arrived would take to transmit. */
+    long double total_delay;            /**< The ticks from arrival to the end of transmission, over all delivered packets. */
+    long long max_delay;                /**< The longest delay of a delivered packet. */
+    long long max_queue_length;         /**< The most packets a node held at once. */
+};
+
+/**
+ * @brief Parse the rest of an A line, after the letter.
+ *
+ * @param words The words of the line after the letter.
+ * @param arrivals Set to the arrival process.
+ * @param error Set to a description of the problem if the line is malformed.
+ * @return bool True if the line is an arrival process, false otherwise.
+ */
+bool parse_arrival_process(const std::vector<std::string>& words, ArrivalProcess& arrivals, std::string& error);
+
+/**
+ * @brief Check that the traffic of a scenario fits its configuration.
+ *
+ * @param config The configuration of the scenario, which must be valid.
+ * @param traffic The traffic of the scenario.
+ * @param error Set to a description of the problem if the traffic is invalid.
+ * @return bool True if every override is of existing nodes and has valid values, false otherwise.
+ */
+bool validate_traffic(const SimulationConfig& config, const TrafficConfig& traffic, std::string& error);
+
+/**
+ * @brief Run a simulation with non-saturated traffic.
+ *
+ * @param config The configuration of the simulation, which must be valid.
+ * @param traffic The traffic of the simulation, which must be valid.
+ * @param options The backoff and window policies, the seed and the persistence.
+ * @param results Set to the results of the simulation.
+ * @param error Set to a description of the problem if an arrival trace cannot be read.
+ * @return bool True if the simulation ran, false otherwise.
+ */
+bool run_traffic_simulation(const SimulationConfig& config, const TrafficConfig& traffic,
+                            const SimulationOptions& options, TrafficResults& results, std::string& error);
+
+/**
+ * @brief Run the simulations of several scenarios with non-saturated traffic on a thread pool.
+ *
+ * @param configs The configurations of the scenarios, which must all be valid.
+ * @param traffic The traffic of each scenario, which must all be valid.
+ * @param options The backoff and window policies, the seed and the persistence.
+ * @param num_threads The number of worker threads, or 0 for one per hardware thread.
+ * @param results Set to the results of each scenario, in the same order.
+ * @param error Set to a description of the first problem if an arrival trace cannot be read.
+ * @return bool True if every simulation ran, false otherwise.
+ */
+bool run_traffic_scenarios(const std::vector<SimulationConfig>& configs, const std::vector<TrafficConfig>& traffic,
+                           const SimulationOptions& options, int num_threads, std::vector<TrafficResults>& results,
+                           std::string& error);
+
+/**
+ * @brief Write the results of scenarios with non-saturated traffic as a CSV table, one row per scenario.
+ *
+ * @param output The stream to write the table to.
+ * @param names The name of each scenario, or an empty name to number it instead.
+ * @param configs The configurations of the scenarios.
+ * @param results The results of the scenarios.
+ */
+void write_traffic_results(std::ostream& output, const std::vector<std::string>& names,
+                           const std::vector<SimulationConfig>& configs, const std::vector<TrafficResults>& results);
+
+#endif // TRAFFIC_H
@@ -0,0 +1,70 @@
+/**
+ * @file verify.h
+ * @brief Differential checks of the fast engines against the reference engine, for --verify and --stress.
+ *
+ * The reference engine visits every node on every tick, exactly as the simulation
+ * was originally designed, and every other engine must give the same answers.
+ * A check runs the reference engine and every other engine side by side on the
+ * same configuration and policies, and compares:
+ *
+ * - the complete state (every backoff and collision count, the channel and the
+ *   successful ticks) on VERIFY_NUM_CHECKS evenly spaced ticks, and at T
+ * - the number of transmissions, collisions and drops of every node at T
+ * - the results at T of cycle detection and of the batch engine, which keep no
+ *   state that can be compared along the way
+ *
+ * When the states first differ, both engines are taken back to the last tick on
+ * which they matched, and stepped one tick at a time to find the first tick they
+ * diverge on.
+ *
+ * A stress run checks random configurations and policies, with few nodes and
+ * short runs, small and large M and R lists of every length, so the corner
+ * cases such as dropped packets and the reuse of the last R value come up often.
+ *
+ * @author Vicky Chen (chen-vv)
+ * @author Eric Omielan (eomielan)
+ * @bug No known bugs.
+ */
+
+#ifndef VERIFY_H
+#define VERIFY_H
+
+#include <iosfwd>
+#include <string>
+
+#include "csma.h"
+
+/** @brief The number of evenly spaced ticks the states of the engines are compared on. */
+#define VERIFY_NUM_CHECKS 64
+
+/**
+ * @brief Check every engine against the reference engine on one configuration.
+ *
+ * @param config The parameters of the simulation, which must be valid.
+ * @param options The backoff and window policies, the seed and the persistence.
+ * @param mismatch Set to a description of the first difference, naming the engine and the tick.
+ * @return bool True if every engine matches the reference engine, false otherwise.
+ */
+bool verify_engines(const SimulationConfig& config, const SimulationOptions& options, std::string& mismatch);
+
+/**
+ * @brief Draw a random configuration and random policies for a stress run.
+ *
+ * @param seed The seed of the stress run.
+ * @param index The index of the configuration in the stress run.
+ * @param config Set to a valid configuration.
+ * @param options Set to random policies, a random seed and a random persistence.
+ */
+void random_verify_case(unsigned long long seed, long long index, SimulationConfig& config, SimulationOptions& options);
+
+/**
+ * @brief Check every engine against the reference engine on random configurations.
+ *
+ * @param seed The seed of the random configurations.
+ * @param num_cases The number of configurations to check.
+ * @param output The stream every mismatch is described on, with its configuration and policies.
+ * @return long long The number of configurations on which an engine did not match.
+ */
+long long run_stress(unsigned long long seed, long long num_cases, std::ostream& output);
+
+#endif // VERIFY_H
@@ -0,0 +1,434 @@
+/**
+ * @file input_file.cpp
+ * @brief Implementation of the input file parser.
+ *
+ * @author Vicky Chen (chen-vv)
+ * @author Eric Omielan (eomielan)
+ * @bug No known bugs.
+ */
+
+/* -- Includes -- */
+
+/* Standard library includes. */
+#include <algorithm>
+#include <climits>
+#include <fstream>
+
+/* Custom includes */
+#include "include/input_file.h"
+#include "include/traffic.h"
+
+/**
+ * @brief Check whether a character separates the tokens of a line.
+ *
+ * @param c The character.
+ * @return bool True for spaces, tabs and carriage returns.
+ */
+static inline bool is_blank(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+InputScanner::InputScanner(const std::string& contents)
+    : position_(contents.data()),
+      line_end_(contents.data()),
+      end_(contents.data() + contents.size()),
+      line_number_(0) {}
+
+bool InputScanner::next_line() {
+    if (line_number_ > 0) {
+        if (line_end_ == end_) {
+            return false;
+        }
+        // Step over the newline of the current line
+        line_end_++;
+    }
+
+    position_ = line_end_;
+    while (line_end_ != end_ && *line_end_ != '\n') {
+        line_end_++;
+    }
+
+    line_number_++;
+    return true;
+}
+
+bool InputScanner::next_token(InputToken& token) {
+    while (position_ != line_end_ && is_blank(*position_)) {
+        position_++;
+    }
+
+    if (position_ == line_end_) {
+        return false;
+    }
+
+    token.begin = position_;
+    while (position_ != line_end_ && !is_blank(*position_)) {
+        position_++;
+    }
+    token.end = position_;
+    return true;
+}
+
+bool parse_integer(const char*& position, const char* end, long long& value) {
+    const char* p = position;
+    bool negative = false;
+
+    if (p != end && *p == '-') {
+        negative = true;
+        p++;
+    }
+
+    if (p == end || *p < '0' || *p > '9') {
+        return false;
+    }
+
+    // Accumulate towards the limit of the sign, so that LLONG_MIN can be parsed too
+    unsigned long long limit = negative ? static_cast<unsigned long long>(LLONG_MAX) + 1 : LLONG_MAX;
+    unsigned long long magnitude = 0;
+
+    for (; p != end && *p >= '0' && *p <= '9'; p++) {
+        unsigned digit = static_cast<unsigned>(*p - '0');
+
+        if (magnitude > (limit - digit) / 10) {
+            return false;
+        }
+        magnitude = magnitude * 10 + digit;
+    }
+
+    value = negative ? static_cast<long long>(0 - magnitude) : static_cast<long long>(magnitude);
+    position = p;
+    return true;
+}
+
+int scan_header(InputScanner& scanner, const InputToken& token, InputToken& name, std::string& error) {
+    if (*token.begin != '[') {
+        return 0;
+    }
+
+    // The name may contain spaces, so the header ends with the last token of the line
+    InputToken last = token;
+    while (scanner.next_token(last)) {
+    }
+
+    if (last.end[-1] != ']' || last.end - 1 < token.begin + 1) {
+        error = "line " + std::to_string(scanner.line_number()) + ": header is not closed with ']'";
+        return -1;
+    }
+
+    name.begin = token.begin + 1;
+    name.end = last.end - 1;
+    while (name.begin != name.end && is_blank(*name.begin)) {
+        name.begin++;
+    }
+    while (name.begin != name.end && is_blank(name.end[-1])) {
+        name.end--;
+    }
+    return 1;
+}
+
+bool read_input_file(const std::string& filename, std::string& contents) {
+    std::ifstream input_file(filename, std::ios::binary | std::ios::ate);
+
+    if (!input_file.is_open()) {
+        return false;
+    }
+
+    std::streamoff size = input_file.tellg();
+    if (size < 0) {
+        return false;
+    }
+
+    contents.resize(static_cast<size_t>(size));
+    input_file.seekg(0);
+    return static_cast<bool>(input_file.read(&contents[0], size));
+}
+
+/**
+ * @brief Parse a token as the integer value of a parameter.
+ *
+ * @param token The token.
+ * @param min_value The smallest value the parameter can hold.
+ * @param max_value The largest value the parameter can hold.
+ * @param value Set to the value.
+ * @return bool True if the whole token is an integer within the limits, false otherwise.
+ */
+static bool parse_value(const InputToken& token, long long min_value, long long max_value, long long& value) {
+    const char* position = token.begin;
+    return parse_integer(position, token.end, value) && position == token.end &&
+           value >= min_value && value <= max_value;
+}
+
+/**
+ * @brief Finish the scenario being parsed, if it had any parameters.
+ *
+ * @param config The configuration of the scenario, reset to the defaults afterwards.
+ * @param scenario_traffic The traffic of the scenario, reset to the defaults afterwards.
+ * @param first_line The line the scenario started on, or 0 if it has no parameters yet.
+ * @param configs The configurations to append the scenario to.
+ * @param traffic If not null, the traffic to append the traffic of the scenario to.
+ * @param error Set to a description of the problem if the scenario is invalid.
+ * @return bool True if the scenario is valid or empty, false otherwise.
+ */
+static bool finish_scenario(SimulationConfig& config, TrafficConfig& scenario_traffic, int& first_line,
+                            std::vector<SimulationConfig>& configs, std::vector<TrafficConfig>* traffic,
+                            std::string& error) {
+    if (first_line == 0) {
+        return true;
+    }
+
+    std::string config_error;
+    if (!validate_config(config, config_error) ||
+        (traffic && !validate_traffic(config, scenario_traffic, config_error))) {
+        error = "scenario on line " + std::to_string(first_line) + ": " + config_error;
+        return false;
+    }
+
+    configs.push_back(std::move(config));
+    config = SimulationConfig();
+    if (traffic) {
+        traffic->push_back(std::move(scenario_traffic));
+    }
+    scenario_traffic = TrafficConfig();
+    first_line = 0;
+    return true;
+}
+
+/**
+ * @brief Parse the rest of a node line of the traffic of a scenario, after the word node.
+ *
+ * @param scanner The scanner, whose remaining tokens on the line are consumed.
+ * @param scenario_traffic The traffic of the scenario, which the override is added to.
+ * @param error Set to a description of the problem if the line is malformed.
+ * @return bool True if the line is a valid override, false otherwise.
+ */
+static bool parse_node_line(InputScanner& scanner, TrafficConfig& scenario_traffic, std::string& error) {
+    std::string line = "line " + std::to_string(scanner.line_number()) + ": ";
+    InputToken token;
+    NodeTraffic node;
+    long long first_node = 0;
+    long long last_node = 0;
+
+    // The nodes are a single ID or an inclusive range of IDs, as in "2-5"
+    if (!scanner.next_token(token)) {
+        error = line + "no nodes given";
+        return false;
+    }
+
+    const char* position = token.begin;
+    bool valid = parse_integer(position, token.end, first_node);
+    last_node = first_node;
+    if (valid && position != token.end) {
+        valid = *position++ == '-' && parse_integer(position, token.end, last_node) && position == token.end;
+    }
+
+    if (!valid || first_node < 0 || last_node < first_node || last_node > INT_MAX) {
+        error = line + "invalid nodes '" + token.str() + "'";
+        return false;
+    }
+    node.first_node = static_cast<int>(first_node);
+    node.last_node = static_cast<int>(last_node);
+
+    if (!scanner.next_token(token)) {
+        error = line + "no parameter given for the nodes";
+        return false;
+    }
+
+    char parameter = *token.begin++;
+    bool has_token = token.begin != token.end || scanner.next_token(token);
+    long long value = 0;
+
+    if (parameter != 'L' && parameter != 'R' && parameter != 'A') {
+        error = line + "unknown node parameter '" + parameter + "'";
+        return false;
+    }
+
+    if (!has_token) {
+        error = line + "no value given for " + parameter;
+        return false;
+    }
+
+    if (parameter == 'A') {
+        std::vector<std::string> words;
+        do {
+            words.push_back(token.str());
+        } while (scanner.next_token(token));
+
+        if (!parse_arrival_process(words, node.arrivals, error)) {
+            error = line + error;
+            return false;
+        }
+        node.has_arrivals = true;
+    } else {
+        do {
+            if (!parse_value(token, INT_MIN, INT_MAX, value)) {
+                error = line + "invalid value '" + token.str() + "' for " + parameter;
+                return false;
+            }
+
+            if (parameter == 'L') {
+                node.packet_length = static_cast<int>(value);
+            } else {
+                node.R.push_back(static_cast<int>(value));
+            }
+        } while (parameter == 'R' && scanner.next_token(token));
+
+        if (parameter == 'L' && scanner.next_token(token)) {
+            error = line + "L takes a single value";
+            return false;
+        }
+    }
+
+    scenario_traffic.nodes.push_back(std::move(node));
+    return true;
+}
+
+bool parse_scenarios(const std::string& contents, std::vector<SimulationConfig>& configs, std::string& error,
+                     std::vector<std::string>* names, std::vector<TrafficConfig>* traffic) {
+    configs.clear();
+    if (names) {
+        names->clear();
+    }
+    if (traffic) {
+        traffic->clear();
+    }
+
+    InputScanner scanner(contents);
+    SimulationConfig config;
+    TrafficConfig scenario_traffic;
+    InputToken name = {nullptr, nullptr};
+    int first_line = 0;
+    bool has_R = false;
+
+    while (scanner.next_line()) {
+        InputToken token;
+
+        // A blank line or a header ends the scenario before it
+        if (!scanner.next_token(token)) {
+            if (!finish_scenario(config, scenario_traffic, first_line, configs, traffic, error)) {
+                return false;
+            }
+            continue;
+        }
+
+        InputToken header_name;
+        int header = scan_header(scanner, token, header_name, error);
+        if (header != 0) {
+            if (header < 0 || !finish_scenario(config, scenario_traffic, first_line, configs, traffic, error)) {
+                return false;
+            }
+            name = header_name;
+            continue;
+        }
+
+        if (first_line == 0) {
+            // The scenario takes the name of the header before it, if any
+            first_line = scanner.line_number();
+            has_R = false;
+
+            if (names) {
+                names->push_back(name.begin ? name.str() : std::string());
+            }
+            name.begin = name.end = nullptr;
+        }
+
+        bool is_node_line = static_cast<size_t>(token.end - token.begin) == 4 && std::equal(token.begin, token.end, "node");
+
+        if (is_node_line || *token.begin == 'A') {
+            // The traffic of a scenario is only read where it is simulated
+            if (!traffic) {
+                error = "line " + std::to_string(scanner.line_number()) + ": " +
+                        (is_node_line ? "node lines" : "arrival processes") + " need --traffic";
+                return false;
+            }
+        }
+
+        if (is_node_line) {
+            if (!parse_node_line(scanner, scenario_traffic, error)) {
+                return false;
+            }
+            continue;
+        }
+
+        // The letter may be written right before its first value, as in "N4"
+        char parameter = *token.begin++;
+        bool has_token = token.begin != token.end || scanner.next_token(token);
+        long long value = 0;
+
+        if (parameter != 'N' && parameter != 'L' && parameter != 'M' && parameter != 'R' && parameter != 'T' &&
+            parameter != 'A') {
+            error = "line " + std::to_string(scanner.line_number()) + ": unknown parameter '" + parameter + "'";
+            return false;
+        }
+
+        if (!has_token) {
+            error = "line " + std::to_string(scanner.line_number()) + ": no value given for " + parameter;
+            return false;
+        }
+
+        switch (parameter) {
+            case 'A': {
+                std::vector<std::string> words;
+                do {
+                    words.push_back(token.str());
+                } while (scanner.next_token(token));
+
+                if (!parse_arrival_process(words, scenario_traffic.arrivals, error)) {
+                    error = "line " + std::to_string(scanner.line_number()) + ": " + error;
+                    return false;
+                }
+                break;
+            }
+
+            case 'N':
+            case 'L':
+            case 'M':
+            case 'T':
+                if (!parse_value(token, parameter == 'T' ? LLONG_MIN : INT_MIN, parameter == 'T' ? LLONG_MAX : INT_MAX, value)) {
+                    error = "line " + std::to_string(scanner.line_number()) + ": invalid value '" + token.str() + "' for " + parameter;
+                    return false;
+                }
+
+                if (scanner.next_token(token)) {
+                    error = "line " + std::to_string(scanner.line_number()) + ": " + parameter + " takes a single value";
+                    return false;
+                }
+
+                if (parameter == 'N') {
+                    config.num_nodes = static_cast<int>(value);
+                } else if (parameter == 'L') {
+                    config.packet_length = static_cast<int>(value);
+                } else if (parameter == 'M') {
+                    config.max_retransmission_attempt = static_cast<int>(value);
+                } else {
+                    config.total_simulation_time = value;
+                }
+                break;
+
+            case 'R':
+                if (!has_R) {
+                    config.R.clear();
+                    has_R = true;
+                }
+
+                do {
+                    if (!parse_value(token, INT_MIN, INT_MAX, value)) {
+                        error = "line " + std::to_string(scanner.line_number()) + ": invalid value '" + token.str() + "' for R";
+                        return false;
+                    }
+                    config.R.push_back(static_cast<int>(value));
+                } while (scanner.next_token(token));
+                break;
+        }
+    }
+
+    if (!finish_scenario(config, scenario_traffic, first_line, configs, traffic, error)) {
+        return false;
+    }
+
+    if (configs.empty()) {
+        error = "no scenario found";
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,171 @@
+/** 
+ * @file node_kernels.cpp
+ * @brief Vectorized kernels over node backoffs.
+ *
+ * This file contains the AVX2, SSE2 and scalar implementations of the
+ * kernels declared in node_kernels.h, and selects one of them from the
+ * features of the processor the program runs on. The AVX2 versions are
+ * compiled with a function target attribute, so the program does not
+ * need to be built for a specific processor.
+ *
+ * @author Vicky Chen (chen-vv)
+ * @author Eric Omielan (eomielan)
+ * @bug No known bugs.
+ */
+
+/* -- Includes -- */
+
+/* Standard library includes. */
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define NODE_KERNELS_X86 1
+#endif
+
+/* Custom includes */
+#include "include/csma.h"
+#include "include/node_kernels.h"
+
+static int count_ready_nodes_scalar(const int* backoffs, int num_nodes, int* first_ready_node_id) {
+    int num_ready_nodes = 0;
+
+    for (int node_id = num_nodes - 1; node_id >= 0; node_id--) {
+        if (backoffs[node_id] == READY_TO_TRANSMIT) {
+            *first_ready_node_id = node_id;
+            num_ready_nodes++;
+        }
+    }
+
+    return num_ready_nodes;
+}
+
+static void count_down_backoffs_scalar(int* backoffs, int num_nodes) {
+    for (int node_id = 0; node_id < num_nodes; node_id++) {
+        backoffs[node_id]--;
+    }
+}
+
+#ifdef NODE_KERNELS_X86
+
+static int count_ready_nodes_sse2(const int* backoffs, int num_nodes, int* first_ready_node_id) {
+    const __m128i ready = _mm_set1_epi32(READY_TO_TRANSMIT);
+    int num_ready_nodes = 0;
+    int node_id = 0;
+
+    for (; node_id + 4 <= num_nodes; node_id += 4) {
+        __m128i values = _mm_loadu_si128(reinterpret_cast<const __m128i*>(backoffs + node_id));
+        int mask = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(values, ready)));
+
+        if (mask != 0) {
+            if (num_ready_nodes == 0) {
+                *first_ready_node_id = node_id + __builtin_ctz(mask);
+            }
+            num_ready_nodes += __builtin_popcount(mask);
+        }
+    }
+
+    int first_tail_node_id = 0;
+    int num_tail_ready_nodes = count_ready_nodes_scalar(backoffs + node_id, num_nodes - node_id, &first_tail_node_id);
+
+    if (num_ready_nodes == 0 && num_tail_ready_nodes != 0) {
+        *first_ready_node_id = node_id + first_tail_node_id;
+    }
+
+    return num_ready_nodes + num_tail_ready_nodes;
+}
+
+static void count_down_backoffs_sse2(int* backoffs, int num_nodes) {
+    const __m128i one = _mm_set1_epi32(1);
+    int node_id = 0;
+
+    for (; node_id + 4 <= num_nodes; node_id += 4) {
+        __m128i* values = reinterpret_cast<__m128i*>(backoffs + node_id);
+        _mm_storeu_si128(values, _mm_sub_epi32(_mm_loadu_si128(values), one));
+    }
+
+    count_down_backoffs_scalar(backoffs + node_id, num_nodes - node_id);
+}
+
+__attribute__((target("avx2")))
+static int count_ready_nodes_avx2(const int* backoffs, int num_nodes, int* first_ready_node_id) {
+    const __m256i ready = _mm256_set1_epi32(READY_TO_TRANSMIT);
+    int num_ready_nodes = 0;
+    int node_id = 0;
+
+    for (; node_id + 8 <= num_nodes; node_id += 8) {
+        __m256i values = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(backoffs + node_id));
+        int mask = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(values, ready)));
+
+        if (mask != 0) {
+            if (num_ready_nodes == 0) {
+                *first_ready_node_id = node_id + __builtin_ctz(mask);
+            }
+            num_ready_nodes += __builtin_popcount(mask);
+        }
+    }
+
+    int first_tail_node_id = 0;
+    int num_tail_ready_nodes = count_ready_nodes_sse2(backoffs + node_id, num_nodes - node_id, &first_tail_node_id);
+
+    if (num_ready_nodes == 0 && num_tail_ready_nodes != 0) {
+        *first_ready_node_id = node_id + first_tail_node_id;
+    }
+
+    return num_ready_nodes + num_tail_ready_nodes;
+}
+
+__attribute__((target("avx2")))
+static void count_down_backoffs_avx2(int* backoffs, int num_nodes) {
+    const __m256i one = _mm256_set1_epi32(1);
+    int node_id = 0;
+
+    for (; node_id + 8 <= num_nodes; node_id += 8) {
+        __m256i* values = reinterpret_cast<__m256i*>(backoffs + node_id);
+        _mm256_storeu_si256(values, _mm256_sub_epi32(_mm256_loadu_si256(values), one));
+    }
+
+    count_down_backoffs_sse2(backoffs + node_id, num_nodes - node_id);
+}
+
+#endif // NODE_KERNELS_X86
+
+/**
+ * @brief The kernels for one instruction set.
+ */
+struct NodeKernels {
+    const char* instruction_set;
+    int (*count_ready_nodes)(const int*, int, int*);
+    void (*count_down_backoffs)(int*, int);
+};
+
+static const NodeKernels& select_node_kernels() {
+#ifdef NODE_KERNELS_X86
+    static const NodeKernels avx2 = {"avx2", count_ready_nodes_avx2, count_down_backoffs_avx2};
+    static const NodeKernels sse2 = {"sse2", count_ready_nodes_sse2, count_down_backoffs_sse2};
+
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return avx2;
+    }
+    return sse2;
+#else
+    static const NodeKernels scalar = {"scalar", count_ready_nodes_scalar, count_down_backoffs_scalar};
+    return scalar;
+#endif
+}
+
+static const NodeKernels& node_kernels() {
+    static const NodeKernels& kernels = select_node_kernels();
+    return kernels;
+}
+
+int count_ready_nodes(const int* backoffs, int num_nodes, int* first_ready_node_id) {
+    return node_kernels().count_ready_nodes(backoffs, num_nodes, first_ready_node_id);
+}
+
+void count_down_backoffs(int* backoffs, int num_nodes) {
+    node_kernels().count_down_backoffs(backoffs, num_nodes);
+}
+
+const char* node_kernels_instruction_set() {
+    return node_kernels().instruction_set;
+}
@@ -0,0 +1,82 @@
+/** 
+ * @file node_stats.cpp
+ * @brief Implementation of the per-node statistics.
+ *
+ * @author Vicky Chen (chen-vv)
+ * @author Eric Omielan (eomielan)
+ * @bug No known bugs.
+ */
+
+/* -- Includes -- */
+
+/* Standard library includes. */
+#include <cstring>
+#include <iostream>
+
+/* Custom includes */
+#include "include/csma.h"
+#include "include/node_stats.h"
+
+void NodeStatistics::reset(int num_nodes) {
+    NodeStats empty;
+    std::memset(&empty, 0, sizeof(empty));
+
+    nodes_.assign(num_nodes, empty);
+    saved_nodes_.clear();
+}
+
+void NodeStatistics::skip_cycle(long long repetitions, long long skipped_ticks) {
+    for (size_t node_id = 0; node_id < nodes_.size(); node_id++) {
+        NodeStats& node = nodes_[node_id];
+        const NodeStats& saved = saved_nodes_[node_id];
+
+        bool had_events = node.transmissions != saved.transmissions || node.drops != saved.drops;
+
+        node.transmissions += repetitions * (node.transmissions - saved.transmissions);
+        node.collisions += repetitions * (node.collisions - saved.collisions);
+        node.drops += repetitions * (node.drops - saved.drops);
+        node.total_delay += repetitions * (node.total_delay - saved.total_delay);
+
+        // A node that sent or dropped nothing in the cycle keeps waiting for the same packet
+        if (had_events) {
+            node.head_of_line_tick += skipped_ticks;
+        }
+
+        for (int bin = 0; bin < NODE_STATS_DELAY_BINS; bin++) {
+            unsigned long long count = node.delay_bins[bin] +
+                                       static_cast<unsigned long long>(repetitions) * (node.delay_bins[bin] - saved.delay_bins[bin]);
+            node.delay_bins[bin] = count < UINT_MAX ? static_cast<unsigned int>(count) : UINT_MAX;
+        }
+    }
+}
+
+void write_node_statistics(std::ostream& output, const NodeStatistics& statistics) {
+    output << "node,transmissions,collisions,drops,mean_delay";
+
+    // Name each bin after the range of delays it counts
+    for (int bin = 0; bin < NODE_STATS_DELAY_BINS; bin++) {
+        long long low = bin == 0 ? 0 : 1LL << (bin - 1);
+        long long high = bin == 0 ? 0 : (1LL << bin) - 1;
+
+        output << ",delay_" << low;
+        if (bin == NODE_STATS_DELAY_BINS - 1) {
+            output << "+";
+        } else if (high != low) {
+            output << "_" << high;
+        }
+    }
+    output << '\n';
+
+    const std::vector<NodeStats>& nodes = statistics.nodes();
+    for (size_t node_id = 0; node_id < nodes.size(); node_id++) {
+        const NodeStats& node = nodes[node_id];
+
+        output << node_id << ',' << node.transmissions << ',' << node.collisions << ',' << node.drops << ','
+               << format_ratio(node.total_delay, node.transmissions, 3);
+
+        for (int bin = 0; bin < NODE_STATS_DELAY_BINS; bin++) {
+            output << ',' << node.delay_bins[bin];
+        }
+        output << '\n';
+    }
+}
@@ -0,0 +1,96 @@
+/** 
+ * @file profile.cpp
+ * @brief Implementation of the --profile report.
+ *
+ * @author Vicky Chen (chen-vv)
+ * @author Eric Omielan (eomielan)
+ * @bug No known bugs.
+ */
+
+/* -- Includes -- */
+
+/* Standard library includes. */
+#include <iomanip>
+#include <iostream>
+
+/* Custom includes */
+#include "include/profile.h"
+
+SimulationProfile::SimulationProfile()
+    : busy_ticks(0),
+      idle_ticks(0),
+      single_ready_ticks(0),
+      collision_ticks(0),
+      skipped_ticks(0),
+      ready_lookup_cycles(0),
+      idle_countdown_cycles(0),
+      collision_cycles(0),
+      output_cycles(0),
+      total_cycles(0),
+      total_seconds(0) {}
+
+bool profiling_available() {
+#ifdef CSMA_PROFILE
+    return true;
+#else
+    return false;
+#endif
+}
+
+/**
+ * @brief Write one line of the tick counts.
+ * 
+ * @param output The stream to write the line to.
+ * @param name The name of the case.
+ * @param ticks The number of ticks of the case.
+ * @param total_ticks The number of ticks of the run.
+ */
+static void write_tick_line(std::ostream& output, const char* name, long long ticks, long long total_ticks) {
+    output << "  " << std::left << std::setw(28) << name << std::right << std::setw(20) << ticks << "  "
+           << std::setw(7) << (total_ticks ? 100.0 * ticks / total_ticks : 0.0) << "%\n";
+}
+
+/**
+ * @brief Write one line of the phase times.
+ * 
+ * @param output The stream to write the line to.
+ * @param name The name of the phase.
+ * @param cycles The clock cycles spent in the phase.
+ * @param profile The profile, which gives the length of a clock cycle.
+ */
+static void write_time_line(std::ostream& output, const char* name, unsigned long long cycles,
+                            const SimulationProfile& profile) {
+    double fraction = profile.total_cycles ? static_cast<double>(cycles) / profile.total_cycles : 0.0;
+
+    output << "  " << std::left << std::setw(28) << name << std::right << std::setw(18)
+           << std::setprecision(6) << fraction * profile.total_seconds << " s  "
+           << std::setprecision(2) << std::setw(7) << 100.0 * fraction << "%\n";
+}
+
+void write_profile(std::ostream& output, const SimulationProfile& profile) {
+    long long total_ticks = profile.busy_ticks + profile.idle_ticks + profile.single_ready_ticks +
+                            profile.collision_ticks + profile.skipped_ticks;
+    unsigned long long phase_cycles = profile.ready_lookup_cycles + profile.idle_countdown_cycles +
+                                      profile.collision_cycles + profile.output_cycles;
+    std::ios::fmtflags flags = output.flags();
+    std::streamsize precision = output.precision();
+
+    output << std::fixed << std::setprecision(2);
+    output << "Profile: " << total_ticks << " ticks\n";
+    write_tick_line(output, "Busy", profile.busy_ticks, total_ticks);
+    write_tick_line(output, "Idle", profile.idle_ticks, total_ticks);
+    write_tick_line(output, "Single ready", profile.single_ready_ticks, total_ticks);
+    write_tick_line(output, "Collision", profile.collision_ticks, total_ticks);
+    write_tick_line(output, "Skipped by cycle detection", profile.skipped_ticks, total_ticks);
+
+    output << "Profile: " << std::setprecision(6) << profile.total_seconds << " s\n";
+    write_time_line(output, "Ready lookup", profile.ready_lookup_cycles, profile);
+    write_time_line(output, "Idle countdown", profile.idle_countdown_cycles, profile);
+    write_time_line(output, "Collision handling", profile.collision_cycles, profile);
+    write_time_line(output, "Output", profile.output_cycles, profile);
+    write_time_line(output, "Rest of the loop",
+                    profile.total_cycles > phase_cycles ? profile.total_cycles - phase_cycles : 0, profile);
+
+    output.flags(flags);
+    output.precision(precision);
+}
@@ -0,0 +1,144 @@
+/** 
+ * @file replication.cpp
+ * @brief Implementation of the Monte Carlo replications.
+ *
+ * @author Vicky Chen (chen-vv)
+ * @author Eric Omielan (eomielan)
+ * @bug No known bugs.
+ */
+
+/* -- Includes -- */
+
+/* Standard library includes. */
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+/* Custom includes */
+#include "include/replication.h"
+#include "include/thread_pool.h"
+
+/** @brief The 97.5% quantiles of Student's t distribution for 1 to 30 degrees of freedom. */
+static const double STUDENT_T_975[] = {
+    12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+    2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+    2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+};
+
+unsigned long long replica_seed(unsigned long long seed, long long replica) {
+    // Node IDs are never negative, so the streams of the replicas never meet the backoff draws
+    return random_bits(seed, -1, replica);
+}
+
+double student_t_975(long long degrees_of_freedom) {
+    if (degrees_of_freedom <= 30) {
+        return STUDENT_T_975[std::max(degrees_of_freedom, 1LL) - 1];
+    }
+
+    // Cornish-Fisher expansion around the normal quantile, accurate to 1e-4 beyond 30
+    double z = 1.959964;
+    double n = static_cast<double>(degrees_of_freedom);
+    return z + (z * z * z + z) / (4 * n) + (5 * std::pow(z, 5) + 16 * z * z * z + 3 * z) / (96 * n * n);
+}
+
+/**
+ * @brief Summarize the first replicas, in order of their index.
+ * 
+ * @param utilizations The utilization of every replica.
+ * @param count The number of replicas to summarize.
+ * @return ReplicationSummary The summary of the replicas.
+ */
+static ReplicationSummary summarize(const std::vector<double>& utilizations, long long count) {
+    ReplicationSummary summary;
+    summary.num_replications = count;
+    summary.mean = 0;
+    summary.variance = 0;
+    summary.ci_half_width = 0;
+
+    // Welford's algorithm, which stays accurate when the replicas barely differ
+    double sum_of_squares = 0;
+    for (long long i = 0; i < count; i++) {
+        double delta = utilizations[i] - summary.mean;
+        summary.mean += delta / (i + 1);
+        sum_of_squares += delta * (utilizations[i] - summary.mean);
+    }
+
+    if (count > 1) {
+        summary.variance = sum_of_squares / (count - 1);
+        summary.ci_half_width = student_t_975(count - 1) * std::sqrt(summary.variance / count);
+    }
+
+    return summary;
+}
+
+ReplicationSummary run_replications(const SimulationConfig& config, SimulationOptions options,
+                                    long long max_replications, double max_ci_width, int num_threads) {
+    options.log_level = LOG_OFF;
+    options.trace_writer = nullptr;
+    options.node_statistics = nullptr;
+    options.profile = nullptr;
+    options.checkpoint_writer = nullptr;
+    options.resume_snapshot = nullptr;
+    options.report = nullptr;
+    options.async_log = nullptr;
+    std::vector<double> utilizations;
+    utilizations.reserve(static_cast<size_t>(std::min<long long>(max_replications, 1 << 20)));
+
+    if (num_threads <= 0) {
+        num_threads = static_cast<int>(std::thread::hardware_concurrency());
+    }
+    ThreadPool pool(static_cast<int>(std::max(1LL, std::min<long long>(num_threads, max_replications))));
+
+    // Without a stopping criterion every replica is submitted at once, otherwise a few per worker at a time
+    long long batch_size = max_replications;
+    if (max_ci_width > 0) {
+        batch_size = (4 * pool.size() + REPLICATION_CHECK_INTERVAL - 1) / REPLICATION_CHECK_INTERVAL * REPLICATION_CHECK_INTERVAL;
+    }
+
+    long long num_checked = 0;
+
+    while (static_cast<long long>(utilizations.size()) < max_replications) {
+        long long first = static_cast<long long>(utilizations.size());
+        long long last = std::min(first + batch_size, max_replications);
+        utilizations.resize(static_cast<size_t>(last));
+
+        for (long long replica = first; replica < last; replica++) {
+            pool.submit([&config, &options, &utilizations, replica] {
+                SimulationOptions replica_options = options;
+                replica_options.seed = replica_seed(options.seed, replica);
+                SimulationResults results = run_simulation(config, replica_options);
+
+                // A run of T = 0 has no ticks, and is written as 0.00 like a single run
+                utilizations[replica] = results.total_simulation_time > 0 ? results.utilization() : 0.0;
+            });
+        }
+
+        pool.wait();
+
+        if (max_ci_width <= 0) {
+            continue;
+        }
+
+        // Only the checkpoints decide when to stop, so the result is the same with any batch size
+        while (num_checked + REPLICATION_CHECK_INTERVAL <= last) {
+            num_checked += REPLICATION_CHECK_INTERVAL;
+            ReplicationSummary summary = summarize(utilizations, num_checked);
+
+            if (2 * summary.ci_half_width < max_ci_width) {
+                return summary;
+            }
+        }
+    }
+
+    return summarize(utilizations, max_replications);
+}
+
+void write_replication_summary(std::ostream& output, const ReplicationSummary& summary) {
+    output << "replications,mean,variance,ci_low,ci_high" << std::endl;
+    output << summary.num_replications << std::fixed << std::setprecision(6) << ','
+           << summary.mean << ',' << std::scientific << summary.variance << std::fixed << ','
+           << summary.mean - summary.ci_half_width << ',' << summary.mean + summary.ci_half_width << std::endl;
+}
@@ -0,0 +1,173 @@
+/**
+ * @file report.cpp
+ * @brief Implementation of the streaming utilization report.
+ *
+ * @author Vicky Chen (chen-vv)
+ * @author Eric Omielan (eomielan)
+ * @bug No known bugs.
+ */
+
+/* -- Includes -- */
+
+/* Standard library includes. */
+#include <algorithm>
+#include <chrono>
+
+/* Custom includes */
+#include "include/csma.h"
+#include "include/report.h"
+
+UtilizationReport::UtilizationReport()
+    : file_(nullptr),
+      owns_file_(false),
+      interval_(1),
+      transmission_start_(0),
+      transmission_end_(0),
+      ring_(REPORT_RING_CAPACITY),
+      closing_(false),
+      failed_(false),
+      collecting_(false) {
+    window_.start_tick = 0;
+    window_.end_tick = LLONG_MAX;
+    window_.successful_ticks = 0;
+    window_.collisions = 0;
+    window_.drops = 0;
+}
+
+UtilizationReport::~UtilizationReport() {
+    if (file_ || collecting_) {
+        close(window_.start_tick);
+    }
+}
+
+bool UtilizationReport::open(const std::string& filename, long long interval) {
+    if (filename == "-") {
+        file_ = stdout;
+        owns_file_ = false;
+    } else {
+        file_ = std::fopen(filename.c_str(), "w");
+        owns_file_ = true;
+    }
+
+    if (!file_) {
+        return false;
+    }
+
+    interval_ = interval;
+    window_.end_tick = interval;
+    thread_ = std::thread(&UtilizationReport::write_windows, this);
+    return true;
+}
+
+void UtilizationReport::collect(long long interval) {
+    collecting_ = true;
+    collected_.clear();
+    interval_ = interval;
+    window_.end_tick = interval;
+}
+
+bool UtilizationReport::close(long long total_simulation_time) {
+    complete_windows(total_simulation_time - 1);
+
+    if (window_.start_tick < total_simulation_time) {
+        // The last window is cut short by the end of the run
+        window_.end_tick = total_simulation_time;
+        complete_window();
+    }
+
+    if (collecting_) {
+        collecting_ = false;
+        return true;
+    }
+
+    // Only the end of the run waits for the writing thread
+    while (!backlog_.empty()) {
+        if (ring_.try_push(backlog_.front())) {
+            backlog_.pop_front();
+        } else {
+            std::this_thread::yield();
+        }
+    }
+
+    closing_.store(true, std::memory_order_release);
+    thread_.join();
+
+    if (owns_file_ && std::fclose(file_) != 0) {
+        failed_ = true;
+    }
+    file_ = nullptr;
+    return !failed_;
+}
+
+void UtilizationReport::credit_transmission() {
+    long long start = std::max(transmission_start_, window_.start_tick);
+    long long end = std::min(transmission_end_, window_.end_tick);
+
+    if (end > start) {
+        window_.successful_ticks += end - start;
+    }
+}
+
+void UtilizationReport::complete_window() {
+    credit_transmission();
+
+    if (collecting_) {
+        collected_.push_back(window_);
+    } else {
+        // Keep the order of the windows if the writing thread fell behind
+        while (!backlog_.empty() && ring_.try_push(backlog_.front())) {
+            backlog_.pop_front();
+        }
+        if (!backlog_.empty() || !ring_.try_push(window_)) {
+            backlog_.push_back(window_);
+        }
+    }
+
+    window_.start_tick = window_.end_tick;
+    window_.end_tick = interval_ > LLONG_MAX - window_.start_tick ? LLONG_MAX : window_.start_tick + interval_;
+    window_.successful_ticks = 0;
+    window_.collisions = 0;
+    window_.drops = 0;
+}
+
+void UtilizationReport::write_windows() {
+    UtilizationWindow total = {0, 0, 0, 0, 0};
+    UtilizationWindow window;
+
+    if (std::fputs("window_start,window_end,successful_ticks,utilization,collisions,drops,"
+                   "total_successful_ticks,total_utilization,total_collisions,total_drops\n", file_) < 0) {
+        failed_ = true;
+    }
+
+    for (;;) {
+        // Every window is in the ring before closing_ is set, so one more pass drains them all
+        bool closing = closing_.load(std::memory_order_acquire);
+
+        while (ring_.try_pop(window)) {
+            total.end_tick = window.end_tick;
+            total.successful_ticks += window.successful_ticks;
+            total.collisions += window.collisions;
+            total.drops += window.drops;
+
+            std::string utilization = format_ratio(window.successful_ticks, window.end_tick - window.start_tick, 6);
+            std::string total_utilization = format_ratio(total.successful_ticks, total.end_tick, 6);
+
+            if (std::fprintf(file_, "%lld,%lld,%lld,%s,%lld,%lld,%lld,%s,%lld,%lld\n", window.start_tick,
+                             window.end_tick, window.successful_ticks, utilization.c_str(), window.collisions,
+                             window.drops, total.successful_ticks, total_utilization.c_str(), total.collisions,
+                             total.drops) < 0) {
+                failed_ = true;
+            }
+        }
+
+        // Flush every batch, so that a reader of a pipe sees the windows as they complete
+        if (std::fflush(file_) != 0) {
+            failed_ = true;
+        }
+
+        if (closing) {
+            break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
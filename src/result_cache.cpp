@@ -0,0 +1,114 @@
+/**
+ * @file result_cache.cpp
+ * @brief Implementation of the on-disk result cache.
+ *
+ * @author Vicky Chen (chen-vv)
+ * @author Eric Omielan (eomielan)
+ * @bug No known bugs.
+ */
+
+/* -- Includes -- */
+
+/* Standard library includes. */
+#include <cerrno>
+#include <cinttypes>
+#include <cstdio>
+#include <dirent.h>
+#include <sys/stat.h>
+
+/* Custom includes */
+#include "include/checkpoint.h"
+#include "include/result_cache.h"
+
+ResultCache::ResultCache()
+    : num_reused_(0),
+      num_extended_(0),
+      num_simulated_(0) {}
+
+bool ResultCache::open(const std::string& directory) {
+    directory_ = directory;
+    entries_.clear();
+
+    if (mkdir(directory.c_str(), 0777) != 0 && errno != EEXIST) {
+        return false;
+    }
+
+    DIR* listing = opendir(directory.c_str());
+    if (!listing) {
+        return false;
+    }
+
+    // Only the names of the entries are read here, their contents are checked on lookup
+    while (struct dirent* entry = readdir(listing)) {
+        uint64_t fingerprint;
+        long long ticks;
+        int length = 0;
+
+        if (std::sscanf(entry->d_name, "%16" SCNx64 "-%lld.checkpoint%n", &fingerprint, &ticks, &length) == 2 &&
+            entry->d_name[length] == '\0' && length > 0 && ticks >= 0 &&
+            entry_filename(fingerprint, ticks) == directory_ + "/" + entry->d_name) {
+            entries_[fingerprint].insert(ticks);
+        }
+    }
+
+    closedir(listing);
+    return true;
+}
+
+std::string ResultCache::entry_filename(uint64_t fingerprint, long long ticks) const {
+    char name[64];
+    std::snprintf(name, sizeof(name), "%016" PRIx64 "-%lld.checkpoint", fingerprint, ticks);
+    return directory_ + "/" + name;
+}
+
+bool ResultCache::lookup(const SimulationConfig& config, const SimulationOptions& options,
+                         SimulationSnapshot& snapshot) {
+    uint64_t fingerprint = checkpoint_fingerprint(config, options);
+
+    for (;;) {
+        long long ticks;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+
+            std::map<uint64_t, std::set<long long>>::iterator entry = entries_.find(fingerprint);
+            if (entry == entries_.end()) {
+                return false;
+            }
+
+            // The longest run that is not longer than this one
+            std::set<long long>::iterator longest = entry->second.upper_bound(config.total_simulation_time);
+            if (longest == entry->second.begin()) {
+                return false;
+            }
+            ticks = *--longest;
+        }
+
+        std::string error;
+        if (read_checkpoint(entry_filename(fingerprint, ticks), fingerprint, config.num_nodes, snapshot, error) &&
+            snapshot.current_tick == ticks) {
+            return true;
+        }
+
+        // A damaged entry is forgotten, so the next longest one is tried, and the run stores a new one
+        std::lock_guard<std::mutex> lock(mutex_);
+        entries_[fingerprint].erase(ticks);
+    }
+}
+
+void ResultCache::store(const SimulationConfig& config, const SimulationOptions& options,
+                        const SimulationSnapshot& snapshot) {
+    uint64_t fingerprint = checkpoint_fingerprint(config, options);
+    {
+        // The workers of a sweep that run the same point write its entry only once
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!entries_[fingerprint].insert(snapshot.current_tick).second) {
+            return;
+        }
+    }
+
+    if (!write_checkpoint(entry_filename(fingerprint, snapshot.current_tick), snapshot, fingerprint)) {
+        // The cache only saves time, so a run does not fail if its entry cannot be written
+        std::lock_guard<std::mutex> lock(mutex_);
+        entries_[fingerprint].erase(snapshot.current_tick);
+    }
+}
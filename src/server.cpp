@@ -0,0 +1,468 @@
+/**
+ * @file server.cpp
+ * @brief Implementation of the simulation server.
+ *
+ * @author Vicky Chen (chen-vv)
+ * @author Eric Omielan (eomielan)
+ * @bug No known bugs.
+ */
+
+/* -- Includes -- */
+
+/* Standard library includes. */
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <csignal>
+#include <cstring>
+#include <deque>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+/* Custom includes */
+#include "include/input_file.h"
+#include "include/result_cache.h"
+#include "include/server.h"
+#include "include/stream_connection.h"
+#include "include/thread_pool.h"
+
+/**
+ * @brief Split a request line into its id and its scenario.
+ *
+ * @param connection The connection, which the scenario of a length-prefixed request is read from.
+ * @param line The request line.
+ * @param id Set to the id of the request.
+ * @param contents Set to the scenario of the request, as the contents of an input file.
+ * @param error Set to a description of the problem if the request is malformed.
+ * @return int 1 if the request was read, 0 if it is malformed but the next request can
+ * still be read, -1 if the rest of the stream cannot be read as requests.
+ */
+static int read_request(StreamConnection& connection, const std::string& line, std::string& id,
+                        std::string& contents, std::string& error) {
+    size_t id_begin = line.find_first_not_of(" \t\r");
+    size_t id_end = line.find_first_of(" \t\r", id_begin);
+    id = line.substr(id_begin, id_end - id_begin);
+
+    size_t scenario_begin = id_end == std::string::npos ? std::string::npos : line.find_first_not_of(" \t\r", id_end);
+
+    if (scenario_begin == std::string::npos) {
+        error = "request without a scenario";
+        return 0;
+    }
+
+    if (line[scenario_begin] != '+') {
+        contents = line.substr(scenario_begin);
+
+        // The semicolons separate the lines of the scenario
+        for (char& c : contents) {
+            if (c == ';') {
+                c = '\n';
+            }
+        }
+        return 1;
+    }
+
+    const char* position = line.data() + scenario_begin + 1;
+    const char* end = line.data() + line.find_last_not_of(" \t\r") + 1;
+    long long num_bytes;
+
+    if (!parse_integer(position, end, num_bytes) || position != end || num_bytes < 0 ||
+        num_bytes > SERVER_MAX_REQUEST_BYTES) {
+        // Without its length, the end of the scenario, and so the next request, is unknown
+        error = "invalid request length '" + line.substr(scenario_begin + 1) + "'";
+        return -1;
+    }
+
+    if (!connection.read_bytes(static_cast<size_t>(num_bytes), contents)) {
+        error = "request shorter than its length";
+        return -1;
+    }
+
+    return 1;
+}
+
+/**
+ * @brief The answers of one connection, written by a thread of their own.
+ *
+ * The workers of the pool only queue the answers, so a client that sends requests
+ * but does not read its answers only blocks its own writer, and never a worker.
+ * Once SERVER_MAX_PENDING_ANSWERS of its requests are unanswered or unwritten, it
+ * is its reader that waits before taking in the next request.
+*/
+class AnswerWriter {
+public:
+    /**
+     * @brief Start the writer of a connection.
+     *
+     * @param connection The connection the answers are written to.
+     */
+    explicit AnswerWriter(const std::shared_ptr<StreamConnection>& connection)
+        : connection_(connection),
+          num_pending_(0),
+          finished_(false),
+          thread_(&AnswerWriter::write_answers, this) {}
+
+    AnswerWriter(const AnswerWriter&) = delete;
+    AnswerWriter& operator=(const AnswerWriter&) = delete;
+
+    /**
+     * @brief Make room for the answer of one more request, waiting while too many are pending.
+     */
+    void reserve() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        room_.wait(lock, [this] { return num_pending_ < SERVER_MAX_PENDING_ANSWERS; });
+        num_pending_++;
+    }
+
+    /**
+     * @brief Queue the answer of a request that was reserved, without waiting on the connection.
+     *
+     * @param line The answer, without its newline.
+     */
+    void push(std::string line) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        answers_.push_back(std::move(line));
+        ready_.notify_one();
+    }
+
+    /**
+     * @brief Wait until every reserved answer is written, and stop the writer.
+     */
+    void finish() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            finished_ = true;
+            ready_.notify_one();
+        }
+        thread_.join();
+    }
+
+private:
+    /**
+     * @brief Write the queued answers in order, until the writer is finished and none is pending.
+     */
+    void write_answers() {
+        std::unique_lock<std::mutex> lock(mutex_);
+
+        for (;;) {
+            ready_.wait(lock, [this] { return !answers_.empty() || (finished_ && num_pending_ == 0); });
+            if (answers_.empty()) {
+                return;
+            }
+
+            std::string line = std::move(answers_.front());
+            answers_.pop_front();
+
+            lock.unlock();
+            connection_->write_line(std::move(line));
+            lock.lock();
+
+            num_pending_--;
+            room_.notify_one();
+        }
+    }
+
+    std::shared_ptr<StreamConnection> connection_;  /**< The connection the answers are written to. */
+    std::mutex mutex_;                              /**< Guards the queue and the counts. */
+    std::condition_variable ready_;                 /**< Signalled when an answer is queued or the writer is finished. */
+    std::condition_variable room_;                  /**< Signalled when an answer is written. */
+    std::deque<std::string> answers_;               /**< The answers not yet written. */
+    long long num_pending_;                         /**< The reserved answers not yet written. */
+    bool finished_;                                 /**< Whether no more answers will be reserved. */
+    std::thread thread_;                            /**< The writing thread, started last. */
+};
+
+/**
+ * @brief Answers requests on a thread pool whose workers each keep a simulation between requests.
+ *
+ * @tparam SimulationType The instantiation of BasicSimulation with the selected policies.
+*/
+template <typename SimulationType>
+class SimulationServer {
+public:
+    /**
+     * @brief Construct a server over a thread pool.
+     *
+     * @param options The options used for every request, without any logging or observers.
+     * @param pool The thread pool the requests are run on.
+     */
+    SimulationServer(const SimulationOptions& options, ThreadPool& pool)
+        : options_(options),
+          pool_(pool),
+          simulations_(pool.size()) {}
+
+    /**
+     * @brief Read the requests of a connection until its stream ends, and submit each of them.
+     *
+     * The answers go through a writer of the connection, and every one of them is
+     * written on return.
+     *
+     * @param connection The connection.
+     */
+    void read_requests(const std::shared_ptr<StreamConnection>& connection) {
+        std::shared_ptr<AnswerWriter> writer(new AnswerWriter(connection));
+        std::string line;
+
+        while (connection->read_line(line)) {
+            if (line.find_first_not_of(" \t\r") == std::string::npos) {
+                continue;
+            }
+
+            std::string id;
+            std::string contents;
+            std::string error;
+            int status = read_request(*connection, line, id, contents, error);
+            writer->reserve();
+
+            if (status <= 0) {
+                writer->push(id + " error " + error);
+
+                if (status < 0) {
+                    break;
+                }
+                continue;
+            }
+
+            pool_.submit([this, writer, id, contents] {
+                writer->push(id + " " + answer(contents));
+            });
+        }
+
+        writer->finish();
+    }
+
+private:
+    /**
+     * @brief Parse and run the scenario of a request on the calling worker.
+     *
+     * @param contents The scenario, as the contents of an input file.
+     * @return std::string The answer, without the id of the request.
+     */
+    std::string answer(const std::string& contents) {
+        std::vector<SimulationConfig> configs;
+        std::string error;
+
+        if (!parse_scenarios(contents, configs, error)) {
+            return "error " + error;
+        }
+
+        if (configs.size() != 1) {
+            return "error request with " + std::to_string(configs.size()) + " scenarios";
+        }
+
+        std::unique_ptr<SimulationType>& simulation = simulations_[ThreadPool::current_worker_index()];
+
+        if (!simulation) {
+            simulation.reset(new SimulationType(configs[0], options_));
+        } else {
+            simulation->reset(configs[0]);
+        }
+
+        SimulationResults results = options_.result_cache ? run_through_cache(*simulation, *options_.result_cache)
+                                                          : simulation->run();
+
+        return "ok " + std::to_string(results.num_successful_transmission_ticks) + " " +
+               std::to_string(results.total_simulation_time) + " " +
+               format_ratio(results.num_successful_transmission_ticks, results.total_simulation_time, 6);
+    }
+
+    const SimulationOptions& options_;                          /**< The options of every request. */
+    ThreadPool& pool_;                                          /**< The pool the requests run on. */
+    std::vector<std::unique_ptr<SimulationType>> simulations_;  /**< The simulation of each worker. */
+};
+
+/**
+ * @brief A thread reading the requests of one connection.
+*/
+struct ConnectionReader {
+    std::thread thread;         /**< The thread. */
+    std::atomic<bool> done;     /**< Set once the thread has read the last request of its connection. */
+};
+
+/**
+ * @brief Join the readers whose connections have ended, so a long-lived server only keeps
+ * the threads of its open connections.
+ *
+ * @param readers The readers of every connection accepted so far.
+ */
+static void join_finished_readers(std::list<ConnectionReader>& readers) {
+    for (std::list<ConnectionReader>::iterator reader = readers.begin(); reader != readers.end();) {
+        if (reader->done.load(std::memory_order_acquire)) {
+            reader->thread.join();
+            reader = readers.erase(reader);
+        } else {
+            ++reader;
+        }
+    }
+}
+
+/**
+ * @brief Accept the connections of a listening socket and read each on a thread of its own.
+ *
+ * @tparam SimulationType The instantiation of BasicSimulation with the selected policies.
+ * @param server The server the requests are submitted to.
+ * @param listener The listening socket.
+ * @param error Set to a description of the problem that stopped accepting connections.
+ */
+template <typename SimulationType>
+static void accept_connections(SimulationServer<SimulationType>& server, int listener, std::string& error) {
+    // A list, so every reader stays at the same address while the others are joined
+    std::list<ConnectionReader> readers;
+
+    for (;;) {
+        int client = accept(listener, nullptr, nullptr);
+
+        if (client < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+
+            error = std::string("unable to accept a connection: ") + std::strerror(errno);
+            break;
+        }
+
+        join_finished_readers(readers);
+
+        std::shared_ptr<StreamConnection> connection(new StreamConnection(client, client, true));
+        readers.emplace_back();
+        ConnectionReader& reader = readers.back();
+        reader.done.store(false, std::memory_order_relaxed);
+        reader.thread = std::thread([&server, connection, &reader] {
+            server.read_requests(connection);
+            reader.done.store(true, std::memory_order_release);
+        });
+    }
+
+    for (ConnectionReader& reader : readers) {
+        reader.thread.join();
+    }
+}
+
+/**
+ * @brief Run a server with the given policies, on standard streams or on a socket.
+ *
+ * @tparam SimulationType The instantiation of BasicSimulation with the selected policies.
+ * @param options The options of every request.
+ * @param num_threads The number of worker threads, or 0 for one per hardware thread.
+ * @param listener The listening socket, or -1 to serve standard input and output.
+ * @param error Set to a description of the problem that stopped the server.
+ * @return bool True if the standard input was served to its end, false otherwise.
+ */
+template <typename SimulationType>
+static bool serve_as(const SimulationOptions& options, int num_threads, int listener, std::string& error) {
+    ThreadPool pool(num_threads);
+    SimulationServer<SimulationType> server(options, pool);
+
+    if (listener >= 0) {
+        accept_connections(server, listener, error);
+        pool.wait();
+        return false;
+    }
+
+    std::shared_ptr<StreamConnection> connection(new StreamConnection(STDIN_FILENO, STDOUT_FILENO, false));
+    server.read_requests(connection);
+    pool.wait();
+
+    if (connection->write_failed()) {
+        error = "unable to write to standard output";
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Run a server with the given backoff policy and the window policy of the options.
+ *
+ * @tparam Backoff The backoff policy.
+ */
+template <typename Backoff>
+static bool serve_with(const SimulationOptions& options, int num_threads, int listener, std::string& error) {
+    if (options.window_policy == WINDOW_BINARY_EXPONENTIAL) {
+        return serve_as<BasicSimulation<Backoff, BinaryExponentialWindow>>(options, num_threads, listener, error);
+    }
+
+    return serve_as<BasicSimulation<Backoff, TableWindow>>(options, num_threads, listener, error);
+}
+
+/**
+ * @brief Run a server with the policies of the options.
+ *
+ * @param options The options of every request, of which only the engine, the policies
+ * and the result cache are used.
+ * @param num_threads The number of worker threads, or 0 for one per hardware thread.
+ * @param listener The listening socket, or -1 to serve standard input and output.
+ * @param error Set to a description of the problem that stopped the server.
+ * @return bool True if the standard input was served to its end, false otherwise.
+ */
+static bool serve(SimulationOptions options, int num_threads, int listener, std::string& error) {
+    options.log_level = LOG_OFF;
+    options.trace_writer = nullptr;
+    options.node_statistics = nullptr;
+    options.profile = nullptr;
+    options.checkpoint_writer = nullptr;
+    options.resume_snapshot = nullptr;
+    options.report = nullptr;
+    options.async_log = nullptr;
+
+    // A client that goes away fails the writes of its answers, rather than stopping the server
+    std::signal(SIGPIPE, SIG_IGN);
+
+    switch (options.backoff_policy) {
+        case BACKOFF_UNIFORM:
+            return serve_with<UniformBackoff>(options, num_threads, listener, error);
+
+        case BACKOFF_P_PERSISTENT:
+            return serve_with<PPersistentBackoff>(options, num_threads, listener, error);
+
+        case BACKOFF_DETERMINISTIC:
+        default:
+            return serve_with<DeterministicBackoff>(options, num_threads, listener, error);
+    }
+}
+
+bool serve_standard_streams(const SimulationOptions& options, int num_threads, std::string& error) {
+    return serve(options, num_threads, -1, error);
+}
+
+bool serve_socket(const std::string& socket_path, const SimulationOptions& options, int num_threads,
+                  std::string& error) {
+    struct sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+
+    if (socket_path.empty() || socket_path.size() >= sizeof(address.sun_path)) {
+        error = "invalid socket path '" + socket_path + "'";
+        return false;
+    }
+    std::memcpy(address.sun_path, socket_path.c_str(), socket_path.size());
+
+    // A socket left behind by a server that was stopped is replaced, any other file is kept
+    struct stat status;
+    if (lstat(socket_path.c_str(), &status) == 0 && S_ISSOCK(status.st_mode)) {
+        unlink(socket_path.c_str());
+    }
+
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+
+    if (listener < 0 || bind(listener, reinterpret_cast<struct sockaddr*>(&address), sizeof(address)) != 0 ||
+        listen(listener, SOMAXCONN) != 0) {
+        error = "unable to listen on " + socket_path + ": " + std::strerror(errno);
+        if (listener >= 0) {
+            close(listener);
+        }
+        return false;
+    }
+
+    serve(options, num_threads, listener, error);
+    close(listener);
+    return false;
+}
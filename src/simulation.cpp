@@ -0,0 +1,1363 @@
+/** 
+ * @file simulation.cpp
+ * @brief The engines of the Carrier Sense Multiple Access (CSMA) simulation.
+ *
+ * This file contains the implementation of the Simulation class and of
+ * the structures its engines use to advance the simulation clock.
+ *
+ * @author Vicky Chen (chen-vv)
+ * @author Eric Omielan (eomielan)
+ * @bug No known bugs.
+ */
+
+/* -- Includes -- */
+
+/* Standard library includes. */
+#include <iostream>
+#include <algorithm>
+#include <array>
+#include <climits>
+#include <cstdint>
+#include <string>
+
+/* Custom includes */
+#include "include/async_log.h"
+#include "include/checkpoint.h"
+#include "include/csma.h"
+#include "include/node_kernels.h"
+#include "include/node_stats.h"
+#include "include/profile.h"
+#include "include/report.h"
+#include "include/result_cache.h"
+#include "include/trace.h"
+
+SimulationConfig::SimulationConfig()
+    : num_nodes(0),
+      packet_length(1),
+      R(1, 1),
+      max_retransmission_attempt(0),
+      total_simulation_time(0) {}
+
+SimulationOptions::SimulationOptions()
+    : engine(ENGINE_SMALL),
+      log_level(LOG_OFF),
+      detect_cycles(false),
+      log_stream(&std::cout),
+      backoff_policy(BACKOFF_DETERMINISTIC),
+      window_policy(WINDOW_TABLE),
+      seed(0),
+      persistence(0.5),
+      trace_writer(nullptr),
+      node_statistics(nullptr),
+      profile(nullptr),
+      checkpoint_writer(nullptr),
+      resume_snapshot(nullptr),
+      report(nullptr),
+      result_cache(nullptr),
+      async_log(nullptr) {}
+
+int generate_backoff(int node_id, long long ticks, int R) {
+    unsigned long long value = static_cast<unsigned long long>(node_id + ticks);
+
+    // A 32-bit division is several times faster than a 64-bit one, and covers every T below 2^32
+    if (value <= 0xFFFFFFFFULL) {
+        return static_cast<int>(static_cast<unsigned>(value) % static_cast<unsigned>(R));
+    }
+
+    int backoff = static_cast<int>(value % static_cast<unsigned long long>(R));
+    return backoff;
+}
+
+std::string format_ratio(long long numerator, long long denominator, int decimals) {
+    unsigned long long scale = 1;
+    for (int i = 0; i < decimals; i++) {
+        scale *= 10;
+    }
+
+    // numerator * scale can exceed 64 bits, the quotient and remainder cannot
+    unsigned long long scaled = 0;
+    if (denominator > 0) {
+        unsigned __int128 product = static_cast<unsigned __int128>(numerator) * scale;
+        unsigned __int128 quotient = product / static_cast<unsigned long long>(denominator);
+        unsigned __int128 remainder = product % static_cast<unsigned long long>(denominator);
+
+        if (2 * remainder >= static_cast<unsigned long long>(denominator)) {
+            quotient++;
+        }
+        scaled = static_cast<unsigned long long>(quotient);
+    }
+
+    std::string digits = std::to_string(scaled % scale + scale).substr(1);
+    std::string text = std::to_string(scaled / scale);
+
+    if (decimals > 0) {
+        text += "." + digits;
+    }
+
+    return text;
+}
+
+bool validate_config(const SimulationConfig& config, std::string& error) {
+    if (config.num_nodes < 0) {
+        error = "the number of nodes N must not be negative";
+    } else if (config.packet_length < 1) {
+        error = "the packet length L must be at least 1";
+    } else if (config.R.empty()) {
+        error = "at least one value of R is required";
+    } else if (*std::min_element(config.R.begin(), config.R.end()) < 1) {
+        error = "every value of R must be at least 1";
+    } else if (config.max_retransmission_attempt < 0) {
+        error = "the maximum number of retransmission attempts M must not be negative";
+    } else if (config.total_simulation_time < 0) {
+        error = "the total simulation time T must not be negative";
+    } else {
+        return true;
+    }
+
+    return false;
+}
+
+bool parse_log_level(const std::string& name, LogLevel& level) {
+    if (name == "off") {
+        level = LOG_OFF;
+    } else if (name == "summary") {
+        level = LOG_SUMMARY;
+    } else if (name == "events") {
+        level = LOG_EVENTS;
+    } else if (name == "full-trace") {
+        level = LOG_FULL_TRACE;
+    } else {
+        return false;
+    }
+
+    return true;
+}
+
+bool parse_engine(const std::string& name, Engine& engine) {
+    if (name == "tick") {
+        engine = ENGINE_TICK;
+    } else if (name == "reference") {
+        engine = ENGINE_REFERENCE;
+    } else if (name == "event") {
+        engine = ENGINE_NEXT_EVENT;
+    } else if (name == "simd") {
+        engine = ENGINE_SIMD;
+    } else if (name == "group") {
+        engine = ENGINE_GROUP;
+    } else if (name == "small") {
+        engine = ENGINE_SMALL;
+    } else if (name == "batch") {
+        engine = ENGINE_BATCH;
+    } else {
+        return false;
+    }
+
+    return true;
+}
+
+bool parse_backoff_policy(const std::string& name, BackoffPolicy& policy) {
+    if (name == "deterministic") {
+        policy = BACKOFF_DETERMINISTIC;
+    } else if (name == "uniform") {
+        policy = BACKOFF_UNIFORM;
+    } else if (name == "p-persistent") {
+        policy = BACKOFF_P_PERSISTENT;
+    } else {
+        return false;
+    }
+
+    return true;
+}
+
+bool parse_window_policy(const std::string& name, WindowPolicy& policy) {
+    if (name == "table") {
+        policy = WINDOW_TABLE;
+    } else if (name == "beb") {
+        policy = WINDOW_BINARY_EXPONENTIAL;
+    } else {
+        return false;
+    }
+
+    return true;
+}
+
+void ReadyCalendar::reset(int num_nodes, int max_backoff_window) {
+    // One bucket per possible backoff, unless that would be much larger than the node count
+    int num_buckets_wanted = std::min(max_backoff_window, std::max(2 * num_nodes, 4096));
+    int num_buckets = 1;
+
+    while (num_buckets < num_buckets_wanted) {
+        num_buckets *= 2;
+    }
+
+    epoch = 0;
+    bucket_mask = num_buckets - 1;
+    bucket_heads.assign(num_buckets, -1);
+    occupied_buckets.assign((num_buckets + 63) / 64, 0);
+    next_node_ids.assign(num_nodes, -1);
+    ready_epochs.assign(num_nodes, 0);
+}
+
+void ReadyCalendar::schedule(int node_id, int backoff) {
+    long long ready_epoch = epoch + backoff;
+    int bucket = static_cast<int>(ready_epoch & bucket_mask);
+    int& head = bucket_heads[bucket];
+
+    ready_epochs[node_id] = ready_epoch;
+    next_node_ids[node_id] = head;
+    head = node_id;
+    occupied_buckets[bucket >> 6] |= 1ULL << (bucket & 63);
+}
+
+void ReadyCalendar::take_ready(std::vector<int>& ready_nodes) {
+    ready_nodes.clear();
+
+    // Unlink the nodes of the current epoch, leaving nodes of later epochs in place
+    int bucket = static_cast<int>(epoch & bucket_mask);
+    int* link = &bucket_heads[bucket];
+    while (*link != -1) {
+        int node_id = *link;
+
+        if (ready_epochs[node_id] == epoch) {
+            *link = next_node_ids[node_id];
+            ready_nodes.push_back(node_id);
+        } else {
+            link = &next_node_ids[node_id];
+        }
+    }
+
+    if (bucket_heads[bucket] == -1) {
+        occupied_buckets[bucket >> 6] &= ~(1ULL << (bucket & 63));
+    }
+
+    if (ready_nodes.size() > 1) {
+        std::sort(ready_nodes.begin(), ready_nodes.end());
+    }
+}
+
+int ReadyCalendar::idle_ticks_until_next_bucket() const {
+    int num_buckets = bucket_mask + 1;
+    int first_bucket = static_cast<int>(epoch & bucket_mask);
+    int num_words = static_cast<int>(occupied_buckets.size());
+
+    // Search the bitmap from the bucket of the current epoch, wrapping around once
+    int word_index = first_bucket >> 6;
+    unsigned long long word = occupied_buckets[word_index] & (~0ULL << (first_bucket & 63));
+
+    for (int i = 0; i <= num_words; i++) {
+        if (word) {
+            int bucket = (word_index << 6) + __builtin_ctzll(word);
+            return bucket >= first_bucket ? bucket - first_bucket : bucket + num_buckets - first_bucket;
+        }
+
+        word_index = word_index + 1 == num_words ? 0 : word_index + 1;
+        word = occupied_buckets[word_index];
+    }
+
+    return -1;
+}
+
+/** @brief The Mersenne prime 2^61 - 1 that fingerprints are taken modulo. */
+static const unsigned long long FINGERPRINT_MODULUS = (1ULL << 61) - 1;
+
+/** @brief The base x of the polynomial fingerprint. */
+static const unsigned long long FINGERPRINT_BASE = 0x16a09e667f3bcc9ULL;
+
+/** @brief The largest power of the base kept in the lookup tables. */
+static const int FINGERPRINT_TABLE_SIZE = 1 << 16;
+
+static unsigned long long multiply_mod(unsigned long long a, unsigned long long b) {
+    unsigned __int128 product = static_cast<unsigned __int128>(a) * b;
+    unsigned long long result = static_cast<unsigned long long>(product & FINGERPRINT_MODULUS) +
+                                static_cast<unsigned long long>(product >> 61);
+    return result >= FINGERPRINT_MODULUS ? result - FINGERPRINT_MODULUS : result;
+}
+
+static unsigned long long power_mod(unsigned long long base, unsigned long long exponent) {
+    unsigned long long result = 1;
+
+    while (exponent > 0) {
+        if (exponent & 1) {
+            result = multiply_mod(result, base);
+        }
+        base = multiply_mod(base, base);
+        exponent >>= 1;
+    }
+
+    return result;
+}
+
+static unsigned long long node_fingerprint(int node_id, int collision_count) {
+    // SplitMix64 finalizer, so neighbouring nodes get unrelated coefficients
+    unsigned long long z = (static_cast<unsigned long long>(node_id) << 32) ^ static_cast<unsigned int>(collision_count);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    z = z ^ (z >> 31);
+    return z % (FINGERPRINT_MODULUS - 1) + 1;
+}
+
+void CycleDetector::reset(const NodeTable& nodes, const std::vector<int>& R, long long ticks_left) {
+    this->nodes = &nodes;
+    enabled = true;
+    backoff_period = 1;
+
+    for (int r_value : R) {
+        long long a = backoff_period;
+        long long b = r_value;
+        while (b != 0) {
+            long long remainder = a % b;
+            a = b;
+            b = remainder;
+        }
+
+        backoff_period = backoff_period / a * r_value;
+
+        if (backoff_period > ticks_left) {
+            // The phase of the backoff cannot repeat within the simulation
+            enabled = false;
+            return;
+        }
+    }
+
+    int table_size = std::min(*std::max_element(R.begin(), R.end()), FINGERPRINT_TABLE_SIZE);
+    unsigned long long inverse_base = power_mod(FINGERPRINT_BASE, FINGERPRINT_MODULUS - 2);
+
+    powers.resize(table_size);
+    inverse_powers.resize(table_size);
+    powers[0] = 1;
+    inverse_powers[0] = 1;
+    for (int i = 1; i < table_size; i++) {
+        powers[i] = multiply_mod(powers[i - 1], FINGERPRINT_BASE);
+        inverse_powers[i] = multiply_mod(inverse_powers[i - 1], inverse_base);
+    }
+
+    hash = 0;
+    for (int node_id = 0; node_id < nodes.size(); node_id++) {
+        add(node_id);
+    }
+
+    // Nothing is saved yet, the first checked state will be
+    saved_hash = 0;
+    saved_ticks = -1;
+    saved_successful_ticks = 0;
+    steps_since_saved = 0;
+    steps_until_save = 1;
+}
+
+void CycleDetector::add(int node_id) {
+    int backoff = nodes->backoff[node_id];
+    unsigned long long power = backoff < static_cast<int>(powers.size())
+                                   ? powers[backoff]
+                                   : power_mod(FINGERPRINT_BASE, backoff);
+    hash += multiply_mod(node_fingerprint(node_id, nodes->collision_count[node_id]), power);
+    if (hash >= FINGERPRINT_MODULUS) {
+        hash -= FINGERPRINT_MODULUS;
+    }
+}
+
+void CycleDetector::remove(int node_id) {
+    int backoff = nodes->backoff[node_id];
+    unsigned long long power = backoff < static_cast<int>(powers.size())
+                                   ? powers[backoff]
+                                   : power_mod(FINGERPRINT_BASE, backoff);
+    hash += FINGERPRINT_MODULUS - multiply_mod(node_fingerprint(node_id, nodes->collision_count[node_id]), power);
+    if (hash >= FINGERPRINT_MODULUS) {
+        hash -= FINGERPRINT_MODULUS;
+    }
+}
+
+void CycleDetector::count_down(int idle_ticks) {
+    unsigned long long inverse_power = idle_ticks < static_cast<int>(inverse_powers.size())
+                                           ? inverse_powers[idle_ticks]
+                                           : power_mod(power_mod(FINGERPRINT_BASE, FINGERPRINT_MODULUS - 2), idle_ticks);
+    hash = multiply_mod(hash, inverse_power);
+}
+
+bool CycleDetector::check(long long ticks, long long successful_ticks, long long& period, long long& successful_ticks_per_period) {
+    if (saved_ticks >= 0 && hash == saved_hash && (ticks - saved_ticks) % backoff_period == 0) {
+        bool same_state = nodes->backoff == saved_backoffs &&
+                          nodes->collision_count == saved_collision_counts &&
+                          nodes->collision_count_overflows == saved_collision_count_overflows;
+
+        if (same_state) {
+            period = ticks - saved_ticks;
+            successful_ticks_per_period = successful_ticks - saved_successful_ticks;
+            return true;
+        }
+    }
+
+    if (saved_ticks < 0 || ++steps_since_saved == steps_until_save) {
+        save(ticks, successful_ticks);
+        steps_until_save *= 2;
+    }
+
+    return false;
+}
+
+void CycleDetector::save(long long ticks, long long successful_ticks) {
+    saved_backoffs = nodes->backoff;
+    saved_collision_counts = nodes->collision_count;
+    saved_collision_count_overflows = nodes->collision_count_overflows;
+    saved_hash = hash;
+    saved_ticks = ticks;
+    saved_successful_ticks = successful_ticks;
+    steps_since_saved = 0;
+}
+
+/**
+ * @brief Write a line of the log, through the asynchronous log of the options if they have one.
+ *
+ * @param options The options of the simulation.
+ * @param kind The LogRecordKind of the line.
+ * @param first The tick, node or cycle length the line starts with.
+ * @param second The backoff or tick the line ends with, if it has one.
+ */
+static inline void write_log(const SimulationOptions& options, LogRecordKind kind, long long first, long long second = 0) {
+    LogRecord record = {first, second, kind};
+
+    if (options.async_log) {
+        options.async_log->push(record);
+        return;
+    }
+
+    char line[LOG_RECORD_MAX_LENGTH];
+    options.log_stream->write(line, static_cast<std::streamsize>(format_log_record(record, line)));
+}
+
+template <typename Backoff, typename Window>
+BasicSimulation<Backoff, Window>::BasicSimulation()
+    : backoff_policy_(options_.seed, options_.persistence) {
+    reset();
+}
+
+template <typename Backoff, typename Window>
+BasicSimulation<Backoff, Window>::BasicSimulation(const SimulationConfig& config, const SimulationOptions& options)
+    : config_(config),
+      options_(options),
+      backoff_policy_(options.seed, options.persistence) {
+    reset();
+}
+
+template <typename Backoff, typename Window>
+void BasicSimulation<Backoff, Window>::reset() {
+    backoff_policy_ = Backoff(options_.seed, options_.persistence);
+    nodes_.resize(config_.num_nodes);
+    initialize_nodes();
+
+    channel_occupied_ = false;
+    active_node_id_ = 0;
+    packet_ticks_remaining_ = 0;
+    current_tick_ = 0;
+    num_successful_transmission_ticks_ = 0;
+}
+
+template <typename Backoff, typename Window>
+void BasicSimulation<Backoff, Window>::reset(const SimulationConfig& config) {
+    config_ = config;
+    reset();
+}
+
+template <typename Backoff, typename Window>
+SimulationResults BasicSimulation<Backoff, Window>::run() {
+    return run(config_.total_simulation_time);
+}
+
+template <typename Backoff, typename Window>
+SimulationResults BasicSimulation<Backoff, Window>::run(long long total_simulation_time) {
+    CheckpointWriter* checkpoint_writer = options_.checkpoint_writer;
+
+    while (total_simulation_time > current_tick_) {
+        PROFILE_RUN();
+        long long stop_tick = total_simulation_time;
+
+        if (checkpoint_writer) {
+            // Stop at the next multiple of the interval to save a snapshot
+            long long interval = checkpoint_writer->interval();
+            long long ticks_to_checkpoint = interval - current_tick_ % interval;
+
+            if (ticks_to_checkpoint < total_simulation_time - current_tick_) {
+                stop_tick = current_tick_ + ticks_to_checkpoint;
+            }
+        }
+
+        switch (options_.log_level) {
+            case LOG_OFF:
+                run_engine<LOG_OFF>(stop_tick);
+                break;
+
+            case LOG_SUMMARY:
+                run_engine<LOG_SUMMARY>(stop_tick);
+                break;
+
+            case LOG_EVENTS:
+                run_engine<LOG_EVENTS>(stop_tick);
+                break;
+
+            case LOG_FULL_TRACE:
+                run_engine<LOG_FULL_TRACE>(stop_tick);
+                break;
+        }
+
+        current_tick_ = stop_tick;
+
+        if (checkpoint_writer && current_tick_ < total_simulation_time) {
+            // The snapshot is copied here and written in the background
+            save(checkpoint_writer->next_snapshot());
+            checkpoint_writer->commit();
+        }
+    }
+
+    return results();
+}
+
+template <typename Backoff, typename Window>
+void BasicSimulation<Backoff, Window>::save(SimulationSnapshot& snapshot) const {
+    snapshot.nodes.collision_count = nodes_.collision_count;
+    snapshot.nodes.backoff = nodes_.backoff;
+    snapshot.nodes.collision_count_overflows = nodes_.collision_count_overflows;
+    snapshot.channel_occupied = channel_occupied_;
+    snapshot.active_node_id = active_node_id_;
+    snapshot.packet_ticks_remaining = packet_ticks_remaining_;
+    snapshot.current_tick = current_tick_;
+    snapshot.num_successful_transmission_ticks = num_successful_transmission_ticks_;
+}
+
+template <typename Backoff, typename Window>
+void BasicSimulation<Backoff, Window>::restore(SimulationSnapshot& snapshot) {
+    std::swap(nodes_.collision_count, snapshot.nodes.collision_count);
+    std::swap(nodes_.backoff, snapshot.nodes.backoff);
+    std::swap(nodes_.collision_count_overflows, snapshot.nodes.collision_count_overflows);
+    channel_occupied_ = snapshot.channel_occupied;
+    active_node_id_ = snapshot.active_node_id;
+    packet_ticks_remaining_ = snapshot.packet_ticks_remaining;
+    current_tick_ = snapshot.current_tick;
+    num_successful_transmission_ticks_ = snapshot.num_successful_transmission_ticks;
+}
+
+template <typename Backoff, typename Window>
+SimulationResults BasicSimulation<Backoff, Window>::results() const {
+    SimulationResults results;
+    results.total_simulation_time = current_tick_;
+    results.num_successful_transmission_ticks = num_successful_transmission_ticks_;
+    return results;
+}
+
+template <typename Backoff, typename Window>
+void BasicSimulation<Backoff, Window>::initialize_nodes() {
+    for (int node_id = 0; node_id < nodes_.size(); node_id++) {
+        nodes_.collision_count[node_id] = 0;
+        nodes_.backoff[node_id] = draw_backoff(node_id, 0, 0);
+    }
+    nodes_.collision_count_overflows.clear();
+}
+
+template <typename Backoff, typename Window>
+void BasicSimulation<Backoff, Window>::set_channel_occupied(bool is_occupied) {
+    channel_occupied_ = is_occupied;
+}
+
+template <typename Backoff, typename Window>
+void BasicSimulation<Backoff, Window>::get_ready_node_ids(std::vector<int>& ready_nodes) const {
+    ready_nodes.clear();
+
+    for (int node_id = 0; node_id < nodes_.size(); node_id++) {
+        if (nodes_.backoff[node_id] == READY_TO_TRANSMIT) {
+            ready_nodes.push_back(node_id);
+        }
+    }
+}
+
+template <typename Backoff, typename Window>
+template <LogLevel level>
+void BasicSimulation<Backoff, Window>::start_transmission(int node_id, long long ticks) {
+    set_channel_occupied(true);
+
+    active_node_id_ = node_id;
+    packet_ticks_remaining_ = config_.packet_length;
+
+    if (options_.trace_writer) {
+        options_.trace_writer->start(ticks, node_id);
+    }
+
+    if (options_.report) {
+        options_.report->start(ticks, config_.packet_length);
+    }
+
+    if (level == LOG_EVENTS) {
+        write_log(options_, LOG_RECORD_TICK, ticks);
+        write_log(options_, LOG_RECORD_OCCUPIED, active_node_id_);
+    }
+}
+
+template <typename Backoff, typename Window>
+template <LogLevel level>
+void BasicSimulation<Backoff, Window>::finish_transmission(long long ticks) {
+    nodes_.set_collisions(active_node_id_, 0);
+    nodes_.backoff[active_node_id_] = draw_backoff(active_node_id_, ticks + 1, 0);
+    set_channel_occupied(false);
+
+    if (options_.trace_writer) {
+        options_.trace_writer->end(ticks, active_node_id_, nodes_.backoff[active_node_id_]);
+    }
+
+    if (options_.node_statistics) {
+        options_.node_statistics->end(active_node_id_, ticks + 1 - config_.packet_length, ticks);
+    }
+
+    // A one-tick packet finishes on the tick it started, which already printed the tick
+    if (level == LOG_EVENTS && config_.packet_length > 1) {
+        write_log(options_, LOG_RECORD_TICK, ticks);
+    }
+
+    if (level >= LOG_EVENTS) {
+        write_log(options_, LOG_RECORD_FINISHED, active_node_id_, nodes_.backoff[active_node_id_]);
+    }
+}
+
+template <typename Backoff, typename Window>
+template <LogLevel level>
+void BasicSimulation<Backoff, Window>::transmit_packet(long long ticks) {
+    if (level >= LOG_FULL_TRACE) {
+        write_log(options_, LOG_RECORD_OCCUPIED, active_node_id_);
+    }
+
+    packet_ticks_remaining_--;
+
+    if (packet_ticks_remaining_ == TRANSMIT_COMPLETE) {
+        finish_transmission<level>(ticks);
+    }
+
+    num_successful_transmission_ticks_++;
+}
+
+template <typename Backoff, typename Window>
+template <LogLevel level>
+void BasicSimulation<Backoff, Window>::begin_collision(long long ticks) {
+    if (level == LOG_EVENTS) {
+        write_log(options_, LOG_RECORD_TICK, ticks);
+    }
+
+    if (level >= LOG_EVENTS) {
+        write_log(options_, LOG_RECORD_COLLISION, 0);
+    }
+
+    if (options_.report) {
+        options_.report->collision(ticks);
+    }
+}
+
+template <typename Backoff, typename Window>
+template <LogLevel level>
+void BasicSimulation<Backoff, Window>::back_off_node(int node_id, long long ticks) {
+    if (level >= LOG_EVENTS) {
+        write_log(options_, LOG_RECORD_COLLIDED, node_id);
+    }
+
+    int collision_count = nodes_.collisions(node_id) + 1;
+
+    if (options_.node_statistics) {
+        options_.node_statistics->collision(node_id);
+    }
+
+    if (collision_count > config_.max_retransmission_attempt) {
+        // Drop packet and reset node
+        if (options_.trace_writer) {
+            options_.trace_writer->drop(ticks, node_id);
+        }
+
+        if (options_.node_statistics) {
+            options_.node_statistics->drop(node_id, ticks);
+        }
+
+        if (options_.report) {
+            options_.report->drop(ticks);
+        }
+
+        nodes_.set_collisions(node_id, 0);
+        nodes_.backoff[node_id] = draw_backoff(node_id, ticks + 1, 0);
+        return;
+    }
+
+    nodes_.set_collisions(node_id, collision_count);
+    nodes_.backoff[node_id] = draw_backoff(node_id, ticks + 1, collision_count);
+}
+
+template <typename Backoff, typename Window>
+template <LogLevel level>
+void BasicSimulation<Backoff, Window>::handle_collision(const std::vector<int>& ready_nodes, long long ticks) {
+    begin_collision<level>(ticks);
+
+    if (options_.trace_writer) {
+        options_.trace_writer->collision(ticks, ready_nodes);
+    }
+
+    for (int node_id : ready_nodes) {
+        back_off_node<level>(node_id, ticks);
+    }
+}
+
+template <typename Backoff, typename Window>
+template <LogLevel level>
+void BasicSimulation<Backoff, Window>::run_engine(long long total_simulation_time) {
+    // Random backoffs never repeat, so cycles are only looked for with a periodic backoff
+    if (options_.detect_cycles && Backoff::periodic) {
+        cycle_detector_.reset(nodes_, window_policy_.windows(config_.R), total_simulation_time - current_tick_);
+        run_next_event_loop<level>(total_simulation_time, cycle_detector_.enabled ? &cycle_detector_ : nullptr);
+    } else {
+        switch (options_.engine) {
+            case ENGINE_TICK:
+                run_tick_loop<level>(total_simulation_time);
+                break;
+
+            case ENGINE_REFERENCE:
+                run_reference_loop<level>(total_simulation_time);
+                break;
+
+            case ENGINE_NEXT_EVENT:
+                run_next_event_loop<level>(total_simulation_time, nullptr);
+                break;
+
+            case ENGINE_SIMD:
+                run_simd_loop<level>(total_simulation_time);
+                break;
+
+            case ENGINE_GROUP:
+                run_group_loop<level>(total_simulation_time);
+                break;
+
+            case ENGINE_SMALL:
+            case ENGINE_BATCH:
+                // Pick the smallest arrays that hold every node, or the tick engine if none does
+                if (nodes_.size() <= 8) {
+                    run_small_loop<level, 8>(total_simulation_time);
+                } else if (nodes_.size() <= 16) {
+                    run_small_loop<level, 16>(total_simulation_time);
+                } else if (nodes_.size() <= 32) {
+                    run_small_loop<level, 32>(total_simulation_time);
+                } else if (nodes_.size() <= SMALL_ENGINE_MAX_NODES) {
+                    run_small_loop<level, SMALL_ENGINE_MAX_NODES>(total_simulation_time);
+                } else {
+                    run_tick_loop<level>(total_simulation_time);
+                }
+                break;
+        }
+    }
+
+    if (level >= LOG_EVENTS) {
+        options_.log_stream->flush();
+    }
+}
+
+template <typename Backoff, typename Window>
+template <LogLevel level>
+void BasicSimulation<Backoff, Window>::run_tick_loop(long long total_simulation_time) {
+
+    std::vector<int> windows = window_policy_.windows(config_.R);
+    calendar_.reset(nodes_.size(), *std::max_element(windows.begin(), windows.end()));
+    for (int node_id = 0; node_id < nodes_.size(); node_id++) {
+        if (!channel_occupied_ || node_id != active_node_id_) {
+            calendar_.schedule(node_id, nodes_.backoff[node_id]);
+        }
+    }
+
+    for (long long ticks = current_tick_; ticks < total_simulation_time; ticks++) {
+        if (level >= LOG_FULL_TRACE) {
+            PROFILE_PHASE(output_cycles);
+            write_log(options_, LOG_RECORD_TICK, ticks);
+            for (int node_id = 0; node_id < nodes_.size(); node_id++) {
+                write_log(options_, LOG_RECORD_BACKOFF, node_id, calendar_.backoff(node_id));
+            }
+        }
+
+        if (channel_occupied_) {
+            PROFILE_TICKS(busy_ticks, 1);
+            transmit_packet<level>(ticks);
+
+            if (!channel_occupied_) {
+                calendar_.schedule(active_node_id_, nodes_.backoff[active_node_id_]);
+            }
+        } else {
+            {
+                PROFILE_PHASE(ready_lookup_cycles);
+                calendar_.take_ready(ready_nodes_);
+            }
+
+            if (ready_nodes_.empty()) {
+                // No nodes are ready to transmit
+                PROFILE_TICKS(idle_ticks, 1);
+                if (level >= LOG_FULL_TRACE) {
+                    PROFILE_PHASE(output_cycles);
+                    write_log(options_, LOG_RECORD_IDLE, 0);
+                }
+
+                PROFILE_PHASE(idle_countdown_cycles);
+                calendar_.epoch++;
+            } else if (ready_nodes_.size() == 1) {
+                // Only one node is ready to transmit
+                PROFILE_TICKS(single_ready_ticks, 1);
+                start_transmission<level>(ready_nodes_[0], ticks);
+                transmit_packet<level>(ticks);
+
+                if (!channel_occupied_) {
+                    calendar_.schedule(active_node_id_, nodes_.backoff[active_node_id_]);
+                }
+            } else {
+                // Multiple nodes are ready to transmit, so a collision occurs
+                PROFILE_TICKS(collision_ticks, 1);
+                PROFILE_PHASE(collision_cycles);
+                handle_collision<level>(ready_nodes_, ticks);
+
+                for (int node_id : ready_nodes_) {
+                    calendar_.schedule(node_id, nodes_.backoff[node_id]);
+                }
+            }
+        }
+    }
+
+    // Bring the backoffs of the nodes back in sync with the calendar. A node that is still
+    // transmitting was taken out on the epoch it became ready, so it reads back as ready.
+    for (int node_id = 0; node_id < nodes_.size(); node_id++) {
+        nodes_.backoff[node_id] = calendar_.backoff(node_id);
+    }
+}
+
+template <typename Backoff, typename Window>
+template <LogLevel level>
+void BasicSimulation<Backoff, Window>::run_reference_loop(long long total_simulation_time) {
+
+    for (long long ticks = current_tick_; ticks < total_simulation_time; ticks++) {
+        if (level >= LOG_FULL_TRACE) {
+            PROFILE_PHASE(output_cycles);
+            write_log(options_, LOG_RECORD_TICK, ticks);
+            for (int node_id = 0; node_id < nodes_.size(); node_id++) {
+                write_log(options_, LOG_RECORD_BACKOFF, node_id, nodes_.backoff[node_id]);
+            }
+        }
+
+        if (channel_occupied_) {
+            PROFILE_TICKS(busy_ticks, 1);
+            transmit_packet<level>(ticks);
+        } else {
+            {
+                PROFILE_PHASE(ready_lookup_cycles);
+                get_ready_node_ids(ready_nodes_);
+            }
+
+            if (ready_nodes_.empty()) {
+                // No nodes are ready to transmit
+                PROFILE_TICKS(idle_ticks, 1);
+                if (level >= LOG_FULL_TRACE) {
+                    PROFILE_PHASE(output_cycles);
+                    write_log(options_, LOG_RECORD_IDLE, 0);
+                }
+
+                PROFILE_PHASE(idle_countdown_cycles);
+                for (int& backoff : nodes_.backoff) {
+                    backoff--;
+                }
+            } else if (ready_nodes_.size() == 1) {
+                // Only one node is ready to transmit
+                PROFILE_TICKS(single_ready_ticks, 1);
+                start_transmission<level>(ready_nodes_[0], ticks);
+                transmit_packet<level>(ticks);
+            } else {
+                // Multiple nodes are ready to transmit, so a collision occurs
+                PROFILE_TICKS(collision_ticks, 1);
+                PROFILE_PHASE(collision_cycles);
+                handle_collision<level>(ready_nodes_, ticks);
+            }
+        }
+    }
+}
+
+template <typename Backoff, typename Window>
+template <LogLevel level>
+void BasicSimulation<Backoff, Window>::run_simd_loop(long long total_simulation_time) {
+
+    for (long long ticks = current_tick_; ticks < total_simulation_time; ticks++) {
+        if (level >= LOG_FULL_TRACE) {
+            PROFILE_PHASE(output_cycles);
+            write_log(options_, LOG_RECORD_TICK, ticks);
+            for (int node_id = 0; node_id < nodes_.size(); node_id++) {
+                write_log(options_, LOG_RECORD_BACKOFF, node_id, nodes_.backoff[node_id]);
+            }
+        }
+
+        if (channel_occupied_) {
+            PROFILE_TICKS(busy_ticks, 1);
+            transmit_packet<level>(ticks);
+            continue;
+        }
+
+        int first_ready_node_id = 0;
+        int num_ready_nodes;
+        {
+            PROFILE_PHASE(ready_lookup_cycles);
+            num_ready_nodes = count_ready_nodes(nodes_.backoff.data(), nodes_.size(), &first_ready_node_id);
+        }
+
+        if (num_ready_nodes == 0) {
+            // No nodes are ready to transmit
+            PROFILE_TICKS(idle_ticks, 1);
+            if (level >= LOG_FULL_TRACE) {
+                PROFILE_PHASE(output_cycles);
+                write_log(options_, LOG_RECORD_IDLE, 0);
+            }
+
+            PROFILE_PHASE(idle_countdown_cycles);
+            count_down_backoffs(nodes_.backoff.data(), nodes_.size());
+        } else if (num_ready_nodes == 1) {
+            // Only one node is ready to transmit
+            PROFILE_TICKS(single_ready_ticks, 1);
+            start_transmission<level>(first_ready_node_id, ticks);
+            transmit_packet<level>(ticks);
+        } else {
+            // Multiple nodes are ready to transmit, so a collision occurs
+            PROFILE_TICKS(collision_ticks, 1);
+            PROFILE_PHASE(collision_cycles);
+            ready_nodes_.clear();
+            for (int node_id = first_ready_node_id; static_cast<int>(ready_nodes_.size()) < num_ready_nodes; node_id++) {
+                if (nodes_.backoff[node_id] == READY_TO_TRANSMIT) {
+                    ready_nodes_.push_back(node_id);
+                }
+            }
+
+            handle_collision<level>(ready_nodes_, ticks);
+        }
+    }
+}
+
+template <typename Backoff, typename Window>
+template <LogLevel level>
+void BasicSimulation<Backoff, Window>::run_next_event_loop(long long total_simulation_time, CycleDetector* cycle_detector) {
+    long long ticks = current_tick_;
+    bool cycle_entered = false;
+
+    while (ticks < total_simulation_time) {
+        long long ticks_left = total_simulation_time - ticks;
+
+        if (channel_occupied_) {
+            // Skip straight to the end of the transmission. Every tick of it is successful.
+
+            if (packet_ticks_remaining_ > ticks_left) {
+                PROFILE_TICKS(busy_ticks, ticks_left);
+                packet_ticks_remaining_ -= static_cast<int>(ticks_left);
+                num_successful_transmission_ticks_ += ticks_left;
+                break;
+            }
+
+            PROFILE_TICKS(busy_ticks, packet_ticks_remaining_);
+            ticks += packet_ticks_remaining_;
+            num_successful_transmission_ticks_ += packet_ticks_remaining_;
+            packet_ticks_remaining_ = TRANSMIT_COMPLETE;
+
+            if (cycle_detector) {
+                cycle_detector->remove(active_node_id_);
+            }
+
+            finish_transmission<level>(ticks - 1);
+
+            if (cycle_detector) {
+                cycle_detector->add(active_node_id_);
+            }
+            continue;
+        }
+
+        if (cycle_detector && cycle_detector->enabled) {
+            long long period;
+            long long successful_ticks_per_period;
+            NodeStatistics* node_statistics = options_.node_statistics;
+
+            if (cycle_detector->check(ticks, num_successful_transmission_ticks_, period, successful_ticks_per_period)) {
+                if (node_statistics && !cycle_entered) {
+                    // The access delays only repeat once a whole period was spent in the cycle, so
+                    // the statistics are only extrapolated from the next repetition on
+                    cycle_detector->save(ticks, num_successful_transmission_ticks_);
+                    node_statistics->save();
+                    cycle_entered = true;
+                } else {
+                    // Every full repetition of the cycle adds the same number of successful ticks
+                    long long repetitions = ticks_left / period;
+
+                    if (options_.trace_writer) {
+                        options_.trace_writer->cycle(ticks, period, ticks + repetitions * period);
+                    }
+
+                    if (node_statistics) {
+                        node_statistics->skip_cycle(repetitions, repetitions * period);
+                    }
+
+                    PROFILE_TICKS(skipped_ticks, repetitions * period);
+                    ticks += repetitions * period;
+                    num_successful_transmission_ticks_ += repetitions * successful_ticks_per_period;
+                    cycle_detector->enabled = false;
+
+                    if (level >= LOG_EVENTS) {
+                        write_log(options_, LOG_RECORD_CYCLE, period, ticks);
+                    }
+                    continue;
+                }
+            } else if (node_statistics && cycle_detector->saved_ticks == ticks) {
+                node_statistics->save();
+            }
+        }
+
+        // Find the smallest backoff, and the nodes that have it, in a single pass
+        int min_backoff = 0;
+        int num_ready_nodes = 0;
+        int first_ready_node_id = 0;
+        {
+            PROFILE_PHASE(ready_lookup_cycles);
+
+            for (int node_id = 0; node_id < nodes_.size(); node_id++) {
+                int backoff = nodes_.backoff[node_id];
+
+                if (num_ready_nodes == 0 || backoff < min_backoff) {
+                    min_backoff = backoff;
+                    num_ready_nodes = 1;
+                    first_ready_node_id = node_id;
+                } else if (backoff == min_backoff) {
+                    num_ready_nodes++;
+                }
+            }
+        }
+
+        if (num_ready_nodes == 0) {
+            // Without nodes the channel stays idle until the end
+            PROFILE_TICKS(idle_ticks, ticks_left);
+            break;
+        }
+
+        if (min_backoff != READY_TO_TRANSMIT) {
+            // The channel is idle until the first node is ready, so count every backoff down at once
+            int idle_ticks = static_cast<int>(std::min<long long>(min_backoff, ticks_left));
+            PROFILE_TICKS(idle_ticks, idle_ticks);
+            PROFILE_PHASE(idle_countdown_cycles);
+
+            for (int& backoff : nodes_.backoff) {
+                backoff -= idle_ticks;
+            }
+
+            if (cycle_detector) {
+                cycle_detector->count_down(idle_ticks);
+            }
+
+            ticks += idle_ticks;
+        } else if (num_ready_nodes == 1) {
+            // The first tick of the transmission is counted as single ready instead of busy
+            PROFILE_TICKS(single_ready_ticks, 1);
+            PROFILE_TICKS(busy_ticks, -1);
+            start_transmission<level>(first_ready_node_id, ticks);
+        } else {
+            PROFILE_TICKS(collision_ticks, 1);
+            PROFILE_PHASE(collision_cycles);
+            ready_nodes_.clear();
+            for (int node_id = first_ready_node_id; node_id < nodes_.size(); node_id++) {
+                if (nodes_.backoff[node_id] == READY_TO_TRANSMIT) {
+                    ready_nodes_.push_back(node_id);
+                }
+            }
+
+            if (cycle_detector) {
+                for (int node_id : ready_nodes_) {
+                    cycle_detector->remove(node_id);
+                }
+            }
+
+            handle_collision<level>(ready_nodes_, ticks);
+
+            if (cycle_detector) {
+                for (int node_id : ready_nodes_) {
+                    cycle_detector->add(node_id);
+                }
+            }
+            ticks++;
+        }
+    }
+}
+
+template <typename Backoff, typename Window>
+template <LogLevel level>
+void BasicSimulation<Backoff, Window>::run_group_loop(long long total_simulation_time) {
+    long long ticks = current_tick_;
+
+    std::vector<int> windows = window_policy_.windows(config_.R);
+    calendar_.reset(nodes_.size(), *std::max_element(windows.begin(), windows.end()));
+    for (int node_id = 0; node_id < nodes_.size(); node_id++) {
+        if (!channel_occupied_ || node_id != active_node_id_) {
+            calendar_.schedule(node_id, nodes_.backoff[node_id]);
+        }
+    }
+
+    while (ticks < total_simulation_time) {
+        long long ticks_left = total_simulation_time - ticks;
+
+        if (channel_occupied_) {
+            // Skip straight to the end of the transmission. Every tick of it is successful.
+
+            if (packet_ticks_remaining_ > ticks_left) {
+                PROFILE_TICKS(busy_ticks, ticks_left);
+                packet_ticks_remaining_ -= static_cast<int>(ticks_left);
+                num_successful_transmission_ticks_ += ticks_left;
+                break;
+            }
+
+            PROFILE_TICKS(busy_ticks, packet_ticks_remaining_);
+            ticks += packet_ticks_remaining_;
+            num_successful_transmission_ticks_ += packet_ticks_remaining_;
+            packet_ticks_remaining_ = TRANSMIT_COMPLETE;
+
+            finish_transmission<level>(ticks - 1);
+            calendar_.schedule(active_node_id_, nodes_.backoff[active_node_id_]);
+            continue;
+        }
+
+        int idle_ticks;
+        {
+            PROFILE_PHASE(ready_lookup_cycles);
+            idle_ticks = calendar_.idle_ticks_until_next_bucket();
+
+            if (idle_ticks == 0) {
+                calendar_.take_ready(ready_nodes_);
+            }
+        }
+
+        if (idle_ticks < 0) {
+            // Without nodes the channel stays idle until the end
+            PROFILE_TICKS(idle_ticks, ticks_left);
+            break;
+        }
+
+        if (idle_ticks > 0 || ready_nodes_.empty()) {
+            // The channel is idle until the next group may be ready. A bucket of a capped
+            // calendar that only holds nodes of later epochs is an idle tick too.
+            long long skipped_ticks = std::min<long long>(std::max(idle_ticks, 1), ticks_left);
+            PROFILE_TICKS(idle_ticks, skipped_ticks);
+            calendar_.epoch += skipped_ticks;
+            ticks += skipped_ticks;
+        } else if (ready_nodes_.size() == 1) {
+            // The first tick of the transmission is counted as single ready instead of busy
+            PROFILE_TICKS(single_ready_ticks, 1);
+            PROFILE_TICKS(busy_ticks, -1);
+            start_transmission<level>(ready_nodes_[0], ticks);
+        } else {
+            PROFILE_TICKS(collision_ticks, 1);
+            PROFILE_PHASE(collision_cycles);
+            handle_collision<level>(ready_nodes_, ticks);
+
+            for (int node_id : ready_nodes_) {
+                calendar_.schedule(node_id, nodes_.backoff[node_id]);
+            }
+            ticks++;
+        }
+    }
+
+    // Bring the backoffs of the nodes back in sync with the calendar. A node that is still
+    // transmitting was taken out on the epoch it became ready, so it reads back as ready.
+    for (int node_id = 0; node_id < nodes_.size(); node_id++) {
+        nodes_.backoff[node_id] = calendar_.backoff(node_id);
+    }
+}
+
+template <typename Backoff, typename Window>
+template <LogLevel level, int MaxNodes>
+void BasicSimulation<Backoff, Window>::run_small_loop(long long total_simulation_time) {
+    const int num_nodes = nodes_.size();
+    long long ticks = current_tick_;
+
+    // The backoffs are copied into an array of a fixed size on the stack, which the compiler
+    // keeps apart from the members the event handlers write to
+    std::array<int, MaxNodes> backoffs;
+    std::copy(nodes_.backoff.begin(), nodes_.backoff.end(), backoffs.begin());
+
+    while (ticks < total_simulation_time) {
+        long long ticks_left = total_simulation_time - ticks;
+
+        if (level >= LOG_FULL_TRACE) {
+            PROFILE_PHASE(output_cycles);
+            write_log(options_, LOG_RECORD_TICK, ticks);
+            for (int node_id = 0; node_id < num_nodes; node_id++) {
+                write_log(options_, LOG_RECORD_BACKOFF, node_id, backoffs[node_id]);
+            }
+        }
+
+        if (channel_occupied_) {
+            if (level >= LOG_FULL_TRACE) {
+                // The full trace prints every tick of the transmission
+                PROFILE_TICKS(busy_ticks, 1);
+                transmit_packet<level>(ticks);
+                ticks++;
+            } else if (packet_ticks_remaining_ > ticks_left) {
+                PROFILE_TICKS(busy_ticks, ticks_left);
+                packet_ticks_remaining_ -= static_cast<int>(ticks_left);
+                num_successful_transmission_ticks_ += ticks_left;
+                break;
+            } else {
+                // Skip straight to the end of the transmission. Every tick of it is successful.
+                PROFILE_TICKS(busy_ticks, packet_ticks_remaining_);
+                ticks += packet_ticks_remaining_;
+                num_successful_transmission_ticks_ += packet_ticks_remaining_;
+                packet_ticks_remaining_ = TRANSMIT_COMPLETE;
+                finish_transmission<level>(ticks - 1);
+            }
+
+            if (!channel_occupied_) {
+                backoffs[active_node_id_] = nodes_.backoff[active_node_id_];
+            }
+            continue;
+        }
+
+        // The smallest backoff, and the set of nodes that have it as a bitmask
+        int min_backoff = INT_MAX;
+        uint64_t ready_mask = 0;
+        {
+            PROFILE_PHASE(ready_lookup_cycles);
+
+            // A scalar pass: a vector load of the array right after the scalar store of
+            // an event would stall until the store is written back
+            for (int node_id = 0; node_id < num_nodes; node_id++) {
+                int backoff = backoffs[node_id];
+
+                if (backoff < min_backoff) {
+                    min_backoff = backoff;
+                    ready_mask = 0;
+                }
+                if (backoff == min_backoff) {
+                    ready_mask |= static_cast<uint64_t>(1) << node_id;
+                }
+            }
+        }
+
+        if (num_nodes == 0) {
+            // Without nodes the channel stays idle until the end
+            PROFILE_TICKS(idle_ticks, ticks_left);
+            if (level >= LOG_FULL_TRACE) {
+                write_log(options_, LOG_RECORD_IDLE, 0);
+                ticks++;
+                continue;
+            }
+            break;
+        }
+
+        if (min_backoff != READY_TO_TRANSMIT) {
+            // The channel is idle until the first node is ready, so count every backoff down at once
+            int idle_ticks = level >= LOG_FULL_TRACE ? 1 : static_cast<int>(std::min<long long>(min_backoff, ticks_left));
+            PROFILE_TICKS(idle_ticks, idle_ticks);
+
+            if (level >= LOG_FULL_TRACE) {
+                PROFILE_PHASE(output_cycles);
+                write_log(options_, LOG_RECORD_IDLE, 0);
+            }
+
+            PROFILE_PHASE(idle_countdown_cycles);
+            for (int node_id = 0; node_id < num_nodes; node_id++) {
+                backoffs[node_id] -= idle_ticks;
+            }
+            ticks += idle_ticks;
+        } else if ((ready_mask & (ready_mask - 1)) == 0) {
+            // Only one node is ready to transmit
+            PROFILE_TICKS(single_ready_ticks, 1);
+            start_transmission<level>(__builtin_ctzll(ready_mask), ticks);
+
+            if (level >= LOG_FULL_TRACE) {
+                // The first tick of the transmission is also printed on its own tick
+                transmit_packet<level>(ticks);
+                ticks++;
+
+                if (!channel_occupied_) {
+                    backoffs[active_node_id_] = nodes_.backoff[active_node_id_];
+                }
+            } else {
+                // It is counted as single ready instead of busy when the transmission is skipped
+                PROFILE_TICKS(busy_ticks, -1);
+            }
+        } else {
+            PROFILE_TICKS(collision_ticks, 1);
+            PROFILE_PHASE(collision_cycles);
+
+            if (options_.trace_writer) {
+                // The trace records the colliding nodes as a list
+                ready_nodes_.clear();
+                for (uint64_t mask = ready_mask; mask; mask &= mask - 1) {
+                    ready_nodes_.push_back(__builtin_ctzll(mask));
+                }
+                handle_collision<level>(ready_nodes_, ticks);
+            } else {
+                begin_collision<level>(ticks);
+                for (uint64_t mask = ready_mask; mask; mask &= mask - 1) {
+                    back_off_node<level>(__builtin_ctzll(mask), ticks);
+                }
+            }
+
+            for (uint64_t mask = ready_mask; mask; mask &= mask - 1) {
+                int node_id = __builtin_ctzll(mask);
+                backoffs[node_id] = nodes_.backoff[node_id];
+            }
+            ticks++;
+        }
+    }
+
+    std::copy(backoffs.begin(), backoffs.begin() + num_nodes, nodes_.backoff.begin());
+}
+
+template class BasicSimulation<DeterministicBackoff, TableWindow>;
+template class BasicSimulation<DeterministicBackoff, BinaryExponentialWindow>;
+template class BasicSimulation<UniformBackoff, TableWindow>;
+template class BasicSimulation<UniformBackoff, BinaryExponentialWindow>;
+template class BasicSimulation<PPersistentBackoff, TableWindow>;
+template class BasicSimulation<PPersistentBackoff, BinaryExponentialWindow>;
+
+/**
+ * @brief Run a simulation, from the snapshot of the options if there is one.
+ * 
+ * @tparam SimulationType The instantiation of BasicSimulation with the selected policies.
+ * @param config The parameters of the simulation.
+ * @param options How the simulation is run.
+ * @return SimulationResults The results of the simulation.
+ */
+template <typename SimulationType>
+static SimulationResults run_simulation_as(const SimulationConfig& config, const SimulationOptions& options) {
+    SimulationType simulation(config, options);
+
+    if (options.resume_snapshot) {
+        simulation.restore(*options.resume_snapshot);
+    } else if (options.result_cache) {
+        return run_through_cache(simulation, *options.result_cache);
+    }
+
+    return simulation.run();
+}
+
+/**
+ * @brief Run a simulation with the given backoff policy and the window policy of the options.
+ * 
+ * @tparam Backoff The backoff policy.
+ * @param config The parameters of the simulation, which must be valid.
+ * @param options How the simulation is run.
+ * @return SimulationResults The results of the simulation.
+ */
+template <typename Backoff>
+static SimulationResults run_simulation_with(const SimulationConfig& config, const SimulationOptions& options) {
+    switch (options.window_policy) {
+        case WINDOW_BINARY_EXPONENTIAL:
+            return run_simulation_as<BasicSimulation<Backoff, BinaryExponentialWindow>>(config, options);
+
+        case WINDOW_TABLE:
+        default:
+            return run_simulation_as<BasicSimulation<Backoff, TableWindow>>(config, options);
+    }
+}
+
+SimulationResults run_simulation(const SimulationConfig& config, const SimulationOptions& options) {
+    switch (options.backoff_policy) {
+        case BACKOFF_UNIFORM:
+            return run_simulation_with<UniformBackoff>(config, options);
+
+        case BACKOFF_P_PERSISTENT:
+            return run_simulation_with<PPersistentBackoff>(config, options);
+
+        case BACKOFF_DETERMINISTIC:
+        default:
+            return run_simulation_with<DeterministicBackoff>(config, options);
+    }
+}
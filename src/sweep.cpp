@@ -0,0 +1,444 @@
+/** 
+ * @file sweep.cpp
+ * @brief Implementation of the parameter sweeps.
+ *
+ * @author Vicky Chen (chen-vv)
+ * @author Eric Omielan (eomielan)
+ * @bug No known bugs.
+ */
+
+/* -- Includes -- */
+
+/* Standard library includes. */
+#include <algorithm>
+#include <climits>
+#include <iostream>
+#include <memory>
+#include <thread>
+
+/* Custom includes */
+#include "include/batch.h"
+#include "include/input_file.h"
+#include "include/result_cache.h"
+#include "include/sweep.h"
+#include "include/thread_pool.h"
+
+/**
+ * @brief Parse one value of a sweep parameter, which may be a range, and append its values.
+ * 
+ * @param token The value, either "v", "start:stop", "start:stop:step" or "start:stop*factor".
+ * @param values The values to append to.
+ * @return bool True if the value was parsed, false otherwise.
+ */
+static bool parse_sweep_values(const InputToken& token, std::vector<long long>& values) {
+    const char* position = token.begin;
+    long long start, stop, step = 1, factor = 1;
+
+    if (!parse_integer(position, token.end, start)) {
+        return false;
+    }
+
+    if (position == token.end) {
+        values.push_back(start);
+        return true;
+    }
+
+    if (*position++ != ':' || !parse_integer(position, token.end, stop)) {
+        return false;
+    }
+
+    if (position != token.end) {
+        char separator = *position++;
+        long long amount;
+
+        if (!parse_integer(position, token.end, amount) || position != token.end) {
+            return false;
+        }
+
+        if (separator == ':') {
+            step = amount;
+        } else if (separator == '*') {
+            step = 0;
+            factor = amount;
+        } else {
+            return false;
+        }
+    }
+
+    // Reject ranges that would never reach their end
+    if (stop < start || (step == 0 && (factor < 2 || start < 1)) || step < 0) {
+        return false;
+    }
+
+    for (long long value = start; value <= stop; value = step ? value + step : value * factor) {
+        values.push_back(value);
+
+        // Stop before the next value would overflow
+        if (step ? static_cast<unsigned long long>(stop) - static_cast<unsigned long long>(value) < static_cast<unsigned long long>(step)
+                 : value > stop / factor) {
+            break;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief Give the parameters of a grid that are not swept their single default value.
+ * 
+ * @param grid The grid to complete.
+ */
+static void complete_sweep_grid(SweepGrid& grid) {
+    SimulationConfig defaults;
+    if (grid.num_nodes.empty()) grid.num_nodes.push_back(defaults.num_nodes);
+    if (grid.packet_length.empty()) grid.packet_length.push_back(defaults.packet_length);
+    if (grid.R.empty()) grid.R.push_back(defaults.R);
+    if (grid.max_retransmission_attempt.empty()) grid.max_retransmission_attempt.push_back(defaults.max_retransmission_attempt);
+    if (grid.total_simulation_time.empty()) grid.total_simulation_time.push_back(defaults.total_simulation_time);
+}
+
+bool parse_sweep_grids(const std::string& contents, std::vector<SweepGrid>& grids, std::string& error) {
+    grids.clear();
+    InputScanner scanner(contents);
+    bool in_grid = false;
+    std::vector<long long> values;
+
+    while (scanner.next_line()) {
+        InputToken token;
+        InputToken name;
+
+        // A blank line or a header ends the grid before it
+        int header = 0;
+        if (!scanner.next_token(token) || (header = scan_header(scanner, token, name, error)) != 0) {
+            if (header < 0) {
+                return false;
+            }
+            in_grid = false;
+            continue;
+        }
+
+        if (!in_grid) {
+            grids.push_back(SweepGrid());
+            in_grid = true;
+        }
+
+        SweepGrid& grid = grids.back();
+        std::string line = "line " + std::to_string(scanner.line_number()) + ": ";
+        char parameter = *token.begin++;
+        values.clear();
+
+        for (bool has_token = token.begin != token.end || scanner.next_token(token); has_token;
+             has_token = scanner.next_token(token)) {
+            size_t num_values = values.size();
+            if (!parse_sweep_values(token, values)) {
+                error = line + "invalid value '" + token.str() + "'";
+                return false;
+            }
+
+            // Every parameter but T is an int, so its values must fit in one
+            if (parameter != 'T' && std::any_of(values.begin() + num_values, values.end(),
+                                                [](long long value) { return value < INT_MIN || value > INT_MAX; })) {
+                error = line + "invalid value '" + token.str() + "' for " + parameter;
+                return false;
+            }
+        }
+
+        if (parameter != 'N' && parameter != 'L' && parameter != 'M' && parameter != 'R' && parameter != 'T') {
+            error = line + "unknown parameter " + parameter;
+            return false;
+        }
+
+        if (values.empty()) {
+            error = line + "no values given for " + parameter;
+            return false;
+        }
+
+        switch (parameter) {
+            case 'N':
+                grid.num_nodes.insert(grid.num_nodes.end(), values.begin(), values.end());
+                break;
+
+            case 'L':
+                grid.packet_length.insert(grid.packet_length.end(), values.begin(), values.end());
+                break;
+
+            case 'M':
+                grid.max_retransmission_attempt.insert(grid.max_retransmission_attempt.end(), values.begin(), values.end());
+                break;
+
+            case 'R':
+                grid.R.push_back(std::vector<int>(values.begin(), values.end()));
+                break;
+
+            case 'T':
+                grid.total_simulation_time.insert(grid.total_simulation_time.end(), values.begin(), values.end());
+                break;
+        }
+    }
+
+    if (grids.empty()) {
+        error = "no grid found";
+        return false;
+    }
+
+    for (SweepGrid& grid : grids) {
+        complete_sweep_grid(grid);
+    }
+
+    return true;
+}
+
+std::vector<SimulationConfig> expand_sweep_grid(const SweepGrid& grid) {
+    std::vector<SimulationConfig> configs;
+    SimulationConfig config;
+
+    for (const std::vector<int>& R : grid.R) {
+        config.R = R;
+        for (int num_nodes : grid.num_nodes) {
+            config.num_nodes = num_nodes;
+            for (int packet_length : grid.packet_length) {
+                config.packet_length = packet_length;
+                for (int max_retransmission_attempt : grid.max_retransmission_attempt) {
+                    config.max_retransmission_attempt = max_retransmission_attempt;
+                    for (long long total_simulation_time : grid.total_simulation_time) {
+                        config.total_simulation_time = total_simulation_time;
+                        configs.push_back(config);
+                    }
+                }
+            }
+        }
+    }
+
+    return configs;
+}
+
+/**
+ * @brief Run the points of a sweep on a thread pool, with one reusable simulation per worker.
+ * 
+ * @tparam SimulationType The instantiation of BasicSimulation with the selected policies.
+ * @param configs The configurations to run.
+ * @param options The options used for every point.
+ * @param order The indices of the configurations, in the order they are submitted.
+ * @param pool The thread pool to run the points on.
+ * @param results Set to the results of each configuration.
+ */
+template <typename SimulationType>
+static void run_sweep_points(const std::vector<SimulationConfig>& configs, const SimulationOptions& options,
+                             const std::vector<size_t>& order, ThreadPool& pool,
+                             std::vector<SimulationResults>& results) {
+    // Every worker allocates its own simulation on first use, so the state of the simulations
+    // of different workers never shares a cache line and is local to the core of the worker
+    std::vector<std::unique_ptr<SimulationType>> simulations(pool.size());
+
+    for (size_t i : order) {
+        pool.submit([&configs, &options, &results, &simulations, i] {
+            std::unique_ptr<SimulationType>& simulation = simulations[ThreadPool::current_worker_index()];
+
+            if (!simulation) {
+                simulation.reset(new SimulationType(configs[i], options));
+            } else {
+                simulation->reset(configs[i]);
+            }
+            results[i] = options.result_cache ? run_through_cache(*simulation, *options.result_cache)
+                                              : simulation->run();
+        });
+    }
+
+    pool.wait();
+}
+
+/**
+ * @brief Submit the points of a sweep to a thread pool in batches for the batch engine.
+ * 
+ * Every task runs a group of consecutive points of the order, which have a similar
+ * cost, in the lanes of one batch. The groups are large enough to keep the lanes
+ * busy while a lane is refilled, and small enough to give every worker several.
+ * 
+ * @param configs The configurations to run.
+ * @param options The options used for every point.
+ * @param order The indices of the configurations, which must all be batchable().
+ * @param pool The thread pool to run the points on.
+ * @param results Set to the results of each configuration.
+ */
+static void submit_sweep_batches(const std::vector<SimulationConfig>& configs, const SimulationOptions& options,
+                                 const std::vector<size_t>& order, ThreadPool& pool,
+                                 std::vector<SimulationResults>& results) {
+    size_t group_size = std::max<size_t>(BATCH_LANES, std::min<size_t>(8 * BATCH_LANES, order.size() / (4 * pool.size())));
+
+    for (size_t first = 0; first < order.size(); first += group_size) {
+        size_t num_points = std::min(group_size, order.size() - first);
+
+        pool.submit([&configs, &options, &order, &results, first, num_points] {
+            run_batch(configs, order.data() + first, num_points, options, results);
+        });
+    }
+}
+
+/**
+ * @brief Run the points of a sweep with the given backoff policy and the window policy of the options.
+ * 
+ * @tparam Backoff The backoff policy.
+ */
+template <typename Backoff>
+static void run_sweep_points_with(const std::vector<SimulationConfig>& configs, const SimulationOptions& options,
+                                  const std::vector<size_t>& order, ThreadPool& pool,
+                                  std::vector<SimulationResults>& results) {
+    if (options.window_policy == WINDOW_BINARY_EXPONENTIAL) {
+        run_sweep_points<BasicSimulation<Backoff, BinaryExponentialWindow>>(configs, options, order, pool, results);
+    } else {
+        run_sweep_points<BasicSimulation<Backoff, TableWindow>>(configs, options, order, pool, results);
+    }
+}
+
+std::vector<SimulationResults> run_sweep(const std::vector<SimulationConfig>& configs,
+                                         SimulationOptions options, int num_threads, bool pin_threads) {
+    options.log_level = LOG_OFF;
+    options.trace_writer = nullptr;
+    options.node_statistics = nullptr;
+    options.profile = nullptr;
+    options.checkpoint_writer = nullptr;
+    options.resume_snapshot = nullptr;
+    options.report = nullptr;
+    options.async_log = nullptr;
+    std::vector<SimulationResults> results(configs.size());
+
+    // Submit the most expensive points first, so that no long point is left for the end
+    std::vector<size_t> order(configs.size());
+    for (size_t i = 0; i < order.size(); i++) {
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [&configs](size_t a, size_t b) {
+        return static_cast<double>(configs[a].num_nodes + 1) * configs[a].total_simulation_time >
+               static_cast<double>(configs[b].num_nodes + 1) * configs[b].total_simulation_time;
+    });
+
+    int max_threads = static_cast<int>(std::min<size_t>(std::max<size_t>(configs.size(), 1), 1 << 16));
+    ThreadPool pool(num_threads > 0 ? std::min(num_threads, max_threads)
+                                    : std::min(static_cast<int>(std::thread::hardware_concurrency()), max_threads),
+                    pin_threads);
+
+    // The batch engine takes the points it can run, and the others run one at a time.
+    // The batched points are referenced by their tasks until the pool is done. The lanes
+    // keep no final state, so a sweep through a result cache runs every point on its own.
+    std::vector<size_t> batched_order;
+
+    if (options.engine == ENGINE_BATCH && !options.detect_cycles && !options.result_cache) {
+        std::vector<size_t> single_order;
+
+        for (size_t i : order) {
+            (batchable(configs[i], options) ? batched_order : single_order).push_back(i);
+        }
+
+        // A batch runs in smaller lanes if all of its points have at most half the nodes
+        std::stable_partition(batched_order.begin(), batched_order.end(), [&configs](size_t i) {
+            return configs[i].num_nodes <= BATCH_MAX_NODES / 2;
+        });
+
+        submit_sweep_batches(configs, options, batched_order, pool, results);
+        order.swap(single_order);
+    }
+
+    switch (options.backoff_policy) {
+        case BACKOFF_UNIFORM:
+            run_sweep_points_with<UniformBackoff>(configs, options, order, pool, results);
+            break;
+
+        case BACKOFF_P_PERSISTENT:
+            run_sweep_points_with<PPersistentBackoff>(configs, options, order, pool, results);
+            break;
+
+        case BACKOFF_DETERMINISTIC:
+        default:
+            run_sweep_points_with<DeterministicBackoff>(configs, options, order, pool, results);
+            break;
+    }
+
+    return results;
+}
+
+void write_point_fields(std::ostream& output, const SimulationConfig& config, const SimulationResults& results) {
+    output << config.num_nodes << ',' << config.packet_length << ','
+           << config.max_retransmission_attempt << ',';
+
+    for (size_t j = 0; j < config.R.size(); j++) {
+        output << (j ? " " : "") << config.R[j];
+    }
+
+    output << ',' << config.total_simulation_time << ','
+           << results.num_successful_transmission_ticks << ','
+           << format_ratio(results.num_successful_transmission_ticks, results.total_simulation_time, 6);
+}
+
+void write_csv_name(std::ostream& output, const std::string& name, const char* kind, size_t index) {
+    if (name.empty()) {
+        output << kind << ' ' << index + 1;
+    } else if (name.find_first_of(",\"") == std::string::npos) {
+        output << name;
+    } else {
+        // Quote names that would break the CSV row
+        output << '"';
+        for (char c : name) {
+            output << (c == '"' ? "\"\"" : std::string(1, c));
+        }
+        output << '"';
+    }
+}
+
+void write_sweep_results(std::ostream& output, const std::vector<SimulationConfig>& configs,
+                         const std::vector<SimulationResults>& results) {
+    output << "N,L,M,R,T,successful_ticks,utilization" << std::endl;
+
+    for (size_t i = 0; i < configs.size(); i++) {
+        write_point_fields(output, configs[i], results[i]);
+        output << std::endl;
+    }
+}
+
+/**
+ * @brief Format a 128-bit count in decimal.
+ * 
+ * @param value The count.
+ * @return std::string The decimal digits of the count.
+ */
+static std::string to_decimal(unsigned __int128 value) {
+    std::string digits;
+
+    do {
+        digits.push_back(static_cast<char>('0' + static_cast<int>(value % 10)));
+        value /= 10;
+    } while (value);
+
+    return std::string(digits.rbegin(), digits.rend());
+}
+
+void write_domain_results(std::ostream& output, const std::vector<std::string>& names,
+                          const std::vector<SimulationConfig>& configs,
+                          const std::vector<SimulationResults>& results) {
+    long long num_nodes = 0;
+    unsigned __int128 total_ticks = 0;
+    unsigned __int128 successful_ticks = 0;
+
+    output << "domain,N,L,M,R,T,successful_ticks,utilization" << std::endl;
+
+    for (size_t i = 0; i < configs.size(); i++) {
+        write_csv_name(output, names[i], "domain", i);
+
+        output << ',';
+        write_point_fields(output, configs[i], results[i]);
+        output << std::endl;
+
+        num_nodes += configs[i].num_nodes;
+        total_ticks += results[i].total_simulation_time;
+        successful_ticks += results[i].num_successful_transmission_ticks;
+    }
+
+    output << "total," << num_nodes << ",,,," << to_decimal(total_ticks) << ',' << to_decimal(successful_ticks) << ',';
+
+    // The totals only exceed 64 bits with horizons near the largest T, and halving them
+    // until they fit only changes the utilization far below its printed decimals
+    while (total_ticks >> 63) {
+        total_ticks >>= 1;
+        successful_ticks >>= 1;
+    }
+    output << format_ratio(static_cast<long long>(successful_ticks), static_cast<long long>(total_ticks), 6) << std::endl;
+}
@@ -1,5 +1,10 @@
+import json
 import os
+import re
+import socket
 import subprocess
+import sys
+import time
 
 import pytest
 
@@ -32,5 +37,1082 @@ def test_csma(input_filename, expected_output_data):
     assert output_data == expected_output_data
 
 
+@pytest.mark.parametrize("engine", ["small", "tick", "reference", "event", "simd", "group", "batch"])
+@pytest.mark.parametrize(
+    "input_filename, expected_output_data",
+    [
+        ("src/test/test_input1.txt", "0.40"),
+        ("src/test/test_input2.txt", "0.55"),
+        ("src/test/test_input3.txt", "0.43"),
+        ("src/test/test_input4.txt", "0.80"),
+        ("src/test/test_input5.txt", "1.00"),
+    ],
+)
+def test_csma_engine(engine, input_filename, expected_output_data):
+    simulation_process = subprocess.Popen(
+        ["./csma", "--log-level", "off", "--engine", engine, input_filename]
+    )
+
+    simulation_process.wait()
+
+    with open("output.txt", "r") as output_file:
+        output_data = output_file.read().strip()
+
+    assert output_data == expected_output_data
+
+
+@pytest.mark.parametrize("input_filename", ["src/test/test_input2.txt", "src/test/test_input5.txt"])
+def test_csma_engine_events_match(input_filename):
+    event_logs = []
+
+    for engine in ["small", "tick", "reference", "event", "simd", "group"]:
+        simulation_process = subprocess.Popen(
+            ["./csma", "--log-level", "events", "--engine", engine, input_filename],
+            stdout=subprocess.PIPE,
+        )
+        stdout_data, _ = simulation_process.communicate()
+        event_logs.append(stdout_data)
+
+    assert all(event_log == event_logs[0] for event_log in event_logs)
+
+
+@pytest.mark.parametrize("input_filename", ["src/test/test_input1.txt", "src/test/test_input2.txt"])
+def test_csma_full_trace_matches_reference(input_filename):
+    traces = []
+
+    for engine in ["small", "tick", "reference", "simd"]:
+        simulation_process = subprocess.Popen(
+            ["./csma", "--engine", engine, input_filename], stdout=subprocess.PIPE
+        )
+        stdout_data, _ = simulation_process.communicate()
+        traces.append(stdout_data)
+
+    assert all(trace == traces[0] for trace in traces)
+
+
+@pytest.mark.parametrize("options", [[], ["--log-level", "events"], ["--log-level", "events", "--cycle-detect"], ["--engine", "tick", "--backoff", "uniform"]])
+@pytest.mark.parametrize("input_filename", ["src/test/test_input2.txt", "src/test/test_input3.txt"])
+def test_csma_async_log(options, input_filename, tmp_path):
+    logs = []
+
+    # The background writer formats every record into exactly the text the simulation prints itself
+    for async_options in [[], ["--async-log", "block"]]:
+        simulation_process = subprocess.run(["./csma"] + options + async_options + [input_filename, str(tmp_path / "output.txt")],
+                                            check=True, stdout=subprocess.PIPE)
+        logs.append(simulation_process.stdout)
+
+    assert logs[0] == logs[1]
+
+
+def test_csma_async_log_drop(tmp_path):
+    input_filename = tmp_path / "input.txt"
+    input_filename.write_text("N 30\nL 3\nM 6\nR 4 8 16 32 64\nT 20000\n")
+
+    subprocess.run(["./csma", "--log-level", "off", str(input_filename), str(tmp_path / "plain.txt")], check=True)
+    simulation_process = subprocess.run(["./csma", "--async-log", "drop", str(input_filename), str(tmp_path / "dropped.txt")],
+                                        check=True, stdout=subprocess.PIPE)
+    lines = simulation_process.stdout.decode().strip().split("\n")
+
+    # Dropped records only shorten the log, and never change the results
+    last_line = lines[-1]
+    if last_line.startswith("Log records dropped: "):
+        assert int(last_line.split(": ")[1]) > 0
+        last_line = lines[-2]
+    assert last_line.startswith("Slots with succcessful transmissions: ")
+    assert (tmp_path / "dropped.txt").read_text() == (tmp_path / "plain.txt").read_text()
+
+
+@pytest.mark.parametrize(
+    "input_filename, expected_output_data",
+    [
+        ("src/test/test_input1.txt", "0.40"),
+        ("src/test/test_input2.txt", "0.55"),
+        ("src/test/test_input3.txt", "0.43"),
+        ("src/test/test_input4.txt", "0.80"),
+        ("src/test/test_input5.txt", "1.00"),
+        ("src/test/test_input6.txt", "0.67"),
+    ],
+)
+def test_csma_cycle_detect(input_filename, expected_output_data):
+    simulation_process = subprocess.Popen(
+        ["./csma", "--log-level", "off", "--cycle-detect", input_filename]
+    )
+
+    simulation_process.wait(timeout=10)
+
+    with open("output.txt", "r") as output_file:
+        output_data = output_file.read().strip()
+
+    assert output_data == expected_output_data
+
+
+@pytest.mark.parametrize("log_level", ["off", "summary", "events", "full-trace"])
+@pytest.mark.parametrize(
+    "input_filename, expected_output_data",
+    [
+        ("src/test/test_input1.txt", "0.40"),
+        ("src/test/test_input3.txt", "0.43"),
+    ],
+)
+def test_csma_log_level(log_level, input_filename, expected_output_data):
+    simulation_process = subprocess.Popen(
+        ["./csma", "--log-level", log_level, input_filename], stdout=subprocess.PIPE
+    )
+
+    stdout_data, _ = simulation_process.communicate()
+
+    with open("output.txt", "r") as output_file:
+        output_data = output_file.read().strip()
+
+    assert output_data == expected_output_data
+
+    if log_level == "off":
+        assert stdout_data == b""
+    else:
+        assert b"Slots with succcessful transmissions" in stdout_data
+
+
+@pytest.mark.parametrize(
+    "policy",
+    [
+        ["--window", "beb"],
+        ["--backoff", "uniform", "--seed", "7"],
+        ["--backoff", "uniform", "--window", "beb"],
+        ["--backoff", "p-persistent", "--persistence", "0.3"],
+    ],
+)
+@pytest.mark.parametrize(
+    "input_filename",
+    ["src/test/test_input2.txt", "src/test/test_input3.txt", "src/test/test_input4.txt"],
+)
+def test_csma_policy_engines_match(policy, input_filename):
+    summaries = []
+
+    for engine in [["--engine", "tick"], ["--engine", "reference"], ["--engine", "event"], ["--engine", "simd"], ["--engine", "group"], ["--engine", "small"], ["--cycle-detect"]]:
+        simulation_process = subprocess.Popen(
+            ["./csma", "--log-level", "summary", *engine, *policy, input_filename],
+            stdout=subprocess.PIPE,
+        )
+
+        stdout_data, _ = simulation_process.communicate()
+        summaries.append(stdout_data)
+
+    assert b"Slots with succcessful transmissions" in summaries[0]
+    assert all(summary == summaries[0] for summary in summaries)
+
+
+@pytest.mark.parametrize(
+    "policy",
+    [[], ["--backoff", "uniform", "--window", "beb"], ["--backoff", "p-persistent", "--persistence", "0.3"]],
+)
+def test_csma_verify(policy, tmp_path):
+    input_filename = tmp_path / "input.txt"
+    input_filename.write_text(
+        "".join(open("src/test/test_input{}.txt".format(i)).read() + "\n\n" for i in range(1, 6)) +
+        "[drops]\nN 70\nL 3\nM 0\nR 1 2\nT 5000\n")
+
+    verify_process = subprocess.run(["./csma", "--verify", *policy, str(input_filename)], check=True, stdout=subprocess.PIPE)
+    assert verify_process.stdout == b"Verify: 6 scenarios checked against the reference engine, 0 mismatches\n"
+
+
+def test_csma_stress():
+    stress_process = subprocess.run(["./csma", "--stress", "40", "--seed", "3"], check=True, stdout=subprocess.PIPE)
+    assert stress_process.stdout == b"Stress: 40 random scenarios checked against the reference engine, 0 mismatches\n"
+
+    # The modes only compare engines, so they take no other mode or output
+    assert subprocess.run(["./csma", "--verify", "--sweep", "src/test/test_input1.txt"], stderr=subprocess.PIPE).returncode != 0
+    assert subprocess.run(["./csma", "--stress", "5", "src/test/test_input1.txt"], stderr=subprocess.PIPE).returncode != 0
+
+
+@pytest.mark.parametrize(
+    "options, input_filename",
+    [
+        (["--engine", "tick"], "src/test/test_input1.txt"),
+        (["--engine", "tick"], "src/test/test_input3.txt"),
+        (["--engine", "event"], "src/test/test_input3.txt"),
+        (["--engine", "event"], "src/test/test_input5.txt"),
+        (["--cycle-detect"], "src/test/test_input6.txt"),
+    ],
+)
+def test_csma_trace_timeline(options, input_filename, tmp_path):
+    trace_filename = tmp_path / "trace.bin"
+
+    simulation_process = subprocess.Popen(
+        ["./csma", "--log-level", "events", *options, "--trace", str(trace_filename), input_filename],
+        stdout=subprocess.PIPE,
+    )
+
+    events_data, _ = simulation_process.communicate()
+
+    reader_process = subprocess.Popen(["./csma-trace", "--timeline", str(trace_filename)], stdout=subprocess.PIPE)
+
+    timeline_data, _ = reader_process.communicate()
+
+    # The reader rebuilds the events log from the trace alone
+    assert reader_process.returncode == 0
+    assert timeline_data == events_data
+    assert os.path.getsize(trace_filename) * 4 < len(events_data) + 64
+
+
+def test_csma_trace_stats(tmp_path):
+    trace_filename = tmp_path / "trace.bin"
+
+    simulation_process = subprocess.Popen(
+        ["./csma", "--log-level", "off", "--trace", str(trace_filename), "src/test/test_input1.txt"]
+    )
+
+    simulation_process.wait()
+
+    reader_process = subprocess.Popen(["./csma-trace", "--nodes", str(trace_filename)], stdout=subprocess.PIPE)
+
+    stats_data, _ = reader_process.communicate()
+
+    assert b"Ticks: 10\nSuccessful ticks: 4\nUtilization: 0.40\nTransmissions: 2\n" in stats_data
+    assert b"Node 0: transmissions" in stats_data
+
+
+def read_node_stats(tmp_path, *options):
+    output_filename = tmp_path / "output.txt"
+
+    simulation_process = subprocess.Popen(
+        ["./csma", "--log-level", "off", "--node-stats", *options, str(output_filename)]
+    )
+
+    simulation_process.wait()
+
+    with open(str(output_filename) + ".nodes.csv", "r") as node_stats_file:
+        return node_stats_file.read().strip().split("\n")
+
+
+@pytest.mark.parametrize(
+    "input_filename, expected_successful_ticks, packet_length",
+    [("src/test/test_input2.txt", 6, 2), ("src/test/test_input3.txt", 3, 1), ("src/test/test_input4.txt", 4, 1)],
+)
+def test_csma_node_stats(input_filename, expected_successful_ticks, packet_length, tmp_path):
+    rows = read_node_stats(tmp_path, input_filename)
+
+    assert rows[0].startswith("node,transmissions,collisions,drops,mean_delay,delay_0,delay_1,delay_2_3,")
+    assert rows[0].endswith(",delay_1073741824+")
+
+    # Every sent packet is counted once in its node's histogram
+    transmissions = 0
+    for row in rows[1:]:
+        fields = row.split(",")
+        transmissions += int(fields[1])
+        assert sum(int(count) for count in fields[5:]) == int(fields[1])
+
+    assert expected_successful_ticks - packet_length < transmissions * packet_length <= expected_successful_ticks
+
+    for engine in ["reference", "event", "simd", "group", "small"]:
+        assert read_node_stats(tmp_path, "--engine", engine, input_filename) == rows
+
+
+def test_csma_node_stats_cycle_detect(tmp_path):
+    input_filename = tmp_path / "input.txt"
+    input_filename.write_text("N 4\nL 2\nM 6\nR 4 8 16 32 64 128 256\nT 2000000\n")
+
+    # Skipping cycles extrapolates the statistics exactly
+    assert read_node_stats(tmp_path, "--cycle-detect", str(input_filename)) == read_node_stats(
+        tmp_path, "--engine", "event", str(input_filename)
+    )
+
+
+def run_replications(tmp_path, threads, *options):
+    output_filename = tmp_path / f"replications{threads}.csv"
+
+    simulation_process = subprocess.Popen(
+        ["./csma", "--log-level", "off", "--threads", threads, *options, "src/test/test_input4.txt", str(output_filename)]
+    )
+
+    simulation_process.wait()
+
+    with open(output_filename, "r") as output_file:
+        return output_file.read().strip().split("\n")
+
+
+def test_csma_replications(tmp_path):
+    rows = run_replications(tmp_path, "1", "--backoff", "uniform", "--seed", "3", "--replications", "24")
+
+    assert rows[0] == "replications,mean,variance,ci_low,ci_high"
+
+    replications, mean, variance, ci_low, ci_high = rows[1].split(",")
+    assert replications == "24"
+    assert float(ci_low) <= float(mean) <= float(ci_high)
+    assert float(variance) > 0
+
+    # The replicas have their own seeds, so the thread count cannot change the result
+    assert run_replications(tmp_path, "5", "--backoff", "uniform", "--seed", "3", "--replications", "24") == rows
+
+
+def test_csma_replications_ci_width(tmp_path):
+    # Every replica of the deterministic policy is identical, so the first check stops
+    rows = run_replications(tmp_path, "3", "--replications", "1000", "--ci-width", "0.01")
+
+    assert rows[1] == "8,0.800000,0.000000e+00,0.800000,0.800000"
+
+
+def test_csma_replications_no_ticks(tmp_path):
+    input_filename = tmp_path / "input.txt"
+    input_filename.write_text("N 4\nL 2\nM 6\nR 4 8\nT 0\n")
+    output_filename = tmp_path / "replications.csv"
+
+    # A run without ticks has a utilization of 0, as in a single run
+    subprocess.run(["./csma", "--log-level", "off", "--replications", "5", str(input_filename), str(output_filename)], check=True)
+
+    assert output_filename.read_text().strip().split("\n")[1] == "5,0.000000,0.000000e+00,0.000000,0.000000"
+
+
+@pytest.mark.parametrize("threads", ["1", "4"])
+def test_csma_sweep(threads, tmp_path):
+    grid_filename = tmp_path / "grid.txt"
+    grid_filename.write_text("N 4 2:8*2\nL 1:3\nM 6\nR 4 8 16 32 64 128\nR 2 4\nT 10 100:300:100\n")
+    output_filename = tmp_path / "sweep.csv"
+
+    simulation_process = subprocess.Popen(
+        ["./csma", "--sweep", "--threads", threads, str(grid_filename), str(output_filename)],
+        stdout=subprocess.PIPE,
+    )
+
+    simulation_process.communicate()
+
+    with open(output_filename, "r") as output_file:
+        rows = output_file.read().strip().split("\n")
+
+    assert rows[0] == "N,L,M,R,T,successful_ticks,utilization"
+    assert len(rows) == 1 + 2 * 4 * 3 * 4
+
+    # Every point must agree with a single run of the same configuration
+    for row in rows[1::7]:
+        N, L, M, R, T, successful_ticks, _ = row.split(",")
+        input_filename = tmp_path / "point.txt"
+        input_filename.write_text(f"N {N}\nL {L}\nM {M}\nR {R}\nT {T}\n")
+
+        single_process = subprocess.Popen(
+            ["./csma", "--log-level", "summary", str(input_filename), str(tmp_path / "point.out")],
+            stdout=subprocess.PIPE,
+        )
+
+        stdout_data, _ = single_process.communicate()
+
+        assert f"transmissions: {successful_ticks}, T = {T}".encode() in stdout_data
+
+
+@pytest.mark.parametrize("policy", [[], ["--backoff", "uniform", "--seed", "5"], ["--backoff", "p-persistent", "--window", "beb"]])
+def test_csma_sweep_batch(policy, tmp_path):
+    # N up to 10 and an R list of 17 windows mix batched points, in both lane sizes, with points run on their own
+    grid_filename = tmp_path / "grid.txt"
+    grid_filename.write_text("N 1:10\nL 1 3 8\nM 0 2 6\nR 2 4 8 16\nR 1\nR 1:17\nT 1 999 20000\n")
+    sweeps = []
+
+    for engine in ["batch", "event"]:
+        output_filename = tmp_path / (engine + ".csv")
+        subprocess.run(["./csma", "--sweep", "--engine", engine] + policy + [str(grid_filename), str(output_filename)], check=True, stdout=subprocess.PIPE)
+        sweeps.append(output_filename.read_text())
+
+    assert len(sweeps[0].strip().split("\n")) == 1 + 10 * 3 * 3 * 3 * 3
+    assert sweeps[0] == sweeps[1]
+
+
+def test_csma_sweep_single_point(tmp_path):
+    output_filename = tmp_path / "sweep.csv"
+
+    simulation_process = subprocess.Popen(
+        ["./csma", "--sweep", "src/test/test_input1.txt", str(output_filename)],
+        stdout=subprocess.PIPE,
+    )
+
+    simulation_process.communicate()
+
+    with open(output_filename, "r") as output_file:
+        rows = output_file.read().strip().split("\n")
+
+    assert rows[1] == "4,2,6,4 8 16 32 64 128,10,4,0.400000"
+
+
+def test_csma_sweep_several_grids(tmp_path):
+    grid_filename = tmp_path / "grid.txt"
+    grid_filename.write_text("[first]\nN 4\nL 2\nM 6\nR 4 8 16 32 64 128\nT 10 100\n[second]\nN 3\nL 2\nM 3\nR 3 4 5\nT 11\n")
+    output_filename = tmp_path / "sweep.csv"
+
+    simulation_process = subprocess.Popen(
+        ["./csma", "--sweep", str(grid_filename), str(output_filename)],
+        stdout=subprocess.PIPE,
+    )
+
+    simulation_process.communicate()
+
+    with open(output_filename, "r") as output_file:
+        rows = output_file.read().strip().split("\n")
+
+    assert len(rows) == 4
+    assert rows[1] == "4,2,6,4 8 16 32 64 128,10,4,0.400000"
+    assert rows[3] == "3,2,3,3 4 5,11,6,0.545455"
+
+
+@pytest.mark.parametrize(
+    "grid_data, expected_error",
+    [
+        ("N 4\nL x\n", "line 2: invalid value 'x'"),
+        ("N 4294967298\n", "line 1: invalid value '4294967298' for N"),
+        ("N 4\nR 2 2147483647:2147483648\n", "line 2: invalid value '2147483647:2147483648' for R"),
+    ],
+)
+def test_csma_sweep_errors(grid_data, expected_error, tmp_path):
+    grid_filename = tmp_path / "grid.txt"
+    grid_filename.write_text(grid_data)
+
+    simulation_process = subprocess.Popen(
+        ["./csma", "--sweep", str(grid_filename), str(tmp_path / "sweep.csv")],
+        stderr=subprocess.PIPE,
+    )
+
+    _, stderr_data = simulation_process.communicate()
+
+    assert simulation_process.returncode != 0
+    assert expected_error in stderr_data.decode()
+
+
+def test_csma_batch(tmp_path):
+    scenarios = []
+    for input_filename in ["src/test/test_input1.txt", "src/test/test_input2.txt", "src/test/test_input3.txt"]:
+        with open(input_filename, "r") as input_file:
+            scenarios.append(input_file.read().strip())
+
+    # Scenarios are separated by blank lines or headers
+    input_filename = tmp_path / "batch.txt"
+    input_filename.write_text(f"{scenarios[0]}\n\n{scenarios[1]}\n[third]\n{scenarios[2]}\n")
+    output_filename = tmp_path / "batch.csv"
+
+    simulation_process = subprocess.Popen(
+        ["./csma", "--threads", "2", str(input_filename), str(output_filename)],
+        stdout=subprocess.PIPE,
+    )
+
+    simulation_process.communicate()
+
+    with open(output_filename, "r") as output_file:
+        rows = output_file.read().strip().split("\n")
+
+    assert rows[1:] == ["4,2,6,4 8 16 32 64 128,10,4,0.400000", "3,2,3,3 4 5,11,6,0.545455", "2,1,2,2 4,7,3,0.428571"]
+
+
+@pytest.mark.parametrize("policy", [[], ["--backoff", "uniform"], ["--backoff", "p-persistent", "--window", "beb"]])
+@pytest.mark.parametrize("input_filename", ["src/test/test_input2.txt", "src/test/test_input3.txt", "src/test/test_input4.txt"])
+def test_csma_traffic_saturated(policy, input_filename, tmp_path):
+    # Saturated traffic on every node is the model of the simulation without --traffic
+    simulation_process = subprocess.run(["./csma", "--log-level", "summary"] + policy + [input_filename, str(tmp_path / "plain.txt")],
+                                        check=True, stdout=subprocess.PIPE)
+    subprocess.run(["./csma", "--log-level", "off", "--traffic"] + policy + [input_filename, str(tmp_path / "traffic.csv")], check=True)
+
+    header, row = (tmp_path / "traffic.csv").read_text().strip().split("\n")
+    fields = dict(zip(header.split(","), row.split(",")))
+    assert "transmissions: {}, T = {}".format(fields["successful_ticks"], fields["T"]).encode() in simulation_process.stdout
+
+
+def test_csma_traffic(tmp_path):
+    arrivals_filename = tmp_path / "arrivals.txt"
+    arrivals_filename.write_text("0 0\n10 0\n20 1\n")
+    input_filename = tmp_path / "input.txt"
+    input_filename.write_text(
+        "[light]\nN 20\nL 5\nM 6\nR 8 16 32 64\nT 1000000\nA poisson 0.001\n\n"
+        "[bursty]\nN 20\nL 5\nM 6\nR 8 16 32 64\nT 1000000\nA onoff 0.05 200 1800\nnode 0 L 20\nnode 1-3 R 2 4\n\n"
+        "[replay]\nN 2\nL 3\nM 4\nR 4 8\nT 100\nA trace {}\nnode 1 L 5\n".format(arrivals_filename))
+
+    subprocess.run(["./csma", "--traffic", str(input_filename), str(tmp_path / "traffic.csv")], check=True)
+    rows = [row.split(",") for row in (tmp_path / "traffic.csv").read_text().strip().split("\n")]
+    results = {row[0]: dict(zip(rows[0], row)) for row in rows[1:]}
+
+    # Under a light load nearly every packet gets through, so the throughput is the offered load
+    light = results["light"]
+    assert abs(float(light["offered_load"]) - 0.1) < 0.01
+    assert abs(float(light["utilization"]) - float(light["offered_load"])) < 0.001
+    assert int(light["packets_dropped"]) == 0
+
+    bursty = results["bursty"]
+    assert int(bursty["packets_delivered"]) + int(bursty["packets_dropped"]) <= int(bursty["packets_arrived"])
+    assert float(bursty["mean_delay"]) > float(light["mean_delay"])
+
+    # The deterministic backoffs of the trace are (node + tick) mod R: 0 at tick 0, 2 at tick 10 and 1 at tick 20
+    assert results["replay"]["successful_ticks"] == "11"
+    assert results["replay"]["packets_delivered"] == "3"
+    assert results["replay"]["mean_delay"] == "4.667"
+    assert results["replay"]["max_delay"] == "6"
+
+
+def test_csma_domains(tmp_path):
+    input_filename = tmp_path / "campus.txt"
+    input_filename.write_text(
+        "[building A]\nN 4\nL 2\nM 6\nR 4 8 16 32 64 128\nT 10\n\n[lab, west]\nN 3\nL 2\nM 3\nR 3 4 5\nT 11\n\nN 2\nL 1\nM 2\nR 2 4\nT 7\n"
+    )
+    output_filename = tmp_path / "campus.csv"
+
+    simulation_process = subprocess.Popen(
+        ["./csma", "--domains", "--threads", "2", str(input_filename), str(output_filename)],
+        stdout=subprocess.PIPE,
+    )
+
+    simulation_process.communicate()
+
+    with open(output_filename, "r") as output_file:
+        rows = output_file.read().strip().split("\n")
+
+    assert rows == [
+        "domain,N,L,M,R,T,successful_ticks,utilization",
+        "building A,4,2,6,4 8 16 32 64 128,10,4,0.400000",
+        '"lab, west",3,2,3,3 4 5,11,6,0.545455',
+        "domain 3,2,1,2,2 4,7,3,0.428571",
+        "total,9,,,,28,13,0.464286",
+    ]
+
+
+@pytest.mark.parametrize(
+    "input_data, expected_error",
+    [
+        ("N 4\nL x\n", "line 2: invalid value 'x' for L"),
+        ("N 4\n\nN 3\nQ 1\n", "line 4: unknown parameter 'Q'"),
+        ("N 4 5\n", "line 1: N takes a single value"),
+        ("N 4\nL 2\n\nN 2\nR 0\n", "scenario on line 4: every value of R must be at least 1"),
+        ("N 4\nA poisson 0.1\n", "line 2: arrival processes need --traffic"),
+    ],
+)
+def test_csma_input_errors(input_data, expected_error, tmp_path):
+    input_filename = tmp_path / "input.txt"
+    input_filename.write_text(input_data)
+
+    simulation_process = subprocess.Popen(
+        ["./csma", str(input_filename), str(tmp_path / "output.txt")],
+        stderr=subprocess.PIPE,
+    )
+
+    _, stderr_data = simulation_process.communicate()
+
+    assert simulation_process.returncode != 0
+    assert expected_error in stderr_data.decode()
+
+
+@pytest.mark.parametrize(
+    "options, expected_error",
+    [
+        (["--sweep", "--coordinator", "0", "--cache", "cache"], "--coordinator cannot be combined with --cache"),
+        (["--serve", "--sweep"], "--sweep cannot be combined with --serve"),
+        (["--replications", "3", "--trace", "trace.bin", "--cache", "cache"], "--replications cannot be combined with --trace or --cache"),
+        (["--ci-width", "0.01"], "--ci-width needs --replications"),
+        (["--socket", "csma.sock"], "--socket needs --serve"),
+        (["--resume", "run.checkpoint", "--report-interval", "5"], "--resume cannot be combined with --report-interval"),
+    ],
+)
+def test_csma_option_errors(options, expected_error, tmp_path):
+    simulation_process = subprocess.Popen(
+        ["./csma", *options, "src/test/test_input1.txt", str(tmp_path / "output.txt")],
+        stderr=subprocess.PIPE,
+    )
+
+    _, stderr_data = simulation_process.communicate()
+
+    assert simulation_process.returncode != 0
+    assert "Error: " + expected_error in stderr_data.decode()
+
+
+def test_csma_domains_cache(tmp_path):
+    # The collision domains run through the cache like the points of a sweep
+    input_filename = tmp_path / "domains.txt"
+    input_filename.write_text("N 4\nL 2\nM 6\nR 4 8 16 32 64 128\nT 10\n\nN 3\nL 2\nM 3\nR 3 4 5\nT 11\n")
+
+    for output_name in ["first.csv", "second.csv"]:
+        subprocess.run(
+            ["./csma", "--domains", "--cache", str(tmp_path / "cache"), str(input_filename), str(tmp_path / output_name)],
+            check=True,
+            stdout=subprocess.PIPE,
+        )
+
+    assert (tmp_path / "first.csv").read_text() == (tmp_path / "second.csv").read_text()
+    assert len(os.listdir(tmp_path / "cache")) == 2
+
+
+def test_csma_bench():
+    bench_process = subprocess.Popen(
+        ["./csma-bench", "--scale", "0.0001", "--scenarios", "two_nodes,high_contention,huge_N"],
+        stdout=subprocess.PIPE,
+    )
+
+    stdout_data, _ = bench_process.communicate(timeout=60)
+    report = json.loads(stdout_data)
+
+    assert bench_process.returncode == 0
+    assert report["instruction_set"] in ["avx2", "sse2", "scalar"]
+
+    results = report["results"]
+    assert [result["scenario"] for result in results[::7]] == ["two_nodes", "high_contention", "huge_N"]
+    assert [result["engine"] for result in results[:7]] == ["reference", "tick", "simd", "event", "event+cycle-detect", "group", "small"]
+
+    for result in results:
+        assert result["ns_per_tick"] > 0 and result["ticks_per_sec"] > 0 and result["peak_rss_kb"] > 0
+
+    # Every engine simulates the same thing
+    for first in range(0, len(results), 7):
+        assert len({result["utilization"] for result in results[first : first + 7]}) == 1
+
+
+@pytest.mark.parametrize("engine", ["small", "tick", "reference", "simd", "event", "group"])
+def test_csma_profile(engine, tmp_path):
+    simulation_process = subprocess.Popen(
+        ["./csma", "--log-level", "off", "--engine", engine, "--profile", "src/test/test_input1.txt", str(tmp_path / "output.txt")],
+        stderr=subprocess.PIPE,
+    )
+
+    _, stderr_data = simulation_process.communicate()
+    report = stderr_data.decode()
+
+    # The counters are only compiled in by make PROFILE=1
+    if simulation_process.returncode != 0:
+        assert "PROFILE=1" in report
+        return
+
+    ticks = {line[:30].strip(): int(line[30:50]) for line in report.split("\n")[1:6]}
+    assert ticks == {"Busy": 2, "Idle": 4, "Single ready": 2, "Collision": 2, "Skipped by cycle detection": 0}
+
+
+
+@pytest.mark.parametrize("engine", ["small", "tick", "event", "group"])
+def test_csma_checkpoint_resume(engine, tmp_path):
+    parameters = "N 50\nL 5\nM 8\nR 4 8 16 32 64 128 256 512 1024\n"
+    short_input = tmp_path / "short.txt"
+    short_input.write_text(parameters + "T 120000\n")
+    long_input = tmp_path / "long.txt"
+    long_input.write_text(parameters + "T 200000\n")
+
+    def run(*args):
+        subprocess.run(["./csma", "--log-level", "off", "--engine", engine, "--backoff", "uniform"] + list(args), check=True)
+
+    # The last checkpoint of the short run is at tick 100000, and the long run resumes from it
+    run(str(long_input), str(tmp_path / "direct.txt"))
+    run("--checkpoint-every", "50000", str(short_input), str(tmp_path / "short.out"))
+    run("--resume", str(tmp_path / "short.out.checkpoint"), str(long_input), str(tmp_path / "resumed.txt"))
+
+    assert (tmp_path / "resumed.txt").read_text() == (tmp_path / "direct.txt").read_text()
+
+    # A checkpoint is only resumed with the parameters and policies it was written with
+    simulation_process = subprocess.Popen(
+        ["./csma", "--log-level", "off", "--resume", str(tmp_path / "short.out.checkpoint"), str(long_input), str(tmp_path / "other.txt")],
+        stderr=subprocess.PIPE,
+    )
+    _, stderr_data = simulation_process.communicate()
+    assert simulation_process.returncode != 0
+    assert "other parameters or policies" in stderr_data.decode()
+
+
+
+def test_csma_large_retransmission_limit(tmp_path):
+    # With a single small window the nodes keep colliding, so their counts grow past a byte before M drops them
+    parameters = "N 60\nL 3\nM 300\nR 3\n"
+    stats = []
+
+    for engine in ["small", "tick", "event", "group"]:
+        input_filename = tmp_path / "input.txt"
+        input_filename.write_text(parameters + "T 30000\n")
+        output_filename = tmp_path / (engine + ".txt")
+        subprocess.run(["./csma", "--log-level", "off", "--engine", engine, "--node-stats", str(input_filename), str(output_filename)], check=True)
+        stats.append((tmp_path / (engine + ".txt.nodes.csv")).read_text())
+
+    assert all(node_stats == stats[0] for node_stats in stats)
+    assert [line.split(",")[1:4] for line in stats[0].split("\n")[1:4]] == [["0", "20000", "66"], ["0", "10000", "33"], ["0", "5000", "16"]]
+
+    # The checkpoint at tick 4000 holds counts past a byte, and resuming it must reach the same state at tick 5000
+    short_input = tmp_path / "short.txt"
+    short_input.write_text(parameters + "T 5000\n")
+    long_input = tmp_path / "long.txt"
+    long_input.write_text(parameters + "T 6000\n")
+
+    def run(*args):
+        subprocess.run(["./csma", "--log-level", "off", "--checkpoint-every", "1000"] + list(args), check=True)
+
+    run(str(short_input), str(tmp_path / "short.out"))
+    run("--resume", str(tmp_path / "short.out.checkpoint"), str(long_input), str(tmp_path / "resumed.out"))
+    run(str(long_input), str(tmp_path / "direct.out"))
+
+    assert (tmp_path / "resumed.out.checkpoint").read_bytes() == (tmp_path / "direct.out.checkpoint").read_bytes()
+
+
+def test_csma_converge(tmp_path):
+    input_filename = tmp_path / "input.txt"
+    input_filename.write_text("N 20\nL 3\nM 6\nR 4 8 16 32 64\nT 20000000\n")
+
+    full_process = subprocess.run(["./csma", "--log-level", "summary", "--backoff", "uniform", str(input_filename), str(tmp_path / "full.txt")],
+                                  check=True, stdout=subprocess.PIPE)
+    successful_ticks, T = re.search(r"transmissions: (\d+), T = (\d+)", full_process.stdout.decode()).groups()
+    full_utilization = int(successful_ticks) / int(T)
+
+    converge_process = subprocess.run(["./csma", "--log-level", "summary", "--backoff", "uniform", "--converge", "0.002", str(input_filename), str(tmp_path / "converged.txt")],
+                                      check=True, stdout=subprocess.PIPE)
+    match = re.search(r"Converged at tick (\d+): utilization ([0-9.]+) \+/- ([0-9.]+)", converge_process.stdout.decode())
+    assert match is not None
+
+    # The run stops long before T, within a few half widths of the utilization of the full run
+    stop_tick, utilization, half_width = int(match.group(1)), float(match.group(2)), float(match.group(3))
+    assert stop_tick < int(T) // 10
+    assert half_width <= 0.002
+    assert abs(utilization - full_utilization) <= 3 * 0.002
+    assert (tmp_path / "converged.txt").read_text() == "{:.2f}\n".format(utilization)
+
+
+def test_csma_converge_deterministic(tmp_path):
+    input_filename = tmp_path / "input.txt"
+    input_filename.write_text("N 6\nL 3\nM 4\nR 4 8 16 32\nT 1000000\n")
+
+    # The deterministic run is handed to cycle detection, and its output is that of a plain run
+    subprocess.run(["./csma", str(input_filename), str(tmp_path / "plain.txt")], check=True)
+    converge_process = subprocess.run(["./csma", "--log-level", "summary", "--converge", "0.01", str(input_filename), str(tmp_path / "converged.txt")],
+                                      check=True, stdout=subprocess.PIPE)
+
+    assert b"Deterministic backoff: run to T with cycle detection" in converge_process.stdout
+    assert (tmp_path / "converged.txt").read_text() == (tmp_path / "plain.txt").read_text()
+
+
+def test_csma_result_cache(tmp_path):
+    cache_directory = tmp_path / "cache"
+    short_grid = tmp_path / "short.txt"
+    short_grid.write_text("N 2 8 40\nL 3\nM 6\nR 4 8 16 32\nT 1000\n")
+    long_grid = tmp_path / "long.txt"
+    long_grid.write_text("N 2 8 40\nL 3\nM 6\nR 4 8 16 32\nT 1000 30000\n")
+
+    def run(grid_filename, output_filename, *args):
+        simulation_process = subprocess.run(["./csma", "--log-level", "summary", "--sweep", "--backoff", "uniform"] + list(args) + [str(grid_filename), str(tmp_path / output_filename)],
+                                            check=True, stdout=subprocess.PIPE)
+        return simulation_process.stdout.decode()
+
+    assert "Result cache: 0 reused, 0 extended, 3 simulated" in run(short_grid, "first.csv", "--cache", str(cache_directory))
+    assert "Result cache: 3 reused, 0 extended, 0 simulated" in run(short_grid, "again.csv", "--cache", str(cache_directory))
+    assert (tmp_path / "again.csv").read_text() == (tmp_path / "first.csv").read_text()
+
+    # The points with the larger T resume from the points of the first sweep
+    assert "Result cache: 3 reused, 3 extended, 0 simulated" in run(long_grid, "extended.csv", "--cache", str(cache_directory))
+    run(long_grid, "direct.csv")
+    assert (tmp_path / "extended.csv").read_text() == (tmp_path / "direct.csv").read_text()
+    assert len(list(cache_directory.iterdir())) == 6
+
+
+def test_csma_result_cache_logged_run(tmp_path):
+    cache_directory = str(tmp_path / "cache")
+
+    def run(log_level):
+        return subprocess.run(["./csma", "--log-level", log_level, "--cache", cache_directory, "src/test/test_input1.txt", str(tmp_path / "output.txt")],
+                              check=True, stdout=subprocess.PIPE).stdout.decode()
+
+    # A logged run is simulated again, so its log is the same every time
+    first = run("events")
+    assert run("events") == first
+    assert "Result cache: 0 reused, 0 extended, 1 simulated" in first
+    assert "Result cache: 1 reused, 0 extended, 0 simulated" in run("summary")
+
+
+def test_csma_result_cache_shared(tmp_path):
+    cache_directory = tmp_path / "cache"
+    grid_filename = tmp_path / "grid.txt"
+    grid_filename.write_text("N 1:40\nL 3\nM 6\nR 4 8 16 32\nT 2000\n")
+
+    # Several processes store the same entries at once, each through a temporary file of its own
+    processes = [subprocess.Popen(["./csma", "--sweep", "--backoff", "uniform", "--cache", str(cache_directory), str(grid_filename), str(tmp_path / "sweep{}.csv".format(i))],
+                                  stdout=subprocess.PIPE) for i in range(4)]
+    for process in processes:
+        process.communicate()
+        assert process.returncode == 0
+
+    subprocess.run(["./csma", "--sweep", "--backoff", "uniform", str(grid_filename), str(tmp_path / "direct.csv")], check=True, stdout=subprocess.PIPE)
+    for i in range(4):
+        assert (tmp_path / "sweep{}.csv".format(i)).read_text() == (tmp_path / "direct.csv").read_text()
+    assert sorted(entry.suffix for entry in cache_directory.iterdir()) == [".checkpoint"] * 40
+
+
+def test_csma_serve(tmp_path):
+    requests = "".join("p{} N {}; L 2; M 6; R 4 8 16 32; T {}\n".format(i, i % 7 + 1, 100 + 37 * i) for i in range(50))
+    requests += "long +29\nN 12\nL 3\nM 4\nR 2 4 8\nT 99999\n"
+    requests += "bad N 4; L 0\n"
+
+    simulation_process = subprocess.run(["./csma", "--serve", "--threads", "3", "--backoff", "uniform"], input=requests.encode(), check=True, stdout=subprocess.PIPE)
+    answers = dict(line.split(" ", 1) for line in simulation_process.stdout.decode().strip().split("\n"))
+
+    assert len(answers) == 52
+    assert answers["bad"].startswith("error ")
+
+    # Every answer is the result of the simulation of its request on its own
+    for i in [0, 1, 17, 49]:
+        input_filename = tmp_path / "input.txt"
+        input_filename.write_text("N {}\nL 2\nM 6\nR 4 8 16 32\nT {}\n".format(i % 7 + 1, 100 + 37 * i))
+        single_process = subprocess.run(["./csma", "--log-level", "summary", "--backoff", "uniform", str(input_filename), str(tmp_path / "output.txt")], check=True, stdout=subprocess.PIPE)
+        successful_ticks, T, _ = answers["p{}".format(i)].split(" ")[1:]
+        assert "transmissions: {}, T = {}".format(successful_ticks, T).encode() in single_process.stdout
+
+    assert answers["long"].split(" ")[2] == "99999"
+
+
+def test_csma_serve_socket(tmp_path):
+    socket_path = str(tmp_path / "csma.sock")
+    server_process = subprocess.Popen(["./csma", "--serve", "--socket", socket_path, "--threads", "2"])
+
+    try:
+        for _ in range(500):
+            if os.path.exists(socket_path):
+                break
+            time.sleep(0.01)
+
+        # Two clients pipeline their requests, and each gets back the answers to its own
+        clients = [socket.socket(socket.AF_UNIX, socket.SOCK_STREAM) for _ in range(2)]
+        for k, client in enumerate(clients):
+            client.connect(socket_path)
+            client.sendall("".join("{}-{} N 4; L 2; M 6; R 4 8 16 32 64 128; T 10\n".format(k, i) for i in range(20)).encode())
+            client.shutdown(socket.SHUT_WR)
+
+        for k, client in enumerate(clients):
+            data = b""
+            while True:
+                chunk = client.recv(4096)
+                if not chunk:
+                    break
+                data += chunk
+            client.close()
+
+            assert sorted(data.decode().strip().split("\n")) == sorted("{}-{} ok 4 10 0.400000".format(k, i) for i in range(20))
+    finally:
+        server_process.kill()
+        server_process.wait()
+
+
+def test_csma_serve_socket_slow_client(tmp_path):
+    socket_path = str(tmp_path / "csma.sock")
+    server_process = subprocess.Popen(["./csma", "--serve", "--socket", socket_path, "--threads", "1"])
+
+    try:
+        for _ in range(500):
+            if os.path.exists(socket_path):
+                break
+            time.sleep(0.01)
+
+        # A client sends far more answers' worth of requests than the socket holds, and reads none
+        slow_client = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+        slow_client.connect(socket_path)
+        slow_client.settimeout(0.1)
+        requests = "".join("{}{} N 2; L 1; M 2; R 2; T 1\n".format("x" * 200, i) for i in range(20000)).encode()
+        try:
+            slow_client.sendall(requests)
+        except socket.timeout:
+            pass
+
+        # Another client is still answered by the only worker
+        client = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+        client.connect(socket_path)
+        client.settimeout(10)
+        client.sendall(b"fast N 4; L 2; M 6; R 4 8 16 32 64 128; T 10\n")
+        assert client.recv(4096) == b"fast ok 4 10 0.400000\n"
+        client.close()
+        slow_client.close()
+    finally:
+        server_process.kill()
+        server_process.wait()
+
+
+def test_csma_serve_socket_joins_readers(tmp_path):
+    socket_path = str(tmp_path / "csma.sock")
+    server_process = subprocess.Popen(["./csma", "--serve", "--socket", socket_path, "--threads", "1"])
+
+    try:
+        for _ in range(500):
+            if os.path.exists(socket_path):
+                break
+            time.sleep(0.01)
+
+        for i in range(200):
+            client = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+            client.connect(socket_path)
+            client.sendall("{} N 4; L 2; M 6; R 4 8; T 10\n".format(i).encode())
+            client.shutdown(socket.SHUT_WR)
+            while client.recv(4096):
+                pass
+            client.close()
+
+        # The reader of every closed connection is joined, which leaves the main thread, the worker and the last reader
+        assert len(os.listdir("/proc/{}/task".format(server_process.pid))) <= 3
+    finally:
+        server_process.kill()
+        server_process.wait()
+
+
+def start_coordinator(grid_filename, output_filename, *options):
+    coordinator_process = subprocess.Popen(["./csma", "--sweep", "--coordinator", "0", "--log-level", "events", *options, str(grid_filename), str(output_filename)],
+                                           stdout=subprocess.PIPE)
+    port = int(re.match(r"Coordinator listening on port (\d+)", coordinator_process.stdout.readline().decode()).group(1))
+    return coordinator_process, port
+
+
+def read_coordinator_message(client):
+    data = b""
+    while not data.endswith(b"\n"):
+        chunk = client.recv(1)
+        assert chunk
+        data += chunk
+    return data.decode()
+
+
+@pytest.mark.parametrize("policy", [[], ["--backoff", "uniform", "--window", "beb"], ["--engine", "batch", "--backoff", "p-persistent", "--persistence", "0.3"]])
+def test_csma_distributed_sweep(policy, tmp_path):
+    grid_filename = tmp_path / "grid.txt"
+    grid_filename.write_text("N 1 2 4 8 16 32\nL 1:4\nM 2 6\nR 4 8 16\nR 2 4\nT 20000\n\n[large]\nN 100 200\nL 3\nT 50000\n")
+    subprocess.run(["./csma", "--sweep", *policy, str(grid_filename), str(tmp_path / "local.csv")], check=True, stdout=subprocess.PIPE)
+
+    coordinator_process, port = start_coordinator(grid_filename, tmp_path / "distributed.csv", "--shard-points", "7", *policy)
+    workers = [subprocess.Popen(["./csma", "--worker", "localhost:{}".format(port), "--threads", "1"], stdout=subprocess.PIPE) for _ in range(2)]
+    for worker in workers:
+        assert worker.wait() == 0
+    stdout_data, _ = coordinator_process.communicate()
+    assert coordinator_process.returncode == 0
+
+    # The workers take the options of the coordinator, and the merged table is the one of a local sweep
+    assert (tmp_path / "distributed.csv").read_text() == (tmp_path / "local.csv").read_text()
+    assert b"98 points written to" in stdout_data
+    assert b"14 shards run by" in stdout_data
+
+
+@pytest.mark.parametrize("hang", [False, True])
+def test_csma_distributed_sweep_lost_worker(hang, tmp_path):
+    grid_filename = tmp_path / "grid.txt"
+    grid_filename.write_text("N 1:20\nL 2\nM 6\nR 4 8 16 32\nT 10000\n")
+    subprocess.run(["./csma", "--sweep", str(grid_filename), str(tmp_path / "local.csv")], check=True, stdout=subprocess.PIPE)
+
+    coordinator_process, port = start_coordinator(grid_filename, tmp_path / "distributed.csv", "--shard-points", "5", "--shard-timeout", "0.5")
+
+    # A worker takes the first shard, and then disconnects or hangs
+    client = socket.create_connection(("127.0.0.1", port))
+    header = read_coordinator_message(client)
+    assert header.startswith("csma-sweep 1 20 ")
+    client.recv(int(header.split()[-1]) + 1, socket.MSG_WAITALL)
+    client.sendall(b"next\n")
+    assert read_coordinator_message(client) == "shard 0 0 5\n"
+    if not hang:
+        client.close()
+
+    subprocess.run(["./csma", "--worker", "127.0.0.1:{}".format(port)], check=True, stdout=subprocess.PIPE)
+    stdout_data, _ = coordinator_process.communicate()
+    client.close()
+
+    assert (tmp_path / "distributed.csv").read_text() == (tmp_path / "local.csv").read_text()
+    assert (b"Shard 0 timed out, reassigned" if hang else b"lost, shard 0 reassigned") in stdout_data
+    assert b"4 shards run by 1 workers, 1 reassigned" in stdout_data
+
+
+def test_csma_distributed_sweep_idle_connection(tmp_path):
+    grid_filename = tmp_path / "grid.txt"
+    grid_filename.write_text("N 1:20\nL 2\nM 6\nR 4 8 16 32\nT 10000\n")
+    subprocess.run(["./csma", "--sweep", str(grid_filename), str(tmp_path / "local.csv")], check=True, stdout=subprocess.PIPE)
+
+    coordinator_process, port = start_coordinator(grid_filename, tmp_path / "distributed.csv", "--shard-points", "5")
+
+    # A client that connects but never asks for a shard must not keep the coordinator from finishing
+    client = socket.create_connection(("127.0.0.1", port))
+    subprocess.run(["./csma", "--worker", "127.0.0.1:{}".format(port)], check=True, stdout=subprocess.PIPE)
+    stdout_data, _ = coordinator_process.communicate(timeout=30)
+    client.close()
+
+    assert coordinator_process.returncode == 0
+    assert (tmp_path / "distributed.csv").read_text() == (tmp_path / "local.csv").read_text()
+    assert b"4 shards run by 1 workers, 0 reassigned" in stdout_data
+
+
+def test_csma_report_interval(tmp_path):
+    input_filename = tmp_path / "input.txt"
+    input_filename.write_text("N 3\nL 4\nM 3\nR 50 100 500\nT 20000\n")
+    reports = []
+    summaries = []
+
+    # The next-event and group engines skip over many windows at once, and must cut them the same way
+    for engine in ["small", "tick", "reference", "event", "group"]:
+        output_filename = tmp_path / (engine + ".txt")
+        simulation_process = subprocess.run(
+            ["./csma", "--log-level", "summary", "--engine", engine, "--report-interval", "30", str(input_filename), str(output_filename)],
+            check=True,
+            stdout=subprocess.PIPE,
+        )
+        summaries.append(simulation_process.stdout.decode())
+        reports.append((tmp_path / (engine + ".txt.report.csv")).read_text())
+
+    assert all(report == reports[0] for report in reports)
+
+    rows = [row.split(",") for row in reports[0].strip().split("\n")]
+    assert rows[0][:4] == ["window_start", "window_end", "successful_ticks", "utilization"]
+    windows = rows[1:]
+    assert len(windows) == 667
+    assert windows[-1][:2] == ["19980", "20000"]
+    assert all(int(window[1]) - int(window[0]) == 30 for window in windows[:-1])
+
+    # The windows add up to the totals of the run
+    assert sum(int(window[2]) for window in windows) == int(windows[-1][6])
+    assert sum(int(window[4]) for window in windows) == int(windows[-1][8])
+    assert "transmissions: " + windows[-1][6] + ", T = 20000" in summaries[0]
+
+
+def import_csma_sim():
+    # The extension module is built into the root of the project by make python
+    if os.getcwd() not in sys.path:
+        sys.path.insert(0, os.getcwd())
+    return pytest.importorskip("csma_sim")
+
+
+def test_python_module_run(tmp_path):
+    csma_sim = import_csma_sim()
+    result = csma_sim.run(
+        {"N": 30, "L": 3, "M": 5, "R": range(2, 40, 3), "T": 20000}, backoff="uniform", seed=3, node_stats=True, report_interval=700
+    )
+
+    input_filename = tmp_path / "input.txt"
+    input_filename.write_text("N 30\nL 3\nM 5\nR " + " ".join(str(r) for r in range(2, 40, 3)) + "\nT 20000\n")
+    output_filename = tmp_path / "output.txt"
+    simulation_process = subprocess.run(
+        ["./csma", "--log-level", "summary", "--backoff", "uniform", "--seed", "3", "--node-stats", "--report-interval", "700", str(input_filename), str(output_filename)],
+        check=True,
+        stdout=subprocess.PIPE,
+    )
+
+    assert "transmissions: {}, T = 20000".format(result.successful_ticks).encode() in simulation_process.stdout
+    assert result.total_simulation_time == 20000
+    assert result.utilization == result.successful_ticks / 20000
+
+    # The arrays are strided views of the statistics of the simulation, which match its files
+    transmissions = memoryview(result.node_stats["transmissions"])
+    assert transmissions.format == "q" and transmissions.shape == (30,) and transmissions.readonly
+    delay_bins = memoryview(result.node_stats["delay_bins"])
+    assert delay_bins.shape == (30, 32) and delay_bins.strides == (transmissions.strides[0], 4)
+
+    rows = [row.split(",") for row in (tmp_path / "output.txt.nodes.csv").read_text().strip().split("\n")[1:]]
+    assert transmissions.tolist() == [int(row[1]) for row in rows]
+    assert memoryview(result.node_stats["collisions"]).tolist() == [int(row[2]) for row in rows]
+    assert delay_bins.tolist() == [[int(count) for count in row[5:]] for row in rows]
+
+    windows = [row.split(",") for row in (tmp_path / "output.txt.report.csv").read_text().strip().split("\n")[1:]]
+    assert memoryview(result.windows["end_tick"]).tolist() == [int(window[1]) for window in windows]
+    assert memoryview(result.windows["successful_ticks"]).tolist() == [int(window[2]) for window in windows]
+
+    # An array keeps its result alive
+    drops = result.node_stats["drops"]
+    del result
+    assert memoryview(drops).tolist() == [int(row[3]) for row in rows]
+
+    with pytest.raises(ValueError):
+        csma_sim.run({"N": 4, "L": 0})
+
+
+def test_python_module_sweep(tmp_path):
+    csma_sim = import_csma_sim()
+    configs = [{"N": n, "L": l, "M": 6, "R": [4, 8, 16, 32], "T": 5000} for n in [1, 3, 10, 70] for l in [1, 4]]
+    sweep = csma_sim.run_sweep(configs, engine="batch", threads=2, window="beb")
+
+    grid_filename = tmp_path / "grid.txt"
+    grid_filename.write_text("N 1 3 10 70\nL 1 4\nM 6\nR 4 8 16 32\nT 5000\n")
+    output_filename = tmp_path / "sweep.csv"
+    subprocess.run(["./csma", "--sweep", "--window", "beb", str(grid_filename), str(output_filename)], check=True, stdout=subprocess.PIPE)
+
+    # The grid is ordered by N and then L, like the configurations
+    rows = [row.split(",") for row in output_filename.read_text().strip().split("\n")[1:]]
+    assert memoryview(sweep["successful_ticks"]).tolist() == [int(row[5]) for row in rows]
+    assert memoryview(sweep["total_simulation_time"]).tolist() == [5000] * 8
+
+
 if __name__ == "__main__":
     pytest.main(["-v"])
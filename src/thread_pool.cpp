@@ -0,0 +1,178 @@
+/** 
+ * @file thread_pool.cpp
+ * @brief Implementation of the work-stealing thread pool.
+ *
+ * @author Vicky Chen (chen-vv)
+ * @author Eric Omielan (eomielan)
+ * @bug No known bugs.
+ */
+
+/* -- Includes -- */
+
+/* Standard library includes. */
+#include <algorithm>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+/* Custom includes */
+#include "include/thread_pool.h"
+
+/** @brief The index of the worker running on this thread, or -1. */
+static thread_local int worker_index = -1;
+
+/**
+ * @brief List the cores the process may run on.
+ * 
+ * @return std::vector<int> The IDs of the cores, empty if they cannot be listed.
+ */
+static std::vector<int> allowed_cpus() {
+    std::vector<int> cpus;
+
+#ifdef __linux__
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+
+    if (sched_getaffinity(0, sizeof(cpu_set), &cpu_set) == 0) {
+        for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+            if (CPU_ISSET(cpu, &cpu_set)) {
+                cpus.push_back(cpu);
+            }
+        }
+    }
+#endif
+
+    return cpus;
+}
+
+ThreadPool::ThreadPool(int num_threads, bool pin_threads)
+    : queued_tasks_(0),
+      unfinished_tasks_(0),
+      next_queue_(0),
+      stopping_(false) {
+    if (num_threads <= 0) {
+        num_threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    std::vector<int> cpus;
+    if (pin_threads) {
+        cpus = allowed_cpus();
+    }
+
+    for (int i = 0; i < num_threads; i++) {
+        queues_.emplace_back(new WorkerQueue());
+    }
+
+    for (int i = 0; i < num_threads; i++) {
+        int cpu = cpus.empty() ? -1 : cpus[i % cpus.size()];
+        threads_.emplace_back(&ThreadPool::worker_loop, this, i, cpu);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    wait();
+
+    {
+        std::lock_guard<std::mutex> lock(state_mutex_);
+        stopping_ = true;
+    }
+    work_available_.notify_all();
+
+    for (auto& thread : threads_) {
+        thread.join();
+    }
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+    int index = worker_index >= 0 && worker_index < size()
+                    ? worker_index
+                    : static_cast<int>(next_queue_++ % queues_.size());
+
+    unfinished_tasks_++;
+    {
+        std::lock_guard<std::mutex> lock(queues_[index]->mutex);
+        queues_[index]->tasks.push_back(std::move(task));
+    }
+
+    {
+        // Taking the lock orders the increment with a worker about to go to sleep
+        std::lock_guard<std::mutex> lock(state_mutex_);
+        queued_tasks_++;
+    }
+    work_available_.notify_one();
+}
+
+void ThreadPool::wait() {
+    std::unique_lock<std::mutex> lock(state_mutex_);
+    work_finished_.wait(lock, [this] { return unfinished_tasks_ == 0; });
+}
+
+int ThreadPool::current_worker_index() {
+    return worker_index;
+}
+
+bool ThreadPool::take_task(int index, std::function<void()>& task) {
+    int num_queues = static_cast<int>(queues_.size());
+
+    for (int offset = 0; offset < num_queues; offset++) {
+        WorkerQueue& queue = *queues_[(index + offset) % num_queues];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+
+        if (queue.tasks.empty()) {
+            continue;
+        }
+
+        // The owner works from the front and thieves from the back, so they rarely meet
+        if (offset == 0) {
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+        } else {
+            task = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+        }
+
+        queued_tasks_--;
+        return true;
+    }
+
+    return false;
+}
+
+void ThreadPool::worker_loop(int index, int cpu) {
+    worker_index = index;
+
+#ifdef __linux__
+    if (cpu >= 0) {
+        // Pinning is only a hint for locality, so a failure leaves the worker unpinned
+        cpu_set_t cpu_set;
+        CPU_ZERO(&cpu_set);
+        CPU_SET(cpu, &cpu_set);
+        pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set);
+    }
+#else
+    (void) cpu;
+#endif
+
+    for (;;) {
+        std::function<void()> task;
+
+        if (take_task(index, task)) {
+            task();
+
+            if (--unfinished_tasks_ == 0) {
+                std::lock_guard<std::mutex> lock(state_mutex_);
+                work_finished_.notify_all();
+            }
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(state_mutex_);
+        work_available_.wait(lock, [this] { return stopping_ || queued_tasks_ > 0; });
+
+        if (stopping_ && queued_tasks_ == 0) {
+            return;
+        }
+    }
+}
@@ -0,0 +1,269 @@
+/** 
+ * @file trace.cpp
+ * @brief Implementation of the binary trace writer and reader.
+ *
+ * @author Vicky Chen (chen-vv)
+ * @author Eric Omielan (eomielan)
+ * @bug No known bugs.
+ */
+
+/* -- Includes -- */
+
+/* Standard library includes. */
+#include <cstring>
+
+/* Custom includes */
+#include "include/trace.h"
+
+TraceWriter::TraceWriter()
+    : file_(nullptr),
+      buffer_used_(0),
+      last_ticks_(0),
+      idle_since_(0),
+      channel_occupied_(false),
+      failed_(false) {}
+
+TraceWriter::~TraceWriter() {
+    if (file_) {
+        flush();
+        std::fclose(file_);
+    }
+}
+
+bool TraceWriter::open(const std::string& filename, const SimulationConfig& config) {
+    file_ = std::fopen(filename.c_str(), "wb");
+
+    if (!file_) {
+        return false;
+    }
+
+    // The header is written before any record, so it always fits in the buffer
+    buffer_.resize(TRACE_BUFFER_SIZE);
+    buffer_used_ = std::strlen(TRACE_MAGIC);
+    std::memcpy(buffer_.data(), TRACE_MAGIC, buffer_used_);
+
+    put_varint(static_cast<unsigned long long>(config.num_nodes));
+    put_varint(static_cast<unsigned long long>(config.packet_length));
+    put_varint(static_cast<unsigned long long>(config.max_retransmission_attempt));
+    put_varint(static_cast<unsigned long long>(config.total_simulation_time));
+    put_varint(config.R.size());
+    for (int r_value : config.R) {
+        if (buffer_used_ > TRACE_BUFFER_SIZE - 16) {
+            flush();
+        }
+        put_varint(static_cast<unsigned long long>(r_value));
+    }
+
+    last_ticks_ = 0;
+    idle_since_ = 0;
+    channel_occupied_ = false;
+    failed_ = false;
+    return true;
+}
+
+bool TraceWriter::close(const SimulationResults& results) {
+    if (!channel_occupied_) {
+        record_idle(results.total_simulation_time);
+    }
+
+    begin_record(TRACE_END_OF_RUN, results.total_simulation_time);
+    put_varint(static_cast<unsigned long long>(results.num_successful_transmission_ticks));
+
+    flush();
+    failed_ = std::fclose(file_) != 0 || failed_;
+    file_ = nullptr;
+
+    return !failed_;
+}
+
+void TraceWriter::collision(long long ticks, const std::vector<int>& node_ids) {
+    record_idle(ticks);
+    begin_record(TRACE_COLLISION, ticks);
+    put_varint(node_ids.size());
+
+    // The IDs are ascending, so the gaps between them are small
+    int previous_node_id = 0;
+    for (int node_id : node_ids) {
+        if (buffer_used_ > TRACE_BUFFER_SIZE - 16) {
+            flush();
+        }
+
+        put_varint(static_cast<unsigned long long>(node_id - previous_node_id));
+        previous_node_id = node_id;
+    }
+
+    idle_since_ = ticks + 1;
+}
+
+void TraceWriter::cycle(long long ticks, long long period, long long skipped_to_ticks) {
+    record_idle(ticks);
+    begin_record(TRACE_CYCLE, ticks);
+    put_varint(static_cast<unsigned long long>(period));
+    put_varint(static_cast<unsigned long long>(skipped_to_ticks - ticks));
+
+    last_ticks_ = skipped_to_ticks;
+    idle_since_ = skipped_to_ticks;
+}
+
+void TraceWriter::flush() {
+    if (file_ && buffer_used_ > 0 && std::fwrite(buffer_.data(), 1, buffer_used_, file_) != buffer_used_) {
+        failed_ = true;
+    }
+
+    buffer_used_ = 0;
+}
+
+TraceReader::TraceReader()
+    : file_(nullptr),
+      last_ticks_(0),
+      finished_(false) {}
+
+TraceReader::~TraceReader() {
+    if (file_) {
+        std::fclose(file_);
+    }
+}
+
+bool TraceReader::get_varint(unsigned long long& value) {
+    value = 0;
+
+    for (int shift = 0; shift < 64; shift += 7) {
+        int byte = std::getc(file_);
+
+        if (byte == EOF) {
+            return false;
+        }
+
+        value |= static_cast<unsigned long long>(byte & 0x7f) << shift;
+
+        if (!(byte & 0x80)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool TraceReader::open(const std::string& filename, std::string& error) {
+    file_ = std::fopen(filename.c_str(), "rb");
+
+    if (!file_) {
+        error = "unable to open file";
+        return false;
+    }
+
+    // Traces are read sequentially, so a large stdio buffer is all the file needs
+    std::setvbuf(file_, nullptr, _IOFBF, TRACE_BUFFER_SIZE);
+
+    char magic[sizeof(TRACE_MAGIC) - 1];
+    if (std::fread(magic, 1, sizeof(magic), file_) != sizeof(magic) || std::memcmp(magic, TRACE_MAGIC, sizeof(magic)) != 0) {
+        error = "not a trace file";
+        return false;
+    }
+
+    unsigned long long num_nodes, packet_length, max_retransmission_attempt, total_simulation_time, num_r_values;
+    if (!get_varint(num_nodes) || !get_varint(packet_length) || !get_varint(max_retransmission_attempt) ||
+        !get_varint(total_simulation_time) || !get_varint(num_r_values) || num_r_values > (1u << 20)) {
+        error = "truncated header";
+        return false;
+    }
+
+    config_.num_nodes = static_cast<int>(num_nodes);
+    config_.packet_length = static_cast<int>(packet_length);
+    config_.max_retransmission_attempt = static_cast<int>(max_retransmission_attempt);
+    config_.total_simulation_time = static_cast<long long>(total_simulation_time);
+    config_.R.clear();
+
+    for (unsigned long long i = 0; i < num_r_values; i++) {
+        unsigned long long r_value;
+        if (!get_varint(r_value)) {
+            error = "truncated header";
+            return false;
+        }
+        config_.R.push_back(static_cast<int>(r_value));
+    }
+
+    last_ticks_ = 0;
+    finished_ = false;
+    return true;
+}
+
+bool TraceReader::next(TraceRecord& record, std::string& error) {
+    error.clear();
+
+    if (finished_) {
+        return false;
+    }
+
+    int type = std::getc(file_);
+    unsigned long long delta, value = 0, extra = 0;
+
+    if (type == EOF) {
+        error = "trace ends before the end of the run";
+        return false;
+    }
+
+    if (!get_varint(delta)) {
+        error = "truncated record";
+        return false;
+    }
+
+    record.type = static_cast<TraceRecordType>(type);
+    record.ticks = last_ticks_ + static_cast<long long>(delta);
+    record.value = 0;
+    record.skipped_ticks = 0;
+    record.node_ids.clear();
+    last_ticks_ = record.ticks;
+
+    bool complete = true;
+
+    switch (type) {
+        case TRACE_IDLE:
+        case TRACE_END_OF_RUN:
+            complete = get_varint(value);
+            finished_ = type == TRACE_END_OF_RUN;
+            break;
+
+        case TRACE_START:
+        case TRACE_DROP:
+            complete = get_varint(extra);
+            record.node_ids.push_back(static_cast<int>(extra));
+            break;
+
+        case TRACE_END:
+            complete = get_varint(extra) && get_varint(value);
+            record.node_ids.push_back(static_cast<int>(extra));
+            break;
+
+        case TRACE_COLLISION: {
+            unsigned long long count;
+            complete = get_varint(count) && count <= static_cast<unsigned long long>(config_.num_nodes);
+
+            long long node_id = 0;
+            for (unsigned long long i = 0; complete && i < count; i++) {
+                complete = get_varint(extra);
+                node_id += static_cast<long long>(extra);
+                record.node_ids.push_back(static_cast<int>(node_id));
+            }
+            break;
+        }
+
+        case TRACE_CYCLE:
+            complete = get_varint(value) && get_varint(extra);
+            record.skipped_ticks = static_cast<long long>(extra);
+            last_ticks_ += record.skipped_ticks;
+            break;
+
+        default:
+            error = "unknown record type " + std::to_string(type);
+            return false;
+    }
+
+    if (!complete) {
+        error = "truncated record";
+        return false;
+    }
+
+    record.value = static_cast<long long>(value);
+    return true;
+}
@@ -0,0 +1,645 @@
+/**
+ * @file traffic.cpp
+ * @brief Implementation of the non-saturated traffic model.
+ *
+ * @author Vicky Chen (chen-vv)
+ * @author Eric Omielan (eomielan)
+ * @bug No known bugs.
+ */
+
+/* -- Includes -- */
+
+/* Standard library includes. */
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <map>
+#include <ostream>
+#include <queue>
+#include <thread>
+#include <utility>
+
+/* Custom includes */
+#include "include/input_file.h"
+#include "include/sweep.h"
+#include "include/thread_pool.h"
+#include "include/traffic.h"
+
+/** @brief Mixed into the seed of the arrivals, so they are independent of the backoffs. */
+static const unsigned long long ARRIVAL_SEED_SALT = 0x6a09e667f3bcc909ULL;
+
+ArrivalProcess::ArrivalProcess()
+    : kind(ARRIVAL_SATURATED),
+      rate(0),
+      mean_on_ticks(0),
+      mean_off_ticks(0) {}
+
+NodeTraffic::NodeTraffic()
+    : first_node(0),
+      last_node(0),
+      packet_length(0),
+      has_arrivals(false) {}
+
+/**
+ * @brief Parse a positive, finite real number.
+ *
+ * @param word The word to parse.
+ * @param value Set to the number.
+ * @return bool True if the whole word is a positive, finite number, false otherwise.
+ */
+static bool parse_positive(const std::string& word, double& value) {
+    char* end = nullptr;
+    value = std::strtod(word.c_str(), &end);
+    return !word.empty() && *end == '\0' && value > 0 && std::isfinite(value);
+}
+
+bool parse_arrival_process(const std::vector<std::string>& words, ArrivalProcess& arrivals, std::string& error) {
+    const std::string& name = words[0];
+    size_t num_values = words.size() - 1;
+    ArrivalProcess parsed;
+
+    if (name == "saturated" && num_values == 0) {
+        parsed.kind = ARRIVAL_SATURATED;
+    } else if (name == "poisson" && num_values == 1) {
+        parsed.kind = ARRIVAL_POISSON;
+
+        if (!parse_positive(words[1], parsed.rate)) {
+            error = "invalid arrival rate '" + words[1] + "'";
+            return false;
+        }
+    } else if (name == "onoff" && num_values == 3) {
+        parsed.kind = ARRIVAL_ON_OFF;
+
+        if (!parse_positive(words[1], parsed.rate)) {
+            error = "invalid arrival rate '" + words[1] + "'";
+            return false;
+        }
+        if (!parse_positive(words[2], parsed.mean_on_ticks) || !parse_positive(words[3], parsed.mean_off_ticks)) {
+            error = "invalid on and off periods '" + words[2] + " " + words[3] + "'";
+            return false;
+        }
+    } else if (name == "trace" && num_values == 1) {
+        parsed.kind = ARRIVAL_TRACE;
+        parsed.trace_filename = words[1];
+    } else {
+        error = "unknown arrival process '" + name + "' with " + std::to_string(num_values) +
+                " values (expected saturated, poisson <rate>, onoff <rate> <on> <off> or trace <file>)";
+        return false;
+    }
+
+    arrivals = parsed;
+    return true;
+}
+
+bool validate_traffic(const SimulationConfig& config, const TrafficConfig& traffic, std::string& error) {
+    for (const NodeTraffic& node : traffic.nodes) {
+        std::string nodes = "node " + std::to_string(node.first_node);
+        if (node.last_node != node.first_node) {
+            nodes += "-" + std::to_string(node.last_node);
+        }
+
+        if (node.last_node >= config.num_nodes) {
+            error = nodes + " does not exist with N = " + std::to_string(config.num_nodes);
+            return false;
+        }
+        if (node.packet_length < 0 || (node.packet_length == 0 && node.R.empty() && !node.has_arrivals)) {
+            error = "the packet length L of " + nodes + " must be at least 1";
+            return false;
+        }
+        if (!node.R.empty() && *std::min_element(node.R.begin(), node.R.end()) < 1) {
+            error = "every value of R of " + nodes + " must be at least 1";
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief Read the arrival ticks of every node from a trace file of "<tick> <node>" lines.
+ *
+ * @param filename The name of the trace file.
+ * @param num_nodes The number of nodes of the simulation.
+ * @param ticks Set to the arrival ticks of every node, in increasing order.
+ * @param error Set to a description of the problem if the file cannot be read or is malformed.
+ * @return bool True if the file was read, false otherwise.
+ */
+static bool read_arrival_trace(const std::string& filename, int num_nodes, std::vector<std::vector<long long>>& ticks,
+                               std::string& error) {
+    std::string contents;
+
+    if (!read_input_file(filename, contents)) {
+        error = "unable to read arrival trace " + filename;
+        return false;
+    }
+
+    ticks.assign(num_nodes, std::vector<long long>());
+    InputScanner scanner(contents);
+
+    while (scanner.next_line()) {
+        InputToken tick_token;
+        InputToken node_token;
+        InputToken extra_token;
+        long long tick = 0;
+        long long node_id = 0;
+
+        if (!scanner.next_token(tick_token)) {
+            continue;
+        }
+
+        const char* tick_position = tick_token.begin;
+        bool valid = scanner.next_token(node_token) && !scanner.next_token(extra_token) &&
+                     parse_integer(tick_position, tick_token.end, tick) && tick_position == tick_token.end;
+        const char* node_position = node_token.begin;
+        valid = valid && parse_integer(node_position, node_token.end, node_id) && node_position == node_token.end;
+
+        if (!valid || tick < 0 || node_id < 0 || node_id >= num_nodes) {
+            error = filename + ": line " + std::to_string(scanner.line_number()) +
+                    ": expected a tick and a node of the simulation";
+            return false;
+        }
+        ticks[node_id].push_back(tick);
+    }
+
+    for (std::vector<long long>& node_ticks : ticks) {
+        std::sort(node_ticks.begin(), node_ticks.end());
+    }
+
+    return true;
+}
+
+/**
+ * @brief The packets waiting at a node, oldest first, as their arrival ticks.
+*/
+struct PacketQueue {
+    std::vector<long long> arrival_ticks;   /**< The arrival ticks, from head onwards. */
+    size_t head;                            /**< The index of the oldest packet. */
+
+    PacketQueue() : head(0) {}
+
+    bool empty() const {
+        return head == arrival_ticks.size();
+    }
+
+    size_t size() const {
+        return arrival_ticks.size() - head;
+    }
+
+    long long front() const {
+        return arrival_ticks[head];
+    }
+
+    void push(long long tick) {
+        arrival_ticks.push_back(tick);
+    }
+
+    void pop() {
+        head++;
+
+        // Reclaim the popped packets once they take up half of the storage
+        if (head == arrival_ticks.size()) {
+            arrival_ticks.clear();
+            head = 0;
+        } else if (head >= 64 && 2 * head >= arrival_ticks.size()) {
+            arrival_ticks.erase(arrival_ticks.begin(), arrival_ticks.begin() + static_cast<long>(head));
+            head = 0;
+        }
+    }
+};
+
+/**
+ * @brief Where the arrival process of a node is.
+*/
+struct ArrivalState {
+    const ArrivalProcess* process;              /**< The arrival process of the node. */
+    const std::vector<long long>* trace_ticks;  /**< The arrival ticks of a traced node. */
+    size_t trace_index;                         /**< The next arrival tick of a traced node. */
+    double time;                                /**< The time of the last arrival or period change. */
+    double period_end;                          /**< The time the current on or off period ends. */
+    bool on;                                    /**< Whether the node is in an on period. */
+    long long num_draws;                        /**< The random numbers drawn for the node so far. */
+};
+
+/** @brief A node and the tick or idle tick it is scheduled on, ordered by tick and then node. */
+typedef std::pair<long long, int> ScheduledNode;
+
+/** @brief A priority queue that pops the earliest scheduled node first. */
+typedef std::priority_queue<ScheduledNode, std::vector<ScheduledNode>, std::greater<ScheduledNode>> NodeSchedule;
+
+/**
+ * @brief A simulation of nodes with packet queues fed by arrival processes.
+ *
+ * The backoffs only count down on idle ticks, so the contention schedule is keyed by the
+ * number of idle ticks before a node is ready, counted from tick 0, rather than by tick.
+ * A transmission or collision leaves the keys as they are, which freezes the backoffs.
+ *
+ * @tparam Backoff The backoff policy.
+ * @tparam Window The window policy.
+*/
+template <typename Backoff, typename Window>
+class TrafficSimulation {
+public:
+    /**
+     * @brief Set up the nodes of a simulation at tick 0.
+     *
+     * @param config The configuration of the simulation.
+     * @param traffic The traffic of the simulation.
+     * @param options The backoff and window policies, the seed and the persistence.
+     * @param traces The arrival ticks of every node, by trace file name.
+     */
+    TrafficSimulation(const SimulationConfig& config, const TrafficConfig& traffic, const SimulationOptions& options,
+                      const std::map<std::string, std::vector<std::vector<long long>>>& traces)
+        : config_(config),
+          backoff_policy_(options.seed, options.persistence),
+          arrival_seed_(options.seed ^ ARRIVAL_SEED_SALT),
+          packet_length_(config.num_nodes, config.packet_length),
+          R_(config.num_nodes, &config.R),
+          collisions_(config.num_nodes, 0),
+          queues_(config.num_nodes),
+          arrivals_(config.num_nodes),
+          idle_ticks_(0) {
+        std::vector<const ArrivalProcess*> processes(config.num_nodes, &traffic.arrivals);
+
+        // Later overrides take precedence over earlier ones
+        for (const NodeTraffic& node : traffic.nodes) {
+            for (int node_id = node.first_node; node_id <= node.last_node; node_id++) {
+                if (node.packet_length > 0) {
+                    packet_length_[node_id] = node.packet_length;
+                }
+                if (!node.R.empty()) {
+                    R_[node_id] = &node.R;
+                }
+                if (node.has_arrivals) {
+                    processes[node_id] = &node.arrivals;
+                }
+            }
+        }
+
+        for (int node_id = 0; node_id < config.num_nodes; node_id++) {
+            ArrivalState& state = arrivals_[node_id];
+            state.process = processes[node_id];
+            state.trace_ticks = nullptr;
+            state.trace_index = 0;
+            state.time = 0;
+            state.period_end = 0;
+            state.on = false;
+            state.num_draws = 0;
+
+            if (state.process->kind == ARRIVAL_TRACE) {
+                state.trace_ticks = &traces.at(state.process->trace_filename)[node_id];
+            } else if (state.process->kind == ARRIVAL_ON_OFF) {
+                // Start in the stationary mix of on and off periods
+                double on_fraction = state.process->mean_on_ticks / (state.process->mean_on_ticks + state.process->mean_off_ticks);
+                state.on = draw_uniform(node_id) <= on_fraction;
+                state.period_end = draw_exponential(node_id, state.on ? state.process->mean_on_ticks : state.process->mean_off_ticks);
+            }
+        }
+    }
+
+    /**
+     * @brief Run the simulation to T.
+     *
+     * @param results Set to the results of the simulation.
+     */
+    void run(TrafficResults& results) {
+        const long long T = config_.total_simulation_time;
+        results_ = TrafficResults();
+        results_.results.total_simulation_time = T;
+        results_.total_delay = 0;
+
+        for (int node_id = 0; node_id < config_.num_nodes; node_id++) {
+            if (arrivals_[node_id].process->kind == ARRIVAL_SATURATED) {
+                enqueue(node_id, 0);
+            } else {
+                schedule_next_arrival(node_id);
+            }
+        }
+
+        long long ticks = 0;
+
+        while (ticks < T) {
+            admit_arrivals(ticks);
+
+            if (contenders_.empty() || contenders_.top().first > idle_ticks_) {
+                // The channel is idle until the first backoff runs out, or the next packet arrives
+                long long next_tick = T;
+                if (!contenders_.empty()) {
+                    next_tick = std::min(next_tick, ticks + (contenders_.top().first - idle_ticks_));
+                }
+                if (!arrival_schedule_.empty()) {
+                    next_tick = std::min(next_tick, arrival_schedule_.top().first);
+                }
+
+                idle_ticks_ += next_tick - ticks;
+                ticks = next_tick;
+                continue;
+            }
+
+            ready_nodes_.clear();
+            while (!contenders_.empty() && contenders_.top().first == idle_ticks_) {
+                ready_nodes_.push_back(contenders_.top().second);
+                contenders_.pop();
+            }
+
+            if (ready_nodes_.size() == 1) {
+                int node_id = ready_nodes_[0];
+                long long end_tick = ticks + std::min<long long>(packet_length_[node_id], T - ticks);
+                results_.results.num_successful_transmission_ticks += end_tick - ticks;
+
+                if (end_tick - ticks < packet_length_[node_id]) {
+                    // The transmission is cut short by T, and the packets that arrive during it still count
+                    admit_arrivals(T - 1);
+                    break;
+                }
+
+                // The packets that arrive during the transmission find the backoffs frozen
+                admit_arrivals(end_tick - 1);
+
+                long long delay = end_tick - queues_[node_id].front();
+                results_.packets_delivered++;
+                results_.total_delay += delay;
+                results_.max_delay = std::max(results_.max_delay, delay);
+                leave(node_id, end_tick);
+                ticks = end_tick;
+            } else {
+                for (int node_id : ready_nodes_) {
+                    if (++collisions_[node_id] > config_.max_retransmission_attempt) {
+                        results_.packets_dropped++;
+                        leave(node_id, ticks + 1);
+                    } else {
+                        contend(node_id, ticks + 1);
+                    }
+                }
+                ticks++;
+            }
+        }
+
+        results = results_;
+    }
+
+private:
+    /**
+     * @brief Draw a uniform random number in (0, 1] for the arrivals of a node.
+     *
+     * @param node_id The node.
+     * @return double The random number.
+     */
+    double draw_uniform(int node_id) {
+        unsigned long long bits = random_bits(arrival_seed_, node_id, arrivals_[node_id].num_draws++) >> 11;
+        return static_cast<double>(bits + 1) / 9007199254740992.0;
+    }
+
+    /**
+     * @brief Draw an exponentially distributed time for the arrivals of a node.
+     *
+     * @param node_id The node.
+     * @param mean The mean of the time.
+     * @return double The time.
+     */
+    double draw_exponential(int node_id, double mean) {
+        return -std::log(draw_uniform(node_id)) * mean;
+    }
+
+    /**
+     * @brief Schedule the next arrival of a node, if it is before T.
+     *
+     * @param node_id The node, which must not be saturated.
+     */
+    void schedule_next_arrival(int node_id) {
+        ArrivalState& state = arrivals_[node_id];
+        const double T = static_cast<double>(config_.total_simulation_time);
+
+        switch (state.process->kind) {
+            case ARRIVAL_POISSON:
+                state.time += draw_exponential(node_id, 1.0 / state.process->rate);
+                break;
+
+            case ARRIVAL_ON_OFF:
+                // The arrivals are memoryless, so they restart at every change of period
+                for (;;) {
+                    if (state.on) {
+                        double next_time = state.time + draw_exponential(node_id, 1.0 / state.process->rate);
+
+                        if (next_time < state.period_end) {
+                            state.time = next_time;
+                            break;
+                        }
+                    }
+
+                    if (state.period_end >= T) {
+                        return;
+                    }
+
+                    state.time = state.period_end;
+                    state.on = !state.on;
+                    state.period_end = state.time + draw_exponential(node_id, state.on ? state.process->mean_on_ticks
+                                                                                       : state.process->mean_off_ticks);
+                }
+                break;
+
+            case ARRIVAL_TRACE:
+                // The ticks of a trace are exact, however large they are
+                if (state.trace_index < state.trace_ticks->size() &&
+                    (*state.trace_ticks)[state.trace_index] < config_.total_simulation_time) {
+                    arrival_schedule_.push(ScheduledNode((*state.trace_ticks)[state.trace_index++], node_id));
+                }
+                return;
+
+            case ARRIVAL_SATURATED:
+            default:
+                return;
+        }
+
+        if (state.time < T) {
+            arrival_schedule_.push(ScheduledNode(static_cast<long long>(state.time), node_id));
+        }
+    }
+
+    /**
+     * @brief Queue every packet that arrives on or before a tick.
+     *
+     * @param ticks The tick.
+     */
+    void admit_arrivals(long long ticks) {
+        while (!arrival_schedule_.empty() && arrival_schedule_.top().first <= ticks) {
+            ScheduledNode arrival = arrival_schedule_.top();
+            arrival_schedule_.pop();
+            enqueue(arrival.second, arrival.first);
+            schedule_next_arrival(arrival.second);
+        }
+    }
+
+    /**
+     * @brief Queue a packet at a node, which starts to compete for the channel if it had no packet.
+     *
+     * @param node_id The node.
+     * @param ticks The tick the packet arrives on.
+     */
+    void enqueue(int node_id, long long ticks) {
+        PacketQueue& queue = queues_[node_id];
+        bool was_empty = queue.empty();
+        queue.push(ticks);
+
+        results_.packets_arrived++;
+        results_.offered_ticks += packet_length_[node_id];
+        results_.max_queue_length = std::max(results_.max_queue_length, static_cast<long long>(queue.size()));
+
+        if (was_empty) {
+            contend(node_id, ticks);
+        }
+    }
+
+    /**
+     * @brief Remove the oldest packet of a node, once it was transmitted or dropped.
+     *
+     * @param node_id The node.
+     * @param ticks The tick the node moves on to its next packet on.
+     */
+    void leave(int node_id, long long ticks) {
+        queues_[node_id].pop();
+        collisions_[node_id] = 0;
+
+        // A saturated node has its next packet right away
+        if (arrivals_[node_id].process->kind == ARRIVAL_SATURATED && ticks < config_.total_simulation_time) {
+            queues_[node_id].push(ticks);
+            results_.packets_arrived++;
+            results_.offered_ticks += packet_length_[node_id];
+            results_.max_queue_length = std::max(results_.max_queue_length, 1LL);
+        }
+
+        if (!queues_[node_id].empty()) {
+            contend(node_id, ticks);
+        }
+    }
+
+    /**
+     * @brief Draw the backoff of a node for its oldest packet, and schedule it.
+     *
+     * @param node_id The node.
+     * @param ticks The tick the backoff is drawn on.
+     */
+    void contend(int node_id, long long ticks) {
+        int backoff = backoff_policy_(node_id, ticks, window_policy_(*R_[node_id], collisions_[node_id]));
+        contenders_.push(ScheduledNode(idle_ticks_ + backoff, node_id));
+    }
+
+    const SimulationConfig& config_;            /**< The configuration of the simulation. */
+    Backoff backoff_policy_;                    /**< Draws the backoffs of the nodes. */
+    Window window_policy_;                      /**< Chooses the backoff windows of the nodes. */
+    unsigned long long arrival_seed_;           /**< The seed of the arrival processes. */
+    std::vector<int> packet_length_;            /**< The packet length of every node. */
+    std::vector<const std::vector<int>*> R_;    /**< The R values of every node. */
+    std::vector<int> collisions_;               /**< The collisions of the oldest packet of every node. */
+    std::vector<PacketQueue> queues_;           /**< The packets waiting at every node. */
+    std::vector<ArrivalState> arrivals_;        /**< The arrival process of every node. */
+    NodeSchedule contenders_;                   /**< The nodes with packets, by the idle tick they are ready on. */
+    NodeSchedule arrival_schedule_;             /**< The next arrival of every node, by tick. */
+    std::vector<int> ready_nodes_;              /**< The nodes ready on the current tick. */
+    long long idle_ticks_;                      /**< The idle ticks before the current tick. */
+    TrafficResults results_;                    /**< The results so far. */
+};
+
+/**
+ * @brief Run a simulation with non-saturated traffic, with the given backoff policy and the
+ * window policy of the options.
+ *
+ * @tparam Backoff The backoff policy.
+ */
+template <typename Backoff>
+static void run_traffic_with(const SimulationConfig& config, const TrafficConfig& traffic,
+                             const SimulationOptions& options,
+                             const std::map<std::string, std::vector<std::vector<long long>>>& traces,
+                             TrafficResults& results) {
+    if (options.window_policy == WINDOW_BINARY_EXPONENTIAL) {
+        TrafficSimulation<Backoff, BinaryExponentialWindow>(config, traffic, options, traces).run(results);
+    } else {
+        TrafficSimulation<Backoff, TableWindow>(config, traffic, options, traces).run(results);
+    }
+}
+
+bool run_traffic_simulation(const SimulationConfig& config, const TrafficConfig& traffic,
+                            const SimulationOptions& options, TrafficResults& results, std::string& error) {
+    std::map<std::string, std::vector<std::vector<long long>>> traces;
+    std::vector<const ArrivalProcess*> processes(1, &traffic.arrivals);
+
+    for (const NodeTraffic& node : traffic.nodes) {
+        if (node.has_arrivals) {
+            processes.push_back(&node.arrivals);
+        }
+    }
+
+    // Every trace file is read once, however many nodes replay it
+    for (const ArrivalProcess* process : processes) {
+        if (process->kind == ARRIVAL_TRACE && !traces.count(process->trace_filename) &&
+            !read_arrival_trace(process->trace_filename, config.num_nodes, traces[process->trace_filename], error)) {
+            return false;
+        }
+    }
+
+    switch (options.backoff_policy) {
+        case BACKOFF_UNIFORM:
+            run_traffic_with<UniformBackoff>(config, traffic, options, traces, results);
+            break;
+
+        case BACKOFF_P_PERSISTENT:
+            run_traffic_with<PPersistentBackoff>(config, traffic, options, traces, results);
+            break;
+
+        case BACKOFF_DETERMINISTIC:
+        default:
+            run_traffic_with<DeterministicBackoff>(config, traffic, options, traces, results);
+            break;
+    }
+
+    return true;
+}
+
+bool run_traffic_scenarios(const std::vector<SimulationConfig>& configs, const std::vector<TrafficConfig>& traffic,
+                           const SimulationOptions& options, int num_threads, std::vector<TrafficResults>& results,
+                           std::string& error) {
+    results.assign(configs.size(), TrafficResults());
+    std::vector<std::string> errors(configs.size());
+
+    int max_threads = static_cast<int>(std::min<size_t>(std::max<size_t>(configs.size(), 1), 1 << 16));
+    ThreadPool pool(num_threads > 0 ? std::min(num_threads, max_threads)
+                                    : std::min(static_cast<int>(std::thread::hardware_concurrency()), max_threads));
+
+    for (size_t i = 0; i < configs.size(); i++) {
+        pool.submit([&, i]() {
+            run_traffic_simulation(configs[i], traffic[i], options, results[i], errors[i]);
+        });
+    }
+    pool.wait();
+
+    for (const std::string& scenario_error : errors) {
+        if (!scenario_error.empty()) {
+            error = scenario_error;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void write_traffic_results(std::ostream& output, const std::vector<std::string>& names,
+                           const std::vector<SimulationConfig>& configs, const std::vector<TrafficResults>& results) {
+    output << "scenario,N,L,M,R,T,successful_ticks,utilization,offered_load,packets_arrived,packets_delivered,"
+              "packets_dropped,mean_delay,max_delay,max_queue_length" << std::endl;
+
+    for (size_t i = 0; i < configs.size(); i++) {
+        const TrafficResults& result = results[i];
+        char mean_delay[32];
+        std::snprintf(mean_delay, sizeof(mean_delay), "%.3Lf",
+                      result.packets_delivered > 0 ? result.total_delay / result.packets_delivered : 0.0L);
+
+        write_csv_name(output, names[i], "scenario", i);
+        output << ',';
+        write_point_fields(output, configs[i], result.results);
+        output << ',' << format_ratio(result.offered_ticks, result.results.total_simulation_time, 6)
+               << ',' << result.packets_arrived << ',' << result.packets_delivered << ',' << result.packets_dropped
+               << ',' << mean_delay << ',' << result.max_delay << ',' << result.max_queue_length << std::endl;
+    }
+}
@@ -0,0 +1,419 @@
+/**
+ * @file verify.cpp
+ * @brief Implementation of the differential checks of the engines.
+ *
+ * @author Vicky Chen (chen-vv)
+ * @author Eric Omielan (eomielan)
+ * @bug No known bugs.
+ */
+
+/* -- Includes -- */
+
+/* Standard library includes. */
+#include <ostream>
+#include <sstream>
+#include <vector>
+
+/* Custom includes */
+#include "include/batch.h"
+#include "include/node_stats.h"
+#include "include/verify.h"
+
+/**
+ * @brief The engines checked against the reference engine, one tick or event at a time.
+*/
+static const Engine VERIFIED_ENGINES[] = {ENGINE_TICK, ENGINE_SMALL, ENGINE_SIMD, ENGINE_NEXT_EVENT, ENGINE_GROUP};
+
+/**
+ * @brief Get the name of an engine, as given to --engine.
+ *
+ * @param engine The engine.
+ * @return const char* The name of the engine.
+ */
+static const char* engine_name(Engine engine) {
+    switch (engine) {
+        case ENGINE_TICK:
+            return "tick";
+
+        case ENGINE_REFERENCE:
+            return "reference";
+
+        case ENGINE_NEXT_EVENT:
+            return "event";
+
+        case ENGINE_SIMD:
+            return "simd";
+
+        case ENGINE_GROUP:
+            return "group";
+
+        case ENGINE_BATCH:
+            return "batch";
+
+        case ENGINE_SMALL:
+        default:
+            return "small";
+    }
+}
+
+/**
+ * @brief Describe the first difference between the state of an engine and the state of the reference engine.
+ *
+ * The packet of the channel is only compared while the channel is occupied, and the
+ * backoff of the transmitting node is not compared, since neither means anything then.
+ *
+ * @param reference The state of the reference engine.
+ * @param state The state of the engine, at the same tick.
+ * @param difference Set to a description of the first difference.
+ * @return bool True if the states are the same, false otherwise.
+ */
+static bool compare_states(const SimulationSnapshot& reference, const SimulationSnapshot& state,
+                           std::string& difference) {
+    std::ostringstream description;
+
+    if (state.num_successful_transmission_ticks != reference.num_successful_transmission_ticks) {
+        description << "successful ticks " << state.num_successful_transmission_ticks << ", reference "
+                    << reference.num_successful_transmission_ticks;
+    } else if (state.channel_occupied != reference.channel_occupied) {
+        description << "channel " << (state.channel_occupied ? "occupied" : "idle") << ", reference "
+                    << (reference.channel_occupied ? "occupied" : "idle");
+    } else if (state.channel_occupied && state.active_node_id != reference.active_node_id) {
+        description << "channel occupied by node " << state.active_node_id << ", reference node "
+                    << reference.active_node_id;
+    } else if (state.channel_occupied && state.packet_ticks_remaining != reference.packet_ticks_remaining) {
+        description << "packet ticks remaining " << state.packet_ticks_remaining << ", reference "
+                    << reference.packet_ticks_remaining;
+    } else {
+        for (int node_id = 0; node_id < reference.nodes.size(); node_id++) {
+            if (state.nodes.collisions(node_id) != reference.nodes.collisions(node_id)) {
+                description << "node " << node_id << " collision count " << state.nodes.collisions(node_id)
+                            << ", reference " << reference.nodes.collisions(node_id);
+                break;
+            }
+
+            bool transmitting = reference.channel_occupied && node_id == reference.active_node_id;
+            if (!transmitting && state.nodes.backoff[node_id] != reference.nodes.backoff[node_id]) {
+                description << "node " << node_id << " backoff " << state.nodes.backoff[node_id] << ", reference "
+                            << reference.nodes.backoff[node_id];
+                break;
+            }
+        }
+    }
+
+    difference = description.str();
+    return difference.empty();
+}
+
+/**
+ * @brief Describe the first difference between the event counts of an engine and of the reference engine.
+ *
+ * @param reference The statistics of the reference engine.
+ * @param statistics The statistics of the engine.
+ * @param difference Set to a description of the first difference.
+ * @return bool True if every node sent, collided and dropped as often, false otherwise.
+ */
+static bool compare_event_counts(const NodeStatistics& reference, const NodeStatistics& statistics,
+                                 std::string& difference) {
+    std::ostringstream description;
+
+    for (size_t node_id = 0; node_id < reference.nodes().size(); node_id++) {
+        const NodeStats& expected = reference.nodes()[node_id];
+        const NodeStats& node = statistics.nodes()[node_id];
+
+        if (node.transmissions != expected.transmissions) {
+            description << "node " << node_id << " transmissions " << node.transmissions << ", reference "
+                        << expected.transmissions;
+        } else if (node.collisions != expected.collisions) {
+            description << "node " << node_id << " collisions " << node.collisions << ", reference "
+                        << expected.collisions;
+        } else if (node.drops != expected.drops) {
+            description << "node " << node_id << " drops " << node.drops << ", reference " << expected.drops;
+        } else {
+            continue;
+        }
+        break;
+    }
+
+    difference = description.str();
+    return difference.empty();
+}
+
+/**
+ * @brief Describe a mismatch of an engine.
+ *
+ * @param name The name of the engine, or of the mode it ran in.
+ * @param tick The tick of the mismatch.
+ * @param difference The difference.
+ * @return std::string The description.
+ */
+static std::string describe_mismatch(const std::string& name, long long tick, const std::string& difference) {
+    std::ostringstream description;
+    description << "Engine " << name << " differs from the reference engine at tick " << tick << ": " << difference;
+    return description.str();
+}
+
+/**
+ * @brief Check every engine against the reference engine, with the given policies.
+ *
+ * The reference engine is run first, and its state saved on every check. Every
+ * engine is then run to the same ticks, and compared on each of them.
+ *
+ * @tparam SimulationType The instantiation of BasicSimulation with the selected policies.
+ */
+template <typename SimulationType>
+static bool verify_as(const SimulationConfig& config, const SimulationOptions& options, std::string& mismatch) {
+    SimulationOptions reference_options = options;
+    reference_options.engine = ENGINE_REFERENCE;
+    reference_options.log_level = LOG_OFF;
+    reference_options.detect_cycles = false;
+    reference_options.trace_writer = nullptr;
+    reference_options.profile = nullptr;
+    reference_options.checkpoint_writer = nullptr;
+    reference_options.resume_snapshot = nullptr;
+    reference_options.report = nullptr;
+    reference_options.result_cache = nullptr;
+    reference_options.async_log = nullptr;
+
+    NodeStatistics reference_statistics;
+    reference_statistics.reset(config.num_nodes);
+    reference_options.node_statistics = &reference_statistics;
+
+    // The check ticks, evenly spaced from 0 to T without repeats
+    std::vector<long long> check_ticks(1, 0);
+    for (long long check = 1; check <= VERIFY_NUM_CHECKS; check++) {
+        long long tick = static_cast<long long>(static_cast<long double>(config.total_simulation_time) * check /
+                                                VERIFY_NUM_CHECKS);
+        if (tick > check_ticks.back()) {
+            check_ticks.push_back(tick);
+        }
+    }
+
+    SimulationType reference(config, reference_options);
+    std::vector<SimulationSnapshot> reference_states(check_ticks.size());
+    for (size_t check = 0; check < check_ticks.size(); check++) {
+        reference.run(check_ticks[check]);
+        reference.save(reference_states[check]);
+    }
+
+    NodeStatistics statistics;
+    SimulationSnapshot state;
+    SimulationSnapshot previous_state;
+    std::string difference;
+
+    for (Engine engine : VERIFIED_ENGINES) {
+        SimulationOptions engine_options = reference_options;
+        engine_options.engine = engine;
+        engine_options.node_statistics = &statistics;
+        statistics.reset(config.num_nodes);
+
+        SimulationType simulation(config, engine_options);
+
+        for (size_t check = 0; check < check_ticks.size(); check++) {
+            if (check > 0) {
+                simulation.save(previous_state);
+            }
+            simulation.run(check_ticks[check]);
+            simulation.save(state);
+
+            if (compare_states(reference_states[check], state, difference)) {
+                continue;
+            }
+
+            // Step both engines one tick at a time from the last check they matched on
+            long long tick = check_ticks[check];
+            if (check > 0) {
+                SimulationSnapshot reference_state = reference_states[check - 1];
+                SimulationType replay(config, engine_options);
+                reference_options.node_statistics = nullptr;
+                engine_options.node_statistics = nullptr;
+                reference.options() = reference_options;
+                replay.options() = engine_options;
+                reference.restore(reference_state);
+                replay.restore(previous_state);
+
+                std::string step_difference;
+                for (tick = check_ticks[check - 1] + 1; tick <= check_ticks[check]; tick++) {
+                    reference.run(tick);
+                    replay.run(tick);
+                    reference.save(reference_state);
+                    replay.save(state);
+
+                    if (!compare_states(reference_state, state, step_difference)) {
+                        break;
+                    }
+                }
+
+                if (tick <= check_ticks[check]) {
+                    difference = step_difference;
+                } else {
+                    // The engine only differs when it runs the whole stretch at once
+                    tick = check_ticks[check];
+                    difference += ", when run from tick " + std::to_string(check_ticks[check - 1]) + " in one step";
+                }
+            }
+
+            mismatch = describe_mismatch(engine_name(engine), tick, difference);
+            return false;
+        }
+
+        if (!compare_event_counts(reference_statistics, statistics, difference)) {
+            mismatch = describe_mismatch(engine_name(engine), config.total_simulation_time, difference);
+            return false;
+        }
+    }
+
+    // Cycle detection and the batch engine are only compared at T
+    const SimulationSnapshot& reference_state = reference_states.back();
+    SimulationOptions cycle_options = reference_options;
+    cycle_options.engine = ENGINE_NEXT_EVENT;
+    cycle_options.detect_cycles = true;
+    cycle_options.node_statistics = &statistics;
+    statistics.reset(config.num_nodes);
+
+    SimulationType cycles(config, cycle_options);
+    cycles.run();
+    cycles.save(state);
+
+    if (!compare_states(reference_state, state, difference) ||
+        !compare_event_counts(reference_statistics, statistics, difference)) {
+        mismatch = describe_mismatch("event with cycle detection", config.total_simulation_time, difference);
+        return false;
+    }
+
+    if (batchable(config, options)) {
+        std::vector<SimulationConfig> configs(1, config);
+        std::vector<SimulationResults> results(1);
+        size_t point = 0;
+        run_batch(configs, &point, 1, reference_options, results);
+
+        if (results[0].num_successful_transmission_ticks != reference_state.num_successful_transmission_ticks) {
+            std::ostringstream description;
+            description << "successful ticks " << results[0].num_successful_transmission_ticks << ", reference "
+                        << reference_state.num_successful_transmission_ticks;
+            mismatch = describe_mismatch(engine_name(ENGINE_BATCH), config.total_simulation_time, description.str());
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief Check every engine against the reference engine, with the given backoff policy and the window policy of the options.
+ *
+ * @tparam Backoff The backoff policy.
+ */
+template <typename Backoff>
+static bool verify_with(const SimulationConfig& config, const SimulationOptions& options, std::string& mismatch) {
+    if (options.window_policy == WINDOW_BINARY_EXPONENTIAL) {
+        return verify_as<BasicSimulation<Backoff, BinaryExponentialWindow>>(config, options, mismatch);
+    }
+
+    return verify_as<BasicSimulation<Backoff, TableWindow>>(config, options, mismatch);
+}
+
+bool verify_engines(const SimulationConfig& config, const SimulationOptions& options, std::string& mismatch) {
+    switch (options.backoff_policy) {
+        case BACKOFF_UNIFORM:
+            return verify_with<UniformBackoff>(config, options, mismatch);
+
+        case BACKOFF_P_PERSISTENT:
+            return verify_with<PPersistentBackoff>(config, options, mismatch);
+
+        case BACKOFF_DETERMINISTIC:
+        default:
+            return verify_with<DeterministicBackoff>(config, options, mismatch);
+    }
+}
+
+/**
+ * @brief Draws the random choices of one configuration of a stress run.
+*/
+struct VerifyCaseDraws {
+    unsigned long long seed;    /**< The seed of the stress run. */
+    long long index;            /**< The index of the configuration. */
+    int draw;                   /**< The number of choices drawn so far. */
+
+    /**
+     * @brief Draw the next choice.
+     *
+     * @param bound The number of possible values, at least 1.
+     * @return int A value in [0, bound).
+     */
+    int next(int bound) {
+        return static_cast<int>(random_bits(seed, draw++, index) % static_cast<unsigned long long>(bound));
+    }
+};
+
+void random_verify_case(unsigned long long seed, long long index, SimulationConfig& config, SimulationOptions& options) {
+    VerifyCaseDraws draws = {seed, index, 0};
+
+    // Mostly few nodes, where the small and batch engines run, and sometimes more than fit in them
+    config.num_nodes = draws.next(4) == 0 ? draws.next(81) : 1 + draws.next(12);
+    config.packet_length = 1 + draws.next(6);
+    config.max_retransmission_attempt = draws.next(7);
+
+    config.R.resize(1 + draws.next(6));
+    for (int& window : config.R) {
+        window = 1 + draws.next(draws.next(8) == 0 ? 1000 : 40);
+    }
+    config.total_simulation_time = draws.next(8) == 0 ? draws.next(50000) : draws.next(5000);
+
+    options.backoff_policy = static_cast<BackoffPolicy>(draws.next(3));
+    options.window_policy = static_cast<WindowPolicy>(draws.next(2));
+    options.seed = random_bits(seed ^ 0x5eedULL, draws.draw, index);
+    options.persistence = (1 + draws.next(100)) / 100.0;
+}
+
+/**
+ * @brief Get the name of a backoff policy, as given to --backoff.
+ *
+ * @param policy The backoff policy.
+ * @return const char* The name of the policy.
+ */
+static const char* backoff_policy_name(BackoffPolicy policy) {
+    switch (policy) {
+        case BACKOFF_UNIFORM:
+            return "uniform";
+
+        case BACKOFF_P_PERSISTENT:
+            return "p-persistent";
+
+        case BACKOFF_DETERMINISTIC:
+        default:
+            return "deterministic";
+    }
+}
+
+long long run_stress(unsigned long long seed, long long num_cases, std::ostream& output) {
+    long long num_mismatches = 0;
+    SimulationConfig config;
+    SimulationOptions options;
+    std::string mismatch;
+
+    for (long long index = 0; index < num_cases; index++) {
+        random_verify_case(seed, index, config, options);
+
+        if (verify_engines(config, options, mismatch)) {
+            continue;
+        }
+        num_mismatches++;
+
+        // The configuration is written as a scenario of an input file, after the policies to run it with
+        output << "Mismatch in stress case " << index << ": " << mismatch << std::endl;
+        output << "Run with: --backoff " << backoff_policy_name(options.backoff_policy) << " --window "
+               << (options.window_policy == WINDOW_BINARY_EXPONENTIAL ? "beb" : "table") << " --seed "
+               << options.seed << " --persistence " << options.persistence << std::endl;
+        output << "N " << config.num_nodes << std::endl;
+        output << "L " << config.packet_length << std::endl;
+        output << "M " << config.max_retransmission_attempt << std::endl;
+        output << "R";
+        for (int window : config.R) {
+            output << " " << window;
+        }
+        output << std::endl;
+        output << "T " << config.total_simulation_time << std::endl << std::endl;
+    }
+
+    return num_mismatches;
+}